@@ -0,0 +1,39 @@
+/* Generated by util/jsonbind.py from app/schema/app_settings.json, do not edit */
+
+#ifndef _APP_SETTINGS_BIND_H
+#define _APP_SETTINGS_BIND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "jsmn_bind.h"
+
+typedef struct
+{
+  bool led;
+  uint16_t metrics_period;
+  bool bench;
+} app_settings_t;
+
+/* Bits of the 'seen' mask of app_settings_decode() */
+#define APP_SETTINGS_LED (1UL << 0)
+#define APP_SETTINGS_METRICS_PERIOD (1UL << 1)
+#define APP_SETTINGS_BENCH (1UL << 2)
+
+/* Longest output of app_settings_encode(), '\0' included */
+#define APP_SETTINGS_JSON_MAX 50
+
+extern const jsmn_bind_schema_t app_settings_schema;
+
+static inline int app_settings_decode(app_settings_t *obj, const char *js,
+    const jsmntok_t *tokens, int num_tokens, uint32_t *seen)
+{
+  return jsmn_bind_decode(&app_settings_schema, obj, js, tokens, num_tokens, seen);
+}
+
+static inline size_t app_settings_encode(const app_settings_t *obj, char *buf,
+    size_t len)
+{
+  return jsmn_bind_encode(&app_settings_schema, obj, buf, len);
+}
+
+#endif /* _APP_SETTINGS_BIND_H */
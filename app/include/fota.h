@@ -11,6 +11,12 @@
 /* Public function prototype section ======================================== */
 void fota_task(void *param);
 
+/* Start the worker which writes firmware images POSTed to /fota into the
+ next rboot slot. Must be called before httpd_init(). On success the device
+ switches to the new slot and reboots once the response has been sent.
+ */
+void fota_http_init(void);
+
 /* Attempt to make a TFTP client connection and download the specified filename.
 
  'timeout' is in milliseconds, and is timeout for any UDP exchange
@@ -0,0 +1,26 @@
+/* Generated by util/jsonbind.py from app/schema/app_settings.json, do not edit */
+
+#include <stddef.h>
+#include "app_settings_bind.h"
+
+static const jsmn_bind_field_t app_settings_fields[] =
+{
+  { "led", 3, JSMN_BIND_BOOL, 1, offsetof(app_settings_t, led), 0LL, 1LL },
+  { "metrics_period", 14, JSMN_BIND_UINT, 2, offsetof(app_settings_t, metrics_period), 5LL, 3600LL },
+  { "bench", 5, JSMN_BIND_BOOL, 1, offsetof(app_settings_t, bench), 0LL, 1LL },
+};
+
+static const uint8_t app_settings_slots[4] =
+{
+  0, 1, 0xFF, 2
+};
+
+const jsmn_bind_schema_t app_settings_schema =
+{
+  .fields = app_settings_fields,
+  .slots = app_settings_slots,
+  .seed = 0UL,
+  .required = 0x00000000UL,
+  .num_fields = 3,
+  .slot_mask = 3
+};
@@ -9,16 +9,26 @@
  * NOT SUITABLE TO PUT ON THE INTERNET OR INTO A PRODUCTION ENVIRONMENT!!!!
  */
 #include <string.h>
+#include <strings.h>
+#if !defined(LWIP_HOST)
 #include "sdk/esp_common.h"
 #include "hal_uart.h"
 #include "freertos.h"
 #include "freertos_task.h"
+#include "freertos_semphr.h"
+#else
+/* The HTTP upload on the host, see fota_upload_test.c: the FreeRTOS calls
+ come with the lwIP sys_arch, strlcpy() of newlib with the program */
+size_t strlcpy(char *dst, const char *src, size_t size);
+#endif
 #include "app_config.h"
 #include "mbedtls/mbedtls_sha256.h"
 
 #include "tftp.h"
 #include "rboot-api.h"
 #include "fota.h"
+#include "httpd.h"
+#include "httpd_webfs.h"
 #include "log.h"
 
 #include "lwip/lwip_err.h"
@@ -27,12 +37,70 @@
 #include "lwip/lwip_netdb.h"
 #include "lwip/lwip_dns.h"
 #include "lwip/lwip_mem.h"
+#include "lwip/lwip_pbuf.h"
+#include "lwip/lwip_tcpip.h"
 #include <lwip_netbuf_helpers.h>
 #include <sdk/spi_flash.h>
 #include <sdk/esp_system.h>
 
 #define MAX_IMAGE_SIZE 0x100000 /*1MB images max at the moment */
 
+/* HTTP POST upload: the request body is the raw rboot image, e.g.
+ *   curl --data-binary @PlusFarm.bin \
+ *        -H "X-Firmware-SHA256: <hex>" http://<device>/fota
+ * The SHA256 header is optional, when present the image is rejected if the
+ * digest of the received body does not match.
+ * A web filesystem image built by makefsimage is POSTed the same way to
+ * /webfs, it is written to the WEBFS_FLASH_ADDR partition and mounted
+ * without a reboot.
+ */
+#define FOTA_HTTP_URI           "/fota"
+#define FOTA_HTTP_WEBFS_URI     "/webfs"
+#define FOTA_HTTP_OK_URI        "/fota_ok.html"
+#define FOTA_HTTP_WEBFS_OK_URI  "/webfs_ok.html"
+#define FOTA_HTTP_ERR_URI       "/fota_err.html"
+#define FOTA_HTTP_SHA256_HDR    "X-Firmware-SHA256: "
+#define FOTA_HTTP_REBOOT_DELAY  1000
+/* ms before posting to the tcpip thread again when it ran out of messages */
+#define FOTA_HTTP_RETRY_DELAY   20
+
+typedef enum
+{
+  FOTA_HTTP_RECEIVING = 0,
+  FOTA_HTTP_DONE_OK,
+  FOTA_HTTP_DONE_ERR
+} fota_http_result_t;
+
+typedef struct
+{
+  /* httpd connection of the running upload, only touched by tcpip thread */
+  void *connection;
+  /* set by httpd_post_begin, cleared by fota_http_task when it is done */
+  volatile bool active;
+  volatile fota_http_result_t result;
+  int slot;
+  /* the upload is a web filesystem image rather than firmware */
+  bool webfs;
+  uint32_t start_addr;
+  uint32_t content_len;
+  uint32_t written;
+  uint32_t start_time;
+  uint32_t min_free_heap;
+  rboot_write_status status;
+  mbedtls_sha256_context sha;
+  bool has_expected_sha;
+  uint8_t expected_sha[32];
+  /* pbufs handed over from the tcpip thread, protected by a critical section */
+  struct pbuf *pending;
+  /* bytes written to flash but not yet acknowledged to the TCP window */
+  uint32_t unacked;
+  bool reboot;
+  SemaphoreHandle_t wakeup;
+} fota_http_t;
+
+static fota_http_t fota_http;
+
+#if !defined(LWIP_HOST)
 void fota_task(void *param)
 {
   LOG_PRINTF("TFTP client task starting...");
@@ -170,5 +238,332 @@ err_t fota_download(const char *server, int port, const char *filename,
   netconn_delete(nc);
   return err;
 }
+#endif /* !LWIP_HOST */
+
+static bool fota_http_parse_sha(const char *hdr, u16_t hdr_len, uint8_t *sha)
+{
+  const char *end = hdr + hdr_len;
+  const char *p;
+  int i;
+
+  for (p = hdr; p + sizeof(FOTA_HTTP_SHA256_HDR) - 1 + 64 <= end; p++)
+  {
+    if (!strncasecmp(p, FOTA_HTTP_SHA256_HDR, sizeof(FOTA_HTTP_SHA256_HDR) - 1))
+    {
+      p += sizeof(FOTA_HTTP_SHA256_HDR) - 1;
+      for (i = 0; i < 64; i++)
+      {
+        char c = p[i];
+        uint8_t nibble;
+        if (c >= '0' && c <= '9')
+          nibble = c - '0';
+        else if (c >= 'a' && c <= 'f')
+          nibble = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+          nibble = c - 'A' + 10;
+        else
+          return false;
+        if (i % 2)
+          sha[i / 2] |= nibble;
+        else
+          sha[i / 2] = nibble << 4;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Runs on the tcpip thread: open the TCP window for the bytes that
+ * fota_http_task has written to flash so far. */
+static void fota_http_recved(void *ctx)
+{
+  uint32_t len;
+
+  taskENTER_CRITICAL();
+  len = fota_http.unacked;
+  fota_http.unacked = 0;
+  taskEXIT_CRITICAL();
+
+  if (fota_http.connection == NULL)
+    return;
+
+  while (len > 0)
+  {
+    u16_t chunk = (len > 0xFFFF) ? 0xFFFF : len;
+    httpd_post_data_recved(fota_http.connection, chunk);
+    len -= chunk;
+  }
+}
+
+static bool fota_http_finish(void)
+{
+  uint8_t hash[32];
+  uint32_t image_length;
+  const char *error = "Unknown validation error";
+
+  /* rboot_write_flash keeps back the bytes which do not fill a whole word */
+  if (fota_http.status.extra_count)
+  {
+    uint8_t pad[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+    if (!rboot_write_flash(&fota_http.status, pad,
+                           4 - fota_http.status.extra_count))
+    {
+      LOG_PRINTF("FOTA HTTP: flash write failed");
+      return false;
+    }
+  }
+
+  mbedtls_sha256_finish(&fota_http.sha, hash);
+  if (fota_http.has_expected_sha
+      && memcmp(hash, fota_http.expected_sha, sizeof(hash)))
+  {
+    LOG_PRINTF("FOTA HTTP: SHA256 mismatch");
+    return false;
+  }
+
+  if (fota_http.webfs)
+  {
+    if (!webfs_check_image(fota_http.start_addr))
+    {
+      LOG_PRINTF("FOTA HTTP: invalid web filesystem image");
+      return false;
+    }
+    return true;
+  }
+
+  if (!rboot_verify_image(fota_http.start_addr, &image_length, &error))
+  {
+    LOG_PRINTF("FOTA HTTP: %s", error);
+    return false;
+  }
+  if (image_length > fota_http.content_len)
+  {
+    LOG_PRINTF("FOTA HTTP: image truncated");
+    return false;
+  }
+
+  return true;
+}
+
+/* Runs on the tcpip thread, next to the httpd file accesses */
+static void fota_http_webfs_mount(void *ctx)
+{
+  webfs_mount();
+}
+
+/* Writes the POST body to flash. Erasing a sector blocks for tens of
+ * milliseconds, so data is only acknowledged to the TCP window after it has
+ * been written: the sender is throttled instead of pbufs piling up. */
+static void fota_http_task(void *param)
+{
+  struct pbuf *chain;
+  struct pbuf *q;
+  uint32_t heap;
+  /* fota_http_recved could not be posted, the window is still closed */
+  bool recved_retry = false;
+
+  while (1)
+  {
+    xSemaphoreTake(fota_http.wakeup, recved_retry ?
+                   FOTA_HTTP_RETRY_DELAY / portTICK_PERIOD_MS : portMAX_DELAY);
+
+    taskENTER_CRITICAL();
+    chain = fota_http.pending;
+    fota_http.pending = NULL;
+    taskEXIT_CRITICAL();
+
+    if (chain != NULL)
+    {
+      for (q = chain; q != NULL; q = q->next)
+      {
+        if (fota_http.result == FOTA_HTTP_RECEIVING)
+        {
+          mbedtls_sha256_update(&fota_http.sha, q->payload, q->len);
+          if (!rboot_write_flash(&fota_http.status, q->payload, q->len))
+          {
+            LOG_PRINTF("FOTA HTTP: flash write failed");
+            fota_http.result = FOTA_HTTP_DONE_ERR;
+          }
+        }
+        fota_http.written += q->len;
+      }
 
+      heap = xPortGetFreeHeapSize();
+      if (heap < fota_http.min_free_heap)
+        fota_http.min_free_heap = heap;
 
+      if (fota_http.result == FOTA_HTTP_RECEIVING
+          && fota_http.written >= fota_http.content_len)
+      {
+        uint32_t ms = (sdk_system_get_time() - fota_http.start_time) / 1000;
+        fota_http.result = fota_http_finish() ? FOTA_HTTP_DONE_OK :
+                                                FOTA_HTTP_DONE_ERR;
+        LOG_PRINTF("FOTA HTTP: %u bytes in %u ms (%u B/s), min free heap %u",
+                   fota_http.written, ms,
+                   ms ? (uint32_t)((uint64_t)fota_http.written * 1000 / ms) : 0,
+                   fota_http.min_free_heap);
+      }
+
+      taskENTER_CRITICAL();
+      fota_http.unacked += chain->tot_len;
+      taskEXIT_CRITICAL();
+      pbuf_free(chain);
+    }
+
+    if (chain != NULL || recved_retry)
+    {
+      /* without it no more data arrives, so retry until it is posted */
+      recved_retry = (tcpip_callback(fota_http_recved, NULL) != ERR_OK);
+    }
+
+    /* httpd_post_finished has been called: either the response is on its
+     way or the connection was closed before the whole body arrived */
+    if (fota_http.connection == NULL && fota_http.pending == NULL)
+    {
+      if (fota_http.result == FOTA_HTTP_RECEIVING)
+      {
+        LOG_PRINTF("FOTA HTTP: upload aborted after %u bytes",
+                   fota_http.written);
+      }
+      mbedtls_sha256_free(&fota_http.sha);
+      recved_retry = false;
+      if (fota_http.webfs && fota_http.result == FOTA_HTTP_DONE_OK)
+      {
+        while (tcpip_callback(fota_http_webfs_mount, NULL) != ERR_OK)
+        {
+          vTaskDelay(FOTA_HTTP_RETRY_DELAY / portTICK_PERIOD_MS);
+        }
+      }
+      if (fota_http.reboot)
+      {
+        /* let httpd deliver the response page first */
+        vTaskDelay(FOTA_HTTP_REBOOT_DELAY / portTICK_PERIOD_MS);
+        LOG_PRINTF("FOTA HTTP: rebooting into slot %d...", fota_http.slot);
+        vPortEnterCritical();
+        if (!rboot_set_current_rom(fota_http.slot))
+        {
+          LOG_PRINTF("FOTA HTTP: failed to set new rboot slot");
+        }
+        sdk_system_restart();
+      }
+      fota_http.active = false;
+    }
+  }
+}
+
+void fota_http_init(void)
+{
+  fota_http.wakeup = xSemaphoreCreateBinary();
+  xTaskCreate(fota_http_task, "task_fota_http", 512, NULL, 2, NULL);
+}
+
+err_t httpd_post_begin(void *connection, const char *uri,
+                       const char *http_request, u16_t http_request_len,
+                       int content_len, char *response_uri,
+                       u16_t response_uri_len, u8_t *post_auto_wnd)
+{
+  rboot_config conf;
+  int slot;
+  bool webfs;
+
+  webfs = !strcmp(uri, FOTA_HTTP_WEBFS_URI);
+  if (!webfs && strcmp(uri, FOTA_HTTP_URI))
+  {
+    return ERR_ARG;
+  }
+
+  if (fota_http.wakeup == NULL || fota_http.active)
+  {
+    LOG_PRINTF("FOTA HTTP: upload already in progress");
+    strlcpy(response_uri, FOTA_HTTP_ERR_URI, response_uri_len);
+    return ERR_INPROGRESS;
+  }
+
+  conf = rboot_get_config();
+  slot = (conf.current_rom + 1) % conf.count;
+  if (webfs ? (content_len > WEBFS_FLASH_SIZE) :
+              (slot == conf.current_rom || content_len > MAX_IMAGE_SIZE))
+  {
+    LOG_PRINTF("FOTA HTTP: no room for %d bytes", content_len);
+    strlcpy(response_uri, FOTA_HTTP_ERR_URI, response_uri_len);
+    return ERR_VAL;
+  }
+
+  if (webfs)
+  {
+    /* the partition is about to be overwritten, serve fsdata.c meanwhile */
+    webfs_unmount();
+  }
+
+  fota_http.connection = connection;
+  fota_http.active = true;
+  fota_http.result = FOTA_HTTP_RECEIVING;
+  fota_http.slot = slot;
+  fota_http.webfs = webfs;
+  fota_http.start_addr = webfs ? WEBFS_FLASH_ADDR : conf.roms[slot];
+  fota_http.content_len = content_len;
+  fota_http.written = 0;
+  fota_http.unacked = 0;
+  fota_http.reboot = false;
+  fota_http.start_time = sdk_system_get_time();
+  fota_http.min_free_heap = xPortGetFreeHeapSize();
+  fota_http.status = rboot_write_init(fota_http.start_addr);
+  fota_http.has_expected_sha = fota_http_parse_sha(http_request,
+                                                   http_request_len,
+                                                   fota_http.expected_sha);
+  mbedtls_sha256_init(&fota_http.sha);
+  mbedtls_sha256_starts(&fota_http.sha, 0);
+
+  /* the window is opened by fota_http_recved once data hit the flash */
+  *post_auto_wnd = 0;
+
+  LOG_PRINTF("FOTA HTTP: receiving %d bytes at 0x%x", content_len,
+             fota_http.start_addr);
+  return ERR_OK;
+}
+
+err_t httpd_post_receive_data(void *connection, struct pbuf *p)
+{
+  if (connection != fota_http.connection)
+  {
+    pbuf_free(p);
+    return ERR_VAL;
+  }
+
+  taskENTER_CRITICAL();
+  if (fota_http.pending == NULL)
+    fota_http.pending = p;
+  else
+    pbuf_cat(fota_http.pending, p);
+  taskEXIT_CRITICAL();
+
+  xSemaphoreGive(fota_http.wakeup);
+  return ERR_OK;
+}
+
+void httpd_post_finished(void *connection, char *response_uri,
+                         u16_t response_uri_len)
+{
+  if (connection != fota_http.connection)
+  {
+    return;
+  }
+
+  if (fota_http.result == FOTA_HTTP_DONE_OK && fota_http.webfs)
+  {
+    strlcpy(response_uri, FOTA_HTTP_WEBFS_OK_URI, response_uri_len);
+  }
+  else if (fota_http.result == FOTA_HTTP_DONE_OK)
+  {
+    strlcpy(response_uri, FOTA_HTTP_OK_URI, response_uri_len);
+    fota_http.reboot = true;
+  }
+  else
+  {
+    strlcpy(response_uri, FOTA_HTTP_ERR_URI, response_uri_len);
+  }
+
+  fota_http.connection = NULL;
+  xSemaphoreGive(fota_http.wakeup);
+}
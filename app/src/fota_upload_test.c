@@ -0,0 +1,609 @@
+/*
+ * FOTA upload test, a host program ("make fotaupload")
+ *
+ * httpd.c and the POST handlers of fota.c run with the tcpip thread on the
+ * threads of lwip_host_sys.c, fota_http_task() on its own, and rboot-api.c
+ * writes to a flash in RAM that takes fota_test_erase_ms to erase a sector
+ * as the chip of the device. A client POSTs rboot images to /fota over the
+ * loopback netif, as curl does in the comment of fota.c.
+ *
+ * Per upload: the bytes per second from the request to the response page,
+ * the most the stack held of the body, received and not yet written to
+ * flash, and the peaks of the lwip_pool.c classes and of the heap behind
+ * them (lwip_host_heap_malloc()). fota.c opens the TCP window for the bytes
+ * once they are in flash, so what is held stays within TCP_WND however slow
+ * the flash.
+ *
+ * The first upload has a wrong SHA256 and goes at the speed of the stack,
+ * without erase time, the second is cut short: neither may switch the ROM.
+ * The last must leave the image in the next slot, answer with the
+ * fota_ok.html page and switch to the slot before the restart.
+ */
+#if defined(LWIP_HOST)
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_sys.h"
+#include "lwip/lwip_tcpip.h"
+#include "lwip/lwip_timers.h"
+#include "lwip/lwip_tcp_impl.h"
+#include "lwip/lwip_sockets.h"
+#include "lwip_pool.h"
+#include "mbedtls/mbedtls_sha256.h"
+#include <sdk/spi_flash.h>
+#include <sdk/esp_system.h>
+
+#include "rboot-api.h"
+#include "fota.h"
+#include "httpd.h"
+#include "httpd_fs.h"
+#include "httpd_webfs.h"
+
+#if NO_SYS || !LWIP_SOCKET || !LWIP_NETIF_LOOPBACK || !LWIP_HAVE_LOOPIF
+#error "fotaupload needs the sockets of lwip_host_sys.c and the loopback netif"
+#endif
+#if !LWIP_HTTPD_SUPPORT_POST || !LWIP_HTTPD_POST_MANUAL_WND
+#error "fotaupload needs the POST handlers of httpd.c with the manual window"
+#endif
+
+#define FOTA_TEST_PORT          80
+#define FOTA_TEST_FLASH_SIZE    0x200000
+/* The OTA slots of the rboot config, 1 MB each */
+#define FOTA_TEST_ROM0          0x2000
+#define FOTA_TEST_ROM1          0x102000
+#define FOTA_TEST_IMAGE_SIZE    0x20000
+/* Time to erase a sector of the flash of the device */
+#define FOTA_TEST_ERASE_MS      40
+/* The restart comes FOTA_HTTP_REBOOT_DELAY after the response */
+#define FOTA_TEST_RESTART_MS    2000
+#define FOTA_TEST_TIMEOUT       10000
+/* An upload which takes longer is stuck, a send() can wait forever */
+#define FOTA_TEST_STUCK_S       30
+#define FOTA_TEST_RESPONSE      4096
+
+typedef enum
+{
+  FOTA_TEST_OK = 0,
+  FOTA_TEST_BAD_SHA,
+  FOTA_TEST_ABORT
+} fota_test_kind_t;
+
+typedef struct
+{
+  const char *name;
+  fota_test_kind_t kind;
+  u32_t erase_ms;
+} fota_test_run_t;
+
+static const fota_test_run_t fota_test_runs[] =
+{
+  { "bad sha", FOTA_TEST_BAD_SHA, 0 },
+  { "aborted", FOTA_TEST_ABORT, FOTA_TEST_ERASE_MS },
+  /* the last, fota.c waits for the restart from then on */
+  { "ok", FOTA_TEST_OK, FOTA_TEST_ERASE_MS }
+};
+
+/* The upload the tick of the tcpip thread measures */
+typedef struct
+{
+  /* client port, 0 while there is no upload */
+  u16_t port;
+  /* sequence number of the first byte of the body */
+  u32_t body_seq;
+  u32_t held_max;
+  u32_t pool_max;
+} fota_test_upload_t;
+
+static u8_t fota_test_flash[FOTA_TEST_FLASH_SIZE] __attribute__((aligned(4)));
+static u8_t fota_test_image[FOTA_TEST_IMAGE_SIZE];
+static u32_t fota_test_erase_ms;
+/* bytes sdk_spi_flash_write() has written, of the uploads */
+static u32_t fota_test_flashed;
+/* writes which needed an erase first */
+static u32_t fota_test_unerased;
+static fota_test_upload_t fota_test_upload;
+static sys_sem_t fota_test_restart;
+static u32_t fota_test_t0;
+static u32_t fota_test_seed = 2463534242UL;
+static unsigned long fota_test_failures;
+
+static void fota_test_check(int ok, const char *what)
+{
+  if (!ok)
+  {
+    fota_test_failures++;
+    printf("fotaupload: at %u ms: %s\n", (unsigned)(sys_now() - fota_test_t0),
+           what);
+  }
+}
+
+static void fota_test_stuck(int sig)
+{
+  static const char msg[] = "fotaupload: upload stuck\n";
+
+  (void)sig;
+  /* write() of libc, lwip_sockets.h makes the name lwip_write() */
+  if ((write)(STDOUT_FILENO, msg, sizeof(msg) - 1) < 0)
+  {
+    /* exit all the same */
+  }
+  _exit(1);
+}
+
+static u32_t fota_test_rand(void)
+{
+  fota_test_seed ^= fota_test_seed << 13;
+  fota_test_seed ^= fota_test_seed >> 17;
+  fota_test_seed ^= fota_test_seed << 5;
+  return fota_test_seed;
+}
+
+/* The SDK, rboot and webfs calls of fota.c, and strlcpy() of newlib */
+sdk_SpiFlashOpResult sdk_spi_flash_erase_sector(uint16_t sec)
+{
+  struct timespec ts;
+
+  if ((u32_t)(sec + 1) * SPI_FLASH_SEC_SIZE > FOTA_TEST_FLASH_SIZE)
+  {
+    return SPI_FLASH_RESULT_ERR;
+  }
+  memset(fota_test_flash + sec * SPI_FLASH_SEC_SIZE, 0xFF, SPI_FLASH_SEC_SIZE);
+  ts.tv_sec = 0;
+  ts.tv_nsec = (long)fota_test_erase_ms * 1000000;
+  nanosleep(&ts, NULL);
+  return SPI_FLASH_RESULT_OK;
+}
+
+/* Programming only clears bits, as on the chip */
+sdk_SpiFlashOpResult sdk_spi_flash_write(uint32_t des_addr, uint32_t *src,
+                                         uint32_t size)
+{
+  const u8_t *data = (const u8_t *)src;
+  u32_t i;
+
+  if ((des_addr % 4) || (size % 4) || (des_addr + size > FOTA_TEST_FLASH_SIZE))
+  {
+    return SPI_FLASH_RESULT_ERR;
+  }
+  for (i = 0; i < size; i++)
+  {
+    if ((fota_test_flash[des_addr + i] & data[i]) != data[i])
+    {
+      __atomic_add_fetch(&fota_test_unerased, 1, __ATOMIC_RELAXED);
+    }
+    fota_test_flash[des_addr + i] &= data[i];
+  }
+  if (des_addr >= FOTA_TEST_ROM0)
+  {
+    __atomic_add_fetch(&fota_test_flashed, size, __ATOMIC_RELAXED);
+  }
+  return SPI_FLASH_RESULT_OK;
+}
+
+sdk_SpiFlashOpResult sdk_spi_flash_read(uint32_t src_addr, uint32_t *des,
+                                        uint32_t size)
+{
+  if (src_addr + size > FOTA_TEST_FLASH_SIZE)
+  {
+    return SPI_FLASH_RESULT_ERR;
+  }
+  memcpy(des, fota_test_flash + src_addr, size);
+  return SPI_FLASH_RESULT_OK;
+}
+
+bool sdk_system_rtc_mem_read(uint32_t src_addr, void *des_addr,
+                             uint16_t save_size)
+{
+  return false;
+}
+
+bool sdk_system_rtc_mem_write(uint32_t des_addr, void *src_addr,
+                              uint16_t save_size)
+{
+  return false;
+}
+
+uint32_t sdk_system_get_time(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+/* The device boots the new ROM, fota_http_task() stops here */
+void sdk_system_restart(void)
+{
+  sys_sem_signal(&fota_test_restart);
+  while (1)
+  {
+    vTaskDelay(portMAX_DELAY / 1000);
+  }
+}
+
+void Log_Printf(const char *format, ...)
+{
+  va_list ap;
+
+  printf("    ");
+  va_start(ap, format);
+  vprintf(format, ap);
+  va_end(ap);
+  printf("\n");
+}
+
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+  size_t len = strlen(src);
+
+  if (size > 0)
+  {
+    size_t n = (len < size) ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+
+bool webfs_check_image(uint32_t addr)
+{
+  return false;
+}
+
+err_t webfs_mount(void)
+{
+  return ERR_OK;
+}
+
+void webfs_unmount(void)
+{
+}
+
+static struct tcp_pcb *fota_test_pcb(u16_t local_port, u16_t remote_port)
+{
+  struct tcp_pcb *pcb;
+
+  for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next)
+  {
+    if ((pcb->local_port == local_port) && (pcb->remote_port == remote_port))
+    {
+      return pcb;
+    }
+  }
+  return NULL;
+}
+
+static u32_t fota_test_pool_used(void)
+{
+  lwip_pool_stats_t stats[8];
+  u8_t n = lwip_pool_get_stats(stats, 8);
+  u32_t used = 0;
+  u8_t i;
+
+  for (i = 0; i < n; i++)
+  {
+    used += (u32_t)stats[i].used * stats[i].size;
+  }
+  return used;
+}
+
+/* Every ms on the tcpip thread: what the server side of the upload has
+ received and fota.c has not written to flash yet */
+static void fota_test_tick(void *arg)
+{
+  fota_test_upload_t *up = &fota_test_upload;
+  struct tcp_pcb *pcb;
+  u32_t received;
+  u32_t flashed;
+  u32_t used;
+
+  sys_timeout(1, fota_test_tick, arg);
+  if (up->port == 0)
+  {
+    return;
+  }
+  pcb = fota_test_pcb(FOTA_TEST_PORT, up->port);
+  if ((pcb != NULL) && TCP_SEQ_GT(pcb->rcv_nxt, up->body_seq))
+  {
+    received = pcb->rcv_nxt - up->body_seq;
+    flashed = __atomic_load_n(&fota_test_flashed, __ATOMIC_RELAXED);
+    if ((received > flashed) && (received - flashed > up->held_max))
+    {
+      up->held_max = received - flashed;
+    }
+  }
+  used = fota_test_pool_used();
+  if (used > up->pool_max)
+  {
+    up->pool_max = used;
+  }
+}
+
+static void fota_test_init_done(void *arg)
+{
+  sys_sem_signal((sys_sem_t *)arg);
+}
+
+/* An rboot image of one section, the checksum at the end of the last 16 B */
+static void fota_test_make_image(u8_t *image, u32_t size)
+{
+  u32_t len = size - 32;
+  u8_t checksum = CHKSUM_INIT;
+  u32_t i;
+
+  memset(image, 0, size);
+  image[0] = 0xe9;
+  image[1] = 1;
+  image[4] = 0x10;
+  image[5] = 0x10;
+  image[6] = 0x20;
+  image[7] = 0x40;
+  image[12] = len & 0xFF;
+  image[13] = (len >> 8) & 0xFF;
+  image[14] = (len >> 16) & 0xFF;
+  for (i = 0; i < len; i++)
+  {
+    image[16 + i] = fota_test_rand();
+    checksum ^= image[16 + i];
+  }
+  image[size - 1] = checksum;
+}
+
+static void fota_test_config(void)
+{
+  rboot_config conf;
+
+  memset(fota_test_flash, 0xFF, sizeof(fota_test_flash));
+  memset(&conf, 0, sizeof(conf));
+  conf.magic = BOOT_CONFIG_MAGIC;
+  conf.version = BOOT_CONFIG_VERSION;
+  conf.count = 2;
+  conf.roms[0] = FOTA_TEST_ROM0;
+  conf.roms[1] = FOTA_TEST_ROM1;
+  fota_test_check(rboot_set_config(&conf), "rboot config not written");
+}
+
+static int fota_test_connect(void)
+{
+  struct sockaddr_in addr;
+  int timeout = FOTA_TEST_TIMEOUT;
+  int s;
+
+  s = lwip_socket(AF_INET, SOCK_STREAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(FOTA_TEST_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if ((s < 0) || (lwip_connect(s, (struct sockaddr *)&addr, sizeof(addr)) != 0))
+  {
+    return -1;
+  }
+  lwip_setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  lwip_setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  return s;
+}
+
+/* Measure the upload of 'head_len' bytes of request on the connection 's' */
+static void fota_test_measure(int s, u32_t head_len)
+{
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  struct tcp_pcb *pcb;
+
+  lwip_getsockname(s, (struct sockaddr *)&addr, &len);
+  LOCK_TCPIP_CORE();
+  memset(&fota_test_upload, 0, sizeof(fota_test_upload));
+  /* nothing sent yet, the server expects the byte after the SYN */
+  pcb = fota_test_pcb(ntohs(addr.sin_port), FOTA_TEST_PORT);
+  if (pcb != NULL)
+  {
+    fota_test_upload.body_seq = pcb->snd_nxt + head_len;
+    fota_test_upload.port = ntohs(addr.sin_port);
+  }
+  UNLOCK_TCPIP_CORE();
+  fota_test_check(pcb != NULL, "client pcb not found");
+}
+
+static int fota_test_send(int s, const void *data, u32_t len)
+{
+  const u8_t *p = data;
+  int n;
+
+  while (len > 0)
+  {
+    n = lwip_send(s, p, (len > TCP_MSS) ? TCP_MSS : len, 0);
+    if (n <= 0)
+    {
+      return -1;
+    }
+    p += n;
+    len -= n;
+  }
+  return 0;
+}
+
+/* The response, until the server closes, returns its length */
+static int fota_test_response(int s, char *buf, int size)
+{
+  int len = 0;
+  int n;
+
+  while ((len < size) && ((n = lwip_recv(s, buf + len, size - len, 0)) > 0))
+  {
+    len += n;
+  }
+  return len;
+}
+
+/* Non zero if 'response' ends with the page 'uri' of the ROM files */
+static int fota_test_page(const char *response, int len, const char *uri)
+{
+  struct fs_file file;
+  int page_len;
+
+  if (fs_open(&file, uri) != ERR_OK)
+  {
+    return 0;
+  }
+  page_len = file.len;
+  fs_close(&file);
+  return (len >= page_len)
+      && !memcmp(response + len - page_len, file.data, page_len);
+}
+
+static void fota_test_run(const fota_test_run_t *run)
+{
+  static char response[FOTA_TEST_RESPONSE];
+  char head[256];
+  char hex[65];
+  u8_t sha[32];
+  rboot_config before;
+  rboot_config after;
+  u32_t body_len;
+  u32_t flashed;
+  u32_t start;
+  u32_t ms;
+  size_t heap;
+  size_t heap_min;
+  int head_len;
+  int len;
+  int restarted;
+  int slot;
+  int s;
+  int i;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  fota_test_make_image(fota_test_image, sizeof(fota_test_image));
+  mbedtls_sha256(fota_test_image, sizeof(fota_test_image), sha, 0);
+  for (i = 0; i < 32; i++)
+  {
+    sprintf(hex + 2 * i, "%02x", sha[i]);
+  }
+  if (run->kind == FOTA_TEST_BAD_SHA)
+  {
+    hex[0] = (hex[0] == '0') ? '1' : '0';
+  }
+  body_len = (run->kind == FOTA_TEST_ABORT) ? sizeof(fota_test_image) / 2 :
+                                              sizeof(fota_test_image);
+  head_len = snprintf(head, sizeof(head),
+                      "POST /fota HTTP/1.1\r\nHost: plusfarm\r\n"
+                      "Connection: close\r\n"
+                      "Content-Type: application/octet-stream\r\n"
+                      "Content-Length: %u\r\nX-Firmware-SHA256: %s\r\n\r\n",
+                      (unsigned)sizeof(fota_test_image), hex);
+
+  before = rboot_get_config();
+  slot = (before.current_rom + 1) % before.count;
+  fota_test_erase_ms = run->erase_ms;
+  __atomic_store_n(&fota_test_flashed, 0, __ATOMIC_RELAXED);
+  SYS_ARCH_PROTECT(lev);
+  heap = lwip_host_free_heap;
+  lwip_host_min_free_heap = heap;
+  SYS_ARCH_UNPROTECT(lev);
+
+  alarm(FOTA_TEST_STUCK_S);
+  start = sys_now();
+  s = fota_test_connect();
+  fota_test_check(s >= 0, "connect failed");
+  if (s < 0)
+  {
+    alarm(0);
+    return;
+  }
+  fota_test_measure(s, head_len);
+  fota_test_check(fota_test_send(s, head, head_len) == 0, "request not sent");
+  fota_test_check(fota_test_send(s, fota_test_image, body_len) == 0,
+                  "body not sent");
+  len = (run->kind == FOTA_TEST_ABORT) ? 0 :
+      fota_test_response(s, response, sizeof(response));
+  ms = sys_now() - start;
+  lwip_close(s);
+  restarted = (sys_arch_sem_wait(&fota_test_restart, FOTA_TEST_RESTART_MS)
+      != SYS_ARCH_TIMEOUT);
+  alarm(0);
+  LOCK_TCPIP_CORE();
+  fota_test_upload.port = 0;
+  UNLOCK_TCPIP_CORE();
+  after = rboot_get_config();
+  flashed = __atomic_load_n(&fota_test_flashed, __ATOMIC_RELAXED);
+  SYS_ARCH_PROTECT(lev);
+  heap_min = lwip_host_min_free_heap;
+  SYS_ARCH_UNPROTECT(lev);
+
+  printf("  %-8s %6u B in %5u ms %8.0f B/s, held %5u B, pool %5u B, "
+         "heap %5u B\n", run->name, (unsigned)body_len, (unsigned)ms,
+         ms ? body_len * 1000.0 / ms : 0.0,
+         (unsigned)fota_test_upload.held_max,
+         (unsigned)fota_test_upload.pool_max,
+         (unsigned)(heap - heap_min));
+
+  fota_test_check(fota_test_upload.held_max <= TCP_WND,
+                  "more than TCP_WND held in RAM");
+  if (run->kind != FOTA_TEST_ABORT)
+  {
+    /* rboot_write_flash() keeps back the bytes of a word the aborted upload
+     does not fill */
+    fota_test_check(flashed >= body_len, "body not written to flash");
+  }
+  if (run->kind == FOTA_TEST_OK)
+  {
+    fota_test_check(fota_test_page(response, len, "/fota_ok.html"),
+                    "no fota_ok.html page");
+    fota_test_check(restarted, "no restart");
+    fota_test_check(after.current_rom == slot, "slot not switched");
+    fota_test_check(!memcmp(fota_test_flash + before.roms[slot],
+                            fota_test_image, sizeof(fota_test_image)),
+                    "image not in the slot");
+  }
+  else
+  {
+    if (run->kind == FOTA_TEST_BAD_SHA)
+    {
+      fota_test_check(fota_test_page(response, len, "/fota_err.html"),
+                      "no fota_err.html page");
+    }
+    fota_test_check(!restarted, "restarted");
+    fota_test_check(after.current_rom == before.current_rom, "slot switched");
+  }
+}
+
+int main(void)
+{
+  sys_sem_t sem;
+  size_t i;
+
+  /* what fota_test_stuck() exits on has been printed */
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  printf("fotaupload, %u B images to /fota over loopback, TCP_WND %u\n",
+         FOTA_TEST_IMAGE_SIZE, TCP_WND);
+  fota_test_t0 = sys_now();
+  signal(SIGALRM, fota_test_stuck);
+  fota_test_config();
+  sys_sem_new(&sem, 0);
+  sys_sem_new(&fota_test_restart, 0);
+  tcpip_init(fota_test_init_done, &sem);
+  sys_sem_wait(&sem);
+  sys_sem_free(&sem);
+
+  fota_http_init();
+  LOCK_TCPIP_CORE();
+  httpd_init();
+  sys_timeout(1, fota_test_tick, NULL);
+  UNLOCK_TCPIP_CORE();
+
+  for (i = 0; i < sizeof(fota_test_runs) / sizeof(fota_test_runs[0]); i++)
+  {
+    fota_test_run(&fota_test_runs[i]);
+  }
+  fota_test_check(fota_test_unerased == 0, "flash written without an erase");
+
+  return (fota_test_failures == 0) ? 0 : 1;
+}
+
+#endif /* LWIP_HOST */
@@ -26,10 +26,29 @@
 #include "hal_rtcmem_regs.h"
 #include "app_config.h"
 #include "httpd.h"
+#include "httpd_webfs.h"
 #include "dhcpserver.h"
 #include "fota.h"
+#include "heap_stats.h"
+#include "stack_stats.h"
+#include "hal_hrtimer.h"
+#include "lwip/lwip_api.h"
+#include "lwip_metrics.h"
+#include "lwip_bench.h"
+#include "mbedtls_bench.h"
+#include "mbedtls_tls_arena.h"
+#include "jsmn.h"
+#include "app_settings_bind.h"
 
 #define PUB_MSG_LEN 16
+/* lwip_metrics_format_json() summary published to "metrics" */
+#define METRICS_MSG_LEN 192
+#define METRICS_PUB_PERIOD_MS 30000
+#define MQTT_BUF_LEN 256
+/* Members of an MQTT settings object, a key and a value token each */
+#define SETTINGS_TOKENS 16
+/* Stack of task_cryptobench, in words */
+#define CRYPTOBENCH_STACK 1024
 
 QueueHandle_t publish_queue;
 
@@ -98,11 +117,23 @@ enum
 {
   SSI_UPTIME,
   SSI_FREE_HEAP,
-  SSI_LED_STATE
+  SSI_LED_STATE,
+  SSI_HEAP_LARGEST,
+  SSI_HEAP_CHUNKS,
+  SSI_HEAP_COST,
+  SSI_HEAP_TASKS
 };
 
-int32_t ssi_handler(int32_t iIndex, char *pcInsert, int32_t iInsertLen)
+/* Only used from the tcpip thread, kept off its stack */
+static heap_stats_t ssi_heap;
+static heap_task_stats_t ssi_heap_tasks[HEAP_STATS_TASKS];
+
+int32_t ssi_handler(int32_t iIndex, char *pcInsert, int32_t iInsertLen,
+                    uint16_t current_tag_part, uint16_t *next_tag_part)
 {
+  uint8_t n;
+  int len;
+
   switch (iIndex)
   {
     case SSI_UPTIME:
@@ -115,6 +146,51 @@ int32_t ssi_handler(int32_t iIndex, char *pcInsert, int32_t iInsertLen)
     case SSI_LED_STATE:
       snprintf(pcInsert, iInsertLen, HAL_GPIO_Read(LED_PIN) ? "Off" : "On");
       break;
+    case SSI_HEAP_LARGEST:
+      heap_get_stats(&ssi_heap);
+      snprintf(pcInsert, iInsertLen, "%u", ssi_heap.largest);
+      break;
+    case SSI_HEAP_CHUNKS:
+      heap_get_stats(&ssi_heap);
+      for (n = 0, len = 0; n < HEAP_STATS_HIST_BUCKETS - 1; n++)
+      {
+        len += snprintf(pcInsert + len, iInsertLen - len, "<%u:%u ",
+                        HEAP_STATS_HIST_LIMIT(n), ssi_heap.hist[n]);
+        /* snprintf() returns the untruncated length */
+        if (len > iInsertLen - 1)
+          len = iInsertLen - 1;
+      }
+      snprintf(pcInsert + len, iInsertLen - len, ">=%u:%u",
+               HEAP_STATS_HIST_LAST, ssi_heap.hist[n]);
+      break;
+    case SSI_HEAP_COST:
+      heap_get_stats(&ssi_heap);
+      snprintf(pcInsert, iInsertLen, "%u calls, %u cycles avg, %u header bytes",
+               ssi_heap.calls,
+               ssi_heap.calls ? ssi_heap.cycles / ssi_heap.calls : 0,
+               ssi_heap.overhead);
+      break;
+    case SSI_HEAP_TASKS:
+      /* one table row per part */
+      n = heap_get_task_stats(ssi_heap_tasks, HEAP_STATS_TASKS);
+      if (current_tag_part < n)
+      {
+        snprintf(pcInsert, iInsertLen,
+                 "<tr><td>%s</td><td>%u</td><td>%u</td><td>%u</td></tr>",
+                 ssi_heap_tasks[current_tag_part].name,
+                 ssi_heap_tasks[current_tag_part].live,
+                 ssi_heap_tasks[current_tag_part].peak,
+                 ssi_heap_tasks[current_tag_part].count);
+        if (current_tag_part + 1 < n)
+        {
+          *next_tag_part = current_tag_part + 1;
+        }
+      }
+      else
+      {
+        pcInsert[0] = '\0';
+      }
+      break;
     default:
       snprintf(pcInsert, iInsertLen, "N/A");
       break;
@@ -167,35 +243,27 @@ char *websocket_cgi_handler(int iIndex, int iNumParams, char *pcParam[],
   return "/websockets.html";
 }
 
-void websocket_task(void *pvParameter)
+/* /bench?run=1 opens the benchmark service for util/netbench.py, run=0
+ closes it */
+char *bench_cgi_handler(int iIndex, int iNumParams, char *pcParam[],
+                        char *pcValue[])
 {
-  struct tcp_pcb *pcb = (struct tcp_pcb *)pvParameter;
-
-  for (;;)
+  for (int i = 0; i < iNumParams; i++)
   {
-    if (pcb == NULL || pcb->state != ESTABLISHED)
+    if (strcmp(pcParam[i], "run") == 0)
     {
-      printf("Connection closed, deleting task\n");
-      break;
+      if (atoi(pcValue[i]) != 0)
+      {
+        lwip_bench_start();
+      }
+      else
+      {
+        lwip_bench_stop();
+      }
+      return "/bench_ok.html";
     }
-
-    int uptime = xTaskGetTickCount() * portTICK_PERIOD_MS / 1000;
-    int heap = (int)xPortGetFreeHeapSize();
-    int led = !HAL_GPIO_Read(LED_PIN);
-
-    /* Generate response in JSON format */
-    char response[64];
-    int len = snprintf(response, sizeof(response), "{\"uptime\" : \"%d\","
-                       " \"heap\" : \"%d\","
-                       " \"led\" : \"%d\"}",
-                       uptime, heap, led);
-    if (len < sizeof(response))
-      websocket_write(pcb, (unsigned char *)response, len, WS_TEXT_MODE);
-
-    vTaskDelay(2000 / portTICK_PERIOD_MS);
   }
-
-  vTaskDelete(NULL);
+  return "/404.html";
 }
 
 /**
@@ -239,28 +307,72 @@ void websocket_cb(struct tcp_pcb *pcb, uint8_t *data, u16_t data_len,
 }
 
 /**
- * This function is called when new websocket is open and
- * creates a new websocket_task if requested URI equals '/stream'.
+ * This function is called when new websocket is open. Live statistics are
+ * streamed from task_http to LWIP_HTTPD_SSE_URI instead of a task per
+ * websocket.
  */
 void websocket_open_cb(struct tcp_pcb *pcb, const char *uri)
 {
   printf("WS URI: %s\n", uri);
-  if (!strcmp(uri, "/stream"))
+}
+
+/* Telemetry event pushed to the SSE clients, the values are written in place
+ into fixed-width fields (right-aligned, space padded) */
+#define TELEMETRY_UPTIME      "{\"uptime\":\""
+#define TELEMETRY_HEAP        "\",\"heap\":\""
+#define TELEMETRY_LED         "\",\"led\":\""
+#define TELEMETRY_END         "\"}"
+#define TELEMETRY_UPTIME_LEN  10
+#define TELEMETRY_HEAP_LEN    6
+#define TELEMETRY_LED_LEN     1
+
+#define TELEMETRY_UPTIME_POS  (sizeof(TELEMETRY_UPTIME) - 1)
+#define TELEMETRY_HEAP_POS    (TELEMETRY_UPTIME_POS + TELEMETRY_UPTIME_LEN \
+                               + sizeof(TELEMETRY_HEAP) - 1)
+#define TELEMETRY_LED_POS     (TELEMETRY_HEAP_POS + TELEMETRY_HEAP_LEN \
+                               + sizeof(TELEMETRY_LED) - 1)
+
+static char telemetry_event[] = TELEMETRY_UPTIME "          " TELEMETRY_HEAP
+    "      " TELEMETRY_LED " " TELEMETRY_END;
+
+static void telemetry_set_field(char *field, uint32_t val, uint8_t width)
+{
+  do
   {
-    printf("request for streaming\n");
-    xTaskCreate(&websocket_task, "websocket_task", 256, (void *)pcb, 2, NULL);
-  }
+    field[--width] = '0' + val % 10;
+    val /= 10;
+  } while (width && val);
+  while (width)
+    field[--width] = ' ';
+}
+
+static void telemetry_publish(void)
+{
+  telemetry_set_field(&telemetry_event[TELEMETRY_UPTIME_POS],
+                      xTaskGetTickCount() * portTICK_PERIOD_MS / 1000,
+                      TELEMETRY_UPTIME_LEN);
+  telemetry_set_field(&telemetry_event[TELEMETRY_HEAP_POS],
+                      xPortGetFreeHeapSize(), TELEMETRY_HEAP_LEN);
+  telemetry_set_field(&telemetry_event[TELEMETRY_LED_POS],
+                      !HAL_GPIO_Read(LED_PIN), TELEMETRY_LED_LEN);
+  httpd_sse_publish(NULL, telemetry_event, sizeof(telemetry_event) - 1);
 }
 
 void task_http(void *pvParameters)
 {
+  uint8_t stats_count = 0;
   tCGI pCGIs[] = { { "/gpio", (tCGIHandler)gpio_cgi_handler }, {
       "/about", (tCGIHandler)about_cgi_handler },
-                   { "/websockets", (tCGIHandler)websocket_cgi_handler }, };
+                   { "/websockets", (tCGIHandler)websocket_cgi_handler },
+                   { "/bench", (tCGIHandler)bench_cgi_handler }, };
 
   const char *pcConfigSSITags[] = { "uptime", // SSI_UPTIME
       "heap",   // SSI_FREE_HEAP
-      "led"     // SSI_LED_STATE
+      "led",    // SSI_LED_STATE
+      "heapmax",  // SSI_HEAP_LARGEST
+      "heapfrag", // SSI_HEAP_CHUNKS
+      "heapcost", // SSI_HEAP_COST
+      "heaptask"  // SSI_HEAP_TASKS
       };
 
   /* register handlers and start the server */
@@ -269,13 +381,83 @@ void task_http(void *pvParameters)
                        sizeof(pcConfigSSITags) / sizeof(pcConfigSSITags[0]));
   websocket_register_callbacks((tWsOpenHandler)websocket_open_cb,
                                (tWsHandler)websocket_cb);
+  fota_http_init();
+  webfs_init();
+  lwip_metrics_init();
   httpd_init();
 
+  /* live dashboard of websockets.html, shared by all clients */
   while (1)
   {
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
+    telemetry_publish();
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+
+    if (++stats_count == 30)
+    {
+      httpd_stats_t stats;
+
+      stats_count = 0;
+      httpd_get_stats(&stats);
+      LOG_PRINTF("httpd: %u conns (%u active, %u max, %u refused, %u timeout)",
+                 stats.conns, stats.conns_active, stats.conns_max,
+                 stats.conns_refused, stats.conns_timeout);
+      LOG_PRINTF("httpd: %u reqs (%u err, %u dropped, %u keepalive, "
+                 "%u pipelined), %u alloc err, %u bytes sent",
+                 stats.reqs, stats.reqs_err, stats.reqs_dropped,
+                 stats.keepalive, stats.pipelined, stats.alloc_err,
+                 stats.bytes_sent);
+      if (stats.reqs > stats.reqs_dropped)
+      {
+        LOG_PRINTF("httpd: response time %u ms avg, %u ms max",
+                   stats.resp_time_total / (stats.reqs - stats.reqs_dropped),
+                   stats.resp_time_max);
+      }
+#if configUSE_TRACE_RECORDER
+      trace_print_cpu();
+#endif
+      stack_stats_report();
+    }
+  }
+}
+
+/* TCP port of the trace dumps, 0 for none. Anyone who can reach the device
+ can read the trace, only for debugging builds */
+#ifndef TRACE_PORT
+#define TRACE_PORT 0
+#endif
+
+#if configUSE_TRACE_RECORDER && TRACE_PORT
+static void trace_write_netconn(const char *data, size_t len, void *ctx)
+{
+  netconn_write((struct netconn *)ctx, data, len, NETCONN_COPY);
+}
+
+/* Each connection receives a dump of the trace ring and is closed, eg.
+ nc <ip> 5555 > trace.txt && util/trace2chrome.py trace.txt > trace.json */
+void task_trace(void *pvParameters)
+{
+  struct netconn *listener;
+  struct netconn *conn;
+
+  listener = netconn_new(NETCONN_TCP);
+  if ((listener == NULL) || (netconn_bind(listener, IP_ADDR_ANY, TRACE_PORT)
+      != ERR_OK) || (netconn_listen(listener) != ERR_OK))
+  {
+    LOG_PRINTF("trace: cannot listen on port %d", TRACE_PORT);
+    vTaskDelete(NULL);
+    return;
+  }
+
+  while (1)
+  {
+    if (netconn_accept(listener, &conn) != ERR_OK)
+      continue;
+    trace_dump(trace_write_netconn, conn);
+    netconn_close(conn);
+    netconn_delete(conn);
   }
 }
+#endif
 
 const char *mqtt_get_id(void)
 {
@@ -343,14 +525,116 @@ void topic_received(mqtt_message_data_t* md)
   LOG_PRINTF("Topic Received: %s = %s", topic, msg);
 }
 
+// "start" or "stop" on the bench topic drives the benchmark service, "crypto"
+// runs the crypto benchmark once
+/* The crypto benchmark blocks for seconds, it runs in a task of its own at
+ a lower priority so that task_mqtt keeps serving the connection */
+static volatile bool cryptobench_running;
+
+void task_cryptobench(void *param)
+{
+  mbedtls_bench_run();
+  cryptobench_running = false;
+  vTaskDelete(NULL);
+}
+
+void bench_received(mqtt_message_data_t* md)
+{
+  char msg[8];
+  size_t len = LWIP_MIN(md->message->payloadlen, sizeof(msg) - 1);
+
+  memcpy(msg, md->message->payload, len);
+  msg[len] = '\0';
+  if (strcmp(msg, "start") == 0)
+  {
+    lwip_bench_start();
+  }
+  else if (strcmp(msg, "stop") == 0)
+  {
+    lwip_bench_stop();
+  }
+  else if (strcmp(msg, "crypto") == 0)
+  {
+    if (cryptobench_running)
+    {
+      LOG_PRINTF("Bench: crypto already running");
+      return;
+    }
+    cryptobench_running = true;
+    if (xTaskCreate(task_cryptobench, "task_crypto", CRYPTOBENCH_STACK, NULL,
+                    tskIDLE_PRIORITY + 1, NULL) != pdPASS)
+    {
+      cryptobench_running = false;
+      LOG_PRINTF("Bench: no memory for task_crypto");
+      return;
+    }
+  }
+  LOG_PRINTF("Bench: %s", msg);
+}
+
+/* Settings changed over MQTT, echoed on "settings/state" by task_mqtt */
+static app_settings_t settings =
+{
+  .led = false,
+  .metrics_period = METRICS_PUB_PERIOD_MS / 1000,
+  .bench = false
+};
+static bool settings_changed = true;
+
+// JSON object on the settings topic, only the members present are applied
+void settings_received(mqtt_message_data_t* md)
+{
+  jsmntok_t tokens[SETTINGS_TOKENS];
+  jsmn_parser parser;
+  app_settings_t update = settings;
+  uint32_t seen = 0;
+  int ret;
+
+  jsmn_init(&parser);
+  ret = jsmn_parse(&parser, md->message->payload, md->message->payloadlen,
+                   tokens, SETTINGS_TOKENS);
+  /* an empty payload has no tokens, and nothing to decode */
+  if (ret > 0)
+    ret = app_settings_decode(&update, md->message->payload, tokens, ret,
+                              &seen);
+  else if (ret == 0)
+    ret = JSMN_ERROR_PART;
+  if (ret < 0)
+  {
+    LOG_PRINTF("Settings: invalid (%d)", ret);
+    return;
+  }
+
+  if (seen & APP_SETTINGS_LED)
+  {
+    /* the LED is active low */
+    if (update.led)
+      HAL_GPIO_SetLow(LED_PIN);
+    else
+      HAL_GPIO_SetHigh(LED_PIN);
+  }
+  if (seen & APP_SETTINGS_BENCH)
+  {
+    if (update.bench)
+      lwip_bench_start();
+    else
+      lwip_bench_stop();
+  }
+  settings = update;
+  settings_changed = true;
+}
+
 void task_mqtt(void *param)
 {
   mqtt_network_t network;
   mqtt_client_t client = mqtt_client_default;
   mqtt_packet_connect_data_t data = mqtt_packet_connect_data_initializer;
-  unsigned char mqtt_buf[100];
+  unsigned char mqtt_buf[MQTT_BUF_LEN];
   unsigned char mqtt_readbuf[100];
   char mqtt_client_id[30];
+  char metrics_msg[METRICS_MSG_LEN];
+  char settings_msg[APP_SETTINGS_JSON_MAX];
+  TickType_t metrics_tick = 0;
   int ret;
   uint8_t wifi_status;
   uint8_t timeout;
@@ -394,6 +678,7 @@ void task_mqtt(void *param)
       if (wifi_status == STATION_GOT_IP)
       {
         LOG_PRINTF("WiFi: Connected");
+        lwip_metrics_init();
       }
 
       while (sdk_wifi_station_get_connect_status() == STATION_GOT_IP)
@@ -407,8 +692,8 @@ void task_mqtt(void *param)
           LOG_PRINTF("(Re)connecting to MQTT server %s OK ", MQTT_HOST);
 
           /* Create new MQTT client */
-          mqtt_client_new(&client, &network, 5000, mqtt_buf, 100, mqtt_readbuf,
-                          100);
+          mqtt_client_new(&client, &network, 5000, mqtt_buf, MQTT_BUF_LEN,
+                          mqtt_readbuf, 100);
           data.willFlag = 0;
           data.MQTTVersion = 3;
           data.clientID.cstring = mqtt_client_id;
@@ -427,6 +712,16 @@ void task_mqtt(void *param)
             /* Subscriptions */
             ret = mqtt_subscribe(&client, "temperature", MQTT_QOS1,
                                  topic_received);
+            if (ret == MQTT_SUCCESS)
+            {
+              ret = mqtt_subscribe(&client, "bench", MQTT_QOS1,
+                                   bench_received);
+            }
+            if (ret == MQTT_SUCCESS)
+            {
+              ret = mqtt_subscribe(&client, "settings", MQTT_QOS1,
+                                   settings_received);
+            }
 
             if (ret == MQTT_SUCCESS)
             {
@@ -449,6 +744,36 @@ void task_mqtt(void *param)
                   if (ret != MQTT_SUCCESS)
                     break;
                 }
+                /* Network and heap summary */
+                if (xTaskGetTickCount() - metrics_tick
+                    >= settings.metrics_period * 1000 / portTICK_PERIOD_MS)
+                {
+                  mqtt_message_t message;
+                  metrics_tick = xTaskGetTickCount();
+                  message.payload = metrics_msg;
+                  message.payloadlen = lwip_metrics_format_json(metrics_msg,
+                                                                METRICS_MSG_LEN);
+                  message.dup = 0;
+                  message.qos = MQTT_QOS0;
+                  message.retained = 0;
+                  if (message.payloadlen != 0)
+                    mqtt_publish(&client, "metrics", &message);
+                }
+                /* Current settings, retained for new subscribers */
+                if (settings_changed)
+                {
+                  mqtt_message_t message;
+                  message.payload = settings_msg;
+                  message.payloadlen = app_settings_encode(&settings,
+                                                           settings_msg,
+                                                           sizeof(settings_msg));
+                  message.dup = 0;
+                  message.qos = MQTT_QOS1;
+                  message.retained = 1;
+                  if (mqtt_publish(&client, "settings/state", &message)
+                      == MQTT_SUCCESS)
+                    settings_changed = false;
+                }
                 /* Receiving / Ping */
                 ret = mqtt_yield(&client, 1000);
                 if (ret == MQTT_DISCONNECTED)
@@ -490,6 +815,14 @@ void user_init(void)
 {
   /* Initialize log */
   Log_Init();
+  /* Sub-tick timers, FRC2 is set up by now */
+  HAL_HRTIMER_Init();
+  /* Stack peaks of the previous runs, sampled from now on */
+  stack_stats_init();
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+  /* mbed TLS allocates from its own arena, off the system heap */
+  mbedtls_tls_arena_init();
+#endif
 
   LOG_PRINTF("Setting wifi Station + AP mode");
   struct sdk_station_config sta_config =
@@ -553,5 +886,9 @@ void user_init(void)
 //  xTaskCreate(task_http, "task_http", 128, NULL, 2, NULL);
   /* Test FOTA */
   xTaskCreate(fota_task, "task_fota", 2048, NULL, 2, NULL);
+#if configUSE_TRACE_RECORDER && TRACE_PORT
+  /* Trace dumps over TCP */
+  xTaskCreate(task_trace, "task_trace", 512, NULL, 1, NULL);
+#endif
 }
 
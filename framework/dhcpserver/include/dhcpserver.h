@@ -14,14 +14,44 @@
 #define DHCPSERVER_LEASE_TIME 3600
 #endif
 
+/* Seconds an offered address stays reserved for the REQUEST */
+#ifndef DHCPSERVER_OFFER_TIME
+#define DHCPSERVER_OFFER_TIME 10
+#endif
+
+/* Period of the lease expiry check, in milliseconds */
+#ifndef DHCPSERVER_TIMER_MS
+#define DHCPSERVER_TIMER_MS 2000
+#endif
+
+/* Most buckets of the hash table of the leases by MAC, a power of 2 up to
+ 128. With 1, finding a lease walks all those in use, "make dhcpswarm"
+ times that build too. */
+#ifndef DHCPSERVER_BUCKETS
+#define DHCPSERVER_BUCKETS 128
+#endif
+
+/* Save the bound leases in sysparam so clients keep their address across a
+ reboot. Each change costs a flash write from the tcpip thread, at most one
+ per DHCPSERVER_TIMER_MS. */
+#ifndef DHCPSERVER_PERSIST
+#define DHCPSERVER_PERSIST 0
+#endif
+
+#ifndef DHCPSERVER_PERSIST_KEY
+#define DHCPSERVER_PERSIST_KEY "dhcps.leases"
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
-/* Start DHCP server.
+/* Start DHCP server, on the softAP interface.
 
  Static IP of server should already be set and network interface enabled.
+ The server runs in the tcpip thread, this only queues the start and can be
+ called from user_init().
 
  first_client_addr is the IP address of the first lease to be handed
  to a client.  Subsequent lease addresses are calculated by
@@ -32,7 +62,7 @@ void dhcpserver_start(const ip_addr_t *first_client_addr, uint8_t max_leases);
 void dhcpserver_get_lease(const ip_addr_t *first_client_addr,
                           uint8_t max_leases);
 
-/* Stop DHCP server.
+/* Stop DHCP server, queued like dhcpserver_start().
  */
 void dhcpserver_stop(void);
 
@@ -1,77 +1,118 @@
-/* Very basic LWIP & FreeRTOS-based DHCP server
+/* Very basic LWIP-based DHCP server
  *
  * Based on RFC2131 http://www.ietf.org/rfc/rfc2131.txt
  * ... although not fully RFC compliant yet.
  *
- * TODO
- * * Allow binding on a single interface only (for mixed AP/client mode), lwip seems to make it hard to
- *   listen for or send broadcasts on a specific interface only.
+ * Runs in the tcpip thread on the raw UDP API. Requests are parsed in place
+ * in the received pbuf and replies are built directly in the outgoing one,
+ * then sent on the interface the request came from, the softAP one only.
  *
- * * Probably allocates more memory than it should, it should be possible to reuse netbufs in most cases.
+ * Lease 'i' is the address first_client_addr + i, so lookups by address are
+ * direct. Lookups by MAC go through a hash table chaining the leases in use,
+ * and free leases are found in a bitmap. Offers and bound leases expire from
+ * a timer rather than while handling packets.
  *
  * Part of esp-open-rtos
  * Copyright (C) 2015 Superhouse Automation Pty Ltd
  * BSD Licensed as described in the file LICENSE
  */
 #include <string.h>
+#include <stdlib.h>
 #include "log.h"
-#include <freertos.h>
-#include <freertos_task.h>
 #include <lwip/lwip_netif.h>
-#include <lwip/lwip_api.h>
+#include <lwip/lwip_udp.h>
+#include <lwip/lwip_dhcp.h>
+#include <lwip/lwip_tcpip.h>
+#include <lwip/lwip_timers.h>
+#include "sdk/esp_system.h"
 
-/* Grow the size of the lwip dhcp_msg struct's options field, as LWIP
- defaults to a 68 octet options field for its DHCP client, and most
- full-sized clients send us more than this. */
-#define DHCP_OPTIONS_LEN 312
+#include "dhcpserver.h"
+#if DHCPSERVER_PERSIST
+#include "sysparam.h"
+#endif
 
-#include <lwip/lwip_dhcp.h>
+/* sdk_system_get_netif() index of the softAP interface */
+#define DHCPSERVER_SOFTAP_IF 1
 
-_Static_assert(
-    sizeof(struct dhcp_msg) == offsetof(struct dhcp_msg, options) + 312,
-    "dhcp_msg_t should have extended options size");
+/* BOOTP minimum message size, padded with zeroes */
+#define DHCPSERVER_REPLY_LEN 300
 
-#include <lwip/lwip_netbuf.h>
+#define LEASE_FREE    0
+#define LEASE_OFFERED 1
+#define LEASE_BOUND   2
 
-#include "dhcpserver.h"
+/* Sentinel of the hash chains, leases are linked by index */
+#define LEASE_NONE    0xFF
 
 typedef struct
 {
   uint8_t hwaddr[NETIF_MAX_HWADDR_LEN];
+  uint8_t state;
+  /* next lease in the same hash bucket */
+  uint8_t next;
+  /* sys_now() at expiry */
   uint32_t expires;
 } dhcp_lease_t;
 
 typedef struct
 {
-  struct netconn *nc;
+  struct udp_pcb *pcb;
   uint8_t max_leases;
+  uint8_t hash_mask;
   ip_addr_t first_client_addr;
-  struct netif *server_if;
   dhcp_lease_t *leases; /* length max_leases */
+  uint8_t *buckets;     /* length hash_mask + 1 */
+  uint32_t *free_map;   /* bit i set when lease i is free */
+#if DHCPSERVER_PERSIST
+  bool dirty;
+#endif
 } server_state_t;
 
-/* Only one DHCP server task can run at once, so we have global state
- for it.
+#if DHCPSERVER_PERSIST
+/* Bound lease as saved in sysparam */
+typedef struct
+{
+  uint8_t hwaddr[NETIF_MAX_HWADDR_LEN];
+  uint8_t index;
+  uint8_t pad;
+  uint32_t remaining;
+} dhcp_saved_lease_t;
+#endif
+
+/* Only one DHCP server can run at once, so we have global state for it.
+ The state is only touched in the tcpip thread.
  */
-static TaskHandle_t dhcpserver_task_handle = NULL;
 static server_state_t *state;
+/* Arguments of the pending dhcpserver_start() */
+static ip_addr_t start_first_client_addr;
+static uint8_t start_max_leases;
 
-/* Handlers for various kinds of incoming DHCP messages */
-static void handle_dhcp_discover(struct dhcp_msg *received);
-static void handle_dhcp_request(struct dhcp_msg *dhcpmsg);
-static void handle_dhcp_release(struct dhcp_msg *dhcpmsg);
+static void dhcpserver_do_start(void *arg);
+static void dhcpserver_do_stop(void *arg);
+static void dhcpserver_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                            ip_addr_t *addr, u16_t port);
+static void dhcpserver_timer(void *arg);
 
-static void send_dhcp_nak(struct dhcp_msg *dhcpmsg);
+/* Handlers for various kinds of incoming DHCP messages */
+static void handle_dhcp_discover(const uint8_t *msg, u16_t len,
+                                 struct netif *netif);
+static void handle_dhcp_request(const uint8_t *msg, u16_t len,
+                                struct netif *netif);
+static void handle_dhcp_release(const uint8_t *msg);
 
-static void dhcpserver_task(void *pxParameter);
+static void send_dhcp_reply(const uint8_t *msg, uint8_t type,
+                            const ip_addr_t *yiaddr, struct netif *netif);
 
 /* Utility functions */
-static uint8_t *find_dhcp_option(struct dhcp_msg *msg, uint8_t option_num,
-                                 uint8_t min_length, uint8_t *length);
+static const uint8_t *find_dhcp_option(const uint8_t *msg, u16_t len,
+                                       uint8_t option_num, uint8_t min_length);
 static uint8_t *add_dhcp_option_byte(uint8_t *opt, uint8_t type, uint8_t value);
-static uint8_t *add_dhcp_option_bytes(uint8_t *opt, uint8_t type, void *value,
-                                      uint8_t len);
-static dhcp_lease_t *find_lease_slot(uint8_t *hwaddr);
+static uint8_t *add_dhcp_option_bytes(uint8_t *opt, uint8_t type,
+                                      const void *value, uint8_t len);
+
+static dhcp_lease_t *lease_find(const uint8_t *hwaddr);
+static dhcp_lease_t *lease_claim(int index, const uint8_t *hwaddr);
+static void lease_free(dhcp_lease_t *lease);
 
 /* Copy IP address as dotted decimal to 'dest', must be at least 16 bytes long */
 inline static void sprintf_ipaddr(const ip_addr_t *addr, char *dest)
@@ -85,299 +126,403 @@ inline static void sprintf_ipaddr(const ip_addr_t *addr, char *dest)
 
 void dhcpserver_start(const ip_addr_t *first_client_addr, uint8_t max_leases)
 {
-  /* Stop any existing running dhcpserver */
-  if (dhcpserver_task_handle)
-    dhcpserver_stop();
-
-  state = malloc(sizeof(server_state_t));
-  state->max_leases = max_leases;
-  state->leases = calloc(max_leases, sizeof(dhcp_lease_t));
-  // state->server_if is assigned once the task is running - see comment in dhcpserver_task()
-  ip_addr_copy(state->first_client_addr, *first_client_addr);
-
-  xTaskCreate(dhcpserver_task, "DHCPServer", 768, NULL, 8,
-              &dhcpserver_task_handle);
+  ip_addr_copy(start_first_client_addr, *first_client_addr);
+  start_max_leases = max_leases;
+  /* Any running server is stopped by the callback */
+  tcpip_callback(dhcpserver_do_start, NULL);
 }
 
 void dhcpserver_stop(void)
 {
-  if (dhcpserver_task_handle)
-  {
-    vTaskDelete(dhcpserver_task_handle);
-    free(state);
-    dhcpserver_task_handle = NULL;
-  }
+  tcpip_callback(dhcpserver_do_stop, NULL);
 }
 
-static void dhcpserver_task(void *pxParameter)
+static void dhcpserver_do_start(void *arg)
 {
-  /* netif_list isn't assigned until after user_init completes, which is why we do it inside the task */
-  state->server_if = netif_list; /* TODO: Make this configurable */
-
-  state->nc = netconn_new(NETCONN_UDP);
-  if (!state->nc)
+  dhcpserver_do_stop(NULL);
+
+  uint8_t max_leases = LWIP_MIN(start_max_leases, LEASE_NONE);
+  uint8_t buckets = 1;
+  while (buckets < max_leases && buckets < DHCPSERVER_BUCKETS)
+    buckets <<= 1;
+  size_t map_words = (max_leases + 31) / 32;
+
+  /* One block: state, free map, leases, buckets */
+  state = malloc(sizeof(server_state_t) + map_words * sizeof(uint32_t)
+                 + max_leases * sizeof(dhcp_lease_t) + buckets);
+  if (!state)
   {
-    LOG_PRINTF("DHCP Server Error: Failed to allocate socket.");
+    LOG_PRINTF("DHCP Server Error: Out of memory");
     return;
   }
-
-  netconn_bind(state->nc, IP_ADDR_ANY, DHCP_SERVER_PORT);
-
-  while (1)
+  memset(state, 0, sizeof(server_state_t));
+  state->free_map = (uint32_t *)(state + 1);
+  state->leases = (dhcp_lease_t *)(state->free_map + map_words);
+  state->buckets = (uint8_t *)(state->leases + max_leases);
+  state->max_leases = max_leases;
+  state->hash_mask = buckets - 1;
+  ip_addr_copy(state->first_client_addr, start_first_client_addr);
+
+  memset(state->leases, 0, max_leases * sizeof(dhcp_lease_t));
+  memset(state->buckets, LEASE_NONE, buckets);
+  memset(state->free_map, 0, map_words * sizeof(uint32_t));
+  for (int i = 0; i < max_leases; i++)
+    state->free_map[i / 32] |= 1UL << (i % 32);
+
+#if DHCPSERVER_PERSIST
+  uint8_t *saved;
+  size_t saved_len;
+  if (sysparam_get_data(DHCPSERVER_PERSIST_KEY, &saved, &saved_len, NULL)
+      == SYSPARAM_OK)
   {
-    struct netbuf *netbuf;
-    struct dhcp_msg received = { 0 };
-
-    /* Receive a DHCP packet */
-    err_t err = netconn_recv(state->nc, &netbuf);
-    if (err != ERR_OK)
+    uint32_t now = sys_now();
+    dhcp_saved_lease_t entry;
+    for (size_t off = 0; off + sizeof(entry) <= saved_len;
+         off += sizeof(entry))
     {
-      LOG_PRINTF("DHCP Server Error: Failed to receive DHCP packet. err=%d",
-                 err);
-      continue;
+      memcpy(&entry, saved + off, sizeof(entry));
+      dhcp_lease_t *lease = lease_claim(entry.index, entry.hwaddr);
+      if (lease)
+      {
+        lease->state = LEASE_BOUND;
+        lease->expires = now + entry.remaining * 1000;
+      }
     }
+    free(saved);
+  }
+#endif
 
-    /* expire any leases that have passed */
-    uint32_t now = xTaskGetTickCount();
-    for (int i = 0; i < state->max_leases; i++)
-    {
-      uint32_t expires = state->leases[i].expires;
-      if (expires && expires < now)
-        state->leases[i].expires = 0;
-    }
+  state->pcb = udp_new();
+  if (!state->pcb || udp_bind(state->pcb, IP_ADDR_ANY, DHCP_SERVER_PORT)
+      != ERR_OK)
+  {
+    LOG_PRINTF("DHCP Server Error: Failed to allocate socket.");
+    dhcpserver_do_stop(NULL);
+    return;
+  }
+  udp_recv(state->pcb, dhcpserver_recv, NULL);
+  sys_timeout(DHCPSERVER_TIMER_MS, dhcpserver_timer, NULL);
+}
 
-    ip_addr_t received_ip;
-    u16_t port;
-    netconn_addr(state->nc, &received_ip, &port);
+static void dhcpserver_do_stop(void *arg)
+{
+  if (!state)
+    return;
 
-    if (netbuf_len(netbuf) < offsetof(struct dhcp_msg, options))
-    {
-      /* too short to be a valid DHCP client message */
-      netbuf_delete(netbuf);
-      continue;
-    }
-    if (netbuf_len(netbuf) >= sizeof(struct dhcp_msg))
-    {
-      LOG_PRINTF("DHCP Server Warning: Client sent more options than we know "
-                 "how to parse. len=%d", netbuf_len(netbuf));
-    }
+  sys_untimeout(dhcpserver_timer, NULL);
+  if (state->pcb)
+    udp_remove(state->pcb);
+  free(state);
+  state = NULL;
+}
 
-    netbuf_copy(netbuf, &received, sizeof(struct dhcp_msg));
-    netbuf_delete(netbuf);
+#if DHCPSERVER_PERSIST
+static void save_leases(void)
+{
+  dhcp_saved_lease_t *entries;
+  size_t count = 0;
+  uint32_t now = sys_now();
 
-    uint8_t *message_type = find_dhcp_option(&received,
-                                             DHCP_OPTION_MESSAGE_TYPE,
-                                             DHCP_OPTION_MESSAGE_TYPE_LEN,
-                                             NULL);
-    if (!message_type)
-    {
-      LOG_PRINTF("DHCP Server Error: No message type field found");
+  entries = malloc(state->max_leases * sizeof(dhcp_saved_lease_t));
+  if (!entries)
+    return;
+  for (int i = 0; i < state->max_leases; i++)
+  {
+    dhcp_lease_t *lease = &state->leases[i];
+    if (lease->state != LEASE_BOUND)
       continue;
-    }
-
-    LOG_PRINTF("State dump. Message type %d", *message_type);
-    for (int i = 0; i < state->max_leases; i++)
-    {
-      dhcp_lease_t *lease = &state->leases[i];
-      LOG_PRINTF("lease slot %d expiry %d hwaddr %02x:%02x:%02x:%02x:%02x:%02x",
-                 i, lease->expires, lease->hwaddr[0], lease->hwaddr[1],
-                 lease->hwaddr[2], lease->hwaddr[3], lease->hwaddr[4],
-                 lease->hwaddr[5]);
-    }
+    memcpy(entries[count].hwaddr, lease->hwaddr, NETIF_MAX_HWADDR_LEN);
+    entries[count].index = i;
+    entries[count].pad = 0;
+    entries[count].remaining = (lease->expires - now) / 1000;
+    count++;
+  }
+  if (sysparam_set_data(DHCPSERVER_PERSIST_KEY, (uint8_t *)entries,
+                        count * sizeof(dhcp_saved_lease_t), true)
+      == SYSPARAM_OK)
+    state->dirty = false;
+  free(entries);
+}
+#endif
 
-    switch (*message_type)
+static void dhcpserver_timer(void *arg)
+{
+  /* expire any leases that have passed */
+  uint32_t now = sys_now();
+  for (int i = 0; i < state->max_leases; i++)
+  {
+    dhcp_lease_t *lease = &state->leases[i];
+    if (lease->state != LEASE_FREE && (int32_t)(now - lease->expires) >= 0)
     {
-      case DHCP_DISCOVER:
-        handle_dhcp_discover(&received);
-        break;
-      case DHCP_REQUEST:
-        handle_dhcp_request(&received);
-        break;
-      case DHCP_RELEASE:
-        handle_dhcp_release(&received);
-      default:
-        LOG_PRINTF("DHCP Server Error: Unsupported message type %d",
-                   *message_type);
-        break;
+#if DHCPSERVER_PERSIST
+      if (lease->state == LEASE_BOUND)
+        state->dirty = true;
+#endif
+      lease_free(lease);
     }
   }
+#if DHCPSERVER_PERSIST
+  /* Flash writes stall the tcpip thread, batch them here */
+  if (state->dirty)
+    save_leases();
+#endif
+  sys_timeout(DHCPSERVER_TIMER_MS, dhcpserver_timer, NULL);
 }
 
-static void handle_dhcp_discover(struct dhcp_msg *dhcpmsg)
+static void dhcpserver_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                            ip_addr_t *addr, u16_t port)
 {
-  if (dhcpmsg->htype != DHCP_HTYPE_ETH)
+  struct netif *netif = ip_current_netif();
+
+  /* Only serve the softAP clients, not the network of the station */
+  if (netif != sdk_system_get_netif(DHCPSERVER_SOFTAP_IF))
+  {
+    pbuf_free(p);
     return;
-  if (dhcpmsg->hlen > NETIF_MAX_HWADDR_LEN)
+  }
+  if (p->next)
+  {
+    /* parsing needs the message in one piece, rarely the case otherwise */
+    p = pbuf_coalesce(p, PBUF_RAW);
+    if (p->next)
+    {
+      pbuf_free(p);
+      return;
+    }
+  }
+
+  const uint8_t *msg = p->payload;
+  u16_t len = p->len;
+  if (len < DHCP_OPTIONS_OFS || msg[DHCP_OP_OFS] != DHCP_BOOTREQUEST
+      || msg[DHCP_HTYPE_OFS] != DHCP_HTYPE_ETH
+      || msg[DHCP_HLEN_OFS] != NETIF_MAX_HWADDR_LEN
+      || msg[DHCP_COOKIE_OFS] != 0x63 || msg[DHCP_COOKIE_OFS + 1] != 0x82
+      || msg[DHCP_COOKIE_OFS + 2] != 0x53 || msg[DHCP_COOKIE_OFS + 3] != 0x63)
+  {
+    /* not a valid DHCP client message */
+    pbuf_free(p);
     return;
+  }
 
-  dhcp_lease_t *freelease = find_lease_slot(dhcpmsg->chaddr);
-  if (!freelease)
+  const uint8_t *message_type = find_dhcp_option(msg, len,
+                                                 DHCP_OPTION_MESSAGE_TYPE,
+                                                 DHCP_OPTION_MESSAGE_TYPE_LEN);
+  if (!message_type)
   {
-    LOG_PRINTF("DHCP Server: All leases taken.");
-    return; /* Nothing available, so do nothing */
+    LOG_PRINTF("DHCP Server Error: No message type field found");
+    pbuf_free(p);
+    return;
   }
 
-  /* Reuse the DISCOVER buffer for the OFFER response */
-  dhcpmsg->op = DHCP_BOOTREPLY;
-  bzero(dhcpmsg->options, DHCP_OPTIONS_LEN);
+  switch (*message_type)
+  {
+    case DHCP_DISCOVER:
+      handle_dhcp_discover(msg, len, netif);
+      break;
+    case DHCP_REQUEST:
+      handle_dhcp_request(msg, len, netif);
+      break;
+    case DHCP_RELEASE:
+      handle_dhcp_release(msg);
+      break;
+    default:
+      LOG_PRINTF("DHCP Server Error: Unsupported message type %d",
+                 *message_type);
+      break;
+  }
+  pbuf_free(p);
+}
 
-  ip_addr_copy(dhcpmsg->yiaddr, state->first_client_addr);
-  ip4_addr4(&(dhcpmsg->yiaddr)) += (freelease - state->leases);
+static void handle_dhcp_discover(const uint8_t *msg, u16_t len,
+                                 struct netif *netif)
+{
+  const uint8_t *hwaddr = msg + DHCP_CHADDR_OFS;
 
-  uint8_t *opt = (uint8_t *)&dhcpmsg->options;
-  opt = add_dhcp_option_byte(opt, DHCP_OPTION_MESSAGE_TYPE, DHCP_OFFER);
-  opt = add_dhcp_option_bytes(opt, DHCP_OPTION_SERVER_ID,
-                              &state->server_if->ip_addr, 4);
-  opt = add_dhcp_option_bytes(opt, DHCP_OPTION_SUBNET_MASK,
-                              &state->server_if->netmask, 4);
-  opt = add_dhcp_option_bytes(opt, DHCP_OPTION_END, NULL, 0);
+  dhcp_lease_t *lease = lease_find(hwaddr);
+  if (!lease)
+  {
+    lease = lease_claim(-1, hwaddr);
+    if (!lease)
+    {
+      LOG_PRINTF("DHCP Server: All leases taken.");
+      return; /* Nothing available, so do nothing */
+    }
+    lease->state = LEASE_OFFERED;
+  }
+  if (lease->state == LEASE_OFFERED)
+    lease->expires = sys_now() + DHCPSERVER_OFFER_TIME * 1000;
 
-  struct netbuf *netbuf = netbuf_new();
-  netbuf_alloc(netbuf, sizeof(struct dhcp_msg));
-  netbuf_take(netbuf, dhcpmsg, sizeof(struct dhcp_msg));
-  netconn_sendto(state->nc, netbuf, IP_ADDR_BROADCAST, 68);
-  netbuf_delete(netbuf);
+  ip_addr_t yiaddr;
+  ip_addr_copy(yiaddr, state->first_client_addr);
+  ip4_addr4(&yiaddr) += (lease - state->leases);
+  send_dhcp_reply(msg, DHCP_OFFER, &yiaddr, netif);
 }
 
-static void handle_dhcp_request(struct dhcp_msg *dhcpmsg)
+static void handle_dhcp_request(const uint8_t *msg, u16_t len,
+                                struct netif *netif)
 {
   static char ipbuf[16];
-  if (dhcpmsg->htype != DHCP_HTYPE_ETH)
-    return;
-  if (dhcpmsg->hlen > NETIF_MAX_HWADDR_LEN)
+  const uint8_t *hwaddr = msg + DHCP_CHADDR_OFS;
+
+  /* The client took the offer of another server */
+  const uint8_t *server_id = find_dhcp_option(msg, len, DHCP_OPTION_SERVER_ID,
+                                              4);
+  if (server_id && memcmp(server_id, &netif->ip_addr, 4))
+  {
+    dhcp_lease_t *lease = lease_find(hwaddr);
+    if (lease && lease->state == LEASE_OFFERED)
+      lease_free(lease);
     return;
+  }
 
   ip_addr_t requested_ip;
-  uint8_t *requested_ip_opt = find_dhcp_option(dhcpmsg,
-                                               DHCP_OPTION_REQUESTED_IP, 4,
-                                               NULL);
+  const uint8_t *requested_ip_opt = find_dhcp_option(msg, len,
+                                                     DHCP_OPTION_REQUESTED_IP,
+                                                     4);
   if (requested_ip_opt)
   {
     memcpy(&requested_ip.addr, requested_ip_opt, 4);
   }
-  else if (ip_addr_cmp(&requested_ip, IP_ADDR_ANY))
-  {
-    ip_addr_copy(requested_ip, dhcpmsg->ciaddr);
-  }
   else
   {
-    LOG_PRINTF("DHCP Server Error: No requested IP");
-    send_dhcp_nak(dhcpmsg);
-    return;
+    memcpy(&requested_ip.addr, msg + DHCP_CIADDR_OFS, 4);
+    if (ip_addr_isany(&requested_ip))
+    {
+      LOG_PRINTF("DHCP Server Error: No requested IP");
+      send_dhcp_reply(msg, DHCP_NAK, NULL, netif);
+      return;
+    }
   }
 
-  /* Test the first 4 octets match */
-  if (ip4_addr1(&requested_ip) != ip4_addr1(&state->first_client_addr) || ip4_addr2(
-      &requested_ip)
-      != ip4_addr2(&state->first_client_addr)
+  /* Test the first 3 octets match */
+  if (ip4_addr1(&requested_ip) != ip4_addr1(&state->first_client_addr)
+      || ip4_addr2(&requested_ip) != ip4_addr2(&state->first_client_addr)
       || ip4_addr3(&requested_ip) != ip4_addr3(&state->first_client_addr))
   {
     sprintf_ipaddr(&requested_ip, ipbuf);
     LOG_PRINTF("DHCP Server Error: %s not an allowed IP", ipbuf);
-    send_dhcp_nak(dhcpmsg);
+    send_dhcp_reply(msg, DHCP_NAK, NULL, netif);
     return;
   }
   /* Test the last octet is in the MAXCLIENTS range */
-  int16_t octet_offs = ip4_addr4(
-      &requested_ip) - ip4_addr4(&state->first_client_addr);
+  int16_t octet_offs = ip4_addr4(&requested_ip)
+      - ip4_addr4(&state->first_client_addr);
   if (octet_offs < 0 || octet_offs >= state->max_leases)
   {
     LOG_PRINTF("DHCP Server Error: Address out of range");
-    send_dhcp_nak(dhcpmsg);
+    send_dhcp_reply(msg, DHCP_NAK, NULL, netif);
     return;
   }
 
   dhcp_lease_t *requested_lease = state->leases + octet_offs;
-  if (requested_lease->expires != 0 && memcmp(requested_lease->hwaddr,
-                                              dhcpmsg->chaddr, dhcpmsg->hlen))
+  if (requested_lease->state != LEASE_FREE
+      && memcmp(requested_lease->hwaddr, hwaddr, NETIF_MAX_HWADDR_LEN))
   {
     LOG_PRINTF("DHCP Server Error: Lease for address already taken");
-    send_dhcp_nak(dhcpmsg);
+    send_dhcp_reply(msg, DHCP_NAK, NULL, netif);
     return;
   }
 
-  memcpy(requested_lease->hwaddr, dhcpmsg->chaddr, dhcpmsg->hlen);
-  sprintf_ipaddr(&requested_ip, ipbuf);
-  LOG_PRINTF("DHCP lease addr %s assigned to MAC %02x:%02x:%02x:%02x:%02x:%02x",
-             ipbuf, requested_lease->hwaddr[0], requested_lease->hwaddr[1],
-             requested_lease->hwaddr[2], requested_lease->hwaddr[3],
-             requested_lease->hwaddr[4], requested_lease->hwaddr[5]);
-  requested_lease->expires = DHCPSERVER_LEASE_TIME * configTICK_RATE_HZ;
-
-  /* Reuse the REQUEST message as the ACK message */
-  dhcpmsg->op = DHCP_BOOTREPLY;
-  bzero(dhcpmsg->options, DHCP_OPTIONS_LEN);
-
-  ip_addr_copy(dhcpmsg->yiaddr, requested_ip);
-
-  uint8_t *opt = (uint8_t *)&dhcpmsg->options;
-  opt = add_dhcp_option_byte(opt, DHCP_OPTION_MESSAGE_TYPE, DHCP_ACK);
-  uint32_t expiry = htonl(DHCPSERVER_LEASE_TIME);
-  opt = add_dhcp_option_bytes(opt, DHCP_OPTION_LEASE_TIME, &expiry, 4);
-  opt = add_dhcp_option_bytes(opt, DHCP_OPTION_SERVER_ID,
-                              &state->server_if->ip_addr, 4);
-  opt = add_dhcp_option_bytes(opt, DHCP_OPTION_SUBNET_MASK,
-                              &state->server_if->netmask, 4);
-  opt = add_dhcp_option_bytes(opt, DHCP_OPTION_END, NULL, 0);
+  /* A client asking for another address than its current lease */
+  dhcp_lease_t *lease = lease_find(hwaddr);
+  if (lease && lease != requested_lease)
+    lease_free(lease);
+  if (requested_lease->state == LEASE_FREE)
+    lease_claim(octet_offs, hwaddr);
+
+  if (requested_lease->state != LEASE_BOUND)
+  {
+    sprintf_ipaddr(&requested_ip, ipbuf);
+    LOG_PRINTF("DHCP lease addr %s assigned to MAC "
+               "%02x:%02x:%02x:%02x:%02x:%02x",
+               ipbuf, hwaddr[0], hwaddr[1], hwaddr[2], hwaddr[3], hwaddr[4],
+               hwaddr[5]);
+  }
+  requested_lease->state = LEASE_BOUND;
+  requested_lease->expires = sys_now() + DHCPSERVER_LEASE_TIME * 1000;
+#if DHCPSERVER_PERSIST
+  state->dirty = true;
+#endif
 
-  struct netbuf *netbuf = netbuf_new();
-  netbuf_alloc(netbuf, sizeof(struct dhcp_msg));
-  netbuf_take(netbuf, dhcpmsg, sizeof(struct dhcp_msg));
-  netconn_sendto(state->nc, netbuf, IP_ADDR_BROADCAST, 68);
-  netbuf_delete(netbuf);
+  send_dhcp_reply(msg, DHCP_ACK, &requested_ip, netif);
 }
 
-static void handle_dhcp_release(struct dhcp_msg *dhcpmsg)
+static void handle_dhcp_release(const uint8_t *msg)
 {
-  dhcp_lease_t *lease = find_lease_slot(dhcpmsg->chaddr);
+  dhcp_lease_t *lease = lease_find(msg + DHCP_CHADDR_OFS);
   if (lease)
   {
-    lease->expires = 0;
+#if DHCPSERVER_PERSIST
+    if (lease->state == LEASE_BOUND)
+      state->dirty = true;
+#endif
+    lease_free(lease);
   }
 }
 
-static void send_dhcp_nak(struct dhcp_msg *dhcpmsg)
+/* OFFER and ACK carry 'yiaddr', a NAK passes NULL */
+static void send_dhcp_reply(const uint8_t *msg, uint8_t type,
+                            const ip_addr_t *yiaddr, struct netif *netif)
 {
-  /* Reuse 'dhcpmsg' for the NAK */
-  dhcpmsg->op = DHCP_BOOTREPLY;
-  bzero(dhcpmsg->options, DHCP_OPTIONS_LEN);
-
-  uint8_t *opt = (uint8_t *)&dhcpmsg->options;
-  opt = add_dhcp_option_byte(opt, DHCP_OPTION_MESSAGE_TYPE, DHCP_NAK);
-  opt = add_dhcp_option_bytes(opt, DHCP_OPTION_SERVER_ID,
-                              &state->server_if->ip_addr, 4);
+  struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, DHCPSERVER_REPLY_LEN, PBUF_RAM);
+  if (!p)
+    return;
+
+  uint8_t *reply = p->payload;
+  bzero(reply, DHCPSERVER_REPLY_LEN);
+  reply[DHCP_OP_OFS] = DHCP_BOOTREPLY;
+  reply[DHCP_HTYPE_OFS] = DHCP_HTYPE_ETH;
+  reply[DHCP_HLEN_OFS] = NETIF_MAX_HWADDR_LEN;
+  memcpy(reply + DHCP_XID_OFS, msg + DHCP_XID_OFS, 4);
+  memcpy(reply + DHCP_FLAGS_OFS, msg + DHCP_FLAGS_OFS, 2);
+  memcpy(reply + DHCP_GIADDR_OFS, msg + DHCP_GIADDR_OFS, 4);
+  memcpy(reply + DHCP_CHADDR_OFS, msg + DHCP_CHADDR_OFS, DHCP_CHADDR_LEN);
+  if (type == DHCP_ACK)
+    memcpy(reply + DHCP_CIADDR_OFS, msg + DHCP_CIADDR_OFS, 4);
+  if (yiaddr)
+    memcpy(reply + DHCP_YIADDR_OFS, &yiaddr->addr, 4);
+  memcpy(reply + DHCP_COOKIE_OFS, msg + DHCP_COOKIE_OFS, 4);
+
+  uint8_t *opt = reply + DHCP_OPTIONS_OFS;
+  opt = add_dhcp_option_byte(opt, DHCP_OPTION_MESSAGE_TYPE, type);
+  if (type == DHCP_ACK)
+  {
+    uint32_t expiry = htonl(DHCPSERVER_LEASE_TIME);
+    opt = add_dhcp_option_bytes(opt, DHCP_OPTION_LEASE_TIME, &expiry, 4);
+  }
+  opt = add_dhcp_option_bytes(opt, DHCP_OPTION_SERVER_ID, &netif->ip_addr, 4);
+  if (type != DHCP_NAK)
+    opt = add_dhcp_option_bytes(opt, DHCP_OPTION_SUBNET_MASK, &netif->netmask,
+                                4);
   opt = add_dhcp_option_bytes(opt, DHCP_OPTION_END, NULL, 0);
 
-  struct netbuf *netbuf = netbuf_new();
-  netbuf_alloc(netbuf, sizeof(struct dhcp_msg));
-  netbuf_take(netbuf, dhcpmsg, sizeof(struct dhcp_msg));
-  netconn_sendto(state->nc, netbuf, IP_ADDR_BROADCAST, 68);
-  netbuf_delete(netbuf);
+  udp_sendto_if(state->pcb, p, IP_ADDR_BROADCAST, DHCP_CLIENT_PORT, netif);
+  pbuf_free(p);
 }
 
-static uint8_t *find_dhcp_option(struct dhcp_msg *msg, uint8_t option_num,
-                                 uint8_t min_length, uint8_t *length)
+/* Options of the received message, read in place up to 'len' */
+static const uint8_t *find_dhcp_option(const uint8_t *msg, u16_t len,
+                                       uint8_t option_num, uint8_t min_length)
 {
-  uint8_t *start = (uint8_t *)&msg->options;
-  uint8_t *msg_end = (uint8_t *)msg + sizeof(struct dhcp_msg);
+  const uint8_t *msg_end = msg + len;
 
-  for (uint8_t *p = start; p < msg_end - 2;)
+  for (const uint8_t *p = msg + DHCP_OPTIONS_OFS; p < msg_end;)
   {
     uint8_t type = *p++;
-    uint8_t len = *p++;
     if (type == DHCP_OPTION_END)
       return NULL ;
-    if (p + len >= msg_end)
+    if (type == DHCP_OPTION_PAD)
+      continue;
+    if (p >= msg_end || p + 1 + *p > msg_end)
       break; /* We've overrun our valid DHCP message size, or this isn't a valid option */
+    uint8_t optlen = *p++;
     if (type == option_num)
     {
-      if (len < min_length)
+      if (optlen < min_length)
         break;
-      if (length)
-        *length = len;
       return p; /* start of actual option data */
     }
-    p += len;
+    p += optlen;
   }
   return NULL ; /* Not found */
 }
@@ -390,8 +535,8 @@ static uint8_t *add_dhcp_option_byte(uint8_t *opt, uint8_t type, uint8_t value)
   return opt;
 }
 
-static uint8_t *add_dhcp_option_bytes(uint8_t *opt, uint8_t type, void *value,
-                                      uint8_t len)
+static uint8_t *add_dhcp_option_bytes(uint8_t *opt, uint8_t type,
+                                      const void *value, uint8_t len)
 {
   *opt++ = type;
   if (len)
@@ -402,16 +547,73 @@ static uint8_t *add_dhcp_option_bytes(uint8_t *opt, uint8_t type, void *value,
   return opt + len;
 }
 
-/* Find a free DHCP lease, or a lease already assigned to 'hwaddr' */
-static dhcp_lease_t *find_lease_slot(uint8_t *hwaddr)
+static uint8_t *lease_bucket(const uint8_t *hwaddr)
 {
-  dhcp_lease_t *empty_lease = NULL;
-  for (int i = 0; i < state->max_leases; i++)
+  /* FNV-1a, the low bits of a MAC alone are often sequential */
+  uint32_t hash = 2166136261UL;
+  for (int i = 0; i < NETIF_MAX_HWADDR_LEN; i++)
+    hash = (hash ^ hwaddr[i]) * 16777619UL;
+  return &state->buckets[(hash ^ (hash >> 16)) & state->hash_mask];
+}
+
+/* The lease offered or bound to 'hwaddr' */
+static dhcp_lease_t *lease_find(const uint8_t *hwaddr)
+{
+  for (uint8_t i = *lease_bucket(hwaddr); i != LEASE_NONE;
+       i = state->leases[i].next)
   {
-    if (state->leases[i].expires == 0 && !empty_lease)
-      empty_lease = &state->leases[i];
-    else if (memcmp(hwaddr, state->leases[i].hwaddr, 6) == 0)
+    if (memcmp(hwaddr, state->leases[i].hwaddr, NETIF_MAX_HWADDR_LEN) == 0)
       return &state->leases[i];
   }
-  return empty_lease;
+  return NULL;
+}
+
+/* Take free lease 'index', or the first free one when 'index' is -1, for
+ 'hwaddr'. The caller sets the state and expiry. */
+static dhcp_lease_t *lease_claim(int index, const uint8_t *hwaddr)
+{
+  if (index < 0)
+  {
+    for (int w = 0; w * 32 < state->max_leases; w++)
+    {
+      if (state->free_map[w])
+      {
+        index = w * 32 + __builtin_ctz(state->free_map[w]);
+        break;
+      }
+    }
+    if (index < 0)
+      return NULL;
+  }
+  else if (index >= state->max_leases
+      || !(state->free_map[index / 32] & (1UL << (index % 32))))
+  {
+    return NULL;
+  }
+  state->free_map[index / 32] &= ~(1UL << (index % 32));
+
+  dhcp_lease_t *lease = &state->leases[index];
+  uint8_t *bucket = lease_bucket(hwaddr);
+  memcpy(lease->hwaddr, hwaddr, NETIF_MAX_HWADDR_LEN);
+  lease->next = *bucket;
+  *bucket = index;
+  return lease;
+}
+
+static void lease_free(dhcp_lease_t *lease)
+{
+  uint8_t index = lease - state->leases;
+
+  for (uint8_t *link = lease_bucket(lease->hwaddr); *link != LEASE_NONE;
+       link = &state->leases[*link].next)
+  {
+    if (*link == index)
+    {
+      *link = lease->next;
+      break;
+    }
+  }
+  lease->state = LEASE_FREE;
+  lease->expires = 0;
+  state->free_map[index / 32] |= 1UL << (index % 32);
 }
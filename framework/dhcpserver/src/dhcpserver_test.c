@@ -0,0 +1,571 @@
+/*
+ * DHCP server test, a host program ("make dhcpswarm")
+ *
+ * dhcpserver.c runs on the softAP port of the host port of the lwIP core
+ * (lwip_host.h) and a tap on its segment is a swarm of clients, one MAC
+ * each in the chaddr of their messages. The leases are handed out, renewed,
+ * released, taken by another server, refused and let expire, and a client
+ * on the station segment must get no answer.
+ *
+ * Then swarms of 8 up to DHCP_TEST_CLIENTS clients DISCOVER, REQUEST and
+ * RELEASE at once, DHCP_TEST_ROUNDS times with new MACs, and the time the
+ * server takes per message is measured around its receive callback: the
+ * offers and acks per second of host CPU must not fall as the lease table
+ * grows.
+ *
+ * The Makefile builds the program a second time with DHCPSERVER_BUCKETS 1,
+ * where finding a lease walks all of them.
+ */
+#if defined(LWIP_HOST)
+
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_udp.h"
+#include "lwip/lwip_dhcp.h"
+#include "lwip_host.h"
+#include "dhcpserver.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* Largest swarm, leases from .2 up to .254 */
+#define DHCP_TEST_CLIENTS       253
+/* Swarms of each size for the measure */
+#define DHCP_TEST_ROUNDS        200
+/* Longest an answer may take */
+#define DHCP_TEST_WAIT          1000
+#define DHCP_TEST_LEN           300
+
+typedef struct
+{
+  u8_t mac[6];
+  u32_t xid;
+  /* yiaddr of the last OFFER and ACK, any until then */
+  ip_addr_t offer;
+  ip_addr_t ack;
+  /* lease time of the last ACK, in seconds */
+  u32_t lease;
+  u32_t offers;
+  u32_t acks;
+  u32_t naks;
+} dhcp_test_client_t;
+
+static lwip_host_seg_t dhcp_test_ap;
+static lwip_host_seg_t dhcp_test_sta;
+static struct netif dhcp_test_softap;
+static struct netif dhcp_test_station;
+static struct netif dhcp_test_swarm;
+static struct netif dhcp_test_lan;
+static ip_addr_t dhcp_test_first;
+/* one more than the largest swarm, the one left without a lease */
+static dhcp_test_client_t dhcp_test_clients[DHCP_TEST_CLIENTS + 1];
+/* first byte of the MACs that differs between swarms */
+static u8_t dhcp_test_gen;
+static u32_t dhcp_test_replies;
+static u32_t dhcp_test_lan_replies;
+static unsigned long dhcp_test_logs;
+static unsigned long dhcp_test_failures;
+
+/* the receive callback of the server, and the time spent in it */
+static udp_recv_fn dhcp_test_server_recv;
+static void *dhcp_test_server_arg;
+static double dhcp_test_server_time;
+
+static void dhcp_test_check(int ok, const char *what)
+{
+  if (!ok)
+  {
+    dhcp_test_failures++;
+    printf("dhcpswarm: at %u ms: %s\n", (unsigned)lwip_host_now, what);
+  }
+}
+
+/* log.h of the firmware, the server logs each new binding */
+void Log_Printf(const char *format, ...)
+{
+  (void)format;
+  dhcp_test_logs++;
+}
+
+/* sdk/esp_system.h, the server answers on the softAP interface only */
+struct netif *sdk_system_get_netif(uint32_t mode)
+{
+  return (mode == 1) ? &dhcp_test_softap : &dhcp_test_station;
+}
+
+static double dhcp_test_clock(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void dhcp_test_timed_recv(void *arg, struct udp_pcb *pcb,
+                                 struct pbuf *p, ip_addr_t *addr, u16_t port)
+{
+  double start = dhcp_test_clock();
+
+  dhcp_test_server_recv(arg, pcb, p, addr, port);
+  dhcp_test_server_time += dhcp_test_clock() - start;
+}
+
+/* dhcpserver_start() runs at the next millisecond, then its pcb is wrapped */
+static void dhcp_test_start(u8_t leases)
+{
+  struct udp_pcb *pcb;
+
+  dhcpserver_start(&dhcp_test_first, leases);
+  lwip_host_run(1);
+  for (pcb = udp_pcbs; pcb != NULL; pcb = pcb->next)
+  {
+    if (pcb->local_port == DHCP_SERVER_PORT)
+    {
+      dhcp_test_server_recv = pcb->recv;
+      dhcp_test_server_arg = pcb->recv_arg;
+      pcb->recv = dhcp_test_timed_recv;
+      return;
+    }
+  }
+  dhcp_test_check(0, "no server pcb");
+}
+
+/* New MACs for the clients */
+static void dhcp_test_new_swarm(void)
+{
+  dhcp_test_client_t *client;
+  int i;
+
+  dhcp_test_gen++;
+  memset(dhcp_test_clients, 0, sizeof(dhcp_test_clients));
+  for (i = 0; i <= DHCP_TEST_CLIENTS; i++)
+  {
+    client = &dhcp_test_clients[i];
+    client->mac[0] = 0x02;
+    client->mac[1] = 0xdc;
+    client->mac[2] = 0x50;
+    client->mac[3] = dhcp_test_gen;
+    client->mac[4] = i >> 8;
+    client->mac[5] = i & 0xff;
+  }
+}
+
+/* Address 'i' of the pool */
+static ip_addr_t dhcp_test_addr(int i)
+{
+  ip_addr_t addr;
+
+  IP4_ADDR(&addr, 172, 16, 0, ip4_addr4(&dhcp_test_first) + i);
+  return addr;
+}
+
+/* Broadcast a message of 'client' from 0.0.0.0, or from the LAN tap, with
+ the requested address and server identifier options unless NULL */
+static void dhcp_test_send(struct netif *tap, dhcp_test_client_t *client,
+                           u8_t type, const ip_addr_t *requested,
+                           const ip_addr_t *server)
+{
+  static const u8_t cookie[] = { 0x63, 0x82, 0x53, 0x63 };
+  u8_t msg[DHCP_TEST_LEN];
+  lwip_host_udp_t udp;
+  u8_t *opt;
+
+  memset(msg, 0, sizeof(msg));
+  msg[DHCP_OP_OFS] = DHCP_BOOTREQUEST;
+  msg[DHCP_HTYPE_OFS] = DHCP_HTYPE_ETH;
+  msg[DHCP_HLEN_OFS] = 6;
+  client->xid = lwip_host_rand();
+  memcpy(msg + DHCP_XID_OFS, &client->xid, 4);
+  memcpy(msg + DHCP_CHADDR_OFS, client->mac, 6);
+  memcpy(msg + DHCP_COOKIE_OFS, cookie, 4);
+  opt = msg + DHCP_OPTIONS_OFS;
+  *opt++ = DHCP_OPTION_MESSAGE_TYPE;
+  *opt++ = 1;
+  *opt++ = type;
+  /* a PAD the parser must step over */
+  *opt++ = DHCP_OPTION_PAD;
+  if (requested != NULL)
+  {
+    *opt++ = DHCP_OPTION_REQUESTED_IP;
+    *opt++ = 4;
+    memcpy(opt, &requested->addr, 4);
+    opt += 4;
+  }
+  if (server != NULL)
+  {
+    *opt++ = DHCP_OPTION_SERVER_ID;
+    *opt++ = 4;
+    memcpy(opt, &server->addr, 4);
+    opt += 4;
+  }
+  *opt = DHCP_OPTION_END;
+
+  memset(&udp, 0xff, sizeof(udp.mac));
+  ip_addr_set_any(&udp.src);
+  ip_addr_copy(udp.dst, *IP_ADDR_BROADCAST);
+  udp.src_port = DHCP_CLIENT_PORT;
+  udp.dst_port = DHCP_SERVER_PORT;
+  udp.data = msg;
+  udp.len = sizeof(msg);
+  lwip_host_tap_udp_send(tap, &udp);
+}
+
+/* Option 'type' of a reply, NULL if it has none */
+static const u8_t *dhcp_test_option(const u8_t *msg, u16_t len, u8_t type)
+{
+  u16_t i = DHCP_OPTIONS_OFS;
+
+  while ((i + 1 < len) && (msg[i] != DHCP_OPTION_END))
+  {
+    if (msg[i] == DHCP_OPTION_PAD)
+    {
+      i++;
+      continue;
+    }
+    if (i + 2 + msg[i + 1] > len)
+    {
+      break;
+    }
+    if (msg[i] == type)
+    {
+      return &msg[i + 2];
+    }
+    i += 2 + msg[i + 1];
+  }
+  return NULL;
+}
+
+/* Input of the swarm tap: the replies to the client of their chaddr */
+static err_t dhcp_test_swarm_input(struct pbuf *p, struct netif *netif)
+{
+  dhcp_test_client_t *client;
+  const u8_t *type;
+  const u8_t *lease;
+  lwip_host_udp_t udp;
+  u32_t xid;
+  u16_t i;
+
+  if (!lwip_host_tap_arp(netif, p) && lwip_host_tap_udp_parse(p, &udp)
+      && (udp.dst_port == DHCP_CLIENT_PORT) && (udp.len >= DHCP_OPTIONS_OFS)
+      && (udp.data[DHCP_OP_OFS] == DHCP_BOOTREPLY))
+  {
+    dhcp_test_replies++;
+    i = (udp.data[DHCP_CHADDR_OFS + 4] << 8) | udp.data[DHCP_CHADDR_OFS + 5];
+    type = dhcp_test_option(udp.data, udp.len, DHCP_OPTION_MESSAGE_TYPE);
+    memcpy(&xid, udp.data + DHCP_XID_OFS, 4);
+    if ((i <= DHCP_TEST_CLIENTS) && (type != NULL)
+        && (memcmp(udp.data + DHCP_CHADDR_OFS, dhcp_test_clients[i].mac, 6)
+            == 0))
+    {
+      client = &dhcp_test_clients[i];
+      dhcp_test_check(xid == client->xid, "reply with another xid");
+      switch (*type)
+      {
+        case DHCP_OFFER:
+          client->offers++;
+          memcpy(&client->offer.addr, udp.data + DHCP_YIADDR_OFS, 4);
+          break;
+        case DHCP_ACK:
+          client->acks++;
+          memcpy(&client->ack.addr, udp.data + DHCP_YIADDR_OFS, 4);
+          lease = dhcp_test_option(udp.data, udp.len, DHCP_OPTION_LEASE_TIME);
+          if (lease != NULL)
+          {
+            client->lease = ((u32_t)lease[0] << 24) | (lease[1] << 16)
+                | (lease[2] << 8) | lease[3];
+          }
+          break;
+        case DHCP_NAK:
+          client->naks++;
+          break;
+        default:
+          dhcp_test_check(0, "reply of an unexpected type");
+          break;
+      }
+    }
+    else
+    {
+      dhcp_test_check(0, "reply to no client");
+    }
+  }
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+/* Input of the tap on the station segment, where nothing must answer */
+static err_t dhcp_test_lan_input(struct pbuf *p, struct netif *netif)
+{
+  lwip_host_udp_t udp;
+
+  if (!lwip_host_tap_arp(netif, p) && lwip_host_tap_udp_parse(p, &udp)
+      && (udp.dst_port == DHCP_CLIENT_PORT))
+  {
+    dhcp_test_lan_replies++;
+  }
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static int dhcp_test_replied(void *arg)
+{
+  return dhcp_test_replies >= *(u32_t *)arg;
+}
+
+/* Wait until 'count' replies more, returns non zero if they came */
+static int dhcp_test_wait(u32_t count)
+{
+  u32_t until = dhcp_test_replies + count;
+
+  return lwip_host_run_until(dhcp_test_replied, &until, DHCP_TEST_WAIT)
+      <= DHCP_TEST_WAIT;
+}
+
+/* A DISCOVER of client 'i', returns non zero if it got an offer */
+static int dhcp_test_discover(int i)
+{
+  u32_t offers = dhcp_test_clients[i].offers;
+
+  ip_addr_set_any(&dhcp_test_clients[i].offer);
+  dhcp_test_send(&dhcp_test_swarm, &dhcp_test_clients[i], DHCP_DISCOVER, NULL,
+                 NULL);
+  dhcp_test_wait(1);
+  return dhcp_test_clients[i].offers != offers;
+}
+
+/* A REQUEST of client 'i' for 'addr', returns the reply type, 0 for none */
+static u8_t dhcp_test_request(int i, const ip_addr_t *addr,
+                              const ip_addr_t *server)
+{
+  dhcp_test_client_t *client = &dhcp_test_clients[i];
+  u32_t acks = client->acks;
+  u32_t naks = client->naks;
+
+  dhcp_test_send(&dhcp_test_swarm, client, DHCP_REQUEST, addr, server);
+  dhcp_test_wait(1);
+  return (client->acks != acks) ? DHCP_ACK
+      : (client->naks != naks) ? DHCP_NAK : 0;
+}
+
+static void dhcp_test_release(int i)
+{
+  dhcp_test_send(&dhcp_test_swarm, &dhcp_test_clients[i], DHCP_RELEASE, NULL,
+                 NULL);
+  lwip_host_run(1);
+}
+
+/* The leases of the pool, handed out to a swarm and taken back */
+static void dhcp_test_leases(void)
+{
+  ip_addr_t other_server;
+  ip_addr_t addr;
+  ip_addr_t held;
+  /* the last octets bound */
+  u8_t bound[256];
+  u32_t i;
+  int all = 1;
+
+  dhcp_test_start(DHCP_TEST_CLIENTS);
+  dhcp_test_new_swarm();
+
+  /* all at once, then each takes its offer */
+  for (i = 0; i < DHCP_TEST_CLIENTS; i++)
+  {
+    dhcp_test_send(&dhcp_test_swarm, &dhcp_test_clients[i], DHCP_DISCOVER,
+                   NULL, NULL);
+  }
+  dhcp_test_check(dhcp_test_wait(DHCP_TEST_CLIENTS), "offers missing");
+  for (i = 0; i < DHCP_TEST_CLIENTS; i++)
+  {
+    addr = dhcp_test_clients[i].offer;
+    all &= (dhcp_test_clients[i].offers == 1)
+        && ip_addr_netcmp(&addr, &dhcp_test_first, &dhcp_test_softap.netmask)
+        && (ip4_addr4(&addr) >= ip4_addr4(&dhcp_test_first))
+        && (ip4_addr4(&addr) < ip4_addr4(&dhcp_test_first) + DHCP_TEST_CLIENTS);
+  }
+  dhcp_test_check(all, "offer missing or out of the pool");
+  for (i = 0; i < DHCP_TEST_CLIENTS; i++)
+  {
+    dhcp_test_send(&dhcp_test_swarm, &dhcp_test_clients[i], DHCP_REQUEST,
+                   &dhcp_test_clients[i].offer, &dhcp_test_softap.ip_addr);
+  }
+  dhcp_test_check(dhcp_test_wait(DHCP_TEST_CLIENTS), "acks missing");
+  all = 1;
+  memset(bound, 0, sizeof(bound));
+  for (i = 0; i < DHCP_TEST_CLIENTS; i++)
+  {
+    /* a distinct address each */
+    bound[ip4_addr4(&dhcp_test_clients[i].ack)]++;
+    all &= (bound[ip4_addr4(&dhcp_test_clients[i].ack)] == 1)
+        && (dhcp_test_clients[i].acks == 1)
+        && ip_addr_cmp(&dhcp_test_clients[i].ack, &dhcp_test_clients[i].offer)
+        && (dhcp_test_clients[i].lease == DHCPSERVER_LEASE_TIME);
+  }
+  dhcp_test_check(all, "ack missing, not the offer or bound twice");
+  dhcp_test_check(dhcp_test_logs == DHCP_TEST_CLIENTS,
+                  "not one log per binding");
+
+  /* a bound client finds its lease again, by its MAC */
+  dhcp_test_check(dhcp_test_discover(7)
+                  && ip_addr_cmp(&dhcp_test_clients[7].offer,
+                                 &dhcp_test_clients[7].ack),
+                  "bound client offered another address");
+  dhcp_test_check(dhcp_test_request(7, &dhcp_test_clients[7].ack, NULL)
+                  == DHCP_ACK, "renewal not acked");
+  dhcp_test_check(dhcp_test_logs == DHCP_TEST_CLIENTS,
+                  "renewal logged as a binding");
+
+  /* the pool is taken */
+  dhcp_test_check(!dhcp_test_discover(DHCP_TEST_CLIENTS),
+                  "offer with the pool taken");
+
+  /* the address of client 7 is taken by the other */
+  held = dhcp_test_clients[7].ack;
+  dhcp_test_check(dhcp_test_request(DHCP_TEST_CLIENTS, &held, NULL)
+                  == DHCP_NAK, "address of another client acked");
+  addr = dhcp_test_addr(DHCP_TEST_CLIENTS);
+  dhcp_test_check(dhcp_test_request(DHCP_TEST_CLIENTS, &addr, NULL)
+                  == DHCP_NAK, "address past the pool acked");
+  IP4_ADDR(&addr, 172, 16, 1, ip4_addr4(&dhcp_test_first));
+  dhcp_test_check(dhcp_test_request(DHCP_TEST_CLIENTS, &addr, NULL)
+                  == DHCP_NAK, "address of another network acked");
+
+  /* a release frees the lease for the other, whose offer holds it */
+  dhcp_test_release(7);
+  dhcp_test_check(dhcp_test_discover(DHCP_TEST_CLIENTS)
+                  && ip_addr_cmp(&dhcp_test_clients[DHCP_TEST_CLIENTS].offer,
+                                 &held), "released address not offered");
+  dhcp_test_check(!dhcp_test_discover(7), "offered address offered again");
+
+  /* until the offer runs out */
+  lwip_host_run(DHCPSERVER_OFFER_TIME * 1000 + DHCPSERVER_TIMER_MS);
+  dhcp_test_check(dhcp_test_discover(7)
+                  && ip_addr_cmp(&dhcp_test_clients[7].offer, &held),
+                  "expired offer not offered again");
+
+  /* the client takes the offer of another server, which frees this one */
+  IP4_ADDR(&other_server, 172, 16, 0, 254);
+  dhcp_test_check(dhcp_test_request(7, &held, &other_server) == 0,
+                  "reply to a request for another server");
+  dhcp_test_check(dhcp_test_discover(DHCP_TEST_CLIENTS)
+                  && ip_addr_cmp(&dhcp_test_clients[DHCP_TEST_CLIENTS].offer,
+                                 &held), "offer for another server kept");
+  dhcp_test_check(dhcp_test_request(DHCP_TEST_CLIENTS, &held,
+                                    &dhcp_test_softap.ip_addr) == DHCP_ACK,
+                  "request of the offer not acked");
+
+  /* a client of the station network gets nothing */
+  dhcp_test_send(&dhcp_test_lan, &dhcp_test_clients[0], DHCP_DISCOVER, NULL,
+                 NULL);
+  lwip_host_run(DHCP_TEST_WAIT);
+  dhcp_test_check(dhcp_test_lan_replies == 0, "answer on the station network");
+
+  /* bound leases run out, then a new swarm gets the whole pool */
+  lwip_host_run(DHCPSERVER_LEASE_TIME * 1000 + DHCPSERVER_TIMER_MS);
+  dhcp_test_new_swarm();
+  for (i = 0; i < DHCP_TEST_CLIENTS; i++)
+  {
+    dhcp_test_send(&dhcp_test_swarm, &dhcp_test_clients[i], DHCP_DISCOVER,
+                   NULL, NULL);
+  }
+  dhcp_test_wait(DHCP_TEST_CLIENTS);
+  all = 1;
+  for (i = 0; i < DHCP_TEST_CLIENTS; i++)
+  {
+    all &= (dhcp_test_clients[i].offers == 1);
+  }
+  dhcp_test_check(all, "expired leases not offered again");
+  dhcpserver_stop();
+  lwip_host_run(1);
+}
+
+/* DHCP_TEST_ROUNDS swarms of 'count' clients on a pool of as many */
+static void dhcp_test_measure(u8_t count)
+{
+  double discover = 0;
+  double request = 0;
+  double release = 0;
+  u32_t offers = 0;
+  u32_t acks = 0;
+  int round;
+  int i;
+
+  dhcp_test_start(count);
+  for (round = 0; round < DHCP_TEST_ROUNDS; round++)
+  {
+    dhcp_test_new_swarm();
+    dhcp_test_server_time = 0;
+    for (i = 0; i < count; i++)
+    {
+      dhcp_test_send(&dhcp_test_swarm, &dhcp_test_clients[i], DHCP_DISCOVER,
+                     NULL, NULL);
+    }
+    dhcp_test_wait(count);
+    discover += dhcp_test_server_time;
+
+    dhcp_test_server_time = 0;
+    for (i = 0; i < count; i++)
+    {
+      offers += dhcp_test_clients[i].offers;
+      dhcp_test_send(&dhcp_test_swarm, &dhcp_test_clients[i], DHCP_REQUEST,
+                     &dhcp_test_clients[i].offer, &dhcp_test_softap.ip_addr);
+    }
+    dhcp_test_wait(count);
+    request += dhcp_test_server_time;
+
+    dhcp_test_server_time = 0;
+    for (i = 0; i < count; i++)
+    {
+      acks += dhcp_test_clients[i].acks;
+      dhcp_test_send(&dhcp_test_swarm, &dhcp_test_clients[i], DHCP_RELEASE,
+                     NULL, NULL);
+    }
+    lwip_host_run(1);
+    release += dhcp_test_server_time;
+  }
+  dhcp_test_check(offers == (u32_t)count * DHCP_TEST_ROUNDS, "offers missing");
+  dhcp_test_check(acks == (u32_t)count * DHCP_TEST_ROUNDS, "acks missing");
+  printf("  %3u leases: %8.0f offers/s %8.0f acks/s %8.0f releases/s\n",
+         count, offers / discover, acks / request,
+         (double)count * DHCP_TEST_ROUNDS / release);
+  dhcpserver_stop();
+  lwip_host_run(1);
+}
+
+int main(void)
+{
+  static const u8_t counts[] = { 8, 32, 128, DHCP_TEST_CLIENTS };
+  ip_addr_t addr;
+  ip_addr_t mask;
+  size_t i;
+
+  lwip_host_init(1);
+  lwip_host_seg_init(&dhcp_test_ap);
+  lwip_host_seg_init(&dhcp_test_sta);
+  IP4_ADDR(&mask, 255, 255, 255, 0);
+  IP4_ADDR(&addr, 172, 16, 0, 1);
+  lwip_host_port_add(&dhcp_test_ap, &dhcp_test_softap, &addr, &mask,
+                     IP_ADDR_ANY);
+  ip_addr_set_any(&addr);
+  lwip_host_tap_add(&dhcp_test_ap, &dhcp_test_swarm, &addr,
+                    dhcp_test_swarm_input);
+  IP4_ADDR(&addr, 192, 168, 1, 50);
+  lwip_host_port_add(&dhcp_test_sta, &dhcp_test_station, &addr, &mask,
+                     IP_ADDR_ANY);
+  IP4_ADDR(&addr, 192, 168, 1, 1);
+  lwip_host_tap_add(&dhcp_test_sta, &dhcp_test_lan, &addr,
+                    dhcp_test_lan_input);
+  IP4_ADDR(&dhcp_test_first, 172, 16, 0, 2);
+
+  dhcp_test_leases();
+
+  printf("dhcpswarm, DHCPSERVER_BUCKETS %d, %d swarms each, server time per "
+         "message\n", DHCPSERVER_BUCKETS, DHCP_TEST_ROUNDS);
+  for (i = 0; i < sizeof(counts); i++)
+  {
+    dhcp_test_measure(counts[i]);
+  }
+  dhcp_test_check(lwip_host_rx_buffers == 0, "RX buffers not recycled");
+  return (dhcp_test_failures == 0) ? 0 : 1;
+}
+
+#endif /* LWIP_HOST */
@@ -56,6 +56,21 @@
 #define LWIP_HTTPD_SUPPORT_POST   0
 #endif
 
+/** Set this to 1 to support Server-Sent Events (text/event-stream) */
+#ifndef LWIP_HTTPD_SSE
+#define LWIP_HTTPD_SSE            0
+#endif
+
+/** Set this to 1 to count connections, requests and failures */
+#ifndef LWIP_HTTPD_STATS
+#define LWIP_HTTPD_STATS          0
+#endif
+
+/** Set this to 1 to serve lwip_metrics.h on LWIP_HTTPD_METRICS_URI */
+#ifndef LWIP_HTTPD_METRICS
+#define LWIP_HTTPD_METRICS        0
+#endif
+
 #if LWIP_HTTPD_CGI
 
 /*
@@ -229,7 +244,7 @@ void httpd_post_data_recved(void *connection, u16_t recved_len);
 
 #endif /* LWIP_HTTPD_SUPPORT_POST */
 
-enum
+typedef enum
 {
   WS_TEXT_MODE = 0x01,
   WS_BIN_MODE = 0x02,
@@ -259,6 +274,81 @@ err_t websocket_write(struct tcp_pcb *pcb, const uint8_t *data, uint16_t len,
  */
 void websocket_register_callbacks(tWsOpenHandler ws_open_cb, tWsHandler ws_cb);
 
+#if LWIP_HTTPD_SSE
+
+/** URI of the event stream */
+#ifndef LWIP_HTTPD_SSE_URI
+#define LWIP_HTTPD_SSE_URI        "/events"
+#endif
+
+/**
+ * Append an event to the stream sent to all clients of LWIP_HTTPD_SSE_URI.
+ * Events go to a ring shared by all clients, a client that falls a whole
+ * ring behind skips to the newest event. Can be called from any task.
+ *
+ * @param event event type or NULL for the default "message" type.
+ * @param data event data, sent as a single "data:" line (no line breaks).
+ * @param len data length.
+ * @return ERR_OK if the event was queued, ERR_VAL if it contains a line
+ *         break or does not fit in a quarter of the ring.
+ */
+err_t httpd_sse_publish(const char *event, const char *data, u16_t len);
+
+#endif /* LWIP_HTTPD_SSE */
+
+#if LWIP_HTTPD_METRICS
+
+/** URI of the metrics page, in the Prometheus text format */
+#ifndef LWIP_HTTPD_METRICS_URI
+#define LWIP_HTTPD_METRICS_URI    "/metrics"
+#endif
+
+/** Size of the page buffer, allocated for each request until it is sent */
+#ifndef LWIP_HTTPD_METRICS_LEN
+#define LWIP_HTTPD_METRICS_LEN    3072
+#endif
+
+#endif /* LWIP_HTTPD_METRICS */
+
+#if LWIP_HTTPD_STATS
+
+typedef struct
+{
+  /* Connections accepted */
+  u32_t conns;
+  /* Connections reset because no connection state could be allocated */
+  u32_t conns_refused;
+  /* Connections closed by http_poll() after too many retries */
+  u32_t conns_timeout;
+  u16_t conns_active;
+  u16_t conns_max;
+  /* Requests parsed (files, POST, websocket and SSE) */
+  u32_t reqs;
+  /* Requests answered with an error page (400, 404, 501) */
+  u32_t reqs_err;
+  /* Requests that closed the connection without an answer */
+  u32_t reqs_dropped;
+  /* Connections kept open for another request (HTTP/1.1 persistent) */
+  u32_t keepalive;
+  /* Segments queued behind a response being sent (pipelining) */
+  u32_t pipelined;
+  /* Failed allocations of SSI states, file buffers and responses */
+  u32_t alloc_err;
+  /* Bytes acknowledged by the clients */
+  u32_t bytes_sent;
+  /* Time from a request being parsed to its response being queued, in ms */
+  u32_t resp_time_total;
+  u32_t resp_time_max;
+} httpd_stats_t;
+
+/**
+ * Get a snapshot of the httpd counters. Can be called from any task.
+ * The average response time is resp_time_total / (reqs - reqs_dropped).
+ */
+void httpd_get_stats(httpd_stats_t *stats);
+
+#endif /* LWIP_HTTPD_STATS */
+
 void httpd_init(void);
 
 #endif /* __HTTPD_H__ */
@@ -0,0 +1,96 @@
+/* Read-only web filesystem stored in its own flash partition
+ *
+ * The image is built from framework/fsdata/fs by framework/fsdata/makefsimage
+ * and can be replaced at runtime (see fota.c) without touching the firmware.
+ * Files found in the image take precedence over the ones compiled into
+ * fsdata.c, which stay available as a fallback.
+ *
+ * Image layout (little-endian, 4-byte aligned):
+ *   struct webfs_header
+ *   struct webfs_entry[num_files]
+ *   file data (HTTP header included), each file padded to 4 bytes
+ */
+#ifndef __HTTPD_WEBFS_H__
+#define __HTTPD_WEBFS_H__
+
+/* Inclusion section ======================================================== */
+#include <stdbool.h>
+#include <stdint.h>
+#include "lwip/lwip_err.h"
+
+/* Public macro definition section ========================================== */
+/* Flash partition, between the end of rboot slot 0 (1MB max image) and the
+ start of slot 1 on a 4MB flash */
+#ifndef WEBFS_FLASH_ADDR
+#define WEBFS_FLASH_ADDR        0x180000
+#endif
+#ifndef WEBFS_FLASH_SIZE
+#define WEBFS_FLASH_SIZE        0x80000
+#endif
+
+/* Page cache geometry, WEBFS_PAGE_SIZE must be a power of 2 */
+#ifndef WEBFS_PAGE_SIZE
+#define WEBFS_PAGE_SIZE         512
+#endif
+#ifndef WEBFS_CACHE_PAGES
+#define WEBFS_CACHE_PAGES       8
+#endif
+
+#define WEBFS_MAGIC             0x53464557 /* "WEFS" */
+#define WEBFS_VERSION           2
+#define WEBFS_NAME_LEN          48
+
+/* Public type definition section =========================================== */
+struct webfs_header
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t num_files;
+  /* Image size in bytes, header included */
+  uint32_t size;
+  /* 32-bit sum of all bytes following the header */
+  uint32_t checksum;
+};
+
+struct webfs_entry
+{
+  /* NUL-terminated URI, e.g. "/index.html" */
+  char name[WEBFS_NAME_LEN];
+  /* Offset of the file data from the start of the image */
+  uint32_t offset;
+  uint32_t len;
+};
+
+typedef struct
+{
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t flash_reads;
+  uint16_t num_files;
+  bool mounted;
+} webfs_stats_t;
+
+/* Public function prototype section ======================================== */
+/* Start the flash reader task and mount the image if it is valid.
+ Must be called before httpd_init().
+ */
+void webfs_init(void);
+
+/* Check the header and the checksum of the image at 'addr'.
+ Reads the whole image, so call it from a task, not from the tcpip thread.
+ */
+bool webfs_check_image(uint32_t addr);
+
+/* Load the directory of the image at WEBFS_FLASH_ADDR. Does not verify the
+ checksum. Must run in the tcpip thread once httpd is started.
+ */
+err_t webfs_mount(void);
+
+/* Drop the directory and the page cache. Files still open return EOF on the
+ next read. Must run in the tcpip thread once httpd is started.
+ */
+void webfs_unmount(void);
+
+void webfs_get_stats(webfs_stats_t *stats);
+
+#endif /* __HTTPD_WEBFS_H__ */
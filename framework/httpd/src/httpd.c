@@ -154,8 +154,12 @@
 #endif
 
 /** Set this to 1 to enable HTTP/1.1 persistent connections.
- * ATTENTION: If the generated file system includes HTTP headers, these must
- * include the "Connection: keep-alive" header (pass argument "-11" to makefsdata).
+ * ATTENTION: If the generated file system includes HTTP headers, static files
+ * must carry a "Content-Length" header (makefsdata/makefsimage add it to all
+ * but SSI files). SSI output has no known length, it is sent with chunked
+ * transfer encoding to HTTP/1.1 clients.
+ * Pipelined requests are queued while a response is being sent and served
+ * in order on the same connection (needs LWIP_HTTPD_SUPPORT_REQUESTLIST).
  */
 #ifndef LWIP_HTTPD_SUPPORT_11_KEEPALIVE
 #define LWIP_HTTPD_SUPPORT_11_KEEPALIVE     0
@@ -185,8 +189,24 @@
 #ifndef LWIP_HTTPD_MAX_REQ_LENGTH
 #define LWIP_HTTPD_MAX_REQ_LENGTH           LWIP_MIN(1023, (LWIP_HTTPD_REQ_QUEUELEN * PBUF_POOL_BUFSIZE))
 #endif
+
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+/** Number of (TCP payload-) bytes to enqueue for pipelined requests received
+ while a response is being sent. The connection is closed if exceeded. */
+#ifndef LWIP_HTTPD_PIPELINE_BUFSIZE
+#define LWIP_HTTPD_PIPELINE_BUFSIZE         (2 * LWIP_HTTPD_REQ_BUFSIZE)
+#endif
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
 #endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
 
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SSI
+/** Maximum payload of one chunk when sending SSI output with chunked
+ transfer encoding. Chunks are assembled in a static buffer of this size. */
+#ifndef LWIP_HTTPD_MAX_CHUNK_LEN
+#define LWIP_HTTPD_MAX_CHUNK_LEN            512
+#endif
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SSI */
+
 /** Maximum length of the filename to send as response to a POST request,
  * filled in by the application when a POST is finished.
  */
@@ -220,6 +240,20 @@
 
 #define CRLF "\r\n"
 #define HTTP11_CONNECTIONKEEPALIVE "Connection: keep-alive"
+#define HTTP11_CONNECTIONCLOSE "Connection: close"
+#define HTTP11_VERSION " HTTP/1.1"
+
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SSI
+/* Added to the header embedded in SSI files, replacing its final CRLF */
+#define HTTP11_CHUNKED_HDR "Transfer-Encoding: chunked" CRLF CRLF
+#define HTTP11_CHUNKED_END "0" CRLF CRLF
+/* chunk-size line (4 hex digits + CRLF) and the CRLF after the data */
+#define HTTP_CHUNK_OVERHEAD 8
+
+/* hs->chunk_state: 0..3 bytes of the header's CRLFCRLF sent, then */
+#define HTTP_CHUNK_SKIP_LF  4 /* final CR of the header replaced, skip LF */
+#define HTTP_CHUNK_BODY     5 /* header done, data is framed as chunks */
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SSI */
 
 #if LWIP_HTTPD_SSI
 #define LWIP_HTTPD_IS_SSI(hs) ((hs)->ssi)
@@ -232,9 +266,18 @@
 /** This was TI's check whether to let TCP copy data or not
  #define HTTP_IS_DATA_VOLATILE(hs) ((hs->file < (char *)0x20000000) ? 0 : TCP_WRITE_FLAG_COPY)*/
 #ifndef HTTP_IS_DATA_VOLATILE
+#if LWIP_HTTPD_DYNAMIC_FILE_READ
+/* Files read through fs_read()/fs_read_async(), like the webfs image, are
+ sent from hs->buf, which http_check_eof() refills as soon as it has been
+ written, before it is acknowledged. */
+#define HTTP_IS_BUF_VOLATILE(hs)    ((hs)->buf != NULL)
+#else /* LWIP_HTTPD_DYNAMIC_FILE_READ */
+#define HTTP_IS_BUF_VOLATILE(hs)    0
+#endif /* LWIP_HTTPD_DYNAMIC_FILE_READ */
 #if LWIP_HTTPD_SSI
-/* Copy for SSI files, no copy for non-SSI files */
-#define HTTP_IS_DATA_VOLATILE(hs)   ((hs)->ssi ? TCP_WRITE_FLAG_COPY : 0)
+/* Copy for SSI files and for data in hs->buf, no copy for other files */
+#define HTTP_IS_DATA_VOLATILE(hs)   (((hs)->ssi || HTTP_IS_BUF_VOLATILE(hs)) \
+                                     ? TCP_WRITE_FLAG_COPY : 0)
 #else /* LWIP_HTTPD_SSI */
 /** Default: don't copy if the data is sent from file-system directly */
 #define HTTP_IS_DATA_VOLATILE(hs) (((hs->file != NULL) && (hs->handle != NULL) && (hs->file == \
@@ -291,6 +334,37 @@ static const char WS_RSP[] = "HTTP/1.1 101 Switching Protocols\r\n"
 static tWsHandler websocket_cb = NULL;
 static tWsOpenHandler websocket_open_cb = NULL;
 
+#if LWIP_HTTPD_SSE
+#include "lwip/lwip_tcpip.h"
+
+/** Size of the event ring shared by all SSE clients, must be a power of 2 */
+#ifndef LWIP_HTTPD_SSE_RING_SIZE
+#define LWIP_HTTPD_SSE_RING_SIZE  1024
+#endif
+
+/** Maximum number of bytes taken out of the ring per tcp_write() */
+#ifndef LWIP_HTTPD_SSE_SEND_LEN
+#define LWIP_HTTPD_SSE_SEND_LEN   512
+#endif
+
+static const char SSE_RSP[] = "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "\r\n"
+    "retry: 2000\n\n";
+static const char SSE_EVENT[] = "event: ";
+static const char SSE_DATA[] = "data: ";
+/* Comment line sent on idle streams, ignored by clients */
+static const char SSE_HEARTBEAT[] = ":\n\n";
+
+/* Events of all clients, written at http_sse_head (bytes written so far) */
+static u8_t http_sse_ring[LWIP_HTTPD_SSE_RING_SIZE];
+static u32_t http_sse_head;
+static u8_t http_sse_kick_pending;
+/* Whole events are copied out of the ring here before being sent */
+static char http_sse_buf[LWIP_HTTPD_SSE_SEND_LEN];
+#endif /* LWIP_HTTPD_SSE */
+
 typedef struct
 {
   const char *name;
@@ -316,6 +390,11 @@ static char httpd_req_buf[LWIP_HTTPD_MAX_REQ_LENGTH + 1];
 static char http_post_response_filename[LWIP_HTTPD_POST_MAX_RESPONSE_URI_LEN+1];
 #endif /* LWIP_HTTPD_SUPPORT_POST */
 
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SSI
+/** A chunk is assembled here so that it is passed to tcp_write() at once */
+static char http_chunk_buf[LWIP_HTTPD_MAX_CHUNK_LEN + HTTP_CHUNK_OVERHEAD];
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SSI */
+
 #if LWIP_HTTPD_DYNAMIC_HEADERS
 /* The number of individual strings that comprise the headers sent before each
  * requested file.
@@ -366,6 +445,11 @@ struct http_state
   char *file; /* Pointer to first unsent byte in buf. */
 
   u8_t is_websocket;
+#if LWIP_HTTPD_SSE
+  u8_t is_sse;
+  struct http_state *sse_next;
+  u32_t sse_offset; /* Position of the next event to send in the ring */
+#endif /* LWIP_HTTPD_SSE */
 
   struct tcp_pcb *pcb;
 #if LWIP_HTTPD_SUPPORT_REQUESTLIST
@@ -380,6 +464,15 @@ struct http_state
   u8_t retries;
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
 u8_t keepalive;
+u8_t http11; /* the request was HTTP/1.1 */
+u8_t in_request; /* http_handle_request() is serving queued requests */
+#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+u16_t req_len; /* Length of the parsed request, the rest of req is pipelined */
+#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+#if LWIP_HTTPD_SSI
+u8_t chunked; /* SSI output is sent with chunked transfer encoding */
+u8_t chunk_state; /* Progress through the embedded header, see HTTP_CHUNK_* */
+#endif /* LWIP_HTTPD_SSI */
 #endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
 #if LWIP_HTTPD_SSI
 struct http_ssi_state *ssi;
@@ -397,6 +490,9 @@ u16_t hdr_index; /* The index of the hdr string currently being sent. */
 #if LWIP_HTTPD_TIMING
 u32_t time_started;
 #endif /* LWIP_HTTPD_TIMING */
+#if LWIP_HTTPD_STATS
+u32_t req_started; /* sys_now() when the request was parsed */
+#endif /* LWIP_HTTPD_STATS */
 #if LWIP_HTTPD_SUPPORT_POST
 u32_t post_content_len_left;
 #if LWIP_HTTPD_POST_MANUAL_WND
@@ -414,6 +510,8 @@ static err_t http_find_file(struct http_state *hs, const char *uri, int is_09);
 static err_t http_init_file(struct http_state *hs, struct fs_file *file,
                             int is_09, const char *uri, u8_t tag_check);
 static err_t http_poll(void *arg, struct tcp_pcb *pcb);
+static void http_handle_request(struct tcp_pcb *pcb, struct http_state *hs,
+                                struct pbuf *p);
 
 static err_t websocket_send_close(struct tcp_pcb *pcb);
 
@@ -446,6 +544,24 @@ int g_iNumCGIs;
 static struct http_state *http_connections;
 #endif /* LWIP_HTTPD_KILL_OLD_ON_CONNECTIONS_EXCEEDED */
 
+#if LWIP_HTTPD_SSE
+/** list of the connections streaming events */
+static struct http_state *http_sse_clients;
+#endif /* LWIP_HTTPD_SSE */
+
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+/** connection in http_handle_request(), NULL once http_state_free() freed it */
+static struct http_state *http_request_hs;
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+
+#if LWIP_HTTPD_STATS
+/** counters, only updated from the tcpip thread */
+static httpd_stats_t httpd_stats;
+#define HTTPD_STATS_INC(x)   ++httpd_stats.x
+#else /* LWIP_HTTPD_STATS */
+#define HTTPD_STATS_INC(x)
+#endif /* LWIP_HTTPD_STATS */
+
 #if LWIP_HTTPD_STRNSTR_PRIVATE
 /** Like strstr but does not need 'buffer' to be NULL-terminated */
 static char*
@@ -516,6 +632,10 @@ if (ret != NULL)
 {
   memset(ret, 0, sizeof(struct http_ssi_state));
 }
+else
+{
+  HTTPD_STATS_INC(alloc_err);
+}
 return ret;
 }
 
@@ -619,6 +739,30 @@ static void http_state_free(struct http_state *hs)
 if (hs != NULL)
 {
   http_state_eof(hs);
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+  if (http_request_hs == hs)
+  {
+    http_request_hs = NULL;
+  }
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#if LWIP_HTTPD_STATS
+  httpd_stats.conns_active--;
+#endif /* LWIP_HTTPD_STATS */
+#if LWIP_HTTPD_SSE
+  /* take the connection off the event stream */
+  if (hs->is_sse)
+  {
+    struct http_state **prev;
+    for (prev = &http_sse_clients; *prev != NULL; prev = &(*prev)->sse_next)
+    {
+      if (*prev == hs)
+      {
+        *prev = hs->sse_next;
+        break;
+      }
+    }
+  }
+#endif /* LWIP_HTTPD_SSE */
 #if LWIP_HTTPD_KILL_OLD_ON_CONNECTIONS_EXCEEDED
   /* take the connection off the list */
   if (http_connections)
@@ -649,6 +793,37 @@ if (hs != NULL)
 }
 }
 
+/** Prepare a struct http_state for the next request on the same connection.
+ * The pcb and the requests queued so far are kept.
+ */
+static void http_state_reuse(struct http_state *hs)
+{
+struct tcp_pcb *pcb = hs->pcb;
+#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+struct pbuf *req = hs->req;
+#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+#if LWIP_HTTPD_KILL_OLD_ON_CONNECTIONS_EXCEEDED
+struct http_state *next = hs->next;
+#endif /* LWIP_HTTPD_KILL_OLD_ON_CONNECTIONS_EXCEEDED */
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+u8_t in_request = hs->in_request;
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+
+http_state_eof(hs);
+http_state_init(hs);
+
+hs->pcb = pcb;
+#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+hs->req = req;
+#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+#if LWIP_HTTPD_KILL_OLD_ON_CONNECTIONS_EXCEEDED
+hs->next = next;
+#endif /* LWIP_HTTPD_KILL_OLD_ON_CONNECTIONS_EXCEEDED */
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+hs->in_request = in_request;
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+}
+
 /** Call tcp_write() in a loop trying smaller and smaller length
  *
  * @param pcb tcp_pcb to send
@@ -701,6 +876,358 @@ else
 return err;
 }
 
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SSI
+/** Advance the CRLFCRLF matcher used to find the end of the HTTP header
+ * embedded in a file.
+ */
+static u8_t http_hdr_end_next(u8_t matched, char c)
+{
+if (c == '\r')
+{
+  return (matched == 2) ? 3 : 1;
+}
+if ((c == '\n') && ((matched == 1) || (matched == 3)))
+{
+  return matched + 1;
+}
+return 0;
+}
+
+/** Send one chunk: chunk-size line, data and CRLF with a single tcp_write()
+ * so that a chunk is never left half queued.
+ *
+ * @param length Length of data to send (in/out: on return, contains the
+ *        amount of data sent)
+ */
+static err_t http_write_chunk(struct tcp_pcb *pcb, const char *data,
+                              u16_t *length)
+{
+u16_t len;
+u16_t space;
+u16_t hdr_len;
+u16_t i;
+err_t err;
+
+len = LWIP_MIN(*length, LWIP_HTTPD_MAX_CHUNK_LEN);
+space = tcp_sndbuf(pcb);
+if (space <= HTTP_CHUNK_OVERHEAD)
+{
+  *length = 0;
+  return ERR_MEM;
+}
+len = LWIP_MIN(len, space - HTTP_CHUNK_OVERHEAD);
+
+do
+{
+  /* chunk-size in hex, without leading zeros */
+  hdr_len = 0;
+  for (i = 12; ; i -= 4)
+  {
+    u8_t digit = (len >> i) & 0xF;
+    if (hdr_len || digit || (i == 0))
+    {
+      http_chunk_buf[hdr_len++] = "0123456789ABCDEF"[digit];
+    }
+    if (i == 0)
+    {
+      break;
+    }
+  }
+  http_chunk_buf[hdr_len++] = '\r';
+  http_chunk_buf[hdr_len++] = '\n';
+  MEMCPY(&http_chunk_buf[hdr_len], data, len);
+  http_chunk_buf[hdr_len + len] = '\r';
+  http_chunk_buf[hdr_len + len + 1] = '\n';
+
+  err = tcp_write(pcb, http_chunk_buf, hdr_len + len + 2, TCP_WRITE_FLAG_COPY);
+  if (err == ERR_MEM)
+  {
+    if (tcp_sndqueuelen(pcb) >= TCP_SND_QUEUELEN)
+    {
+      /* no need to try smaller sizes */
+      break;
+    }
+    len /= 2;
+  }
+} while ((err == ERR_MEM) && (len > 0));
+
+*length = (err == ERR_OK) ? len : 0;
+return err;
+}
+
+/** Sub-function of http_send_data_ssi(): http_write() for SSI output.
+ * On a persistent connection the output is framed with chunked transfer
+ * encoding: the HTTP header embedded in the file is sent as is, with
+ * "Transfer-Encoding: chunked" added before its end, then all data goes out
+ * as chunks.
+ */
+static err_t http_write_ssi(struct tcp_pcb *pcb, struct http_state *hs,
+                            const void *ptr, u16_t *length, u8_t apiflags)
+{
+const char *data = (const char *)ptr;
+u16_t len = *length;
+u16_t hdr_len;
+u16_t i;
+u8_t matched;
+err_t err;
+
+if (!hs->chunked)
+{
+  return http_write(pcb, ptr, length, apiflags);
+}
+if (len == 0)
+{
+  return ERR_OK;
+}
+if (hs->chunk_state == HTTP_CHUNK_BODY)
+{
+  return http_write_chunk(pcb, data, length);
+}
+if (hs->chunk_state == HTTP_CHUNK_SKIP_LF)
+{
+  /* the LF of the header's final CRLF is already part of HTTP11_CHUNKED_HDR */
+  hs->chunk_state = HTTP_CHUNK_BODY;
+  *length = (data[0] == '\n') ? 1 : 0;
+  return ERR_OK;
+}
+
+/* Pass the header through, up to the CR of its final CRLF */
+matched = hs->chunk_state;
+for (hdr_len = 0; hdr_len < len; hdr_len++)
+{
+  if (http_hdr_end_next(matched, data[hdr_len]) == 3)
+  {
+    break;
+  }
+  matched = http_hdr_end_next(matched, data[hdr_len]);
+}
+err = http_write(pcb, data, &hdr_len, apiflags);
+if (err != ERR_OK)
+{
+  *length = 0;
+  return err;
+}
+for (i = 0; i < hdr_len; i++)
+{
+  hs->chunk_state = http_hdr_end_next(hs->chunk_state, data[i]);
+}
+*length = hdr_len;
+
+if ((hdr_len < len) && (hs->chunk_state == 2) && (data[hdr_len] == '\r'))
+{
+  /* data[hdr_len] is the final CR: replace the final CRLF */
+  u16_t chunked_len = sizeof(HTTP11_CHUNKED_HDR) - 1;
+  if (tcp_sndbuf(pcb) >= chunked_len)
+  {
+    if (tcp_write(pcb, HTTP11_CHUNKED_HDR, chunked_len, 0) == ERR_OK)
+    {
+      hs->chunk_state = HTTP_CHUNK_SKIP_LF;
+      *length = hdr_len + 1;
+    }
+  }
+}
+return ERR_OK;
+}
+#elif LWIP_HTTPD_SSI
+#define http_write_ssi(pcb, hs, ptr, length, apiflags) \
+  http_write(pcb, ptr, length, apiflags)
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SSI */
+
+#if LWIP_HTTPD_SSE
+/** Copy 'len' bytes to the event ring at position 'pos' (wraps around) */
+static void http_sse_ring_write(u32_t pos, const void *data, u16_t len)
+{
+u16_t start = (u16_t)(pos & (LWIP_HTTPD_SSE_RING_SIZE - 1));
+u16_t first = LWIP_MIN(len, LWIP_HTTPD_SSE_RING_SIZE - start);
+
+MEMCPY(&http_sse_ring[start], data, first);
+MEMCPY(http_sse_ring, (const u8_t *)data + first, len - first);
+}
+
+/** Send the events this client has not received yet, as far as they fit in
+ * the send buffer. Only whole events are sent so that a client skipping
+ * lost events always resumes at the start of one.
+ */
+static u8_t http_sse_send(struct tcp_pcb *pcb, struct http_state *hs)
+{
+u32_t head;
+u16_t len;
+u16_t start;
+u16_t first;
+SYS_ARCH_DECL_PROTECT(lev);
+
+len = LWIP_MIN(tcp_sndbuf(pcb), sizeof(http_sse_buf));
+
+SYS_ARCH_PROTECT(lev);
+head = http_sse_head;
+if (head - hs->sse_offset > LWIP_HTTPD_SSE_RING_SIZE)
+{
+  /* the events were overwritten before this client took them */
+  hs->sse_offset = head;
+}
+len = (u16_t)LWIP_MIN(len, head - hs->sse_offset);
+start = (u16_t)(hs->sse_offset & (LWIP_HTTPD_SSE_RING_SIZE - 1));
+first = LWIP_MIN(len, LWIP_HTTPD_SSE_RING_SIZE - start);
+MEMCPY(http_sse_buf, &http_sse_ring[start], first);
+MEMCPY(&http_sse_buf[first], http_sse_ring, len - first);
+SYS_ARCH_UNPROTECT(lev);
+
+/* events end with an empty line, data lines never contain one */
+while ((len >= 2)
+    && !((http_sse_buf[len - 1] == '\n') && (http_sse_buf[len - 2] == '\n')))
+{
+  len--;
+}
+if (len < 2)
+{
+  return HTTP_NO_DATA_TO_SEND;
+}
+if (tcp_write(pcb, http_sse_buf, len, TCP_WRITE_FLAG_COPY) != ERR_OK)
+{
+  return HTTP_NO_DATA_TO_SEND;
+}
+hs->sse_offset += len;
+return HTTP_DATA_TO_SEND_CONTINUE;
+}
+
+/** tcpip thread callback: pass new events to all clients */
+static void http_sse_kick(void *ctx)
+{
+struct http_state *hs;
+
+LWIP_UNUSED_ARG(ctx);
+http_sse_kick_pending = 0;
+for (hs = http_sse_clients; hs != NULL; hs = hs->sse_next)
+{
+  if (http_sse_send(hs->pcb, hs))
+  {
+    tcp_output(hs->pcb);
+  }
+}
+}
+
+/** Answer a request for LWIP_HTTPD_SSE_URI and add the connection to the
+ * clients of the event stream. It receives the events published from now on.
+ */
+static err_t http_sse_open(struct tcp_pcb *pcb, struct http_state *hs)
+{
+u16_t len = sizeof(SSE_RSP) - 1;
+
+if ((http_write(pcb, SSE_RSP, &len, 0) != ERR_OK)
+    || (len != sizeof(SSE_RSP) - 1))
+{
+  return ERR_MEM;
+}
+LWIP_DEBUGF(HTTPD_DEBUG, ("SSE client %p\n", (void*)pcb));
+hs->is_sse = 1;
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+/* the connection is the stream, it is never reused for requests */
+hs->keepalive = 0;
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+hs->sse_offset = http_sse_head;
+hs->sse_next = http_sse_clients;
+http_sse_clients = hs;
+return ERR_OK;
+}
+
+err_t httpd_sse_publish(const char *event, const char *data, u16_t len)
+{
+u16_t event_len = (event != NULL) ? strlen(event) : 0;
+u16_t total;
+u32_t pos;
+u8_t kick;
+SYS_ARCH_DECL_PROTECT(lev);
+
+total = sizeof(SSE_DATA) - 1 + len + 2;
+if (event_len != 0)
+{
+  total += sizeof(SSE_EVENT) - 1 + event_len + 1;
+}
+if ((total > LWIP_HTTPD_SSE_RING_SIZE / 4)
+    || (memchr(data, '\n', len) != NULL) || (memchr(data, '\r', len) != NULL)
+    || ((event != NULL) && (strpbrk(event, "\r\n") != NULL)))
+{
+  return ERR_VAL;
+}
+
+SYS_ARCH_PROTECT(lev);
+pos = http_sse_head;
+if (event_len != 0)
+{
+  http_sse_ring_write(pos, SSE_EVENT, sizeof(SSE_EVENT) - 1);
+  pos += sizeof(SSE_EVENT) - 1;
+  http_sse_ring_write(pos, event, event_len);
+  pos += event_len;
+  http_sse_ring_write(pos++, "\n", 1);
+}
+http_sse_ring_write(pos, SSE_DATA, sizeof(SSE_DATA) - 1);
+pos += sizeof(SSE_DATA) - 1;
+http_sse_ring_write(pos, data, len);
+pos += len;
+http_sse_ring_write(pos, "\n\n", 2);
+http_sse_head = pos + 2;
+kick = !http_sse_kick_pending;
+http_sse_kick_pending = 1;
+SYS_ARCH_UNPROTECT(lev);
+
+if (kick && (tcpip_callback_with_block(http_sse_kick, NULL, 0) != ERR_OK))
+{
+  /* the clients catch up from http_poll() */
+  http_sse_kick_pending = 0;
+}
+return ERR_OK;
+}
+#endif /* LWIP_HTTPD_SSE */
+
+#if LWIP_HTTPD_METRICS
+#include "lwip_metrics.h"
+#include <stdio.h>
+
+#if !LWIP_HTTPD_DYNAMIC_FILE_READ
+#error "LWIP_HTTPD_METRICS needs LWIP_HTTPD_DYNAMIC_FILE_READ (hs->buf)"
+#endif
+
+/* Content-Length has a fixed width so that the header size is known before
+ the page is written after it */
+static const char METRICS_RSP[] = "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain; version=0.0.4\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Content-Length: %5u\r\n"
+    "\r\n";
+
+/** Answer a request for LWIP_HTTPD_METRICS_URI. The response is written to
+ * hs->buf and sent as an in-memory file with its header included, the buffer
+ * is freed with the file. The page is empty until the first snapshot.
+ */
+static err_t http_metrics_open(struct http_state *hs, int is_09)
+{
+char hdr[sizeof(METRICS_RSP)];
+char *buf = (char *)mem_malloc(LWIP_HTTPD_METRICS_LEN);
+int hdr_len;
+size_t len;
+
+if (buf == NULL)
+{
+  HTTPD_STATS_INC(alloc_err);
+  return ERR_MEM;
+}
+hdr_len = snprintf(hdr, sizeof(hdr), METRICS_RSP, 0);
+len = lwip_metrics_format_text(buf + hdr_len,
+                               LWIP_HTTPD_METRICS_LEN - hdr_len);
+snprintf(hdr, sizeof(hdr), METRICS_RSP, (unsigned)len);
+MEMCPY(buf, hdr, hdr_len);
+
+hs->buf = buf;
+hs->buf_len = LWIP_HTTPD_METRICS_LEN;
+memset(&hs->file_handle, 0, sizeof(hs->file_handle));
+hs->file_handle.data = buf;
+hs->file_handle.len = hdr_len + len;
+hs->file_handle.index = hs->file_handle.len;
+hs->file_handle.http_header_included = 1;
+return http_init_file(hs, &hs->file_handle, is_09, LWIP_HTTPD_METRICS_URI, 0);
+}
+#endif /* LWIP_HTTPD_METRICS */
+
 /**
  * The connection shall be actively closed (using RST to close from fault states).
  * Reset the sent- and recv-callbacks.
@@ -737,7 +1264,7 @@ if (hs != NULL)
 
   if (hs->req != NULL)
   {
-    /* this should not happen */
+    /* partial or pipelined request left */
     LWIP_DEBUGF(HTTPD_DEBUG, ("Freeing buffer (malformed request?)\n"));
     pbuf_free(hs->req);
     hs->req = NULL;
@@ -786,23 +1313,55 @@ return http_close_or_abort_conn(pcb, hs, 0);
  */
 static void http_eof(struct tcp_pcb *pcb, struct http_state *hs)
 {
-/* HTTP/1.1 persistent connection? (Not supported for SSI) */
-#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
-if (hs->keepalive && !LWIP_HTTPD_IS_SSI(hs))
+#if LWIP_HTTPD_STATS
+if (hs->req_started != 0)
 {
-  http_state_eof(hs);
-  http_state_init(hs);
-  hs->keepalive = 1;
+  u32_t resp_time = sys_now() - hs->req_started;
+  httpd_stats.resp_time_total += resp_time;
+  httpd_stats.resp_time_max = LWIP_MAX(httpd_stats.resp_time_max, resp_time);
+  hs->req_started = 0;
 }
-else
-#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#endif /* LWIP_HTTPD_STATS */
 if (hs->is_websocket)
 {
-  http_state_eof(hs);
-  http_state_init(hs);
+  http_state_reuse(hs);
   hs->is_websocket = 1;
 }
 else
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+/* HTTP/1.1 persistent connection? */
+if (hs->keepalive)
+{
+#if LWIP_HTTPD_SSI
+  if (hs->chunked)
+  {
+    if (hs->chunk_state != HTTP_CHUNK_BODY)
+    {
+      /* the file had no proper header, the response cannot be delimited */
+      http_close_conn(pcb, hs);
+      return;
+    }
+    if (tcp_write(pcb, HTTP11_CHUNKED_END, sizeof(HTTP11_CHUNKED_END) - 1, 0)
+        != ERR_OK)
+    {
+      /* no room for the last-chunk, we're called again from sent/poll */
+      return;
+    }
+  }
+#endif /* LWIP_HTTPD_SSI */
+  HTTPD_STATS_INC(keepalive);
+  http_state_reuse(hs);
+  hs->keepalive = 1;
+#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+  if ((hs->req != NULL) && !hs->in_request)
+  {
+    /* serve the next pipelined request */
+    http_handle_request(pcb, hs, NULL);
+  }
+#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+}
+else
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
 {
   http_close_conn(pcb, hs);
 }
@@ -1190,6 +1749,7 @@ else
   if (hs->buf == NULL)
   {
     LWIP_DEBUGF(HTTPD_DEBUG, ("No buff\n"));
+    HTTPD_STATS_INC(alloc_err);
     return 0;
   }
 }
@@ -1318,7 +1878,7 @@ if(ssi->parsed > hs->file)
     len = 2 * mss;
   }
 
-  err = http_write(pcb, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
+  err = http_write_ssi(pcb, hs, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
   if (err == ERR_OK)
   {
     data_to_send = 1;
@@ -1526,7 +2086,7 @@ while((ssi->parse_left) && (err == ERR_OK))
           }
 #endif /* LWIP_HTTPD_SSI_INCLUDE_TAG*/
 
-          err = http_write(pcb, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
+          err = http_write_ssi(pcb, hs, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
           if (err == ERR_OK)
           {
             data_to_send = 1;
@@ -1583,7 +2143,7 @@ while((ssi->parse_left) && (err == ERR_OK))
 #endif /* LWIP_HTTPD_SSI_INCLUDE_TAG*/
       if (len != 0)
       {
-        err = http_write(pcb, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
+        err = http_write_ssi(pcb, hs, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
       }
       else
       {
@@ -1632,7 +2192,7 @@ while((ssi->parse_left) && (err == ERR_OK))
          * single tag insert buffer per connection. If we don't do
          * this, insert corruption can occur if more than one insert
          * is processed before we call tcp_output. */
-        err = http_write(pcb, &(ssi->tag_insert[ssi->tag_index]), &len,
+        err = http_write_ssi(pcb, hs, &(ssi->tag_insert[ssi->tag_index]), &len,
             HTTP_IS_TAG_VOLATILE(hs));
         if (err == ERR_OK)
         {
@@ -1684,7 +2244,7 @@ if((ssi->tag_state != TAG_SENDING) && (ssi->parsed > hs->file))
     len = 2 * tcp_mss(pcb);
   }
 
-  err = http_write(pcb, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
+  err = http_write_ssi(pcb, hs, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
   if (err == ERR_OK)
   {
     data_to_send = 1;
@@ -1722,6 +2282,13 @@ if (hs == NULL)
   return 0;
 }
 
+#if LWIP_HTTPD_SSE
+if (hs->is_sse)
+{
+  return http_sse_send(pcb, hs);
+}
+#endif /* LWIP_HTTPD_SSE */
+
 #if LWIP_HTTPD_FS_ASYNC_READ
 /* Check if we are allowed to read from this file.
  (e.g. SSI might want to delay sending until data is available) */
@@ -1817,6 +2384,7 @@ if (err != ERR_OK)
     }
   }
 }
+HTTPD_STATS_INC(reqs_err);
 return http_init_file(hs, &hs->file_handle, 0, NULL, 0);
 }
 #else /* LWIP_HTTPD_SUPPORT_EXTSTATUS */
@@ -1858,6 +2426,7 @@ if (err != ERR_OK)
   }
 }
 
+HTTPD_STATS_INC(reqs_err);
 return &hs->file_handle;
 }
 
@@ -2117,7 +2686,8 @@ static err_t http_parse_request(struct pbuf **inp, struct http_state *hs,
 char *data;
 char *crlf;
 u16_t data_len;
-struct pbuf *p = *inp;
+u16_t hdr_len;
+struct pbuf *p = (inp != NULL) ? *inp : NULL;
 #if LWIP_HTTPD_SUPPORT_REQUESTLIST
 u16_t clen;
 #endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
@@ -2126,7 +2696,13 @@ err_t err;
 #endif /* LWIP_HTTPD_SUPPORT_POST */
 
 LWIP_UNUSED_ARG(pcb); /* only used for post */
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SUPPORT_REQUESTLIST
+/* p is NULL when parsing a pipelined request queued in hs->req */
+LWIP_ASSERT("p != NULL", (p != NULL) || (hs->req != NULL));
+hs->req_len = 0;
+#else /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SUPPORT_REQUESTLIST */
 LWIP_ASSERT("p != NULL", p != NULL);
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SUPPORT_REQUESTLIST */
 LWIP_ASSERT("hs != NULL", hs != NULL);
 
 if ((hs->handle != NULL) || (hs->file != NULL))
@@ -2139,18 +2715,22 @@ if ((hs->handle != NULL) || (hs->file != NULL))
 
 #if LWIP_HTTPD_SUPPORT_REQUESTLIST
 
-LWIP_DEBUGF(HTTPD_DEBUG, ("Received %"U16_F" bytes\n", p->tot_len));
-
 /* first check allowed characters in this pbuf? */
 
 /* enqueue the pbuf */
-if (hs->req == NULL)
+if (p == NULL)
 {
+  LWIP_DEBUGF(HTTPD_DEBUG, ("Parsing queued request\n"));
+}
+else if (hs->req == NULL)
+{
+  LWIP_DEBUGF(HTTPD_DEBUG, ("Received %"U16_F" bytes\n", p->tot_len));
   LWIP_DEBUGF(HTTPD_DEBUG, ("First pbuf\n"));
   hs->req = p;
 }
 else
 {
+  LWIP_DEBUGF(HTTPD_DEBUG, ("Received %"U16_F" bytes\n", p->tot_len));
   LWIP_DEBUGF(HTTPD_DEBUG, ("pbuf enqueued\n"));
   pbuf_cat(hs->req, p);
 }
@@ -2164,6 +2744,9 @@ if (hs->req->next != NULL)
 else
 #endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
 {
+#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+  p = hs->req;
+#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
   data = (char *)p->payload;
   data_len = p->len;
   if (p->len != p->tot_len)
@@ -2172,13 +2755,24 @@ else
   }
 }
 
+/* Only look at the headers of this request, pipelined ones may follow */
+crlf = strnstr(data, CRLF CRLF, data_len);
+if (crlf != NULL)
+{
+  hdr_len = crlf + 4 - data;
+}
+else
+{
+  hdr_len = data_len;
+}
+
 /* Parse WebSocket request */
 hs->is_websocket = 0;
 unsigned char *retval = NULL;
-if (strncasestr(data, WS_HEADER, data_len))
+if (strncasestr(data, WS_HEADER, hdr_len))
 {
   LWIP_DEBUGF(HTTPD_DEBUG, ("WebSocket opening handshake\n"));
-  char *key_start = strncasestr(data, "Sec-WebSocket-Key: ", data_len);
+  char *key_start = strncasestr(data, "Sec-WebSocket-Key: ", hdr_len);
   if (key_start)
   {
     key_start += 19;
@@ -2194,6 +2788,7 @@ if (strncasestr(data, WS_HEADER, data_len))
         if (retval == NULL)
         {
           LWIP_DEBUGF(HTTPD_DEBUG, ("Out of memory\n"));
+          HTTPD_STATS_INC(alloc_err);
           return ERR_MEM;
         }
         unsigned char *retval_ptr;
@@ -2202,7 +2797,7 @@ if (strncasestr(data, WS_HEADER, data_len))
 
         /* Concatenate key */
         memcpy(key, key_start, len);
-        strlcpy(&key[len], WS_GUID, sizeof(key));
+        memcpy(&key[len], WS_GUID, sizeof(WS_GUID));
         LWIP_DEBUGF(HTTPD_DEBUG, ("Resulting key: %s\n", key));
 
         /* Get SHA1 */
@@ -2211,7 +2806,7 @@ if (strncasestr(data, WS_HEADER, data_len))
         mbedtls_sha1((unsigned char *)key, key_len, sha1sum);
 
         /* Base64 encode */
-        unsigned int olen;
+        size_t olen;
         mbedtls_base64_encode(NULL, 0, &olen, sha1sum, 20); //get length
         int ok = mbedtls_base64_encode(retval_ptr, WS_BUF_LEN, &olen, sha1sum,
                                        20);
@@ -2303,10 +2898,33 @@ if (data_len >= MIN_REQ_LEN)
       {
         char *uri = sp1 + 1;
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
-        if (!is_09 && strnstr(data, HTTP11_CONNECTIONKEEPALIVE, data_len))
+        /* HTTP/1.1 connections persist unless the client asks to close,
+         HTTP/1.0 ones only if the client asks to keep them */
+        hs->keepalive = 0;
+        hs->http11 = 0;
+        if (!is_09 && !hs->is_websocket)
         {
-          hs->keepalive = 1;
+          hs->http11 = !strncmp(sp2, HTTP11_VERSION,
+                                sizeof(HTTP11_VERSION) - 1);
+          if (hs->http11)
+          {
+            hs->keepalive = !strncasestr(data, HTTP11_CONNECTIONCLOSE, hdr_len);
+          }
+          else
+          {
+            hs->keepalive = !!strncasestr(data, HTTP11_CONNECTIONKEEPALIVE,
+                                          hdr_len);
+          }
+          if (strnstr(data, CRLF CRLF, hdr_len) == NULL)
+          {
+            /* the end of the headers is not here, the next segment could not
+             be told apart from a new request */
+            hs->keepalive = 0;
+          }
         }
+#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+        hs->req_len = hdr_len;
+#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
 #endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
         /* null-terminate the METHOD (pbuf is freed anyway wen returning) */
         *sp1 = 0;
@@ -2316,6 +2934,13 @@ if (data_len >= MIN_REQ_LEN)
 #if LWIP_HTTPD_SUPPORT_POST
         if (is_post)
         {
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+          /* the body is not parsed as a request, close when done */
+          hs->keepalive = 0;
+#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+          hs->req_len = 0;
+#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
 #if LWIP_HTTPD_SUPPORT_REQUESTLIST
           struct pbuf **q = &hs->req;
 #else /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
@@ -2348,6 +2973,19 @@ if (data_len >= MIN_REQ_LEN)
               websocket_open_cb(pcb, uri);
             return ERR_OK; // We handled this
           }
+#if LWIP_HTTPD_SSE
+          else if (!is_09 && !hs->is_websocket
+                   && !strcmp(uri, LWIP_HTTPD_SSE_URI))
+          {
+            return http_sse_open(pcb, hs);
+          }
+#endif /* LWIP_HTTPD_SSE */
+#if LWIP_HTTPD_METRICS
+          else if (!hs->is_websocket && !strcmp(uri, LWIP_HTTPD_METRICS_URI))
+          {
+            return http_metrics_open(hs, is_09);
+          }
+#endif /* LWIP_HTTPD_METRICS */
           else
           {
             return http_find_file(hs, uri, is_09);
@@ -2530,6 +3168,22 @@ if (file != NULL)
       ssi->tag_end = file->data;
       hs->ssi = ssi;
     }
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+    /* SSI files carry no Content-Length: frame the output as chunks for
+     HTTP/1.1, otherwise only closing the connection ends the response */
+    if (hs->keepalive)
+    {
+      if (hs->http11 && (hs->ssi != NULL) && file->http_header_included)
+      {
+        hs->chunked = 1;
+        hs->chunk_state = 0;
+      }
+      else
+      {
+        hs->keepalive = 0;
+      }
+    }
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
   }
 #else /* LWIP_HTTPD_SSI */
   LWIP_UNUSED_ARG(tag_check);
@@ -2537,7 +3191,17 @@ if (file != NULL)
   hs->handle = file;
   hs->file = (char*)file->data;
   LWIP_ASSERT("File length must be positive!", (file->len >= 0));
-  hs->left = file->len;
+#if LWIP_HTTPD_CUSTOM_FILES
+  if (file->is_custom_file && (file->data == NULL))
+  {
+    /* custom file without data in memory, read it through fs_read() */
+    hs->left = 0;
+  }
+  else
+#endif /* LWIP_HTTPD_CUSTOM_FILES */
+  {
+    hs->left = file->len;
+  }
   hs->retries = 0;
 #if LWIP_HTTPD_TIMING
   hs->time_started = sys_now();
@@ -2547,7 +3211,7 @@ if (file != NULL)
               hs->handle->http_header_included);
 #endif /* !LWIP_HTTPD_DYNAMIC_HEADERS */
 #if LWIP_HTTPD_SUPPORT_V09
-  if (hs->handle->http_header_included && is_09)
+  if (hs->handle->http_header_included && is_09 && (hs->file != NULL))
   {
     /* HTTP/0.9 responses are sent without HTTP header,
      search for the end of the header. */
@@ -2609,6 +3273,9 @@ struct http_state *hs = (struct http_state *)arg;
 LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("http_sent %p\n", (void*)pcb));
 
 LWIP_UNUSED_ARG(len);
+#if LWIP_HTTPD_STATS
+httpd_stats.bytes_sent += len;
+#endif /* LWIP_HTTPD_STATS */
 
 if (hs == NULL)
 {
@@ -2657,10 +3324,25 @@ else
   if (hs->retries == ((hs->is_websocket) ? WS_TIMEOUT : HTTPD_MAX_RETRIES))
   {
     LWIP_DEBUGF(HTTPD_DEBUG, ("http_poll: too many retries, close\n"));
+    HTTPD_STATS_INC(conns_timeout);
     http_close_conn(pcb, hs);
     return ERR_OK;
   }
 
+#if LWIP_HTTPD_SSE
+  if (hs->is_sse)
+  {
+    /* catch up if an event was missed, keep idle streams alive so that
+     dead clients are found by the retries above */
+    if (!http_sse_send(pcb, hs) && (hs->retries > 1))
+    {
+      tcp_write(pcb, SSE_HEARTBEAT, sizeof(SSE_HEARTBEAT) - 1, 0);
+    }
+    tcp_output(pcb);
+    return ERR_OK;
+  }
+#endif /* LWIP_HTTPD_SSE */
+
   /* If this connection has a file open, try to send some more data. If
    * it has not yet received a GET request, don't do this since it will
    * cause the connection to close immediately. */
@@ -2809,6 +3491,126 @@ if (data != NULL && data_len > 1)
 return ERR_VAL;
 }
 
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SUPPORT_REQUESTLIST
+/** Drop the parsed request from hs->req, keeping the pipelined ones behind it.
+ */
+static void http_req_consume(struct http_state *hs, u16_t len)
+{
+struct pbuf *q = hs->req;
+
+while ((q != NULL) && (q->len <= len))
+{
+  struct pbuf *head = q;
+  len -= q->len;
+  q = q->next;
+  /* free the head pbuf */
+  head->next = NULL;
+  pbuf_free(head);
+}
+if (q != NULL)
+{
+  pbuf_header(q, -(s16_t)len);
+}
+hs->req = q;
+}
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SUPPORT_REQUESTLIST */
+
+/** Parse a request and start sending the response. With persistent
+ * connections, requests pipelined behind it are served in turn as long as
+ * their responses complete right away; the others are picked up from
+ * http_eof() once the current response is done.
+ *
+ * @param p the received pbuf or NULL to parse the requests queued in hs->req
+ */
+static void http_handle_request(struct tcp_pcb *pcb, struct http_state *hs,
+                                struct pbuf *p)
+{
+err_t parsed;
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+u8_t keepalive;
+
+hs->in_request = 1;
+http_request_hs = hs;
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+do
+{
+  hs->retries = 0;
+  parsed = http_parse_request(&p, hs, pcb);
+  LWIP_ASSERT(
+      "http_parse_request: unexpected return value",
+      parsed == ERR_OK || parsed == ERR_INPROGRESS ||parsed == ERR_ARG || parsed == ERR_USE || parsed == ERR_MEM);
+#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+  p = NULL;
+  if ((parsed != ERR_INPROGRESS) && (hs->req != NULL))
+  {
+    /* request fully parsed or error */
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+    if ((parsed == ERR_OK) && hs->keepalive && (hs->req_len != 0)
+        && (hs->req_len < hs->req->tot_len))
+    {
+      http_req_consume(hs, hs->req_len);
+    }
+    else
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+    {
+      pbuf_free(hs->req);
+      hs->req = NULL;
+    }
+  }
+#else /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+  if (p != NULL)
+  {
+    /* pbuf not passed to application, free it now */
+    pbuf_free(p);
+  }
+#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+  if (parsed != ERR_OK)
+  {
+    if (parsed == ERR_ARG || parsed == ERR_MEM)
+    {
+      /* @todo: close on ERR_USE? */
+      HTTPD_STATS_INC(reqs);
+      HTTPD_STATS_INC(reqs_dropped);
+      http_close_conn(pcb, hs);
+      return;
+    }
+    break;
+  }
+  HTTPD_STATS_INC(reqs);
+#if LWIP_HTTPD_STATS
+  /* 0 means no request in progress */
+  hs->req_started = LWIP_MAX(sys_now(), 1);
+#endif /* LWIP_HTTPD_STATS */
+#if LWIP_HTTPD_SUPPORT_POST
+  if (hs->post_content_len_left != 0)
+  {
+    break;
+  }
+#endif /* LWIP_HTTPD_SUPPORT_POST */
+  LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("http_recv: data %p len %"S32_F"\n", hs->file, hs->left));
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+  keepalive = hs->keepalive;
+  http_send(pcb, hs);
+  if (!keepalive || (http_request_hs != hs))
+  {
+    /* hs might be freed already: http_send() and http_eof() close the
+     connection on errors and on responses that cannot be delimited */
+    return;
+  }
+#else /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+  http_send(pcb, hs);
+  return;
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SUPPORT_REQUESTLIST
+} while ((hs->handle == NULL) && (hs->req != NULL) && !hs->is_websocket);
+#else /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SUPPORT_REQUESTLIST */
+} while (0);
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SUPPORT_REQUESTLIST */
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+hs->in_request = 0;
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+}
+
 /**
  * Data has been received on this pcb.
  * For HTTP 1.0, this should normally only happen once (if the request fits in one packet).
@@ -2816,7 +3618,6 @@ return ERR_VAL;
 static err_t http_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p,
                        err_t err)
 {
-err_t parsed = ERR_ABRT;
 struct http_state *hs = (struct http_state *)arg;
 LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("http_recv: pcb=%p pbuf=%p err=%s\n", (void*)pcb,
         (void*)p, lwip_strerr(err)));
@@ -2876,6 +3677,15 @@ else
   tcp_recved(pcb, p->tot_len);
 }
 
+#if LWIP_HTTPD_SSE
+if (hs->is_sse)
+{
+  /* nothing is expected from event stream clients */
+  pbuf_free(p);
+  return ERR_OK;
+}
+#endif /* LWIP_HTTPD_SSE */
+
 #if LWIP_HTTPD_SUPPORT_POST
 if (hs->post_content_len_left > 0)
 {
@@ -2896,46 +3706,34 @@ else
 {
   if (hs->handle == NULL)
   {
-    parsed = http_parse_request(&p, hs, pcb);
-    LWIP_ASSERT(
-        "http_parse_request: unexpected return value",
-        parsed == ERR_OK || parsed == ERR_INPROGRESS ||parsed == ERR_ARG || parsed == ERR_USE || parsed == ERR_MEM);
+    http_handle_request(pcb, hs, p);
   }
-  else
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SUPPORT_REQUESTLIST
+  else if (hs->keepalive)
   {
-    LWIP_DEBUGF(HTTPD_DEBUG, ("http_recv: already sending data\n"));
-  }
-#if LWIP_HTTPD_SUPPORT_REQUESTLIST
-  if (parsed != ERR_INPROGRESS)
-  {
-    /* request fully parsed or error */
-    if (hs->req != NULL)
+    /* pipelined request: keep it until the current response is sent */
+    LWIP_DEBUGF(HTTPD_DEBUG, ("http_recv: queueing pipelined request\n"));
+    HTTPD_STATS_INC(pipelined);
+    if (hs->req == NULL)
     {
-      pbuf_free(hs->req);
-      hs->req = NULL;
+      hs->req = p;
     }
-  }
-#else /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
-  if (p != NULL)
-  {
-    /* pbuf not passed to application, free it now */
-    pbuf_free(p);
-  }
-#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
-  if (parsed == ERR_OK)
-  {
-#if LWIP_HTTPD_SUPPORT_POST
-    if (hs->post_content_len_left == 0)
-#endif /* LWIP_HTTPD_SUPPORT_POST */
+    else
+    {
+      pbuf_cat(hs->req, p);
+    }
+    if ((hs->req->tot_len > LWIP_HTTPD_PIPELINE_BUFSIZE)
+        || (pbuf_clen(hs->req) > 2 * LWIP_HTTPD_REQ_QUEUELEN))
     {
-      LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("http_recv: data %p len %"S32_F"\n", hs->file, hs->left));
-      http_send(pcb, hs);
+      LWIP_DEBUGF(HTTPD_DEBUG, ("http_recv: too many pipelined requests, close\n"));
+      http_close_conn(pcb, hs);
     }
   }
-  else if (parsed == ERR_ARG || parsed == ERR_MEM)
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SUPPORT_REQUESTLIST */
+  else
   {
-    /* @todo: close on ERR_USE? */
-    http_close_conn(pcb, hs);
+    LWIP_DEBUGF(HTTPD_DEBUG, ("http_recv: already sending data\n"));
+    pbuf_free(p);
   }
 }
 return ERR_OK;
@@ -2961,9 +3759,16 @@ hs = http_state_alloc();
 if (hs == NULL)
 {
   LWIP_DEBUGF(HTTPD_DEBUG, ("http_accept: Out of memory, RST\n"));
+  HTTPD_STATS_INC(conns_refused);
   return ERR_MEM;
 }
 hs->pcb = pcb;
+#if LWIP_HTTPD_STATS
+httpd_stats.conns++;
+httpd_stats.conns_active++;
+httpd_stats.conns_max = LWIP_MAX(httpd_stats.conns_max,
+                                 httpd_stats.conns_active);
+#endif /* LWIP_HTTPD_STATS */
 
 /* Tell TCP that this is the structure we wish to be passed for our
  callbacks. */
@@ -2999,6 +3804,17 @@ tcp_arg(pcb, pcb);
 tcp_accept(pcb, http_accept);
 }
 
+#if LWIP_HTTPD_STATS
+void httpd_get_stats(httpd_stats_t *stats)
+{
+SYS_ARCH_DECL_PROTECT(lev);
+
+SYS_ARCH_PROTECT(lev);
+*stats = httpd_stats;
+SYS_ARCH_UNPROTECT(lev);
+}
+#endif /* LWIP_HTTPD_STATS */
+
 /**
  * Initialize the httpd: set up a listening PCB and bind it to the defined port
  */
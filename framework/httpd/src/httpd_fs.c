@@ -56,6 +56,14 @@ void fs_close_custom(struct fs_file *file);
 u8_t fs_canread_custom(struct fs_file *file);
 u8_t fs_wait_read_custom(struct fs_file *file, fs_wait_cb callback_fn, void *callback_arg);
 #endif /* LWIP_HTTPD_FS_ASYNC_READ */
+#if LWIP_HTTPD_DYNAMIC_FILE_READ
+/* Custom files opened with data == NULL are read through these */
+#if LWIP_HTTPD_FS_ASYNC_READ
+int fs_read_async_custom(struct fs_file *file, char *buffer, int count, fs_wait_cb callback_fn, void *callback_arg);
+#else /* LWIP_HTTPD_FS_ASYNC_READ */
+int fs_read_custom(struct fs_file *file, char *buffer, int count);
+#endif /* LWIP_HTTPD_FS_ASYNC_READ */
+#endif /* LWIP_HTTPD_DYNAMIC_FILE_READ */
 #endif /* LWIP_HTTPD_CUSTOM_FILES */
 
 /*-----------------------------------------------------------------------------------*/
@@ -130,6 +138,16 @@ fs_read(struct fs_file *file, char *buffer, int count)
   {
     return FS_READ_EOF;
   }
+#if LWIP_HTTPD_CUSTOM_FILES
+  if (file->is_custom_file && (file->data == NULL))
+  {
+#if LWIP_HTTPD_FS_ASYNC_READ
+    return fs_read_async_custom(file, buffer, count, callback_fn, callback_arg);
+#else /* LWIP_HTTPD_FS_ASYNC_READ */
+    return fs_read_custom(file, buffer, count);
+#endif /* LWIP_HTTPD_FS_ASYNC_READ */
+  }
+#endif /* LWIP_HTTPD_CUSTOM_FILES */
 #if LWIP_HTTPD_FS_ASYNC_READ
 #if LWIP_HTTPD_CUSTOM_FILES
   if (!fs_canread_custom(file))
@@ -0,0 +1,1008 @@
+/*
+ * httpd load test, a host program ("make httpdload")
+ *
+ * httpd.c serves the ROM files of the firmware (fsdata.c, without the webfs
+ * of the flash) on a port of the host port of the core (lwip_host.h). The
+ * load generator is a PC on the same segment, a tap with a TCP client of its
+ * own, so that only the server draws on the heap of the device: a link of
+ * HTTPD_LOAD_DELAY each way and no rate limit, the loopback of the device.
+ * Each client asks for the pages of httpd_load_uris in turn and asks again
+ * once the response is in, on the same connection when the server keeps it
+ * (HTTP/1.1) or on a new one, for HTTPD_LOAD_TIME.
+ *
+ * Per run: the requests per second of simulated time and the host CPU time
+ * per request, the percentiles of the time from asking (connecting, for a
+ * new connection) to the last byte of the response, and the most the server
+ * has held at once, sampled every ms: connections, pbufs queued on them,
+ * pcbs in TIME-WAIT and heap (the lwip_pool.c blocks in use plus what they
+ * could not serve, out of LWIP_HOST_FREE_HEAP, see lwip_host_heap_malloc()).
+ *
+ * Past HTTPD_LOAD_CLIENTS_HELD clients the heap runs out: connections
+ * refused by httpd (RST), SYNs dropped by the core for want of a pcb and
+ * clients that gave up are counted. The last run opens far more connections
+ * than the heap holds, the server must go on serving and get all of its heap
+ * back once the clients are gone.
+ *
+ * The HTTP/1.0 runs open a connection per request, as every request did
+ * before LWIP_HTTPD_SUPPORT_11_KEEPALIVE. The host is 64 bit, the pcbs and
+ * states take more heap than on the device.
+ */
+#if defined(LWIP_HOST)
+
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_tcp.h"
+#include "lwip/lwip_tcp_impl.h"
+#include "lwip/lwip_inet_chksum.h"
+#include "lwip/lwip_stats.h"
+#include "lwip/lwip_timers.h"
+#include "httpd.h"
+#include "lwip_pool.h"
+#include "lwip_host.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#if !LWIP_HTTPD_STATS || !LWIP_STATS || !TCP_STATS
+#error "httpdload needs LWIP_HTTPD_STATS and TCP_STATS"
+#endif
+
+/* One way delay of the link to the PC, in ms */
+#define HTTPD_LOAD_DELAY        1
+/* Length of a run, and the most it may take the clients to finish */
+#define HTTPD_LOAD_TIME         (10 * 1000)
+#define HTTPD_LOAD_DRAIN        (60 * 1000)
+/* Latency histogram, in ms, the last bucket takes the longer ones */
+#define HTTPD_LOAD_HIST         4096
+#define HTTPD_LOAD_CLIENTS_MAX  128
+/* Clients the heap holds, the runs up to that many may not fail */
+#define HTTPD_LOAD_CLIENTS_HELD 8
+/* The TCP of the PC: first retransmission timeout, doubled each time,
+ retransmissions before giving up, pause before connecting again */
+#define HTTPD_LOAD_RTO          1000
+#define HTTPD_LOAD_RETRIES      4
+#define HTTPD_LOAD_PAUSE        100
+#define HTTPD_LOAD_MSS          1460
+#define HTTPD_LOAD_WND          65535
+#define HTTPD_LOAD_HDR          512
+#define HTTPD_LOAD_PORT         80
+
+typedef enum
+{
+  HTTPD_LOAD_IDLE = 0,
+  HTTPD_LOAD_SYN_SENT,
+  HTTPD_LOAD_OPEN,
+  /* the client closed first, waiting for the FIN of the server */
+  HTTPD_LOAD_FIN_SENT,
+  /* the server closed first, waiting for the ACK of the FIN of the client */
+  HTTPD_LOAD_LAST_ACK
+} httpd_load_state_t;
+
+typedef struct
+{
+  httpd_load_state_t state;
+  u16_t port;
+  u32_t iss;
+  u32_t snd_una;
+  u32_t snd_nxt;
+  u32_t rcv_nxt;
+  /* retransmission timer, 0 when nothing is unacknowledged */
+  u32_t rto_at;
+  u32_t rto;
+  u8_t retries;
+  u8_t fin_sent;
+  u8_t fin_rcvd;
+  /* when to connect again */
+  u32_t next_at;
+  /* the request being answered, asked_at is when the connection was opened
+   for the first one */
+  u8_t uri;
+  u8_t asked;
+  u8_t fresh;
+  u32_t asked_at;
+  char req[128];
+  u16_t req_len;
+  /* its response */
+  char hdr[HTTPD_LOAD_HDR];
+  u16_t hdr_len;
+  u8_t in_body;
+  int status;
+  s32_t body_left;
+  u8_t chunked;
+  u8_t chunk_state;
+  u32_t chunk_left;
+  u32_t body_len;
+} httpd_load_client_t;
+
+/* States of the chunked body */
+enum
+{
+  HTTPD_LOAD_CHUNK_SIZE = 0,
+  HTTPD_LOAD_CHUNK_EXT,
+  HTTPD_LOAD_CHUNK_DATA,
+  HTTPD_LOAD_CHUNK_END,
+  HTTPD_LOAD_CHUNK_LAST,
+  HTTPD_LOAD_CHUNK_DONE
+};
+
+typedef struct
+{
+  u32_t completed;
+  u32_t bad;
+  u32_t resets;
+  u32_t timeouts;
+  u32_t connects;
+  u32_t hist[HTTPD_LOAD_HIST];
+  u32_t max;
+  /* high-water marks of the server */
+  u32_t conns;
+  u32_t pbufs;
+  u32_t time_wait;
+  size_t heap;
+} httpd_load_run_t;
+
+static const char *const httpd_load_uris[] =
+{
+  "/about.html", "/css/style.css", "/img/favicon.png", "/index.ssi",
+  "/js/smoothie_min.js", "/nothere.html"
+};
+#define HTTPD_LOAD_URIS (sizeof(httpd_load_uris) / sizeof(httpd_load_uris[0]))
+
+/* The tags of index.ssi */
+static const char *httpd_load_tags[] =
+{
+  "uptime", "heap", "heapmax", "heapfrag", "heapcost", "heaptask", "led"
+};
+
+static lwip_host_seg_t httpd_load_seg;
+static struct netif httpd_load_dev;
+static struct netif httpd_load_pc;
+static httpd_load_client_t httpd_load_clients[HTTPD_LOAD_CLIENTS_MAX];
+static u8_t httpd_load_num_clients;
+static int httpd_load_keepalive;
+static int httpd_load_running;
+static u16_t httpd_load_next_port = 1024;
+static httpd_load_run_t httpd_load_run;
+static size_t httpd_load_pool_start;
+static unsigned long httpd_load_failures;
+
+static void httpd_load_check(int ok, const char *what)
+{
+  if (!ok)
+  {
+    httpd_load_failures++;
+    printf("httpdload: at %u ms: %s\n", (unsigned)lwip_host_now, what);
+  }
+}
+
+/* log.h of the firmware */
+void Log_Printf(const char *format, ...)
+{
+  (void)format;
+}
+
+/* app/src/main.c takes the uploads, POST is not part of the load */
+err_t httpd_post_begin(void *connection, const char *uri,
+                       const char *http_request, u16_t http_request_len,
+                       int content_len, char *response_uri,
+                       u16_t response_uri_len, u8_t *post_auto_wnd)
+{
+  (void)connection;
+  (void)uri;
+  (void)http_request;
+  (void)http_request_len;
+  (void)content_len;
+  (void)response_uri;
+  (void)response_uri_len;
+  (void)post_auto_wnd;
+  return ERR_ARG;
+}
+
+err_t httpd_post_receive_data(void *connection, struct pbuf *p)
+{
+  (void)connection;
+  pbuf_free(p);
+  return ERR_ARG;
+}
+
+void httpd_post_finished(void *connection, char *response_uri,
+                         u16_t response_uri_len)
+{
+  (void)connection;
+  (void)response_uri;
+  (void)response_uri_len;
+}
+
+static u16_t httpd_load_ssi(int iIndex, char *pcInsert, int iInsertLen,
+                            u16_t current_tag_part, u16_t *next_tag_part)
+{
+  (void)current_tag_part;
+  (void)next_tag_part;
+  return (u16_t)LWIP_MIN(snprintf(pcInsert, iInsertLen, "%d", iIndex * 1000),
+                         iInsertLen - 1);
+}
+
+static double httpd_load_clock(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Bytes of the lwip_pool.c blocks in use */
+static size_t httpd_load_pool_used(void)
+{
+  lwip_pool_stats_t stats[8];
+  size_t used = 0;
+  u8_t num;
+  u8_t i;
+
+  num = LWIP_MIN(lwip_pool_get_stats(stats, 8), 8);
+  for (i = 0; i < num; i++)
+  {
+    used += (size_t)stats[i].used * stats[i].size;
+  }
+  return used;
+}
+
+/* Heap the server holds */
+static size_t httpd_load_heap_used(void)
+{
+  return httpd_load_pool_used() - httpd_load_pool_start
+      + (LWIP_HOST_FREE_HEAP - lwip_host_free_heap);
+}
+
+/* Send a segment of client 'c' with 'flags' and 'len' bytes of 'data' */
+static void httpd_load_send(httpd_load_client_t *c, u32_t seqno, u8_t flags,
+                            const void *data, u16_t len)
+{
+  u8_t frame[SIZEOF_ETH_HDR + IP_HLEN + TCP_HLEN + 4 + sizeof(c->req)];
+  static u16_t ip_id;
+  struct eth_hdr *ethhdr = (struct eth_hdr *)frame;
+  struct ip_hdr *iphdr = (struct ip_hdr *)(ethhdr + 1);
+  struct tcp_hdr *tcphdr = (struct tcp_hdr *)(iphdr + 1);
+  u8_t *opts = (u8_t *)(tcphdr + 1);
+  u16_t hdrlen = TCP_HLEN + ((flags & TCP_SYN) ? 4 : 0);
+  struct pbuf p;
+
+  LWIP_ASSERT("request too long", len <= sizeof(c->req));
+  ETHADDR16_COPY(&ethhdr->dest, httpd_load_dev.hwaddr);
+  ETHADDR16_COPY(&ethhdr->src, httpd_load_pc.hwaddr);
+  ethhdr->type = PP_HTONS(ETHTYPE_IP);
+
+  IPH_VHL_SET(iphdr, 4, IP_HLEN / 4);
+  IPH_TOS_SET(iphdr, 0);
+  IPH_LEN_SET(iphdr, htons(IP_HLEN + hdrlen + len));
+  IPH_ID_SET(iphdr, htons(ip_id));
+  ip_id++;
+  IPH_OFFSET_SET(iphdr, 0);
+  IPH_TTL_SET(iphdr, 64);
+  IPH_PROTO_SET(iphdr, IP_PROTO_TCP);
+  ip_addr_copy(iphdr->src, httpd_load_pc.ip_addr);
+  ip_addr_copy(iphdr->dest, httpd_load_dev.ip_addr);
+  IPH_CHKSUM_SET(iphdr, 0);
+  IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, IP_HLEN));
+
+  tcphdr->src = htons(c->port);
+  tcphdr->dest = PP_HTONS(HTTPD_LOAD_PORT);
+  tcphdr->seqno = htonl(seqno);
+  tcphdr->ackno = htonl((flags & TCP_ACK) ? c->rcv_nxt : 0);
+  TCPH_HDRLEN_FLAGS_SET(tcphdr, hdrlen / 4, flags);
+  tcphdr->wnd = PP_HTONS(HTTPD_LOAD_WND);
+  tcphdr->chksum = 0;
+  tcphdr->urgp = 0;
+  if (flags & TCP_SYN)
+  {
+    opts[0] = 2;
+    opts[1] = 4;
+    opts[2] = HTTPD_LOAD_MSS >> 8;
+    opts[3] = HTTPD_LOAD_MSS & 0xff;
+  }
+  if (len > 0)
+  {
+    memcpy((u8_t *)tcphdr + hdrlen, data, len);
+  }
+
+  memset(&p, 0, sizeof(p));
+  p.payload = tcphdr;
+  p.len = p.tot_len = hdrlen + len;
+  p.type = PBUF_ROM;
+  p.ref = 1;
+  tcphdr->chksum = inet_chksum_pseudo(&p, &httpd_load_pc.ip_addr,
+                                      &httpd_load_dev.ip_addr, IP_PROTO_TCP,
+                                      p.tot_len);
+
+  /* the segment copies the frame */
+  p.payload = frame;
+  p.len = p.tot_len = SIZEOF_ETH_HDR + IP_HLEN + hdrlen + len;
+  httpd_load_pc.linkoutput(&httpd_load_pc, &p);
+}
+
+static void httpd_load_arm(httpd_load_client_t *c)
+{
+  c->rto_at = lwip_host_now + c->rto;
+}
+
+static void httpd_load_connect(httpd_load_client_t *c)
+{
+  c->state = HTTPD_LOAD_SYN_SENT;
+  c->port = httpd_load_next_port++;
+  if (httpd_load_next_port == 0)
+  {
+    httpd_load_next_port = 1024;
+  }
+  c->iss = lwip_host_rand();
+  c->snd_una = c->iss;
+  c->snd_nxt = c->iss + 1;
+  c->rcv_nxt = 0;
+  c->fin_sent = 0;
+  c->fin_rcvd = 0;
+  c->rto = HTTPD_LOAD_RTO;
+  c->retries = 0;
+  c->asked = 0;
+  c->fresh = 1;
+  c->asked_at = lwip_host_now;
+  httpd_load_run.connects++;
+  httpd_load_send(c, c->iss, TCP_SYN, NULL, 0);
+  httpd_load_arm(c);
+}
+
+/* Ask for the next page on the open connection of 'c' */
+static void httpd_load_ask(httpd_load_client_t *c)
+{
+  const char *uri = httpd_load_uris[c->uri];
+
+  c->uri = (c->uri + 1) % HTTPD_LOAD_URIS;
+  if (httpd_load_keepalive)
+  {
+    c->req_len = snprintf(c->req, sizeof(c->req),
+                          "GET %s HTTP/1.1\r\nHost: 10.0.1.1\r\n\r\n", uri);
+  }
+  else
+  {
+    c->req_len = snprintf(c->req, sizeof(c->req),
+                          "GET %s HTTP/1.0\r\nHost: 10.0.1.1\r\n\r\n", uri);
+  }
+  if (!c->fresh)
+  {
+    c->asked_at = lwip_host_now;
+  }
+  c->fresh = 0;
+  c->asked = 1;
+  c->hdr_len = 0;
+  c->in_body = 0;
+  c->status = 0;
+  c->body_left = -1;
+  c->chunked = 0;
+  c->chunk_state = HTTPD_LOAD_CHUNK_SIZE;
+  c->chunk_left = 0;
+  c->body_len = 0;
+  httpd_load_send(c, c->snd_nxt, TCP_ACK | TCP_PSH, c->req, c->req_len);
+  c->snd_nxt += c->req_len;
+  httpd_load_arm(c);
+}
+
+/* Back to idle, to connect again after 'pause' ms */
+static void httpd_load_idle(httpd_load_client_t *c, u32_t pause)
+{
+  c->state = HTTPD_LOAD_IDLE;
+  c->rto_at = 0;
+  c->next_at = lwip_host_now + pause;
+}
+
+static void httpd_load_close(httpd_load_client_t *c, httpd_load_state_t state)
+{
+  c->fin_sent = 1;
+  c->state = state;
+  httpd_load_send(c, c->snd_nxt, TCP_FIN | TCP_ACK, NULL, 0);
+  c->snd_nxt++;
+  httpd_load_arm(c);
+}
+
+static int httpd_load_hdr_has(const char *hdr, const char *what)
+{
+  size_t len = strlen(what);
+
+  for (; *hdr != '\0'; hdr++)
+  {
+    if (strncasecmp(hdr, what, len) == 0)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static const char *httpd_load_hdr_find(const char *hdr, const char *what)
+{
+  size_t len = strlen(what);
+
+  for (; *hdr != '\0'; hdr++)
+  {
+    if (strncasecmp(hdr, what, len) == 0)
+    {
+      return hdr + len;
+    }
+  }
+  return NULL;
+}
+
+/* The headers of the response are in */
+static void httpd_load_headers(httpd_load_client_t *c)
+{
+  const char *length;
+
+  c->hdr[c->hdr_len] = '\0';
+  if (strncmp(c->hdr, "HTTP/1.", 7) == 0)
+  {
+    c->status = atoi(c->hdr + 9);
+  }
+  length = httpd_load_hdr_find(c->hdr, "\r\nContent-Length:");
+  if (length != NULL)
+  {
+    c->body_left = atoi(length);
+  }
+  c->chunked = httpd_load_hdr_has(c->hdr, "\r\nTransfer-Encoding: chunked");
+  c->in_body = 1;
+}
+
+/* Take 'len' bytes of a chunked body, returns those left after its end */
+static u16_t httpd_load_chunks(httpd_load_client_t *c, const u8_t *data,
+                               u16_t len)
+{
+  u16_t n;
+
+  while ((len > 0) && (c->chunk_state != HTTPD_LOAD_CHUNK_DONE))
+  {
+    switch (c->chunk_state)
+    {
+      case HTTPD_LOAD_CHUNK_SIZE:
+        if (isxdigit(*data))
+        {
+          c->chunk_left = c->chunk_left * 16
+              + (isdigit(*data) ? *data - '0' : (tolower(*data) - 'a' + 10));
+        }
+        else if (*data == '\n')
+        {
+          c->chunk_state = c->chunk_left ? HTTPD_LOAD_CHUNK_DATA
+              : HTTPD_LOAD_CHUNK_LAST;
+        }
+        else
+        {
+          c->chunk_state = HTTPD_LOAD_CHUNK_EXT;
+        }
+        data++;
+        len--;
+        break;
+
+      case HTTPD_LOAD_CHUNK_EXT:
+        if (*data == '\n')
+        {
+          c->chunk_state = c->chunk_left ? HTTPD_LOAD_CHUNK_DATA
+              : HTTPD_LOAD_CHUNK_LAST;
+        }
+        data++;
+        len--;
+        break;
+
+      case HTTPD_LOAD_CHUNK_DATA:
+        n = (u16_t)LWIP_MIN(c->chunk_left, len);
+        c->chunk_left -= n;
+        c->body_len += n;
+        data += n;
+        len -= n;
+        if (c->chunk_left == 0)
+        {
+          c->chunk_state = HTTPD_LOAD_CHUNK_END;
+        }
+        break;
+
+      case HTTPD_LOAD_CHUNK_END:
+        /* the CRLF after the data */
+        if (*data == '\n')
+        {
+          c->chunk_state = HTTPD_LOAD_CHUNK_SIZE;
+        }
+        data++;
+        len--;
+        break;
+
+      case HTTPD_LOAD_CHUNK_LAST:
+        /* no trailers, the empty line */
+        if (*data == '\n')
+        {
+          c->chunk_state = HTTPD_LOAD_CHUNK_DONE;
+        }
+        data++;
+        len--;
+        break;
+    }
+  }
+  return len;
+}
+
+/* Take 'len' bytes of the response, returns non zero once it is all in */
+static int httpd_load_response(httpd_load_client_t *c, const u8_t *data,
+                               u16_t len)
+{
+  u16_t n;
+  char *end;
+
+  if (!c->in_body)
+  {
+    n = (u16_t)LWIP_MIN(len, sizeof(c->hdr) - 1 - c->hdr_len);
+    memcpy(c->hdr + c->hdr_len, data, n);
+    c->hdr[c->hdr_len + n] = '\0';
+    end = strstr(c->hdr, "\r\n\r\n");
+    if (end == NULL)
+    {
+      c->hdr_len += n;
+      if (c->hdr_len == sizeof(c->hdr) - 1)
+      {
+        /* headers too long */
+        c->status = -1;
+        c->in_body = 1;
+      }
+      return 0;
+    }
+    /* what follows the headers is body */
+    n = (u16_t)(end + 4 - c->hdr) - c->hdr_len;
+    c->hdr_len = end + 4 - c->hdr;
+    httpd_load_headers(c);
+    data += n;
+    len -= n;
+  }
+
+  if (c->chunked)
+  {
+    len = httpd_load_chunks(c, data, len);
+    if (len > 0)
+    {
+      /* bytes after the end of the response */
+      c->status = -1;
+    }
+    return c->chunk_state == HTTPD_LOAD_CHUNK_DONE;
+  }
+  if (c->body_left >= 0)
+  {
+    if (len > c->body_left)
+    {
+      c->status = -1;
+      len = c->body_left;
+    }
+    c->body_left -= len;
+    c->body_len += len;
+    return c->body_left == 0;
+  }
+  /* ends with the connection */
+  c->body_len += len;
+  return 0;
+}
+
+static void httpd_load_done(httpd_load_client_t *c)
+{
+  u32_t latency = lwip_host_now - c->asked_at;
+  /* the page asked for was the one before c->uri */
+  u8_t uri = (c->uri + HTTPD_LOAD_URIS - 1) % HTTPD_LOAD_URIS;
+  int status = strcmp(httpd_load_uris[uri], "/nothere.html") ? 200 : 404;
+
+  if ((c->status != status) || (c->body_len == 0))
+  {
+    httpd_load_run.bad++;
+    return;
+  }
+  httpd_load_run.completed++;
+  httpd_load_run.hist[LWIP_MIN(latency, HTTPD_LOAD_HIST - 1)]++;
+  httpd_load_run.max = LWIP_MAX(httpd_load_run.max, latency);
+}
+
+static httpd_load_client_t *httpd_load_find(u16_t port)
+{
+  u8_t i;
+
+  for (i = 0; i < httpd_load_num_clients; i++)
+  {
+    if ((httpd_load_clients[i].state != HTTPD_LOAD_IDLE)
+        && (httpd_load_clients[i].port == port))
+    {
+      return &httpd_load_clients[i];
+    }
+  }
+  return NULL;
+}
+
+/* A segment of the server for client 'c' */
+static void httpd_load_segment(httpd_load_client_t *c, struct tcp_hdr *tcphdr,
+                               const u8_t *data, u16_t len)
+{
+  u8_t flags = TCPH_FLAGS(tcphdr);
+  u32_t seqno = ntohl(tcphdr->seqno);
+  u32_t ackno = ntohl(tcphdr->ackno);
+  int done = 0;
+
+  if (flags & TCP_RST)
+  {
+    httpd_load_run.resets++;
+    httpd_load_idle(c, HTTPD_LOAD_PAUSE);
+    return;
+  }
+
+  if (c->state == HTTPD_LOAD_SYN_SENT)
+  {
+    if (((flags & (TCP_SYN | TCP_ACK)) == (TCP_SYN | TCP_ACK))
+        && (ackno == c->iss + 1))
+    {
+      c->rcv_nxt = seqno + 1;
+      c->snd_una = ackno;
+      c->state = HTTPD_LOAD_OPEN;
+      c->rto = HTTPD_LOAD_RTO;
+      c->retries = 0;
+      httpd_load_ask(c);
+    }
+    return;
+  }
+
+  if ((flags & TCP_ACK) && TCP_SEQ_GT(ackno, c->snd_una)
+      && TCP_SEQ_LEQ(ackno, c->snd_nxt))
+  {
+    c->snd_una = ackno;
+    c->rto = HTTPD_LOAD_RTO;
+    c->retries = 0;
+    c->rto_at = (c->snd_una == c->snd_nxt) ? 0 : lwip_host_now + c->rto;
+  }
+
+  if ((len > 0) || (flags & TCP_FIN))
+  {
+    if (seqno != c->rcv_nxt)
+    {
+      /* a retransmission, or ahead of a lost segment */
+      httpd_load_send(c, c->snd_nxt, TCP_ACK, NULL, 0);
+      return;
+    }
+    c->rcv_nxt += len;
+    if ((len > 0) && (c->state == HTTPD_LOAD_OPEN))
+    {
+      if (c->asked)
+      {
+        done = httpd_load_response(c, data, len);
+      }
+      else
+      {
+        /* nothing was asked */
+        httpd_load_run.bad++;
+      }
+    }
+    if (flags & TCP_FIN)
+    {
+      c->rcv_nxt++;
+      c->fin_rcvd = 1;
+      if ((c->state == HTTPD_LOAD_OPEN) && c->asked && c->in_body
+          && !c->chunked && (c->body_left < 0))
+      {
+        done = 1;
+      }
+    }
+    httpd_load_send(c, c->snd_nxt, TCP_ACK, NULL, 0);
+  }
+
+  switch (c->state)
+  {
+    case HTTPD_LOAD_OPEN:
+      if (done)
+      {
+        c->asked = 0;
+        httpd_load_done(c);
+        /* HTTP/1.0 waits for the server to close */
+        if (httpd_load_keepalive && !c->fin_rcvd)
+        {
+          if (httpd_load_running)
+          {
+            httpd_load_ask(c);
+          }
+          else
+          {
+            httpd_load_close(c, HTTPD_LOAD_FIN_SENT);
+          }
+        }
+      }
+      if (c->fin_rcvd && (c->state == HTTPD_LOAD_OPEN))
+      {
+        if (!done && c->asked)
+        {
+          /* the response was cut short */
+          httpd_load_run.bad++;
+        }
+        httpd_load_close(c, HTTPD_LOAD_LAST_ACK);
+      }
+      break;
+
+    case HTTPD_LOAD_FIN_SENT:
+      if (c->fin_rcvd && (c->snd_una == c->snd_nxt))
+      {
+        httpd_load_idle(c, 0);
+      }
+      break;
+
+    case HTTPD_LOAD_LAST_ACK:
+      if (c->snd_una == c->snd_nxt)
+      {
+        httpd_load_idle(c, 0);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+/* Input of the PC */
+static err_t httpd_load_input(struct pbuf *p, struct netif *netif)
+{
+  struct eth_hdr *ethhdr = p->payload;
+  struct ip_hdr *iphdr;
+  struct tcp_hdr *tcphdr;
+  httpd_load_client_t *c;
+  u16_t iphlen;
+  u16_t hdrlen;
+  u16_t len;
+
+  if (lwip_host_tap_arp(netif, p) || (p->len < SIZEOF_ETH_HDR + IP_HLEN)
+      || (ethhdr->type != PP_HTONS(ETHTYPE_IP)))
+  {
+    pbuf_free(p);
+    return ERR_OK;
+  }
+  iphdr = (struct ip_hdr *)(ethhdr + 1);
+  iphlen = IPH_HL(iphdr) * 4;
+  len = ntohs(IPH_LEN(iphdr));
+  if ((IPH_PROTO(iphdr) != IP_PROTO_TCP) || (len > p->len - SIZEOF_ETH_HDR)
+      || (len < iphlen + TCP_HLEN))
+  {
+    pbuf_free(p);
+    return ERR_OK;
+  }
+  tcphdr = (struct tcp_hdr *)((u8_t *)iphdr + iphlen);
+  hdrlen = TCPH_HDRLEN(tcphdr) * 4;
+  c = httpd_load_find(ntohs(tcphdr->dest));
+  if ((c != NULL) && (len >= iphlen + hdrlen))
+  {
+    httpd_load_segment(c, tcphdr, (u8_t *)tcphdr + hdrlen,
+                       len - iphlen - hdrlen);
+  }
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+/* Every ms: connect the idle clients, retransmit, give up, and sample the
+ server */
+static void httpd_load_tick(void *arg)
+{
+  httpd_load_client_t *c;
+  struct tcp_pcb *pcb;
+  struct tcp_seg *seg;
+  u32_t conns = 0;
+  u32_t pbufs = 0;
+  u32_t time_wait = 0;
+  u8_t i;
+
+  (void)arg;
+  for (i = 0; i < httpd_load_num_clients; i++)
+  {
+    c = &httpd_load_clients[i];
+    if (c->state == HTTPD_LOAD_IDLE)
+    {
+      if (httpd_load_running && ((s32_t)(lwip_host_now - c->next_at) >= 0))
+      {
+        httpd_load_connect(c);
+      }
+      continue;
+    }
+    if ((c->rto_at == 0) || ((s32_t)(lwip_host_now - c->rto_at) < 0))
+    {
+      continue;
+    }
+    if (++c->retries > HTTPD_LOAD_RETRIES)
+    {
+      httpd_load_run.timeouts++;
+      httpd_load_send(c, c->snd_nxt, TCP_RST | TCP_ACK, NULL, 0);
+      httpd_load_idle(c, HTTPD_LOAD_PAUSE);
+      continue;
+    }
+    c->rto *= 2;
+    httpd_load_arm(c);
+    if (c->state == HTTPD_LOAD_SYN_SENT)
+    {
+      httpd_load_send(c, c->iss, TCP_SYN, NULL, 0);
+    }
+    else if (c->fin_sent)
+    {
+      httpd_load_send(c, c->snd_nxt - 1, TCP_FIN | TCP_ACK, NULL, 0);
+    }
+    else
+    {
+      httpd_load_send(c, c->snd_una, TCP_ACK | TCP_PSH, c->req, c->req_len);
+    }
+  }
+
+  for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next)
+  {
+    if (pcb->local_port != HTTPD_LOAD_PORT)
+    {
+      continue;
+    }
+    conns++;
+    for (seg = pcb->unsent; seg != NULL; seg = seg->next)
+    {
+      pbufs += pbuf_clen(seg->p);
+    }
+    for (seg = pcb->unacked; seg != NULL; seg = seg->next)
+    {
+      pbufs += pbuf_clen(seg->p);
+    }
+  }
+  for (pcb = tcp_tw_pcbs; pcb != NULL; pcb = pcb->next)
+  {
+    time_wait++;
+  }
+  httpd_load_run.conns = LWIP_MAX(httpd_load_run.conns, conns);
+  httpd_load_run.pbufs = LWIP_MAX(httpd_load_run.pbufs, pbufs);
+  httpd_load_run.time_wait = LWIP_MAX(httpd_load_run.time_wait, time_wait);
+  /* with the timeout of the tick, as the heap of main() */
+  sys_timeout(1, httpd_load_tick, NULL);
+  httpd_load_run.heap = LWIP_MAX(httpd_load_run.heap, httpd_load_heap_used());
+}
+
+static int httpd_load_all_idle(void *arg)
+{
+  u8_t i;
+
+  (void)arg;
+  for (i = 0; i < httpd_load_num_clients; i++)
+  {
+    if (httpd_load_clients[i].state != HTTPD_LOAD_IDLE)
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Latency under which 'permille' of the requests were answered */
+static u32_t httpd_load_percentile(u32_t permille)
+{
+  u32_t want = (u32_t)(httpd_load_run.completed * (permille / 1000.0));
+  u32_t seen = 0;
+  u32_t ms;
+
+  for (ms = 0; ms < HTTPD_LOAD_HIST; ms++)
+  {
+    seen += httpd_load_run.hist[ms];
+    if ((seen >= want) && (seen > 0))
+    {
+      return ms;
+    }
+  }
+  return httpd_load_run.max;
+}
+
+/* 'clients' clients for HTTPD_LOAD_TIME, returns the requests answered */
+static u32_t httpd_load_clients_run(u8_t clients, int keepalive,
+                                    const char *what)
+{
+  httpd_stats_t before;
+  httpd_stats_t after;
+  u32_t memerr = lwip_stats.tcp.memerr;
+  double start;
+  double cpu;
+  u32_t drain;
+  u8_t i;
+
+  memset(&httpd_load_run, 0, sizeof(httpd_load_run));
+  memset(httpd_load_clients, 0, sizeof(httpd_load_clients));
+  for (i = 0; i < clients; i++)
+  {
+    /* spread the first requests over the pages and the first ms */
+    httpd_load_clients[i].uri = i % HTTPD_LOAD_URIS;
+    httpd_load_clients[i].next_at = lwip_host_now + 1 + i % 8;
+  }
+  httpd_load_num_clients = clients;
+  httpd_load_keepalive = keepalive;
+  lwip_host_min_free_heap = lwip_host_free_heap;
+  httpd_get_stats(&before);
+
+  httpd_load_running = 1;
+  start = httpd_load_clock();
+  lwip_host_run(HTTPD_LOAD_TIME);
+  cpu = httpd_load_clock() - start;
+  httpd_load_running = 0;
+  drain = lwip_host_run_until(httpd_load_all_idle, NULL, HTTPD_LOAD_DRAIN);
+  httpd_get_stats(&after);
+
+  printf("  %-10s %3u clients %6.0f req/s, %4u ms p50 %4u ms p99 %5u ms max, "
+         "%5.1f us/req on the host, peak %3u conns %3u pbufs %3u time-wait "
+         "%6u B heap (%6u B left)\n", what, (unsigned)clients,
+         httpd_load_run.completed * 1000.0 / HTTPD_LOAD_TIME,
+         (unsigned)httpd_load_percentile(500),
+         (unsigned)httpd_load_percentile(990), (unsigned)httpd_load_run.max,
+         httpd_load_run.completed ? cpu * 1e6 / httpd_load_run.completed : 0.0,
+         (unsigned)httpd_load_run.conns, (unsigned)httpd_load_run.pbufs,
+         (unsigned)httpd_load_run.time_wait, (unsigned)httpd_load_run.heap,
+         (unsigned)lwip_host_min_free_heap);
+  printf("  %-10s %3u clients %6u answered, %u bad, %u connects, %u refused, "
+         "%u SYNs dropped, %u resets, %u gave up, %u timed out by httpd\n", "",
+         (unsigned)clients, (unsigned)httpd_load_run.completed,
+         (unsigned)httpd_load_run.bad, (unsigned)httpd_load_run.connects,
+         (unsigned)(after.conns_refused - before.conns_refused),
+         (unsigned)(lwip_stats.tcp.memerr - memerr),
+         (unsigned)httpd_load_run.resets, (unsigned)httpd_load_run.timeouts,
+         (unsigned)(after.conns_timeout - before.conns_timeout));
+
+  httpd_load_check(drain <= HTTPD_LOAD_DRAIN, "clients did not finish");
+  httpd_load_check(httpd_load_run.completed > 0, "nothing answered");
+  if (clients <= HTTPD_LOAD_CLIENTS_HELD)
+  {
+    httpd_load_check(httpd_load_run.bad == 0, "bad response");
+    httpd_load_check((httpd_load_run.resets == 0)
+                     && (httpd_load_run.timeouts == 0),
+                     "connection refused or given up");
+    httpd_load_check(!keepalive || (httpd_load_run.connects == clients),
+                     "connection not kept alive");
+  }
+
+  /* the TIME-WAIT pcbs go, then the server holds what it did before */
+  lwip_host_run(2 * TCP_MSL + 1000);
+  httpd_load_check(httpd_load_heap_used() == 0, "heap not given back");
+  httpd_load_check(lwip_host_rx_buffers == 0, "RX buffers not recycled");
+  return httpd_load_run.completed;
+}
+
+int main(void)
+{
+  static const u8_t clients[] = { 1, 8, 32 };
+  ip_addr_t addr;
+  ip_addr_t mask;
+  u32_t completed;
+  size_t i;
+
+  lwip_host_init(1);
+  lwip_host_seg_init(&httpd_load_seg);
+  httpd_load_seg.delay = HTTPD_LOAD_DELAY;
+  IP4_ADDR(&mask, 255, 255, 255, 0);
+  IP4_ADDR(&addr, 10, 0, 1, 1);
+  lwip_host_port_add(&httpd_load_seg, &httpd_load_dev, &addr, &mask, NULL);
+  IP4_ADDR(&addr, 10, 0, 1, 2);
+  lwip_host_tap_add(&httpd_load_seg, &httpd_load_pc, &addr, httpd_load_input);
+
+  httpd_init();
+  http_set_ssi_handler(httpd_load_ssi, httpd_load_tags,
+                       sizeof(httpd_load_tags) / sizeof(httpd_load_tags[0]));
+  sys_timeout(1, httpd_load_tick, NULL);
+  /* the listener and the ARP entry of the PC stay */
+  lwip_host_run(1);
+  httpd_load_pool_start = httpd_load_pool_used();
+
+  printf("httpdload, LWIP_HTTPD_SUPPORT_11_KEEPALIVE %d, round trip %d ms, "
+         "%d s a run, %d B of heap\n", LWIP_HTTPD_SUPPORT_11_KEEPALIVE,
+         2 * HTTPD_LOAD_DELAY, HTTPD_LOAD_TIME / 1000, LWIP_HOST_FREE_HEAP);
+  for (i = 0; i < sizeof(clients); i++)
+  {
+    httpd_load_clients_run(clients[i], 1, "HTTP/1.1");
+  }
+  for (i = 0; i < sizeof(clients); i++)
+  {
+    httpd_load_clients_run(clients[i], 0, "HTTP/1.0");
+  }
+
+  /* more connections than the heap holds, then one client must be served
+   as before */
+  completed = httpd_load_clients_run(HTTPD_LOAD_CLIENTS_MAX, 1, "exhaustion");
+  httpd_load_check(completed > 0, "nothing served under exhaustion");
+  httpd_load_clients_run(1, 1, "after");
+  return (httpd_load_failures == 0) ? 0 : 1;
+}
+
+#endif /* LWIP_HOST */
@@ -0,0 +1,542 @@
+/* Inclusion section ======================================================== */
+#include <string.h>
+#if !defined(LWIP_HOST)
+#include "freertos.h"
+#include "freertos_task.h"
+#include "freertos_queue.h"
+#else
+/* The web filesystem on the host, see httpd_webfs_bench.c: the FreeRTOS
+ calls come with the lwIP sys_arch */
+#endif
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_def.h"
+#include "lwip/lwip_mem.h"
+#include "lwip/lwip_tcpip.h"
+#include "spiflash.h"
+#include "log.h"
+#include "httpd_fs.h"
+#include "httpd_webfs.h"
+
+#if LWIP_HTTPD_CUSTOM_FILES && LWIP_HTTPD_DYNAMIC_FILE_READ \
+    && LWIP_HTTPD_FS_ASYNC_READ
+
+/* Private macro definition section ========================================= */
+#define WEBFS_PAGE_EMPTY        0
+#define WEBFS_PAGE_LOADING      1
+#define WEBFS_PAGE_VALID        2
+
+/* webfs_file_t.wait_page when the file is not waiting for flash data */
+#define WEBFS_WAIT_NONE         -1
+/* webfs_file_t.wait_page when all pages were busy loading */
+#define WEBFS_WAIT_ANY          -2
+
+#define WEBFS_CHECK_CHUNK       256
+
+#define WEBFS_TASK_STACK_SIZE   256
+
+/* Private type definition section ========================================== */
+typedef struct
+{
+  uint8_t data[WEBFS_PAGE_SIZE] __attribute__((aligned(4)));
+  /* flash address of the cached data, page aligned */
+  uint32_t addr;
+  /* webfs.clock value of the last access, the lowest one is evicted */
+  uint32_t last_used;
+  /* mount generation the page was requested for */
+  uint8_t gen;
+  uint8_t state;
+} webfs_page_t;
+
+/* Per open file state, hooked to fs_file.pextension */
+typedef struct webfs_file
+{
+  struct webfs_file *next;
+  /* flash address of the first byte of the file */
+  uint32_t addr;
+  uint8_t gen;
+  /* page index the file is waiting for, or WEBFS_WAIT_NONE/ANY */
+  int8_t wait_page;
+  /* webfs.wake_seq of the last wake-up, each file is woken once per load */
+  uint32_t wake_seq;
+  fs_wait_cb callback_fn;
+  void *callback_arg;
+} webfs_file_t;
+
+typedef struct
+{
+  struct webfs_entry *dir;
+  uint16_t num_files;
+  bool mounted;
+  uint8_t gen;
+  uint32_t clock;
+  uint32_t wake_seq;
+  webfs_file_t *files;
+  QueueHandle_t read_queue;
+  webfs_stats_t stats;
+} webfs_t;
+
+/* Private function prototype section ======================================= */
+int fs_open_custom(struct fs_file *file, const char *name);
+void fs_close_custom(struct fs_file *file);
+u8_t fs_canread_custom(struct fs_file *file);
+u8_t fs_wait_read_custom(struct fs_file *file, fs_wait_cb callback_fn,
+                         void *callback_arg);
+int fs_read_async_custom(struct fs_file *file, char *buffer, int count,
+                         fs_wait_cb callback_fn, void *callback_arg);
+
+static void webfs_read_task(void *param);
+static void webfs_page_loaded(void *ctx);
+static int webfs_page_lookup(uint32_t addr);
+static int webfs_page_fetch(uint32_t addr);
+
+/* Private variable section ================================================= */
+static webfs_t webfs;
+static webfs_page_t webfs_cache[WEBFS_CACHE_PAGES];
+static StaticQueue_t webfs_queue_buf;
+static uint8_t webfs_queue_storage[WEBFS_CACHE_PAGES];
+static StaticTask_t webfs_task_buf;
+static StackType_t webfs_task_stack[WEBFS_TASK_STACK_SIZE];
+
+/* Public function definition section ======================================= */
+void webfs_init(void)
+{
+  webfs.read_queue = xQueueCreateStatic(WEBFS_CACHE_PAGES, sizeof(uint8_t),
+                                        webfs_queue_storage, &webfs_queue_buf);
+  xTaskCreateStatic(webfs_read_task, "task_webfs", WEBFS_TASK_STACK_SIZE, NULL,
+                    3, webfs_task_stack, &webfs_task_buf);
+
+  if (!webfs_check_image(WEBFS_FLASH_ADDR))
+  {
+    LOG_PRINTF("WEBFS: no valid image at 0x%x, using built-in pages",
+               WEBFS_FLASH_ADDR);
+    return;
+  }
+  webfs_mount();
+}
+
+bool webfs_check_image(uint32_t addr)
+{
+  struct webfs_header header;
+  uint32_t chunk[WEBFS_CHECK_CHUNK / sizeof(uint32_t)];
+  uint32_t offset;
+  uint32_t sum = 0;
+  uint32_t len;
+  uint32_t i;
+
+  if (!spiflash_read(addr, (uint8_t *)&header, sizeof(header)))
+  {
+    return false;
+  }
+  if ((header.magic != WEBFS_MAGIC) || (header.version != WEBFS_VERSION)
+      || (header.size > WEBFS_FLASH_SIZE)
+      || (header.size < sizeof(header)
+                        + header.num_files * sizeof(struct webfs_entry)))
+  {
+    return false;
+  }
+
+  for (offset = sizeof(header); offset < header.size; offset += len)
+  {
+    len = LWIP_MIN(sizeof(chunk), header.size - offset);
+    if (!spiflash_read(addr + offset, (uint8_t *)chunk, len))
+    {
+      return false;
+    }
+    for (i = 0; i < len; i++)
+    {
+      sum += ((uint8_t *)chunk)[i];
+    }
+  }
+
+  return (sum == header.checksum);
+}
+
+err_t webfs_mount(void)
+{
+  struct webfs_header header;
+  struct webfs_entry *dir;
+  uint32_t dir_size;
+  uint16_t i;
+
+  webfs_unmount();
+
+  if (!spiflash_read(WEBFS_FLASH_ADDR, (uint8_t *)&header, sizeof(header))
+      || (header.magic != WEBFS_MAGIC) || (header.version != WEBFS_VERSION)
+      || (header.size > WEBFS_FLASH_SIZE))
+  {
+    return ERR_VAL;
+  }
+
+  dir_size = header.num_files * sizeof(struct webfs_entry);
+  dir = (struct webfs_entry *)mem_malloc(dir_size);
+  if (dir == NULL)
+  {
+    return ERR_MEM;
+  }
+  if (!spiflash_read(WEBFS_FLASH_ADDR + sizeof(header), (uint8_t *)dir,
+                     dir_size))
+  {
+    mem_free(dir);
+    return ERR_VAL;
+  }
+
+  for (i = 0; i < header.num_files; i++)
+  {
+    dir[i].name[WEBFS_NAME_LEN - 1] = '\0';
+    if ((dir[i].offset > header.size)
+        || (dir[i].len > header.size - dir[i].offset))
+    {
+      mem_free(dir);
+      return ERR_VAL;
+    }
+  }
+
+  webfs.dir = dir;
+  webfs.num_files = header.num_files;
+  webfs.mounted = true;
+  LOG_PRINTF("WEBFS: mounted %u files, %u bytes", header.num_files,
+             header.size);
+
+  return ERR_OK;
+}
+
+void webfs_unmount(void)
+{
+  int i;
+
+  if (webfs.dir != NULL)
+  {
+    mem_free(webfs.dir);
+    webfs.dir = NULL;
+  }
+  webfs.num_files = 0;
+  webfs.mounted = false;
+  /* open files and pages still loading belong to the old image now */
+  webfs.gen++;
+
+  for (i = 0; i < WEBFS_CACHE_PAGES; i++)
+  {
+    if (webfs_cache[i].state == WEBFS_PAGE_VALID)
+    {
+      webfs_cache[i].state = WEBFS_PAGE_EMPTY;
+    }
+  }
+}
+
+void webfs_get_stats(webfs_stats_t *stats)
+{
+  *stats = webfs.stats;
+  stats->num_files = webfs.num_files;
+  stats->mounted = webfs.mounted;
+}
+
+/* httpd_fs.c hooks, all called in the tcpip thread */
+int fs_open_custom(struct fs_file *file, const char *name)
+{
+  webfs_file_t *wf;
+  uint16_t i;
+
+  if (!webfs.mounted)
+  {
+    return 0;
+  }
+
+  for (i = 0; i < webfs.num_files; i++)
+  {
+    if (!strcmp(name, webfs.dir[i].name))
+    {
+      break;
+    }
+  }
+  if (i == webfs.num_files)
+  {
+    return 0;
+  }
+
+  wf = (webfs_file_t *)mem_malloc(sizeof(webfs_file_t));
+  if (wf == NULL)
+  {
+    /* fall back to fsdata.c, it might have the same file */
+    return 0;
+  }
+  wf->addr = WEBFS_FLASH_ADDR + webfs.dir[i].offset;
+  wf->gen = webfs.gen;
+  wf->wait_page = WEBFS_WAIT_NONE;
+  wf->wake_seq = webfs.wake_seq;
+  wf->callback_fn = NULL;
+  wf->callback_arg = NULL;
+  wf->next = webfs.files;
+  webfs.files = wf;
+
+  /* no data pointer: httpd fetches everything through fs_read_async() */
+  file->data = NULL;
+  file->len = webfs.dir[i].len;
+  file->index = 0;
+  file->pextension = wf;
+  file->http_header_included = 1;
+
+  /* start loading the first page while httpd sets up the response */
+  if (webfs_page_lookup(wf->addr & ~(WEBFS_PAGE_SIZE - 1)) < 0)
+  {
+    webfs_page_fetch(wf->addr & ~(WEBFS_PAGE_SIZE - 1));
+  }
+
+  return 1;
+}
+
+void fs_close_custom(struct fs_file *file)
+{
+  webfs_file_t *wf = (webfs_file_t *)file->pextension;
+  webfs_file_t **pp;
+
+  if (wf == NULL)
+  {
+    return;
+  }
+
+  for (pp = &webfs.files; *pp != NULL; pp = &(*pp)->next)
+  {
+    if (*pp == wf)
+    {
+      *pp = wf->next;
+      break;
+    }
+  }
+  mem_free(wf);
+  file->pextension = NULL;
+}
+
+u8_t fs_canread_custom(struct fs_file *file)
+{
+  webfs_file_t *wf = (webfs_file_t *)file->pextension;
+
+  if (!file->is_custom_file || (wf == NULL))
+  {
+    return 1;
+  }
+  return (wf->wait_page == WEBFS_WAIT_NONE);
+}
+
+u8_t fs_wait_read_custom(struct fs_file *file, fs_wait_cb callback_fn,
+                         void *callback_arg)
+{
+  webfs_file_t *wf = (webfs_file_t *)file->pextension;
+
+  if (!file->is_custom_file || (wf == NULL)
+      || (wf->wait_page == WEBFS_WAIT_NONE))
+  {
+    return 0;
+  }
+  wf->callback_fn = callback_fn;
+  wf->callback_arg = callback_arg;
+  return 1;
+}
+
+int fs_read_async_custom(struct fs_file *file, char *buffer, int count,
+                         fs_wait_cb callback_fn, void *callback_arg)
+{
+  webfs_file_t *wf = (webfs_file_t *)file->pextension;
+  webfs_page_t *page;
+  uint32_t addr;
+  uint32_t page_addr;
+  int idx;
+  int chunk;
+  int read = 0;
+
+  if ((wf == NULL) || (wf->gen != webfs.gen) || (file->index >= file->len))
+  {
+    return FS_READ_EOF;
+  }
+
+  while ((read < count) && (file->index < file->len))
+  {
+    addr = wf->addr + file->index;
+    page_addr = addr & ~(WEBFS_PAGE_SIZE - 1);
+    idx = webfs_page_lookup(page_addr);
+    if ((idx < 0) || (webfs_cache[idx].state != WEBFS_PAGE_VALID))
+    {
+      webfs.stats.misses++;
+      if (idx < 0)
+      {
+        idx = webfs_page_fetch(page_addr);
+      }
+      wf->wait_page = (idx < 0) ? WEBFS_WAIT_ANY : idx;
+      wf->callback_fn = callback_fn;
+      wf->callback_arg = callback_arg;
+      if (read > 0)
+      {
+        /* send what we have, the rest is on its way: httpd is called back
+         when it is loaded, not only when the client acknowledges this */
+        break;
+      }
+      return FS_READ_DELAYED;
+    }
+
+    webfs.stats.hits++;
+    page = &webfs_cache[idx];
+    page->last_used = ++webfs.clock;
+    chunk = LWIP_MIN(count - read, file->len - file->index);
+    chunk = LWIP_MIN(chunk, (int)(page_addr + WEBFS_PAGE_SIZE - addr));
+    MEMCPY(buffer + read, page->data + (addr - page_addr), chunk);
+    read += chunk;
+    file->index += chunk;
+  }
+
+  /* read ahead so the next call does not have to wait for SPI */
+  if (file->index < file->len)
+  {
+    page_addr = (wf->addr + file->index) & ~(WEBFS_PAGE_SIZE - 1);
+    if (webfs_page_lookup(page_addr) < 0)
+    {
+      webfs_page_fetch(page_addr);
+    }
+  }
+
+  return read;
+}
+
+/* Private function definition section ====================================== */
+static int webfs_page_lookup(uint32_t addr)
+{
+  int i;
+
+  for (i = 0; i < WEBFS_CACHE_PAGES; i++)
+  {
+    if ((webfs_cache[i].state != WEBFS_PAGE_EMPTY)
+        && (webfs_cache[i].gen == webfs.gen) && (webfs_cache[i].addr == addr))
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* Claim the least recently used page which is not being loaded and hand it
+ * to webfs_read_task. Returns the page index or -1 if all pages are busy. */
+static int webfs_page_fetch(uint32_t addr)
+{
+  uint8_t idx = 0;
+  int victim = -1;
+  int i;
+
+  for (i = 0; i < WEBFS_CACHE_PAGES; i++)
+  {
+    if (webfs_cache[i].state == WEBFS_PAGE_EMPTY)
+    {
+      victim = i;
+      break;
+    }
+    if ((webfs_cache[i].state == WEBFS_PAGE_VALID)
+        && ((victim < 0)
+            || (webfs_cache[i].last_used < webfs_cache[victim].last_used)))
+    {
+      victim = i;
+    }
+  }
+  if (victim < 0)
+  {
+    return -1;
+  }
+
+  idx = victim;
+  webfs_cache[idx].addr = addr;
+  webfs_cache[idx].gen = webfs.gen;
+  webfs_cache[idx].state = WEBFS_PAGE_LOADING;
+  if (xQueueSend(webfs.read_queue, &idx, 0) != pdTRUE)
+  {
+    webfs_cache[idx].state = WEBFS_PAGE_EMPTY;
+    return -1;
+  }
+  return idx;
+}
+
+/* Reads pages from flash outside the tcpip thread */
+static void webfs_read_task(void *param)
+{
+  uint8_t idx;
+  webfs_page_t *page;
+
+  while (1)
+  {
+    xQueueReceive(webfs.read_queue, &idx, portMAX_DELAY);
+    page = &webfs_cache[idx];
+
+    if (!spiflash_read(page->addr, page->data, WEBFS_PAGE_SIZE))
+    {
+      /* let webfs_page_loaded discard the page */
+      page->gen--;
+    }
+    webfs.stats.flash_reads++;
+
+    while (tcpip_callback(webfs_page_loaded, (void *)(uint32_t)idx) != ERR_OK)
+    {
+      vTaskDelay(1);
+    }
+  }
+}
+
+/* Runs in the tcpip thread once webfs_read_task has filled a page */
+static void webfs_page_loaded(void *ctx)
+{
+  int idx = (int)(uint32_t)ctx;
+  webfs_page_t *page = &webfs_cache[idx];
+  webfs_file_t *wf;
+  fs_wait_cb callback_fn;
+  uint32_t seq;
+
+  page->state = (page->gen == webfs.gen) ? WEBFS_PAGE_VALID : WEBFS_PAGE_EMPTY;
+  page->last_used = ++webfs.clock;
+
+  /* Wake up the files waiting for this page or for any free page. The
+   * callbacks re-enter httpd which may close files, so restart the walk
+   * after each one and use wake_seq to wake every file only once. */
+  seq = ++webfs.wake_seq;
+  wf = webfs.files;
+  while (wf != NULL)
+  {
+    if ((wf->wake_seq != seq)
+        && ((wf->wait_page == idx) || (wf->wait_page == WEBFS_WAIT_ANY)))
+    {
+      wf->wake_seq = seq;
+      wf->wait_page = WEBFS_WAIT_NONE;
+      callback_fn = wf->callback_fn;
+      if (callback_fn != NULL)
+      {
+        callback_fn(wf->callback_arg);
+      }
+      wf = webfs.files;
+    }
+    else
+    {
+      wf = wf->next;
+    }
+  }
+}
+
+#else /* LWIP_HTTPD_CUSTOM_FILES && ... */
+
+void webfs_init(void)
+{
+}
+
+bool webfs_check_image(uint32_t addr)
+{
+  LWIP_UNUSED_ARG(addr);
+  return false;
+}
+
+err_t webfs_mount(void)
+{
+  return ERR_VAL;
+}
+
+void webfs_unmount(void)
+{
+}
+
+void webfs_get_stats(webfs_stats_t *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+}
+
+#endif /* LWIP_HTTPD_CUSTOM_FILES && ... */
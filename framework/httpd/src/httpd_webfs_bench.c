@@ -0,0 +1,378 @@
+/*
+ * Web filesystem benchmark, a host program ("make webfsbench")
+ *
+ * httpd.c and httpd_webfs.c run with the tcpip thread on the threads of
+ * lwip_host_sys.c, pinned to one CPU as on the one core of the device, and
+ * the reader task of httpd_webfs.c on its own. The image makefsimage packs
+ * from framework/fsdata/fs is in a flash in RAM, where spiflash_read() takes
+ * WEBFS_BENCH_READ_US a page as the chip. A client GETs each file over the
+ * loopback netif.
+ *
+ * Per file: the time from the request to the last byte of the response and
+ * the flash reads of a request with a cold cache, right after webfs_mount(),
+ * and with a warm one, WEBFS_BENCH_WARM requests later, then the time of the
+ * same file from the ROM files of fsdata.c with the image unmounted.
+ *
+ * Every response must be the file of the image. A cold request reads each
+ * page of the file once, a warm one of a file that fits the
+ * WEBFS_CACHE_PAGES of the cache reads none.
+ */
+#if defined(LWIP_HOST)
+
+#define _GNU_SOURCE
+
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_sys.h"
+#include "lwip/lwip_tcpip.h"
+#include "lwip/lwip_sockets.h"
+#include "spiflash.h"
+#include "httpd.h"
+#include "httpd_webfs.h"
+
+#if NO_SYS || !LWIP_SOCKET || !LWIP_NETIF_LOOPBACK || !LWIP_HAVE_LOOPIF
+#error "webfsbench needs the sockets of lwip_host_sys.c and the loopback netif"
+#endif
+#if !LWIP_HTTPD_CUSTOM_FILES || !LWIP_HTTPD_FS_ASYNC_READ
+#error "webfsbench needs the custom files and async reads of httpd.c"
+#endif
+
+#define WEBFS_BENCH_PORT        80
+/* A page read: 512 B at 80 MHz over the four lines of QIO is 13 us, and
+ spiflash_read() sends a command for every 64 B */
+#define WEBFS_BENCH_READ_US     20
+#define WEBFS_BENCH_WARM        20
+#define WEBFS_BENCH_TIMEOUT     10000
+/* A request which takes longer is stuck on a page that never loaded */
+#define WEBFS_BENCH_STUCK_S     10
+#define WEBFS_BENCH_RESPONSE    32768
+
+typedef struct
+{
+  /* the time of each request, in us */
+  u32_t us[WEBFS_BENCH_WARM];
+  u32_t count;
+  u32_t reads;
+} webfs_bench_times_t;
+
+static u8_t webfs_bench_flash[WEBFS_FLASH_SIZE] __attribute__((aligned(4)));
+static u32_t webfs_bench_reads;
+static u32_t webfs_bench_t0;
+static unsigned long webfs_bench_failures;
+
+static void webfs_bench_check(int ok, const char *what)
+{
+  if (!ok)
+  {
+    webfs_bench_failures++;
+    printf("webfsbench: at %u ms: %s\n",
+           (unsigned)(sys_now() - webfs_bench_t0), what);
+  }
+}
+
+static void webfs_bench_stuck(int sig)
+{
+  static const char msg[] = "webfsbench: request stuck\n";
+
+  (void)sig;
+  /* write() of libc, lwip_sockets.h makes the name lwip_write() */
+  if ((write)(STDOUT_FILENO, msg, sizeof(msg) - 1) < 0)
+  {
+    /* exit all the same */
+  }
+  _exit(1);
+}
+
+/* The flash of httpd_webfs.c, the partition of the image only */
+bool spiflash_read(uint32_t addr, uint8_t *buf, uint32_t size)
+{
+  struct timespec ts;
+
+  if ((addr < WEBFS_FLASH_ADDR) || (size > WEBFS_FLASH_SIZE)
+      || (addr - WEBFS_FLASH_ADDR > WEBFS_FLASH_SIZE - size))
+  {
+    return false;
+  }
+  memcpy(buf, webfs_bench_flash + addr - WEBFS_FLASH_ADDR, size);
+  if (size == WEBFS_PAGE_SIZE)
+  {
+    __atomic_add_fetch(&webfs_bench_reads, 1, __ATOMIC_RELAXED);
+    ts.tv_sec = 0;
+    ts.tv_nsec = WEBFS_BENCH_READ_US * 1000L;
+    nanosleep(&ts, NULL);
+  }
+  return true;
+}
+
+void Log_Printf(const char *format, ...)
+{
+  (void)format;
+}
+
+/* app/src/fota.c takes the uploads, there are none */
+err_t httpd_post_begin(void *connection, const char *uri,
+                       const char *http_request, u16_t http_request_len,
+                       int content_len, char *response_uri,
+                       u16_t response_uri_len, u8_t *post_auto_wnd)
+{
+  (void)connection;
+  (void)uri;
+  (void)http_request;
+  (void)http_request_len;
+  (void)content_len;
+  (void)response_uri;
+  (void)response_uri_len;
+  (void)post_auto_wnd;
+  return ERR_ARG;
+}
+
+err_t httpd_post_receive_data(void *connection, struct pbuf *p)
+{
+  (void)connection;
+  pbuf_free(p);
+  return ERR_ARG;
+}
+
+void httpd_post_finished(void *connection, char *response_uri,
+                         u16_t response_uri_len)
+{
+  (void)connection;
+  (void)response_uri;
+  (void)response_uri_len;
+}
+
+static void webfs_bench_init_done(void *arg)
+{
+  sys_sem_signal((sys_sem_t *)arg);
+}
+
+static u32_t webfs_bench_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u32_t)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+/* Copy the image of 'path' to the flash, returns its header */
+static int webfs_bench_load(const char *path, struct webfs_header *header)
+{
+  FILE *f = fopen(path, "rb");
+  size_t len;
+
+  if (f == NULL)
+  {
+    return -1;
+  }
+  memset(webfs_bench_flash, 0xFF, sizeof(webfs_bench_flash));
+  len = fread(webfs_bench_flash, 1, sizeof(webfs_bench_flash), f);
+  fclose(f);
+  memcpy(header, webfs_bench_flash, sizeof(*header));
+  return (len >= sizeof(*header)) && (header->size == len) ? 0 : -1;
+}
+
+/* The pages of the cache the file of 'entry' spans */
+static u32_t webfs_bench_pages(const struct webfs_entry *entry)
+{
+  u32_t first = (WEBFS_FLASH_ADDR + entry->offset) & ~(WEBFS_PAGE_SIZE - 1);
+  u32_t last = (WEBFS_FLASH_ADDR + entry->offset + entry->len - 1)
+      & ~(WEBFS_PAGE_SIZE - 1);
+
+  return (last - first) / WEBFS_PAGE_SIZE + 1;
+}
+
+/* GET 'uri' until the server closes, returns the length of the response */
+static int webfs_bench_get(const char *uri, char *buf, int size)
+{
+  struct sockaddr_in addr;
+  char req[WEBFS_NAME_LEN + 32];
+  int timeout = WEBFS_BENCH_TIMEOUT;
+  int len = 0;
+  int n;
+  int s;
+
+  s = lwip_socket(AF_INET, SOCK_STREAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(WEBFS_BENCH_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if ((s < 0) || (lwip_connect(s, (struct sockaddr *)&addr, sizeof(addr)) != 0))
+  {
+    lwip_close(s);
+    return -1;
+  }
+  lwip_setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  n = snprintf(req, sizeof(req), "GET %s HTTP/1.0\r\n\r\n", uri);
+  if (lwip_send(s, req, n, 0) != n)
+  {
+    lwip_close(s);
+    return -1;
+  }
+  while ((len < size) && ((n = lwip_recv(s, buf + len, size - len, 0)) > 0))
+  {
+    len += n;
+  }
+  lwip_close(s);
+  return len;
+}
+
+/* One request of 'entry' into 'times', the response must be 'expect' if it is
+ not NULL */
+static void webfs_bench_request(const struct webfs_entry *entry,
+                                const u8_t *expect, webfs_bench_times_t *times)
+{
+  static char response[WEBFS_BENCH_RESPONSE];
+  u32_t reads = __atomic_load_n(&webfs_bench_reads, __ATOMIC_RELAXED);
+  u32_t start;
+  int len;
+
+  alarm(WEBFS_BENCH_STUCK_S);
+  start = webfs_bench_us();
+  len = webfs_bench_get(entry->name, response, sizeof(response));
+  times->us[times->count++] = webfs_bench_us() - start;
+  alarm(0);
+  times->reads += __atomic_load_n(&webfs_bench_reads, __ATOMIC_RELAXED) - reads;
+
+  webfs_bench_check(len > 0, entry->name);
+  if (expect != NULL)
+  {
+    webfs_bench_check((len == (int)entry->len)
+                      && !memcmp(response, expect, entry->len),
+                      "response is not the file of the image");
+  }
+}
+
+static int webfs_bench_cmp(const void *a, const void *b)
+{
+  u32_t x = *(const u32_t *)a;
+  u32_t y = *(const u32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+static u32_t webfs_bench_median(webfs_bench_times_t *times)
+{
+  qsort(times->us, times->count, sizeof(times->us[0]), webfs_bench_cmp);
+  return times->us[times->count / 2];
+}
+
+static void webfs_bench_file(const struct webfs_entry *entry)
+{
+  const u8_t *data = webfs_bench_flash + entry->offset;
+  webfs_bench_times_t cold;
+  webfs_bench_times_t warm;
+  webfs_bench_times_t rom;
+  webfs_stats_t before;
+  webfs_stats_t after;
+  u32_t pages = webfs_bench_pages(entry);
+  u32_t i;
+
+  memset(&cold, 0, sizeof(cold));
+  memset(&warm, 0, sizeof(warm));
+  memset(&rom, 0, sizeof(rom));
+
+  /* a mount drops the pages of the cache */
+  LOCK_TCPIP_CORE();
+  webfs_bench_check(webfs_mount() == ERR_OK, "image not mounted");
+  UNLOCK_TCPIP_CORE();
+  webfs_bench_request(entry, data, &cold);
+  LOCK_TCPIP_CORE();
+  webfs_get_stats(&before);
+  UNLOCK_TCPIP_CORE();
+  for (i = 0; i < WEBFS_BENCH_WARM; i++)
+  {
+    webfs_bench_request(entry, data, &warm);
+  }
+  LOCK_TCPIP_CORE();
+  webfs_get_stats(&after);
+  webfs_unmount();
+  UNLOCK_TCPIP_CORE();
+  /* the ROM files have headers of their own */
+  webfs_bench_request(entry, NULL, &rom);
+
+  printf("  %-22s %6u B %3u pages  cold %6.2f ms %3u reads  "
+         "warm %6.2f ms %5.1f reads %3.0f%% hits  rom %6.2f ms\n",
+         entry->name, (unsigned)entry->len, (unsigned)pages,
+         cold.us[0] / 1000.0, (unsigned)cold.reads,
+         webfs_bench_median(&warm) / 1000.0,
+         (double)warm.reads / WEBFS_BENCH_WARM,
+         100.0 * (after.hits - before.hits)
+             / ((after.hits - before.hits) + (after.misses - before.misses)),
+         rom.us[0] / 1000.0);
+
+  webfs_bench_check(cold.reads == pages, "cold: a page not read once");
+  if (pages <= WEBFS_CACHE_PAGES)
+  {
+    webfs_bench_check(warm.reads == 0, "warm: pages read from flash");
+  }
+}
+
+int main(int argc, char **argv)
+{
+  struct webfs_header header;
+  const struct webfs_entry *dir;
+  webfs_stats_t stats;
+  cpu_set_t cpus;
+  sys_sem_t sem;
+  u16_t i;
+
+  if (argc != 2)
+  {
+    printf("usage: webfsbench fsimage.bin\n");
+    return 1;
+  }
+  /* the threads of lwip_host_sys.c inherit both: one CPU, and sleeps of
+   WEBFS_BENCH_READ_US not rounded up to the 50 us of the timer slack */
+  CPU_ZERO(&cpus);
+  CPU_SET(0, &cpus);
+  sched_setaffinity(0, sizeof(cpus), &cpus);
+  prctl(PR_SET_TIMERSLACK, 1);
+
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  webfs_bench_t0 = sys_now();
+  signal(SIGALRM, webfs_bench_stuck);
+  if (webfs_bench_load(argv[1], &header) != 0)
+  {
+    printf("webfsbench: no image in %s\n", argv[1]);
+    return 1;
+  }
+  printf("webfsbench, %u files in %u B, %u pages of %u B cached, "
+         "%u us a page read, one CPU\n", header.num_files,
+         (unsigned)header.size, WEBFS_CACHE_PAGES, WEBFS_PAGE_SIZE,
+         WEBFS_BENCH_READ_US);
+
+  sys_sem_new(&sem, 0);
+  tcpip_init(webfs_bench_init_done, &sem);
+  sys_sem_wait(&sem);
+  sys_sem_free(&sem);
+
+  webfs_init();
+  LOCK_TCPIP_CORE();
+  webfs_get_stats(&stats);
+  httpd_init();
+  UNLOCK_TCPIP_CORE();
+  webfs_bench_check(stats.mounted && (stats.num_files == header.num_files),
+                    "image not mounted");
+
+  dir = (const struct webfs_entry *)(webfs_bench_flash + sizeof(header));
+  for (i = 0; i < header.num_files; i++)
+  {
+    /* the output of SSI depends on the tags, not only on the file */
+    if (strstr(dir[i].name, ".ssi") == NULL)
+    {
+      webfs_bench_file(&dir[i]);
+    }
+  }
+
+  return (webfs_bench_failures == 0) ? 0 : 1;
+}
+
+#endif /* LWIP_HOST */
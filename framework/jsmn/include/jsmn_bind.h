@@ -0,0 +1,102 @@
+#ifndef __JSMN_BIND_H_
+#define __JSMN_BIND_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /**
+   * Binding between a flat JSON object and a C struct, described by tables
+   * that util/jsonbind.py generates from a schema (see app/schema). Keys are
+   * found through a perfect hash of their name, so decoding costs one hash
+   * and one compare per member whatever the number of fields. "make
+   * jsonbench" times it on the host against hand written code.
+   */
+
+  typedef enum
+  {
+    JSMN_BIND_BOOL = 0,
+    JSMN_BIND_INT = 1,
+    JSMN_BIND_UINT = 2,
+    JSMN_BIND_STRING = 3
+  } jsmn_bind_type_t;
+
+  enum jsmn_bind_err
+  {
+    /* Not a JSON object, or a value of the wrong type */
+    JSMN_BIND_ERR_TYPE = -10,
+    /* Number out of the schema limits, or string too long */
+    JSMN_BIND_ERR_RANGE = -11,
+    /* A required field is missing */
+    JSMN_BIND_ERR_MISSING = -12
+  };
+
+  /**
+   * Field description.
+   * @param   key     member name, 'key_len' long
+   * @param   type    jsmn_bind_type_t
+   * @param   size    bytes of the integer, or of the string buffer '\0'
+   *                  included
+   * @param   offset  in the struct
+   * @param   min     limits of JSMN_BIND_INT and JSMN_BIND_UINT fields
+   */
+  typedef struct
+  {
+      const char *key;
+      uint8_t key_len;
+      uint8_t type;
+      uint8_t size;
+      uint16_t offset;
+      int64_t min;
+      int64_t max;
+  } jsmn_bind_field_t;
+
+  /**
+   * Schema of a struct. slots[] has slot_mask + 1 entries, each the index in
+   * fields[] of the key hashing there, 0xFF if none. Bit i of 'required' is
+   * set when fields[i] must be present.
+   */
+  typedef struct
+  {
+      const jsmn_bind_field_t *fields;
+      const uint8_t *slots;
+      uint32_t seed;
+      uint32_t required;
+      uint8_t num_fields;
+      uint8_t slot_mask;
+  } jsmn_bind_schema_t;
+
+  /**
+   * Seeded FNV-1a, the hash util/jsonbind.py makes perfect for the keys.
+   */
+  uint32_t jsmn_bind_hash(uint32_t seed, const char *key, size_t len);
+
+  /**
+   * Write the members of the object in tokens[0] to 'obj'. Unknown members
+   * are skipped, fields absent from the document keep their value. 'seen', if
+   * not NULL, gets bit i set for each fields[i] found.
+   *
+   * Returns the number of fields written or a JSMN_BIND_ERR_* code; fields
+   * before the error may have been written.
+   */
+  int jsmn_bind_decode(const jsmn_bind_schema_t *schema, void *obj,
+                       const char *js, const jsmntok_t *tokens,
+                       int num_tokens, uint32_t *seen);
+
+  /**
+   * Write 'obj' as a JSON object, '\0' terminated. Returns the length
+   * written, 0 if it did not fit.
+   */
+  size_t jsmn_bind_encode(const jsmn_bind_schema_t *schema, const void *obj,
+                          char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JSMN_BIND_H_ */
@@ -0,0 +1,136 @@
+#ifndef __JSMN_STREAM_H_
+#define __JSMN_STREAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /**
+   * Push-style JSON parser. The document is fed in chunks of any size, a
+   * pbuf chain segment by segment for instance:
+   *
+   *   jsmn_stream_init(&parser, config_cb, NULL);
+   *   for (q = p; q != NULL; q = q->next)
+   *     if (jsmn_stream_feed(&parser, q->payload, q->len) < 0) ...
+   *   if (jsmn_stream_finish(&parser) < 0) ...
+   *
+   * Nothing is kept between chunks but the fixed-size parser, and every
+   * value is reported to a callback together with its path from the root:
+   * object members are joined with '.' and array elements numbered, as in
+   * "wifi.ssid" or "sensors[1].pin". Strings are unescaped, \uXXXX encoded
+   * as UTF-8.
+   *
+   * "make jsmnstream" fuzzes the parser on the host and times it against
+   * jsmn_parse().
+   */
+
+  /* Longest path, '\0' included */
+#ifndef JSMN_STREAM_PATH_LEN
+#define JSMN_STREAM_PATH_LEN    64
+#endif
+
+  /* Longer strings are reported in several pieces */
+#ifndef JSMN_STREAM_VALUE_LEN
+#define JSMN_STREAM_VALUE_LEN   64
+#endif
+
+  /* Deepest nesting of objects and arrays */
+#ifndef JSMN_STREAM_DEPTH
+#define JSMN_STREAM_DEPTH       8
+#endif
+
+  /* The event closes an object or array */
+#define JSMN_STREAM_END         0x01
+  /* More pieces of this string follow */
+#define JSMN_STREAM_PARTIAL     0x02
+
+  /**
+   * Parser event.
+   * @param   type    value type, or type of the object or array opened or
+   *                  closed
+   * @param   flags   JSMN_STREAM_END, JSMN_STREAM_PARTIAL
+   * @param   depth   0 for the document itself
+   * @param   path    '\0' terminated, "" for the document itself
+   * @param   value   '\0' terminated string or primitive, NULL for objects
+   *                  and arrays
+   */
+  typedef struct
+  {
+      jsmntype_t type;
+      uint8_t flags;
+      uint8_t depth;
+      uint8_t path_len;
+      const char *path;
+      const char *value;
+      size_t len;
+  } jsmn_stream_event_t;
+
+  /**
+   * Event callback, a non-zero return stops the parser and is returned by
+   * jsmn_stream_feed().
+   */
+  typedef int (*jsmn_stream_cb_t)(void *arg, const jsmn_stream_event_t *ev);
+
+  typedef struct
+  {
+      jsmntype_t type;
+      /* length of the path of the object or array */
+      uint8_t path_len;
+      /* next array element */
+      uint16_t index;
+  } jsmn_stream_level_t;
+
+  /**
+   * Streaming parser state, the open objects and arrays and the key or value
+   * being read.
+   */
+  typedef struct
+  {
+      jsmn_stream_cb_t cb;
+      void *arg;
+      unsigned int pos; /* bytes consumed, the offset of the error if any */
+      uint8_t state;
+      uint8_t depth;
+      uint8_t path_len;
+      uint8_t in_key;
+      uint8_t hex_left; /* \uXXXX digits still expected */
+      uint16_t code;
+      uint16_t value_len;
+      int error;
+      jsmn_stream_level_t levels[JSMN_STREAM_DEPTH];
+      char path[JSMN_STREAM_PATH_LEN];
+      char value[JSMN_STREAM_VALUE_LEN + 1];
+  } jsmn_stream_parser;
+
+  /**
+   * Reset the parser for a new document.
+   */
+  void jsmn_stream_init(jsmn_stream_parser *parser, jsmn_stream_cb_t cb,
+                        void *arg);
+
+  /**
+   * Parse the next 'len' bytes of the document. Returns 0, a JSMN_ERROR_*
+   * code, or what the callback returned to stop. Once it failed, the parser
+   * keeps failing until jsmn_stream_init().
+   *
+   * JSMN_ERROR_NOMEM means JSMN_STREAM_PATH_LEN or JSMN_STREAM_DEPTH was
+   * exceeded.
+   */
+  int jsmn_stream_feed(jsmn_stream_parser *parser, const char *js, size_t len);
+
+  /**
+   * End of the document. Returns 0 if it was complete, JSMN_ERROR_PART if
+   * not, or the error of a previous call.
+   */
+  int jsmn_stream_finish(jsmn_stream_parser *parser);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JSMN_STREAM_H_ */
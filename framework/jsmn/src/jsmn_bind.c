@@ -0,0 +1,419 @@
+#include <string.h>
+#include "jsmn_bind.h"
+
+/* No number of the schema needs more digits, and 18 cannot overflow */
+#define JSMN_BIND_DIGITS_MAX  18
+
+uint32_t jsmn_bind_hash(uint32_t seed, const char *key, size_t len)
+{
+  uint32_t hash = seed ^ 2166136261UL;
+  size_t i;
+
+  for (i = 0; i < len; i++)
+  {
+    hash = (hash ^ (uint8_t)key[i]) * 16777619UL;
+  }
+  return hash ^ (hash >> 16);
+}
+
+/**
+ * Index of the token after the value in tokens[i], its children included.
+ */
+static int jsmn_bind_skip(const jsmntok_t *tokens, int num_tokens, int i)
+{
+  int pending = 1;
+
+  while (pending > 0 && i < num_tokens)
+  {
+    pending += tokens[i].size - 1;
+    i++;
+  }
+  return i;
+}
+
+static const jsmn_bind_field_t *jsmn_bind_find(const jsmn_bind_schema_t *schema,
+                                               const char *key, size_t len)
+{
+  const jsmn_bind_field_t *field;
+  uint8_t index;
+
+  index = schema->slots[jsmn_bind_hash(schema->seed, key, len)
+      & schema->slot_mask];
+  if (index >= schema->num_fields)
+  {
+    return NULL;
+  }
+  field = &schema->fields[index];
+  if (field->key_len != len || memcmp(field->key, key, len) != 0)
+  {
+    return NULL;
+  }
+  return field;
+}
+
+static int jsmn_bind_number(const jsmn_bind_field_t *field, void *dest,
+                            const char *s, int len)
+{
+  int64_t val = 0;
+  int neg = 0;
+  int i = 0;
+
+  if (len > 0 && s[0] == '-')
+  {
+    neg = 1;
+    i = 1;
+  }
+  if (i == len || len - i > JSMN_BIND_DIGITS_MAX)
+  {
+    return (i == len) ? JSMN_BIND_ERR_TYPE : JSMN_BIND_ERR_RANGE;
+  }
+  for (; i < len; i++)
+  {
+    if (s[i] < '0' || s[i] > '9')
+    {
+      /* fractions and exponents are not integers */
+      return JSMN_BIND_ERR_TYPE;
+    }
+    val = val * 10 + (s[i] - '0');
+  }
+  if (neg)
+  {
+    val = -val;
+  }
+  if (val < field->min || val > field->max)
+  {
+    return JSMN_BIND_ERR_RANGE;
+  }
+
+  switch (field->size)
+  {
+    case 1:
+      *(uint8_t *)dest = (uint8_t)val;
+      break;
+    case 2:
+      *(uint16_t *)dest = (uint16_t)val;
+      break;
+    default:
+      *(uint32_t *)dest = (uint32_t)val;
+      break;
+  }
+  return 0;
+}
+
+static int jsmn_bind_hex(char c)
+{
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+  c |= 0x20;
+  if (c >= 'a' && c <= 'f')
+  {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+/**
+ * Copy string 's' to 'dest' unescaped, the UTF-8 of \uXXXX included.
+ */
+static int jsmn_bind_string(const jsmn_bind_field_t *field, char *dest,
+                            const char *s, int len)
+{
+  char *end = dest + field->size - 1;
+  uint32_t code;
+  int i;
+  int d;
+
+  /* most strings have nothing to unescape */
+  if (memchr(s, '\\', len) == NULL)
+  {
+    if (len > end - dest)
+    {
+      return JSMN_BIND_ERR_RANGE;
+    }
+    memcpy(dest, s, len);
+    dest[len] = '\0';
+    return 0;
+  }
+
+  for (i = 0; i < len; i++)
+  {
+    code = (uint8_t)s[i];
+    if (code == '\\' && ++i < len)
+    {
+      switch (s[i])
+      {
+        case 'b':
+          code = '\b';
+          break;
+        case 'f':
+          code = '\f';
+          break;
+        case 'n':
+          code = '\n';
+          break;
+        case 'r':
+          code = '\r';
+          break;
+        case 't':
+          code = '\t';
+          break;
+        case 'u':
+          /* jsmn_parse() checked the 4 hex digits */
+          code = 0;
+          for (d = 0; d < 4 && i + 1 < len; d++)
+          {
+            code = (code << 4) | jsmn_bind_hex(s[++i]);
+          }
+          break;
+        default:
+          code = (uint8_t)s[i];
+          break;
+      }
+      if (code >= 0x80)
+      {
+        if (dest + ((code < 0x800) ? 2 : 3) > end)
+        {
+          return JSMN_BIND_ERR_RANGE;
+        }
+        if (code < 0x800)
+        {
+          *dest++ = 0xC0 | (code >> 6);
+        }
+        else
+        {
+          *dest++ = 0xE0 | (code >> 12);
+          *dest++ = 0x80 | ((code >> 6) & 0x3F);
+        }
+        code = 0x80 | (code & 0x3F);
+      }
+    }
+    if (dest == end)
+    {
+      return JSMN_BIND_ERR_RANGE;
+    }
+    *dest++ = (char)code;
+  }
+  *dest = '\0';
+  return 0;
+}
+
+int jsmn_bind_decode(const jsmn_bind_schema_t *schema, void *obj,
+                     const char *js, const jsmntok_t *tokens, int num_tokens,
+                     uint32_t *seen)
+{
+  const jsmn_bind_field_t *field;
+  const jsmntok_t *key;
+  const jsmntok_t *val;
+  const char *s;
+  uint32_t found = 0;
+  int count = 0;
+  int members;
+  int len;
+  int i;
+  int r;
+
+  if (num_tokens < 1 || tokens[0].type != JSMN_OBJECT)
+  {
+    return JSMN_BIND_ERR_TYPE;
+  }
+
+  i = 1;
+  for (members = tokens[0].size; members > 0 && i + 1 < num_tokens; members--)
+  {
+    key = &tokens[i];
+    val = &tokens[i + 1];
+    i = jsmn_bind_skip(tokens, num_tokens, i + 1);
+    if (key->type != JSMN_STRING)
+    {
+      return JSMN_BIND_ERR_TYPE;
+    }
+    field = jsmn_bind_find(schema, js + key->start, key->end - key->start);
+    if (field == NULL)
+    {
+      continue;
+    }
+
+    s = js + val->start;
+    len = val->end - val->start;
+    switch (field->type)
+    {
+      case JSMN_BIND_BOOL:
+        if (val->type != JSMN_PRIMITIVE || (s[0] != 't' && s[0] != 'f'))
+        {
+          return JSMN_BIND_ERR_TYPE;
+        }
+        *((uint8_t *)obj + field->offset) = (s[0] == 't');
+        r = 0;
+        break;
+
+      case JSMN_BIND_INT:
+      case JSMN_BIND_UINT:
+        if (val->type != JSMN_PRIMITIVE)
+        {
+          return JSMN_BIND_ERR_TYPE;
+        }
+        r = jsmn_bind_number(field, (uint8_t *)obj + field->offset, s, len);
+        break;
+
+      default:
+        if (val->type != JSMN_STRING)
+        {
+          return JSMN_BIND_ERR_TYPE;
+        }
+        r = jsmn_bind_string(field, (char *)obj + field->offset, s, len);
+        break;
+    }
+    if (r != 0)
+    {
+      return r;
+    }
+    found |= 1UL << (field - schema->fields);
+    count++;
+  }
+
+  if ((found & schema->required) != schema->required)
+  {
+    return JSMN_BIND_ERR_MISSING;
+  }
+  if (seen != NULL)
+  {
+    *seen = found;
+  }
+  return count;
+}
+
+/**
+ * Output cursor of jsmn_bind_encode(), 'pos' runs past 'end' on overflow.
+ */
+typedef struct
+{
+    char *pos;
+    char *end;
+} jsmn_bind_out_t;
+
+static void jsmn_bind_put(jsmn_bind_out_t *out, const char *s, size_t len)
+{
+  if (out->pos + len <= out->end)
+  {
+    memcpy(out->pos, s, len);
+  }
+  out->pos += len;
+}
+
+static void jsmn_bind_put_number(jsmn_bind_out_t *out, int64_t val)
+{
+  char digits[21];
+  int n = sizeof(digits);
+  uint64_t u = (val < 0) ? -(uint64_t)val : (uint64_t)val;
+
+  do
+  {
+    digits[--n] = '0' + u % 10;
+    u /= 10;
+  } while (u != 0);
+  if (val < 0)
+  {
+    digits[--n] = '-';
+  }
+  jsmn_bind_put(out, &digits[n], sizeof(digits) - n);
+}
+
+static void jsmn_bind_put_string(jsmn_bind_out_t *out, const char *s)
+{
+  static const char hex[] = "0123456789abcdef";
+  char esc[6] = { '\\', 'u', '0', '0' };
+  const char *run = s;
+
+  jsmn_bind_put(out, "\"", 1);
+  for (; *s != '\0'; s++)
+  {
+    if (*s != '\"' && *s != '\\' && (uint8_t)*s >= 0x20)
+    {
+      continue;
+    }
+    /* copy the plain characters before in one go */
+    jsmn_bind_put(out, run, s - run);
+    run = s + 1;
+    if (*s == '\"' || *s == '\\')
+    {
+      esc[1] = *s;
+      jsmn_bind_put(out, esc, 2);
+      esc[1] = 'u';
+    }
+    else
+    {
+      esc[4] = hex[(uint8_t)*s >> 4];
+      esc[5] = hex[*s & 0xF];
+      jsmn_bind_put(out, esc, 6);
+    }
+  }
+  jsmn_bind_put(out, run, s - run);
+  jsmn_bind_put(out, "\"", 1);
+}
+
+size_t jsmn_bind_encode(const jsmn_bind_schema_t *schema, const void *obj,
+                        char *buf, size_t len)
+{
+  const jsmn_bind_field_t *field;
+  const uint8_t *val;
+  jsmn_bind_out_t out;
+  int i;
+
+  if (len == 0)
+  {
+    return 0;
+  }
+  out.pos = buf;
+  /* room for the '\0' */
+  out.end = buf + len - 1;
+
+  jsmn_bind_put(&out, "{", 1);
+  for (i = 0; i < schema->num_fields; i++)
+  {
+    field = &schema->fields[i];
+    val = (const uint8_t *)obj + field->offset;
+    jsmn_bind_put(&out, (i == 0) ? "\"" : ",\"", (i == 0) ? 1 : 2);
+    jsmn_bind_put(&out, field->key, field->key_len);
+    jsmn_bind_put(&out, "\":", 2);
+    switch (field->type)
+    {
+      case JSMN_BIND_BOOL:
+        if (*val)
+        {
+          jsmn_bind_put(&out, "true", 4);
+        }
+        else
+        {
+          jsmn_bind_put(&out, "false", 5);
+        }
+        break;
+
+      case JSMN_BIND_INT:
+        jsmn_bind_put_number(&out, (field->size == 1) ? *(const int8_t *)val
+            : (field->size == 2) ? *(const int16_t *)val
+            : *(const int32_t *)val);
+        break;
+
+      case JSMN_BIND_UINT:
+        jsmn_bind_put_number(&out, (field->size == 1) ? *val
+            : (field->size == 2) ? *(const uint16_t *)val
+            : *(const uint32_t *)val);
+        break;
+
+      default:
+        jsmn_bind_put_string(&out, (const char *)val);
+        break;
+    }
+  }
+  jsmn_bind_put(&out, "}", 1);
+
+  if (out.pos > out.end)
+  {
+    buf[0] = '\0';
+    return 0;
+  }
+  *out.pos = '\0';
+  return out.pos - buf;
+}
@@ -0,0 +1,536 @@
+/*
+ * jsmn_bind benchmark, a host program ("make jsonbench")
+ *
+ * jsmn_bind_decode() and jsmn_bind_encode() are compared with what they
+ * replace in hand written code: a strncmp() chain over the members, as in the
+ * jsoneq() of the jsmn examples, with strtol() and range checks, and one
+ * snprintf() per object. Two schemas are timed, app_settings of the firmware
+ * (3 fields) and bench_config (16 fields, framework/jsmn/schema), which the
+ * Makefile generates with util/jsonbind.py next to the program.
+ *
+ * Before timing, both decoders must give the same struct and the same count
+ * for each document and reject the same bad ones, and both encoders must
+ * write the same text, which decodes back to the same struct. Decoding is
+ * timed from the tokens, jsmn_parse() runs once beforehand. The figures are
+ * objects per second on the host, the fastest of BIND_ROUNDS; compare the
+ * two ways with each other and not with the LX106.
+ */
+#if defined(JSMN_HOST)
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "jsmn.h"
+#include "app_settings_bind.h"
+#include "bench_config_bind.h"
+
+#define BIND_TOKENS     64
+#define BIND_LOOPS      100000
+#define BIND_ROUNDS     16
+#define BIND_JSON_MAX   512
+
+/* Keeps the compiler from merging the loops of a timed run */
+#define BIND_BARRIER()  __asm__ volatile("" ::: "memory")
+
+typedef struct
+{
+    const char *js;
+    jsmntok_t tokens[BIND_TOKENS];
+    int num_tokens;
+} bind_doc_t;
+
+static const char bind_settings_js[] =
+  "{\"metrics_period\":60,\"led\":true,\"bench\":false}";
+
+/* Every field, not in the order of the schema, and a member to skip */
+static const char bind_config_js[] =
+  "{\"mqtt_host\":\"broker.plusfarm.local\",\"led\":true,"
+  "\"sensor_period\":15000,\"wifi_ssid\":\"PlusFarm-GH1\","
+  "\"threshold_lo\":-40,\"mqtt_port\":1883,\"log_level\":3,"
+  "\"wifi_pass\":\"tomatoes-at-dawn\",\"tz_offset\":420,"
+  "\"firmware\":\"1.4.2\",\"mqtt_keepalive\":60,\"relay_invert\":false,"
+  "\"threshold_hi\":350,\"sensor_pin\":4,\"bench\":false,"
+  "\"ota_check\":true,\"metrics_period\":30}";
+
+/* Each is rejected by both decoders of bench_config */
+static const char *const bind_config_bad[] =
+{
+  "[1,2]",
+  "{\"mqtt_port\":0}",
+  "{\"mqtt_port\":65536}",
+  "{\"tz_offset\":-721}",
+  "{\"log_level\":\"3\"}",
+  "{\"led\":1}",
+  "{\"sensor_pin\":4.5}",
+  "{\"threshold_lo\":-2147483649}",
+  "{\"wifi_ssid\":\"0123456789abcdef0123456789abcdef!\"}",
+  "{\"mqtt_host\":42}"
+};
+
+static bind_doc_t bind_settings_doc = { bind_settings_js };
+static bind_doc_t bind_config_doc = { bind_config_js };
+static app_settings_t bind_settings;
+static bench_config_t bind_config;
+static char bind_out[BIND_JSON_MAX];
+static unsigned long bind_failures;
+
+static void bind_fail(const char *what)
+{
+  bind_failures++;
+  printf("jsonbench: %s\n", what);
+}
+
+static void bind_parse(bind_doc_t *doc)
+{
+  jsmn_parser parser;
+
+  jsmn_init(&parser);
+  doc->num_tokens = jsmn_parse(&parser, doc->js, strlen(doc->js),
+                               doc->tokens, BIND_TOKENS);
+  if (doc->num_tokens < 1)
+  {
+    bind_fail("test document does not parse");
+    exit(1);
+  }
+}
+
+/* The hand written side */
+
+static int hand_eq(const char *js, const jsmntok_t *tok, const char *s)
+{
+  return tok->type == JSMN_STRING
+      && (int)strlen(s) == tok->end - tok->start
+      && strncmp(js + tok->start, s, tok->end - tok->start) == 0;
+}
+
+static int hand_bool(const char *js, const jsmntok_t *tok, bool *out)
+{
+  if (tok->type != JSMN_PRIMITIVE
+      || (js[tok->start] != 't' && js[tok->start] != 'f'))
+  {
+    return -1;
+  }
+  *out = (js[tok->start] == 't');
+  return 0;
+}
+
+static int hand_int(const char *js, const jsmntok_t *tok, long long min,
+                    long long max, long long *out)
+{
+  char num[24];
+  char *end;
+  int len = tok->end - tok->start;
+
+  if (tok->type != JSMN_PRIMITIVE || len >= (int)sizeof(num))
+  {
+    return -1;
+  }
+  memcpy(num, js + tok->start, len);
+  num[len] = '\0';
+  *out = strtoll(num, &end, 10);
+  if (end == num || *end != '\0' || *out < min || *out > max)
+  {
+    return -1;
+  }
+  return 0;
+}
+
+static int hand_str(const char *js, const jsmntok_t *tok, char *dst,
+                    size_t size)
+{
+  size_t len = tok->end - tok->start;
+
+  if (tok->type != JSMN_STRING || len >= size)
+  {
+    return -1;
+  }
+  memcpy(dst, js + tok->start, len);
+  dst[len] = '\0';
+  return 0;
+}
+
+/* Flat objects only, like the documents of the benchmark */
+static int hand_settings_decode(app_settings_t *obj, const char *js,
+                                const jsmntok_t *tokens, int num_tokens)
+{
+  const jsmntok_t *key;
+  const jsmntok_t *val;
+  long long v;
+  int count = 0;
+  int i;
+  int r;
+
+  if (num_tokens < 1 || tokens[0].type != JSMN_OBJECT)
+  {
+    return -1;
+  }
+  for (i = 1; i + 1 < num_tokens; i += 2)
+  {
+    key = &tokens[i];
+    val = &tokens[i + 1];
+    if (hand_eq(js, key, "led"))
+    {
+      r = hand_bool(js, val, &obj->led);
+    }
+    else if (hand_eq(js, key, "metrics_period"))
+    {
+      r = hand_int(js, val, 5, 3600, &v);
+      obj->metrics_period = (uint16_t)v;
+    }
+    else if (hand_eq(js, key, "bench"))
+    {
+      r = hand_bool(js, val, &obj->bench);
+    }
+    else
+    {
+      continue;
+    }
+    if (r != 0)
+    {
+      return -1;
+    }
+    count++;
+  }
+  return count;
+}
+
+static int hand_config_decode(bench_config_t *obj, const char *js,
+                              const jsmntok_t *tokens, int num_tokens)
+{
+  const jsmntok_t *key;
+  const jsmntok_t *val;
+  long long v;
+  int count = 0;
+  int i;
+  int r;
+
+  if (num_tokens < 1 || tokens[0].type != JSMN_OBJECT)
+  {
+    return -1;
+  }
+  for (i = 1; i + 1 < num_tokens; i += 2)
+  {
+    key = &tokens[i];
+    val = &tokens[i + 1];
+    if (hand_eq(js, key, "wifi_ssid"))
+    {
+      r = hand_str(js, val, obj->wifi_ssid, sizeof(obj->wifi_ssid));
+    }
+    else if (hand_eq(js, key, "wifi_pass"))
+    {
+      r = hand_str(js, val, obj->wifi_pass, sizeof(obj->wifi_pass));
+    }
+    else if (hand_eq(js, key, "mqtt_host"))
+    {
+      r = hand_str(js, val, obj->mqtt_host, sizeof(obj->mqtt_host));
+    }
+    else if (hand_eq(js, key, "mqtt_port"))
+    {
+      r = hand_int(js, val, 1, UINT16_MAX, &v);
+      obj->mqtt_port = (uint16_t)v;
+    }
+    else if (hand_eq(js, key, "mqtt_keepalive"))
+    {
+      r = hand_int(js, val, 10, 3600, &v);
+      obj->mqtt_keepalive = (uint16_t)v;
+    }
+    else if (hand_eq(js, key, "led"))
+    {
+      r = hand_bool(js, val, &obj->led);
+    }
+    else if (hand_eq(js, key, "bench"))
+    {
+      r = hand_bool(js, val, &obj->bench);
+    }
+    else if (hand_eq(js, key, "metrics_period"))
+    {
+      r = hand_int(js, val, 5, 3600, &v);
+      obj->metrics_period = (uint16_t)v;
+    }
+    else if (hand_eq(js, key, "tz_offset"))
+    {
+      r = hand_int(js, val, -720, 840, &v);
+      obj->tz_offset = (int16_t)v;
+    }
+    else if (hand_eq(js, key, "sensor_pin"))
+    {
+      r = hand_int(js, val, 0, 16, &v);
+      obj->sensor_pin = (uint8_t)v;
+    }
+    else if (hand_eq(js, key, "sensor_period"))
+    {
+      r = hand_int(js, val, 0, UINT32_MAX, &v);
+      obj->sensor_period = (uint32_t)v;
+    }
+    else if (hand_eq(js, key, "threshold_lo"))
+    {
+      r = hand_int(js, val, INT32_MIN, INT32_MAX, &v);
+      obj->threshold_lo = (int32_t)v;
+    }
+    else if (hand_eq(js, key, "threshold_hi"))
+    {
+      r = hand_int(js, val, INT32_MIN, INT32_MAX, &v);
+      obj->threshold_hi = (int32_t)v;
+    }
+    else if (hand_eq(js, key, "relay_invert"))
+    {
+      r = hand_bool(js, val, &obj->relay_invert);
+    }
+    else if (hand_eq(js, key, "ota_check"))
+    {
+      r = hand_bool(js, val, &obj->ota_check);
+    }
+    else if (hand_eq(js, key, "log_level"))
+    {
+      r = hand_int(js, val, 0, 5, &v);
+      obj->log_level = (uint8_t)v;
+    }
+    else
+    {
+      continue;
+    }
+    if (r != 0)
+    {
+      return -1;
+    }
+    count++;
+  }
+  return count;
+}
+
+/* Strings are written as they are, the hand written encoders do not escape */
+static int hand_settings_encode(const app_settings_t *obj, char *buf,
+                                size_t len)
+{
+  return snprintf(buf, len, "{\"led\":%s,\"metrics_period\":%u,"
+                  "\"bench\":%s}", obj->led ? "true" : "false",
+                  obj->metrics_period, obj->bench ? "true" : "false");
+}
+
+static int hand_config_encode(const bench_config_t *obj, char *buf,
+                              size_t len)
+{
+  return snprintf(buf, len, "{\"wifi_ssid\":\"%s\",\"wifi_pass\":\"%s\","
+                  "\"mqtt_host\":\"%s\",\"mqtt_port\":%u,"
+                  "\"mqtt_keepalive\":%u,\"led\":%s,\"bench\":%s,"
+                  "\"metrics_period\":%u,\"tz_offset\":%d,\"sensor_pin\":%u,"
+                  "\"sensor_period\":%" PRIu32 ",\"threshold_lo\":%" PRId32
+                  ",\"threshold_hi\":%" PRId32 ",\"relay_invert\":%s,"
+                  "\"ota_check\":%s,\"log_level\":%u}", obj->wifi_ssid,
+                  obj->wifi_pass, obj->mqtt_host, obj->mqtt_port,
+                  obj->mqtt_keepalive, obj->led ? "true" : "false",
+                  obj->bench ? "true" : "false", obj->metrics_period,
+                  obj->tz_offset, obj->sensor_pin, obj->sensor_period,
+                  obj->threshold_lo, obj->threshold_hi,
+                  obj->relay_invert ? "true" : "false",
+                  obj->ota_check ? "true" : "false", obj->log_level);
+}
+
+/* Checks */
+
+static void bind_check_settings(void)
+{
+  const bind_doc_t *doc = &bind_settings_doc;
+  app_settings_t bind;
+  app_settings_t hand;
+  app_settings_t back;
+  char hand_out[BIND_JSON_MAX];
+  bind_doc_t out = { bind_out };
+  int ret;
+
+  memset(&bind, 0, sizeof(bind));
+  memset(&hand, 0, sizeof(hand));
+  ret = app_settings_decode(&bind, doc->js, doc->tokens, doc->num_tokens,
+                            NULL);
+  if (ret != 3 || ret != hand_settings_decode(&hand, doc->js, doc->tokens,
+                                              doc->num_tokens)
+      || memcmp(&bind, &hand, sizeof(bind)) != 0)
+  {
+    bind_fail("app_settings: the decoders disagree");
+  }
+
+  if (app_settings_encode(&bind, bind_out, APP_SETTINGS_JSON_MAX) == 0
+      || hand_settings_encode(&bind, hand_out, sizeof(hand_out)) < 0
+      || strcmp(bind_out, hand_out) != 0)
+  {
+    bind_fail("app_settings: the encoders disagree");
+  }
+  bind_parse(&out);
+  memset(&back, 0, sizeof(back));
+  if (app_settings_decode(&back, out.js, out.tokens, out.num_tokens,
+                          NULL) != 3
+      || memcmp(&bind, &back, sizeof(bind)) != 0)
+  {
+    bind_fail("app_settings: encoded text decodes differently");
+  }
+}
+
+static void bind_check_config(void)
+{
+  const bind_doc_t *doc = &bind_config_doc;
+  bench_config_t bind;
+  bench_config_t hand;
+  bench_config_t back;
+  char hand_out[BIND_JSON_MAX];
+  bind_doc_t out = { bind_out };
+  bind_doc_t bad;
+  jsmn_parser parser;
+  size_t i;
+  int ret;
+
+  memset(&bind, 0, sizeof(bind));
+  memset(&hand, 0, sizeof(hand));
+  ret = bench_config_decode(&bind, doc->js, doc->tokens, doc->num_tokens,
+                            NULL);
+  if (ret != 16 || ret != hand_config_decode(&hand, doc->js, doc->tokens,
+                                             doc->num_tokens)
+      || memcmp(&bind, &hand, sizeof(bind)) != 0)
+  {
+    bind_fail("bench_config: the decoders disagree");
+  }
+
+  if (bench_config_encode(&bind, bind_out, BENCH_CONFIG_JSON_MAX) == 0
+      || hand_config_encode(&bind, hand_out, sizeof(hand_out)) < 0
+      || strcmp(bind_out, hand_out) != 0)
+  {
+    bind_fail("bench_config: the encoders disagree");
+  }
+  bind_parse(&out);
+  memset(&back, 0, sizeof(back));
+  if (bench_config_decode(&back, out.js, out.tokens, out.num_tokens,
+                          NULL) != 16
+      || memcmp(&bind, &back, sizeof(bind)) != 0)
+  {
+    bind_fail("bench_config: encoded text decodes differently");
+  }
+
+  for (i = 0; i < sizeof(bind_config_bad) / sizeof(bind_config_bad[0]); i++)
+  {
+    bad.js = bind_config_bad[i];
+    jsmn_init(&parser);
+    bad.num_tokens = jsmn_parse(&parser, bad.js, strlen(bad.js), bad.tokens,
+                                BIND_TOKENS);
+    if (bench_config_decode(&back, bad.js, bad.tokens, bad.num_tokens,
+                            NULL) >= 0
+        || hand_config_decode(&back, bad.js, bad.tokens,
+                              bad.num_tokens) >= 0)
+    {
+      printf("jsonbench: %s\n", bad.js);
+      bind_fail("bench_config: bad document accepted");
+    }
+  }
+}
+
+/* Timing */
+
+static uint64_t bind_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Objects per second of BIND_LOOPS calls of 'run', the fastest round */
+static void bind_time(const char *name, void (*run)(void))
+{
+  uint64_t best = UINT64_MAX;
+  uint64_t start;
+  uint64_t ns;
+  int round;
+  int i;
+
+  /* the first round warms the cache up */
+  for (round = 0; round <= BIND_ROUNDS; round++)
+  {
+    start = bind_now();
+    for (i = 0; i < BIND_LOOPS; i++)
+    {
+      run();
+      BIND_BARRIER();
+    }
+    ns = bind_now() - start;
+    if (round > 0 && ns < best)
+    {
+      best = ns;
+    }
+  }
+  printf("  %-30s %7.2f M/s\n", name, BIND_LOOPS * 1000.0 / best);
+}
+
+static void bind_run_settings_decode(void)
+{
+  app_settings_decode(&bind_settings, bind_settings_doc.js,
+                      bind_settings_doc.tokens, bind_settings_doc.num_tokens,
+                      NULL);
+}
+
+static void hand_run_settings_decode(void)
+{
+  hand_settings_decode(&bind_settings, bind_settings_doc.js,
+                       bind_settings_doc.tokens, bind_settings_doc.num_tokens);
+}
+
+static void bind_run_settings_encode(void)
+{
+  app_settings_encode(&bind_settings, bind_out, sizeof(bind_out));
+}
+
+static void hand_run_settings_encode(void)
+{
+  hand_settings_encode(&bind_settings, bind_out, sizeof(bind_out));
+}
+
+static void bind_run_config_decode(void)
+{
+  bench_config_decode(&bind_config, bind_config_doc.js,
+                      bind_config_doc.tokens, bind_config_doc.num_tokens,
+                      NULL);
+}
+
+static void hand_run_config_decode(void)
+{
+  hand_config_decode(&bind_config, bind_config_doc.js,
+                     bind_config_doc.tokens, bind_config_doc.num_tokens);
+}
+
+static void bind_run_config_encode(void)
+{
+  bench_config_encode(&bind_config, bind_out, sizeof(bind_out));
+}
+
+static void hand_run_config_encode(void)
+{
+  hand_config_encode(&bind_config, bind_out, sizeof(bind_out));
+}
+
+int main(void)
+{
+  bind_parse(&bind_settings_doc);
+  bind_parse(&bind_config_doc);
+  bind_check_settings();
+  bind_check_config();
+  printf("  %-30s %7lu failed\n", "decoders and encoders agree",
+         bind_failures);
+  if (bind_failures != 0)
+  {
+    return 1;
+  }
+
+  printf("  app_settings, 3 fields, %d tokens\n", bind_settings_doc.num_tokens);
+  bind_time("decode jsmn_bind", bind_run_settings_decode);
+  bind_time("decode strncmp chain", hand_run_settings_decode);
+  bind_time("encode jsmn_bind", bind_run_settings_encode);
+  bind_time("encode snprintf", hand_run_settings_encode);
+  printf("  bench_config, 16 fields, %d tokens\n", bind_config_doc.num_tokens);
+  bind_time("decode jsmn_bind", bind_run_config_decode);
+  bind_time("decode strncmp chain", hand_run_config_decode);
+  bind_time("encode jsmn_bind", bind_run_config_encode);
+  bind_time("encode snprintf", hand_run_config_encode);
+  return 0;
+}
+
+#endif /* JSMN_HOST */
@@ -0,0 +1,466 @@
+#include "jsmn_stream.h"
+
+/* What the next byte may be */
+enum
+{
+  JS_VALUE,           /* a value */
+  JS_VALUE_OR_CLOSE,  /* a value or ']', after '[' */
+  JS_KEY,             /* a key, after ',' in an object */
+  JS_KEY_OR_CLOSE,    /* a key or '}', after '{' */
+  JS_COLON,
+  JS_NEXT,            /* ',' or the end of the object or array */
+  JS_STRING,
+  JS_ESCAPE,
+  JS_UNICODE,
+  JS_PRIMITIVE,
+  JS_DONE             /* only whitespace may follow the document */
+};
+
+static int jsmn_stream_emit(jsmn_stream_parser *parser, jsmntype_t type,
+                            uint8_t flags, const char *value, size_t len)
+{
+  jsmn_stream_event_t ev;
+
+  parser->path[parser->path_len] = '\0';
+  ev.type = type;
+  ev.flags = flags;
+  ev.depth = parser->depth;
+  ev.path_len = parser->path_len;
+  ev.path = parser->path;
+  ev.value = value;
+  ev.len = len;
+  return parser->cb(parser->arg, &ev);
+}
+
+/**
+ * Report the string or primitive read so far, then start over.
+ */
+static int jsmn_stream_flush(jsmn_stream_parser *parser, jsmntype_t type,
+                             uint8_t flags)
+{
+  int r;
+
+  parser->value[parser->value_len] = '\0';
+  r = jsmn_stream_emit(parser, type, flags, parser->value, parser->value_len);
+  parser->value_len = 0;
+  return r;
+}
+
+/**
+ * Append a decoded character to the key (path) or to the value.
+ */
+static int jsmn_stream_put(jsmn_stream_parser *parser, char c)
+{
+  int r;
+
+  if (parser->in_key)
+  {
+    if (parser->path_len >= JSMN_STREAM_PATH_LEN - 1)
+    {
+      return JSMN_ERROR_NOMEM;
+    }
+    parser->path[parser->path_len++] = c;
+    return 0;
+  }
+  if (parser->value_len == JSMN_STREAM_VALUE_LEN)
+  {
+    if (parser->state == JS_PRIMITIVE)
+    {
+      return JSMN_ERROR_INVAL;
+    }
+    r = jsmn_stream_flush(parser, JSMN_STRING, JSMN_STREAM_PARTIAL);
+    if (r != 0)
+    {
+      return r;
+    }
+  }
+  parser->value[parser->value_len++] = c;
+  return 0;
+}
+
+/**
+ * Append the path of the element about to be read in an array.
+ */
+static int jsmn_stream_index(jsmn_stream_parser *parser)
+{
+  jsmn_stream_level_t *level = &parser->levels[parser->depth - 1];
+  char digits[5];
+  int n = 0;
+  unsigned int index = level->index;
+
+  parser->path_len = level->path_len;
+  do
+  {
+    digits[n++] = '0' + index % 10;
+    index /= 10;
+  } while (index != 0);
+  if (parser->path_len + n + 2 >= JSMN_STREAM_PATH_LEN)
+  {
+    return JSMN_ERROR_NOMEM;
+  }
+  parser->path[parser->path_len++] = '[';
+  while (n > 0)
+  {
+    parser->path[parser->path_len++] = digits[--n];
+  }
+  parser->path[parser->path_len++] = ']';
+  return 0;
+}
+
+static int jsmn_stream_open(jsmn_stream_parser *parser, jsmntype_t type)
+{
+  jsmn_stream_level_t *level;
+  int r;
+
+  if (parser->depth == JSMN_STREAM_DEPTH)
+  {
+    return JSMN_ERROR_NOMEM;
+  }
+  r = jsmn_stream_emit(parser, type, 0, NULL, 0);
+  if (r != 0)
+  {
+    return r;
+  }
+  level = &parser->levels[parser->depth++];
+  level->type = type;
+  level->path_len = parser->path_len;
+  level->index = 0;
+  parser->state = (type == JSMN_OBJECT) ? JS_KEY_OR_CLOSE : JS_VALUE_OR_CLOSE;
+  return 0;
+}
+
+/**
+ * A value was read, what comes next depends on its parent.
+ */
+static void jsmn_stream_value_done(jsmn_stream_parser *parser)
+{
+  parser->state = (parser->depth == 0) ? JS_DONE : JS_NEXT;
+}
+
+static int jsmn_stream_close(jsmn_stream_parser *parser, jsmntype_t type)
+{
+  jsmn_stream_level_t *level;
+
+  if (parser->depth == 0 || parser->levels[parser->depth - 1].type != type)
+  {
+    return JSMN_ERROR_INVAL;
+  }
+  level = &parser->levels[--parser->depth];
+  parser->path_len = level->path_len;
+  jsmn_stream_value_done(parser);
+  return jsmn_stream_emit(parser, type, JSMN_STREAM_END, NULL, 0);
+}
+
+/**
+ * First byte of a value.
+ */
+static int jsmn_stream_start_value(jsmn_stream_parser *parser, char c)
+{
+  int r;
+
+  if (parser->depth > 0
+      && parser->levels[parser->depth - 1].type == JSMN_ARRAY)
+  {
+    r = jsmn_stream_index(parser);
+    if (r != 0)
+    {
+      return r;
+    }
+  }
+  switch (c)
+  {
+    case '{':
+      return jsmn_stream_open(parser, JSMN_OBJECT);
+    case '[':
+      return jsmn_stream_open(parser, JSMN_ARRAY);
+    case '\"':
+      parser->in_key = 0;
+      parser->value_len = 0;
+      parser->state = JS_STRING;
+      return 0;
+    case ',':
+    case ':':
+    case ']':
+    case '}':
+      return JSMN_ERROR_INVAL;
+  }
+#ifdef JSMN_STRICT
+  if (!((c >= '0' && c <= '9') || c == '-' || c == 't' || c == 'f'
+      || c == 'n'))
+  {
+    return JSMN_ERROR_INVAL;
+  }
+#endif
+  parser->value_len = 0;
+  parser->state = JS_PRIMITIVE;
+  return jsmn_stream_put(parser, c);
+}
+
+/**
+ * First byte of a key, the path gets the key in place of the previous one.
+ */
+static int jsmn_stream_start_key(jsmn_stream_parser *parser)
+{
+  parser->path_len = parser->levels[parser->depth - 1].path_len;
+  if (parser->path_len > 0)
+  {
+    if (parser->path_len >= JSMN_STREAM_PATH_LEN - 1)
+    {
+      return JSMN_ERROR_NOMEM;
+    }
+    parser->path[parser->path_len++] = '.';
+  }
+  parser->in_key = 1;
+  parser->state = JS_STRING;
+  return 0;
+}
+
+/**
+ * Append code point 'code' in UTF-8.
+ */
+static int jsmn_stream_put_code(jsmn_stream_parser *parser, uint16_t code)
+{
+  int r;
+
+  if (code < 0x80)
+  {
+    return jsmn_stream_put(parser, (char)code);
+  }
+  if (code < 0x800)
+  {
+    r = jsmn_stream_put(parser, (char)(0xC0 | (code >> 6)));
+  }
+  else
+  {
+    r = jsmn_stream_put(parser, (char)(0xE0 | (code >> 12)));
+    if (r == 0)
+    {
+      r = jsmn_stream_put(parser, (char)(0x80 | ((code >> 6) & 0x3F)));
+    }
+  }
+  if (r == 0)
+  {
+    r = jsmn_stream_put(parser, (char)(0x80 | (code & 0x3F)));
+  }
+  return r;
+}
+
+static int jsmn_stream_byte(jsmn_stream_parser *parser, char c)
+{
+  int is_space = (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+  int r;
+
+  switch (parser->state)
+  {
+    case JS_STRING:
+      if (c == '\"')
+      {
+        if (parser->in_key)
+        {
+          parser->in_key = 0;
+          parser->state = JS_COLON;
+          return 0;
+        }
+        jsmn_stream_value_done(parser);
+        return jsmn_stream_flush(parser, JSMN_STRING, 0);
+      }
+      if (c == '\\')
+      {
+        parser->state = JS_ESCAPE;
+        return 0;
+      }
+      if ((unsigned char)c < 32)
+      {
+        return JSMN_ERROR_INVAL;
+      }
+      return jsmn_stream_put(parser, c);
+
+    case JS_ESCAPE:
+      parser->state = JS_STRING;
+      switch (c)
+      {
+        case '\"':
+        case '/':
+        case '\\':
+          return jsmn_stream_put(parser, c);
+        case 'b':
+          return jsmn_stream_put(parser, '\b');
+        case 'f':
+          return jsmn_stream_put(parser, '\f');
+        case 'r':
+          return jsmn_stream_put(parser, '\r');
+        case 'n':
+          return jsmn_stream_put(parser, '\n');
+        case 't':
+          return jsmn_stream_put(parser, '\t');
+        case 'u':
+          parser->state = JS_UNICODE;
+          parser->hex_left = 4;
+          parser->code = 0;
+          return 0;
+      }
+      return JSMN_ERROR_INVAL;
+
+    case JS_UNICODE:
+      if (c >= '0' && c <= '9')
+      {
+        parser->code = (parser->code << 4) | (c - '0');
+      }
+      else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+      {
+        parser->code = (parser->code << 4) | ((c | 0x20) - 'a' + 10);
+      }
+      else
+      {
+        return JSMN_ERROR_INVAL;
+      }
+      if (--parser->hex_left == 0)
+      {
+        parser->state = JS_STRING;
+        return jsmn_stream_put_code(parser, parser->code);
+      }
+      return 0;
+
+    case JS_PRIMITIVE:
+      if (!is_space && c != ',' && c != ']' && c != '}'
+#ifndef JSMN_STRICT
+          && c != ':'
+#endif
+          )
+      {
+        if ((unsigned char)c < 32 || (unsigned char)c >= 127)
+        {
+          return JSMN_ERROR_INVAL;
+        }
+        return jsmn_stream_put(parser, c);
+      }
+      jsmn_stream_value_done(parser);
+      r = jsmn_stream_flush(parser, JSMN_PRIMITIVE, 0);
+      if (r != 0 || is_space)
+      {
+        return r;
+      }
+      /* the delimiter belongs to the parent */
+      return jsmn_stream_byte(parser, c);
+
+    default:
+      break;
+  }
+
+  if (is_space)
+  {
+    return 0;
+  }
+
+  switch (parser->state)
+  {
+    case JS_VALUE_OR_CLOSE:
+      if (c == ']')
+      {
+        return jsmn_stream_close(parser, JSMN_ARRAY);
+      }
+      /* no break */
+    case JS_VALUE:
+      return jsmn_stream_start_value(parser, c);
+
+    case JS_KEY_OR_CLOSE:
+      if (c == '}')
+      {
+        return jsmn_stream_close(parser, JSMN_OBJECT);
+      }
+      /* no break */
+    case JS_KEY:
+      if (c != '\"')
+      {
+        return JSMN_ERROR_INVAL;
+      }
+      return jsmn_stream_start_key(parser);
+
+    case JS_COLON:
+      if (c != ':')
+      {
+        return JSMN_ERROR_INVAL;
+      }
+      parser->state = JS_VALUE;
+      return 0;
+
+    case JS_NEXT:
+      if (c == ',')
+      {
+        jsmn_stream_level_t *level = &parser->levels[parser->depth - 1];
+        if (level->type == JSMN_ARRAY)
+        {
+          level->index++;
+          parser->state = JS_VALUE;
+        }
+        else
+        {
+          parser->state = JS_KEY;
+        }
+        return 0;
+      }
+      if (c == ']')
+      {
+        return jsmn_stream_close(parser, JSMN_ARRAY);
+      }
+      if (c == '}')
+      {
+        return jsmn_stream_close(parser, JSMN_OBJECT);
+      }
+      return JSMN_ERROR_INVAL;
+
+    default:
+      /* JS_DONE */
+      return JSMN_ERROR_INVAL;
+  }
+}
+
+void jsmn_stream_init(jsmn_stream_parser *parser, jsmn_stream_cb_t cb,
+                      void *arg)
+{
+  parser->cb = cb;
+  parser->arg = arg;
+  parser->pos = 0;
+  parser->state = JS_VALUE;
+  parser->depth = 0;
+  parser->path_len = 0;
+  parser->in_key = 0;
+  parser->value_len = 0;
+  parser->error = 0;
+}
+
+int jsmn_stream_feed(jsmn_stream_parser *parser, const char *js, size_t len)
+{
+  size_t i;
+
+  if (parser->error != 0)
+  {
+    return parser->error;
+  }
+  for (i = 0; i < len; i++)
+  {
+    parser->error = jsmn_stream_byte(parser, js[i]);
+    if (parser->error != 0)
+    {
+      return parser->error;
+    }
+    parser->pos++;
+  }
+  return 0;
+}
+
+int jsmn_stream_finish(jsmn_stream_parser *parser)
+{
+  if (parser->error != 0)
+  {
+    return parser->error;
+  }
+  if (parser->state == JS_PRIMITIVE && parser->depth == 0)
+  {
+    /* a bare primitive ends with the document */
+    parser->state = JS_DONE;
+    parser->error = jsmn_stream_flush(parser, JSMN_PRIMITIVE, 0);
+    return parser->error;
+  }
+  return (parser->state == JS_DONE) ? 0 : JSMN_ERROR_PART;
+}
@@ -0,0 +1,680 @@
+/*
+ * jsmn_stream fuzz test and benchmark, a host program ("make jsmnstream")
+ *
+ * "fuzz n" generates n random documents, each with the events
+ * jsmn_stream must report for it: nested objects and arrays, whitespace,
+ * primitives, strings with every escape, \uXXXX and bytes above 0x7F, and
+ * strings long enough to come in several pieces. Each document is parsed
+ * whole and in random chunks, some of them empty or one byte long, and both
+ * must give the expected events. The document is then mutated (bytes
+ * flipped, inserted, deleted, truncated) and the parser, stopped by its
+ * callback now and then, must fail or succeed in the same way, at the same
+ * offset and with the same events, however the input is cut. The Makefile
+ * builds this mode with the address and undefined behaviour sanitizers.
+ *
+ * "bench" parses a configuration document of about 16 KB with
+ * jsmn_parse() from one buffer, and with jsmn_stream in TCP_MSS chunks as
+ * the pbufs of a POST body come, and prints MB/s and the memory each needs:
+ * the document and its tokens for jsmn_parse(), the parser alone for
+ * jsmn_stream, which also unescapes the strings and builds the paths.
+ */
+#if defined(JSMN_HOST)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "jsmn.h"
+#include "jsmn_stream.h"
+
+/* Generated documents */
+#define GEN_DOC_LEN     8192
+#define GEN_DEPTH       6
+#define GEN_MEMBERS     5
+/* Paths are kept this short so that a valid document never overflows one */
+#define GEN_PATH_MAX    40
+#define GEN_KEY_MAX     6
+/* Expected or reported events, and the bytes of strings in pieces */
+#define LOG_LEN         (16 * GEN_DOC_LEN)
+/* Random documents, unless given on the command line */
+#define FUZZ_CASES      20000
+
+/* TCP_MSS of lwip_opts.h, the chunks of the benchmark */
+#define BENCH_CHUNK     1460
+#define BENCH_DOC_LEN   (16 * 1024)
+#define BENCH_ROUNDS    64
+
+typedef struct
+{
+    char doc[GEN_DOC_LEN + 64];
+    size_t len;
+    char log[LOG_LEN];
+    size_t log_len;
+    char path[JSMN_STREAM_PATH_LEN];
+    size_t path_len;
+    int depth;
+} gen_t;
+
+/* Events reported by the parser, in the format of gen_t.log */
+typedef struct
+{
+    char log[LOG_LEN];
+    size_t log_len;
+    char piece[GEN_DOC_LEN];
+    size_t piece_len;
+    unsigned int events;
+    unsigned int stop_after;
+    /* an event did not fit, or broke the rules of jsmn_stream.h */
+    int broken;
+} sink_t;
+
+static gen_t gen;
+static sink_t sink_whole;
+static sink_t sink_chunked;
+static char mutated[GEN_DOC_LEN * 2];
+static uint32_t fuzz_rng = 0x9E3779B9;
+static unsigned long fuzz_failures;
+
+/* xorshift32, the same documents on every run */
+static uint32_t fuzz_rand(void)
+{
+  fuzz_rng ^= fuzz_rng << 13;
+  fuzz_rng ^= fuzz_rng >> 17;
+  fuzz_rng ^= fuzz_rng << 5;
+  return fuzz_rng;
+}
+
+static int log_put(char *log, size_t *log_len, const void *data, size_t len)
+{
+  if (*log_len + len > LOG_LEN)
+  {
+    return -1;
+  }
+  if (len == 0)
+  {
+    return 0;
+  }
+  memcpy(log + *log_len, data, len);
+  *log_len += len;
+  return 0;
+}
+
+/* One event: type, flags, depth, path and value with their lengths */
+static int log_event(char *log, size_t *log_len, int type, int flags,
+                     int depth, const char *path, size_t path_len,
+                     const char *value, size_t len)
+{
+  unsigned char head[6];
+
+  head[0] = (unsigned char)type;
+  head[1] = (unsigned char)flags;
+  head[2] = (unsigned char)depth;
+  head[3] = (unsigned char)path_len;
+  head[4] = (unsigned char)(len >> 8);
+  head[5] = (unsigned char)len;
+  if (log_put(log, log_len, head, sizeof(head)) != 0
+      || log_put(log, log_len, path, path_len) != 0
+      || log_put(log, log_len, value, len) != 0)
+  {
+    return -1;
+  }
+  return 0;
+}
+
+static void gen_char(char c)
+{
+  if (gen.len < sizeof(gen.doc))
+  {
+    gen.doc[gen.len++] = c;
+  }
+}
+
+static void gen_text(const char *s)
+{
+  while (*s != '\0')
+  {
+    gen_char(*s++);
+  }
+}
+
+static void gen_space(void)
+{
+  static const char spaces[] = " \t\r\n";
+
+  while (fuzz_rand() % 4 == 0)
+  {
+    gen_char(spaces[fuzz_rand() % 4]);
+  }
+}
+
+/* UTF-8 of a \uXXXX code, as jsmn_stream_put_code() writes it */
+static size_t gen_utf8(char *out, uint16_t code)
+{
+  if (code < 0x80)
+  {
+    out[0] = (char)code;
+    return 1;
+  }
+  if (code < 0x800)
+  {
+    out[0] = (char)(0xC0 | (code >> 6));
+    out[1] = (char)(0x80 | (code & 0x3F));
+    return 2;
+  }
+  out[0] = (char)(0xE0 | (code >> 12));
+  out[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+  out[2] = (char)(0x80 | (code & 0x3F));
+  return 3;
+}
+
+/* A quoted string in the document, its value in 'out', 'max' bytes of value
+ at most. Returns the length of the value. */
+static size_t gen_string(char *out, size_t max)
+{
+  static const char escapes[] = "\"\\/bfnrt";
+  static const char values[] = "\"\\/\b\f\n\r\t";
+  size_t len = 0;
+  size_t want;
+  char hex[8];
+  char utf8[3];
+  uint16_t code;
+  int i;
+
+  want = (fuzz_rand() % 8 == 0) ? fuzz_rand() % (3 * JSMN_STREAM_VALUE_LEN)
+      : fuzz_rand() % 12;
+  if (want > max)
+  {
+    want = max;
+  }
+  gen_char('\"');
+  while (len < want)
+  {
+    switch (fuzz_rand() % 8)
+    {
+      case 0:
+        i = fuzz_rand() % 8;
+        gen_char('\\');
+        gen_char(escapes[i]);
+        out[len++] = values[i];
+        break;
+      case 1:
+        /* not \u0000, which would end the path */
+        code = 1 + fuzz_rand() % 0xFFFF;
+        if (len + gen_utf8(utf8, code) > want)
+        {
+          break;
+        }
+        snprintf(hex, sizeof(hex), (fuzz_rand() & 1) ? "\\u%04x" : "\\u%04X",
+                 code);
+        gen_text(hex);
+        len += gen_utf8(out + len, code);
+        break;
+      case 2:
+        out[len] = (char)(0x80 | fuzz_rand() % 0x80);
+        gen_char(out[len++]);
+        break;
+      default:
+        /* printable ASCII but the quote and the backslash */
+        do
+        {
+          out[len] = (char)(' ' + fuzz_rand() % 95);
+        } while (out[len] == '\"' || out[len] == '\\');
+        gen_char(out[len++]);
+        break;
+    }
+  }
+  gen_char('\"');
+  return len;
+}
+
+static void gen_expect(int type, int flags, const char *value, size_t len)
+{
+  if (log_event(gen.log, &gen.log_len, type, flags, gen.depth, gen.path,
+                gen.path_len, value, len) != 0)
+  {
+    fprintf(stderr, "jsmnstream: expected events overflow\n");
+    exit(2);
+  }
+}
+
+static void gen_value(void)
+{
+  static const char *const primitives[] =
+  {
+    "true", "false", "null", "0", "-1", "42", "3.25", "-0.5e-3", "1E+9",
+    "4294967295"
+  };
+  char value[3 * JSMN_STREAM_VALUE_LEN];
+  size_t len;
+  size_t saved;
+  int type = fuzz_rand() % 4;
+  int members;
+  int i;
+
+  if (gen.depth == GEN_DEPTH || gen.len > GEN_DOC_LEN / 2)
+  {
+    type = 2 + (type & 1);
+  }
+  if (type == 0 || type == 1)
+  {
+    gen_expect(type == 0 ? JSMN_OBJECT : JSMN_ARRAY, 0, NULL, 0);
+    gen_char(type == 0 ? '{' : '[');
+    gen.depth++;
+    saved = gen.path_len;
+    members = (gen.path_len > GEN_PATH_MAX) ? 0 : fuzz_rand() % GEN_MEMBERS;
+    for (i = 0; i < members; i++)
+    {
+      gen_space();
+      if (i > 0)
+      {
+        gen_char(',');
+        gen_space();
+      }
+      if (type == 0)
+      {
+        if (saved > 0)
+        {
+          gen.path[gen.path_len++] = '.';
+        }
+        gen.path_len += gen_string(gen.path + gen.path_len, GEN_KEY_MAX);
+        gen_space();
+        gen_char(':');
+        gen_space();
+      }
+      else
+      {
+        gen.path_len += sprintf(gen.path + gen.path_len, "[%d]", i);
+      }
+      gen_value();
+      gen.path_len = saved;
+    }
+    gen_space();
+    gen_char(type == 0 ? '}' : ']');
+    gen.depth--;
+    gen_expect(type == 0 ? JSMN_OBJECT : JSMN_ARRAY, JSMN_STREAM_END, NULL,
+               0);
+  }
+  else if (type == 2)
+  {
+    len = gen_string(value, sizeof(value));
+    gen_expect(JSMN_STRING, 0, value, len);
+  }
+  else
+  {
+    saved = gen.len;
+    gen_text(primitives[fuzz_rand() % 10]);
+    gen_expect(JSMN_PRIMITIVE, 0, gen.doc + saved, gen.len - saved);
+  }
+}
+
+static void gen_document(void)
+{
+  gen.len = 0;
+  gen.log_len = 0;
+  gen.path_len = 0;
+  gen.depth = 0;
+  gen_space();
+  gen_value();
+  /* a bare primitive runs to the end of the document */
+  gen_space();
+}
+
+static int sink_cb(void *arg, const jsmn_stream_event_t *ev)
+{
+  sink_t *sink = arg;
+
+  if (++sink->events == sink->stop_after)
+  {
+    return 7;
+  }
+  if (ev->path[ev->path_len] != '\0' || ev->len > JSMN_STREAM_VALUE_LEN
+      || (ev->value != NULL && ev->value[ev->len] != '\0')
+      || (ev->value == NULL && ev->len != 0))
+  {
+    sink->broken = 1;
+  }
+  if (ev->flags & JSMN_STREAM_PARTIAL)
+  {
+    if (sink->piece_len + ev->len > sizeof(sink->piece))
+    {
+      sink->broken = 1;
+      return 0;
+    }
+    memcpy(sink->piece + sink->piece_len, ev->value, ev->len);
+    sink->piece_len += ev->len;
+    return 0;
+  }
+  if (ev->value != NULL && sink->piece_len > 0)
+  {
+    if (sink->piece_len + ev->len > sizeof(sink->piece))
+    {
+      sink->broken = 1;
+      return 0;
+    }
+    memcpy(sink->piece + sink->piece_len, ev->value, ev->len);
+    sink->piece_len += ev->len;
+    sink->broken |= log_event(sink->log, &sink->log_len, ev->type,
+                                ev->flags, ev->depth, ev->path, ev->path_len,
+                                sink->piece, sink->piece_len) != 0;
+    sink->piece_len = 0;
+    return 0;
+  }
+  sink->broken |= log_event(sink->log, &sink->log_len, ev->type, ev->flags,
+                              ev->depth, ev->path, ev->path_len, ev->value,
+                              ev->len) != 0;
+  return 0;
+}
+
+/* Parse 'doc' in chunks of 'chunk' bytes at most, 0 for random sizes */
+static int parse(sink_t *sink, const char *doc, size_t len, size_t chunk,
+                 unsigned int stop_after, unsigned int *pos)
+{
+  jsmn_stream_parser parser;
+  size_t off = 0;
+  size_t n;
+  int r = 0;
+
+  sink->log_len = 0;
+  sink->piece_len = 0;
+  sink->events = 0;
+  sink->stop_after = stop_after;
+  sink->broken = 0;
+  jsmn_stream_init(&parser, sink_cb, sink);
+  while (off < len)
+  {
+    n = (chunk != 0) ? chunk : fuzz_rand() % 24;
+    if (n > len - off)
+    {
+      n = len - off;
+    }
+    r = jsmn_stream_feed(&parser, doc + off, n);
+    off += n;
+    if (r != 0)
+    {
+      /* failing again, whatever comes next */
+      if (jsmn_stream_feed(&parser, doc, len) != r)
+      {
+        r = 100;
+      }
+      break;
+    }
+  }
+  if (r == 0)
+  {
+    r = jsmn_stream_finish(&parser);
+  }
+  *pos = parser.pos;
+  return r;
+}
+
+static void fuzz_fail(unsigned long n, const char *what, const char *doc,
+                      size_t len)
+{
+  if (fuzz_failures++ < 10)
+  {
+    printf("jsmnstream: case %lu, %s: %.*s\n", n, what,
+           (int)(len < 200 ? len : 200), doc);
+  }
+}
+
+static size_t fuzz_mutate(void)
+{
+  static const char bytes[] = "{}[]\",:\\u0aZ -.eE\x7F\x01";
+  size_t len = gen.len;
+  size_t at;
+  int mutations = 1 + fuzz_rand() % 4;
+
+  memcpy(mutated, gen.doc, len);
+  while (mutations-- > 0 && len > 0)
+  {
+    at = fuzz_rand() % len;
+    switch (fuzz_rand() % 4)
+    {
+      case 0:
+        mutated[at] ^= (char)(1 << (fuzz_rand() % 8));
+        break;
+      case 1:
+        if (len < sizeof(mutated))
+        {
+          memmove(mutated + at + 1, mutated + at, len - at);
+          mutated[at] = bytes[fuzz_rand() % (sizeof(bytes) - 1)];
+          len++;
+        }
+        break;
+      case 2:
+        memmove(mutated + at, mutated + at + 1, len - at - 1);
+        len--;
+        break;
+      default:
+        len = at;
+        break;
+    }
+  }
+  return len;
+}
+
+/* Nesting and paths up to the limits of jsmn_stream.h and one past them */
+static void fuzz_limits(void)
+{
+  char doc[2 * JSMN_STREAM_PATH_LEN + 2 * JSMN_STREAM_DEPTH + 8];
+  unsigned int pos;
+  size_t len;
+  int depth;
+  int r;
+
+  for (depth = JSMN_STREAM_DEPTH; depth <= JSMN_STREAM_DEPTH + 1; depth++)
+  {
+    memset(doc, '[', depth);
+    doc[depth] = '1';
+    memset(doc + depth + 1, ']', depth);
+    r = parse(&sink_whole, doc, 2 * depth + 1, 1, 0, &pos);
+    if (r != ((depth > JSMN_STREAM_DEPTH) ? JSMN_ERROR_NOMEM : 0))
+    {
+      fuzz_fail(0, "nesting limit", doc, 2 * depth + 1);
+    }
+  }
+  for (len = JSMN_STREAM_PATH_LEN - 1; len <= JSMN_STREAM_PATH_LEN; len++)
+  {
+    doc[0] = '{';
+    doc[1] = '\"';
+    memset(doc + 2, 'k', len);
+    memcpy(doc + 2 + len, "\":1}", 4);
+    r = parse(&sink_whole, doc, len + 6, 3, 0, &pos);
+    if (r != ((len > JSMN_STREAM_PATH_LEN - 1) ? JSMN_ERROR_NOMEM : 0))
+    {
+      fuzz_fail(0, "path limit", doc, len + 6);
+    }
+  }
+}
+
+static int fuzz(unsigned long cases)
+{
+  unsigned long valid = 0;
+  unsigned long accepted = 0;
+  unsigned long n;
+  unsigned int pos_whole;
+  unsigned int pos_chunked;
+  unsigned int stop;
+  size_t len;
+  int r_whole;
+  int r_chunked;
+
+  for (n = 0; n < cases; n++)
+  {
+    gen_document();
+    if (gen.len > GEN_DOC_LEN)
+    {
+      continue;
+    }
+    valid++;
+
+    /* the expected events, whole and cut anywhere */
+    r_whole = parse(&sink_whole, gen.doc, gen.len, gen.len, 0, &pos_whole);
+    r_chunked = parse(&sink_chunked, gen.doc, gen.len, (n % 8 == 0) ? 1 : 0,
+                      0, &pos_chunked);
+    if (r_whole != 0 || r_chunked != 0 || sink_whole.broken
+        || sink_chunked.broken || pos_whole != gen.len)
+    {
+      fuzz_fail(n, "valid document rejected", gen.doc, gen.len);
+    }
+    else if (sink_whole.log_len != gen.log_len
+        || memcmp(sink_whole.log, gen.log, gen.log_len) != 0)
+    {
+      fuzz_fail(n, "events differ", gen.doc, gen.len);
+    }
+    else if (sink_chunked.log_len != gen.log_len
+        || memcmp(sink_chunked.log, gen.log, gen.log_len) != 0)
+    {
+      fuzz_fail(n, "events differ in chunks", gen.doc, gen.len);
+    }
+
+    /* a broken document, possibly stopped by the callback */
+    len = fuzz_mutate();
+    stop = (fuzz_rand() % 8 == 0) ? 1 + fuzz_rand() % 16 : 0;
+    r_whole = parse(&sink_whole, mutated, len, len, stop, &pos_whole);
+    r_chunked = parse(&sink_chunked, mutated, len, (n % 8 == 0) ? 1 : 0,
+                      stop, &pos_chunked);
+    accepted += (r_whole == 0);
+    if (sink_whole.broken || sink_chunked.broken)
+    {
+      fuzz_fail(n, "bad event", mutated, len);
+    }
+    else if (r_whole != r_chunked || pos_whole != pos_chunked
+        || pos_whole > len || (r_whole == 0 && pos_whole != len))
+    {
+      fuzz_fail(n, "result depends on the chunks", mutated, len);
+    }
+    else if (sink_whole.log_len != sink_chunked.log_len
+        || memcmp(sink_whole.log, sink_chunked.log, sink_whole.log_len) != 0)
+    {
+      fuzz_fail(n, "events depend on the chunks", mutated, len);
+    }
+  }
+  fuzz_limits();
+  printf("  %-24s %8lu, %lu failed\n", "documents", valid, fuzz_failures);
+  printf("  %-24s %8lu, %lu still valid\n", "mutated documents", valid,
+         accepted);
+  return (fuzz_failures == 0) ? 0 : 1;
+}
+
+static unsigned long bench_events;
+
+static int bench_cb(void *arg, const jsmn_stream_event_t *ev)
+{
+  (void)arg;
+  bench_events += 1 + ev->len;
+  return 0;
+}
+
+static uint64_t bench_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench_print(const char *name, size_t len, uint64_t ns,
+                        size_t ram)
+{
+  printf("  %-24s %6lu.%lu MB/s %8lu bytes\n", name,
+         (unsigned long)(len * 1000ULL / ns),
+         (unsigned long)(len * 10000ULL / ns % 10), (unsigned long)ram);
+}
+
+static int bench(void)
+{
+  static char doc[BENCH_DOC_LEN + 256];
+  jsmn_stream_parser stream;
+  jsmn_parser parser;
+  jsmntok_t *tokens;
+  uint64_t best_jsmn = UINT64_MAX;
+  uint64_t best_stream = UINT64_MAX;
+  uint64_t start;
+  size_t len;
+  size_t off;
+  size_t n;
+  int num_tokens;
+  int round;
+  int r = 0;
+  int i;
+
+  len = sprintf(doc, "{\"device\":\"plusfarm\",\"sensors\":[");
+  for (i = 0; len < BENCH_DOC_LEN; i++)
+  {
+    len += sprintf(doc + len, "%s{\"name\":\"sensor-%d\",\"pin\":%d,"
+                   "\"interval\":60000,\"enabled\":true,\"min\":-12.5,"
+                   "\"max\":45.0,\"label\":\"greenhouse \\u00b0C row %d\"}",
+                   (i > 0) ? "," : "", i, i % 16, i / 4);
+  }
+  len += sprintf(doc + len, "]}");
+
+  jsmn_init(&parser);
+  num_tokens = jsmn_parse(&parser, doc, len, NULL, 0);
+  tokens = malloc(num_tokens * sizeof(*tokens));
+  if (num_tokens <= 0 || tokens == NULL)
+  {
+    return 1;
+  }
+
+  /* the first round warms the cache up */
+  for (round = 0; r == 0 && round <= BENCH_ROUNDS; round++)
+  {
+    start = bench_ns();
+    jsmn_init(&parser);
+    if (jsmn_parse(&parser, doc, len, tokens, num_tokens) != num_tokens)
+    {
+      r = 1;
+    }
+    if (round > 0 && bench_ns() - start < best_jsmn)
+    {
+      best_jsmn = bench_ns() - start;
+    }
+
+    start = bench_ns();
+    jsmn_stream_init(&stream, bench_cb, NULL);
+    for (off = 0; r == 0 && off < len; off += n)
+    {
+      n = (len - off < BENCH_CHUNK) ? len - off : BENCH_CHUNK;
+      r = jsmn_stream_feed(&stream, doc + off, n);
+    }
+    if (r == 0)
+    {
+      r = jsmn_stream_finish(&stream);
+    }
+    if (round > 0 && bench_ns() - start < best_stream)
+    {
+      best_stream = bench_ns() - start;
+    }
+  }
+  free(tokens);
+  if (r != 0)
+  {
+    printf("jsmnstream: benchmark document rejected, %d\n", r);
+    return 1;
+  }
+
+  printf("  %lu bytes, %d tokens, %u byte chunks for jsmn_stream\n",
+         (unsigned long)len, num_tokens, BENCH_CHUNK);
+  bench_print("jsmn_parse", len, best_jsmn,
+              len + num_tokens * sizeof(jsmntok_t) + sizeof(jsmn_parser));
+  bench_print("jsmn_stream", len, best_stream, sizeof(jsmn_stream_parser));
+  return 0;
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc > 1 && strcmp(argv[1], "bench") == 0)
+  {
+    return bench();
+  }
+  if (argc > 1 && strcmp(argv[1], "fuzz") == 0)
+  {
+    return fuzz((argc > 2) ? strtoul(argv[2], NULL, 0) : FUZZ_CASES);
+  }
+  fprintf(stderr, "usage: %s fuzz [cases] | bench\n", argv[0]);
+  return 2;
+}
+
+#endif /* JSMN_HOST */
@@ -32,6 +32,8 @@
 #ifndef __ARCH_CC_H__
 #define __ARCH_CC_H__
 
+/* LWIP_HOST: the host programs of the Makefile, built without the SDK */
+#if !defined(LWIP_HOST)
 /* include ESP SDK prototypes as they're used in some LWIP routines */
 #include "sdk/sdk_private.h"
 
@@ -42,6 +44,17 @@
  */
 #define system_station_got_ip_set sdk_system_station_got_ip_set
 #define system_pp_recycle_rx_pkt sdk_system_pp_recycle_rx_pkt
+#else
+/* The SDK and FreeRTOS calls of the core, lwip_host.c has them */
+#include <stddef.h>
+struct ip_addr;
+size_t xPortGetFreeHeapSize(void);
+void system_pp_recycle_rx_pkt(void *eb);
+void system_station_got_ip_set(struct ip_addr *ip, struct ip_addr *mask,
+                               struct ip_addr *gw);
+void *lwip_host_heap_malloc(size_t size);
+void lwip_host_heap_free(void *mem);
+#endif /* !LWIP_HOST */
 
 /* Include some files for defining library routines */
 #include <stdio.h> /* printf, fflush, FILE */
@@ -52,7 +65,9 @@
 
 #define ERRNO
 
+#ifndef BYTE_ORDER
 #define BYTE_ORDER LITTLE_ENDIAN
+#endif
 
 /** @todo fix some warnings: don't use #pragma if compiling with cygwin gcc */
 #ifndef __GNUC__
@@ -110,6 +125,20 @@ typedef int sys_prot_t;
 #define LWIP_PLATFORM_BYTESWAP 1
 
 #define LWIP_PLATFORM_HTONS(_n)  ((u16_t)((((_n) & 0xff) << 8) | (((_n) >> 8) & 0xff)))
-#define LWIP_PLATFORM_HTONL(_n)  ((u32_t)( (((_n) & 0xff) << 24) | (((_n) & 0xff00) << 8) | (((_n) >> 8)  & 0xff00) | (((_n) >> 24) & 0xff) ))
+/* shifted as u32_t, a signed int argument would overflow */
+#define LWIP_PLATFORM_HTONL(_n)  ((u32_t)( ((((u32_t)(_n)) & 0xff) << 24) | ((((u32_t)(_n)) & 0xff00) << 8) | ((((u32_t)(_n)) >> 8)  & 0xff00) | ((((u32_t)(_n)) >> 24) & 0xff) ))
+
+/* Internet checksum written for the LX106 (lwip_esp_chksum.c), define
+ LWIP_ESP_CHKSUM to 0 to build the generic lwip_standard_chksum() instead */
+#ifndef LWIP_ESP_CHKSUM
+#define LWIP_ESP_CHKSUM 1
+#endif
+
+#if LWIP_ESP_CHKSUM
+#define LWIP_CHKSUM lwip_esp_chksum
+#define LWIP_CHKSUM_COPY(dst, src, len) lwip_esp_chksum_copy(dst, src, len)
+u16_t lwip_esp_chksum(void *dataptr, u16_t len);
+u16_t lwip_esp_chksum_copy(void *dst, const void *src, u16_t len);
+#endif /* LWIP_ESP_CHKSUM */
 
 #endif /* __ARCH_CC_H__ */
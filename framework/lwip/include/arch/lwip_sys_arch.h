@@ -1,57 +1,136 @@
-/*
- * Copyright (c) 2001-2003 Swedish Institute of Computer Science.
- * All rights reserved. 
- * 
- * Redistribution and use in source and binary forms, with or without modification, 
- * are permitted provided that the following conditions are met:
- *
- * 1. Redistributions of source code must retain the above copyright notice,
- *    this list of conditions and the following disclaimer.
- * 2. Redistributions in binary form must reproduce the above copyright notice,
- *    this list of conditions and the following disclaimer in the documentation
- *    and/or other materials provided with the distribution.
- * 3. The name of the author may not be used to endorse or promote products
- *    derived from this software without specific prior written permission. 
- *
- * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED 
- * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
- * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
- * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
- * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT 
- * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
- * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
- * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING 
- * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY 
- * OF SUCH DAMAGE.
- *
- * This file is part of the lwIP TCP/IP stack.
- * 
- * Author: Adam Dunkels <adam@sics.se>
- *
- */
-#ifndef __ARCH_SYS_ARCH_H__
-#define __ARCH_SYS_ARCH_H__
-
-#include "freertos.h"
-#include "freertos_task.h"
-#include "freertos_queue.h"
-#include "freertos_semphr.h"
-
-/* MBOX primitives */
-
-#define SYS_MBOX_NULL					( ( QueueHandle_t ) NULL )
-#define SYS_SEM_NULL					( ( SemaphoreHandle_t ) NULL )
-#define SYS_DEFAULT_THREAD_STACK_DEPTH	configMINIMAL_STACK_SIZE
-
-typedef SemaphoreHandle_t sys_sem_t;
-typedef SemaphoreHandle_t sys_mutex_t;
-typedef QueueHandle_t sys_mbox_t;
-typedef TaskHandle_t sys_thread_t;
-
-#define sys_mbox_valid( x ) ( ( ( *x ) == NULL) ? pdFALSE : pdTRUE )
-#define sys_mbox_set_invalid( x ) ( ( *x ) = NULL )
-#define sys_sem_valid( x ) ( ( ( *x ) == NULL) ? pdFALSE : pdTRUE )
-#define sys_sem_set_invalid( x ) ( ( *x ) = NULL )
-
-#endif /* __ARCH_SYS_ARCH_H__ */
-
+/*
+ * Copyright (c) 2001-2003 Swedish Institute of Computer Science.
+ * All rights reserved. 
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, 
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED 
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF 
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT 
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, 
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT 
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING 
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY 
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ * 
+ * Author: Adam Dunkels <adam@sics.se>
+ *
+ */
+#ifndef __ARCH_SYS_ARCH_H__
+#define __ARCH_SYS_ARCH_H__
+
+#if defined(LWIP_HOST)
+/* The host programs built with NO_SYS 0, on the threads of lwip_host_sys.c */
+#include <pthread.h>
+#include <stddef.h>
+
+/* The priorities of lwip_opts.h, the host threads have none */
+#define configMAX_PRIORITIES			15
+
+#define SYS_MBOX_NULL					NULL
+#define SYS_SEM_NULL					NULL
+
+typedef struct lwip_host_sem *sys_sem_t;
+typedef pthread_mutex_t *sys_mutex_t;
+typedef struct lwip_host_mbox *sys_mbox_t;
+typedef pthread_t sys_thread_t;
+
+#define sys_mbox_valid( x ) ( ( *x ) != NULL )
+#define sys_mbox_set_invalid( x ) ( ( *x ) = NULL )
+#define sys_sem_valid( x ) ( ( *x ) != NULL )
+#define sys_sem_set_invalid( x ) ( ( *x ) = NULL )
+
+/* Times a thread had to wait: on a semaphore, for a message or for room in
+ a mailbox, or for a mutex, a switch to another task and back on the one
+ core of the device */
+extern unsigned long lwip_host_sys_waits;
+
+/* Free heap reported by xPortGetFreeHeapSize() until a program sets
+ lwip_host_free_heap, as in lwip_host.h */
+#define LWIP_HOST_FREE_HEAP				32768
+
+/* What xPortGetFreeHeapSize() returns, and the least lwip_host_heap_malloc()
+ has left of it */
+extern size_t lwip_host_free_heap;
+extern size_t lwip_host_min_free_heap;
+
+/* The FreeRTOS calls of the tasks of a program, which the headers below
+ bring in on the device: the semaphores are binary, a task is a thread */
+#define portMAX_DELAY					0xffffffffUL
+#define portTICK_PERIOD_MS				10
+#define pdFALSE							0
+#define pdTRUE							1
+#define pdPASS							1
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef unsigned long TickType_t;
+typedef unsigned long StackType_t;
+typedef struct lwip_host_sem *SemaphoreHandle_t;
+/* A queue holds items up to the size of a pointer, in a mailbox */
+typedef struct lwip_host_queue *QueueHandle_t;
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *param);
+/* The buffers of the static calls go unused, the host allocates */
+typedef struct { void *unused; } StaticQueue_t;
+typedef struct { void *unused; } StaticTask_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name,
+                       unsigned short stack, void *param, UBaseType_t prio,
+                       TaskHandle_t *task);
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name,
+                               unsigned long stack, void *param,
+                               UBaseType_t prio, StackType_t *stack_buf,
+                               StaticTask_t *task_buf);
+QueueHandle_t xQueueCreateStatic(UBaseType_t len, UBaseType_t item_size,
+                                 unsigned char *storage,
+                                 StaticQueue_t *queue_buf);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait);
+void vTaskDelay(TickType_t ticks);
+void vPortEnterCritical(void);
+
+/* SYS_ARCH_PROTECT(), which nests as the critical sections of the device */
+#define taskENTER_CRITICAL()			((void)sys_arch_protect())
+#define taskEXIT_CRITICAL()				sys_arch_unprotect(0)
+#else
+#include "freertos.h"
+#include "freertos_task.h"
+#include "freertos_queue.h"
+#include "freertos_semphr.h"
+
+/* MBOX primitives */
+
+#define SYS_MBOX_NULL					( ( QueueHandle_t ) NULL )
+#define SYS_SEM_NULL					( ( SemaphoreHandle_t ) NULL )
+#define SYS_DEFAULT_THREAD_STACK_DEPTH	configMINIMAL_STACK_SIZE
+
+typedef SemaphoreHandle_t sys_sem_t;
+typedef SemaphoreHandle_t sys_mutex_t;
+typedef QueueHandle_t sys_mbox_t;
+typedef TaskHandle_t sys_thread_t;
+
+#define sys_mbox_valid( x ) ( ( ( *x ) == NULL) ? pdFALSE : pdTRUE )
+#define sys_mbox_set_invalid( x ) ( ( *x ) = NULL )
+#define sys_sem_valid( x ) ( ( ( *x ) == NULL) ? pdFALSE : pdTRUE )
+#define sys_sem_set_invalid( x ) ( ( *x ) = NULL )
+#endif /* LWIP_HOST */
+
+#endif /* __ARCH_SYS_ARCH_H__ */
+
@@ -0,0 +1,100 @@
+/* Network benchmark service, see lwip_bench.c
+ *
+ * Once started, the node answers a throughput and latency test driven from a
+ * host by util/netbench.py. Everything runs in the tcpip thread on the raw
+ * API, and the service stops by itself after BENCH_IDLE_MS without traffic.
+ * All integers on the wire are big endian.
+ *
+ * TCP, BENCH_PORT: the netio framing of commands, a command word and a
+ * length word, then:
+ *   BENCH_CMD_C2S  the host sends 'length' bytes, the node counts them and
+ *                  answers with two words: the bytes received and the
+ *                  microseconds from the first to the last one
+ *   BENCH_CMD_S2C  the node sends 'length' bytes
+ *   BENCH_CMD_QUIT the node closes the connection
+ *
+ * UDP, BENCH_PORT: each datagram starts with a type word and a sequence
+ * word:
+ *   BENCH_UDP_FLOOD        counted, sequence numbers from 0 give the loss
+ *   BENCH_UDP_ECHO         sent back unchanged
+ *   BENCH_UDP_REPORT       answered with bench_flood_report_t, the flood
+ *                          counters are then cleared
+ *   BENCH_UDP_PING         the node sends 'sequence' ICMP echo requests to
+ *                          the host, the request itself is echoed as an ack
+ *   BENCH_UDP_PING_REPORT  answered with bench_ping_report_t
+ */
+#ifndef _LWIP_BENCH_H
+#define _LWIP_BENCH_H
+
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_err.h"
+
+/* TCP and UDP port, the one of netio */
+#ifndef BENCH_PORT
+#define BENCH_PORT              18767
+#endif
+
+/* Inactivity after which the service stops */
+#ifndef BENCH_IDLE_MS
+#define BENCH_IDLE_MS           300000
+#endif
+
+/* Bytes handed to tcp_write() at a time by BENCH_CMD_S2C */
+#ifndef BENCH_CHUNK
+#define BENCH_CHUNK             512
+#endif
+
+/* Interval between the ICMP echo requests, a reply arriving after the next
+ request is counted as lost */
+#ifndef BENCH_PING_INTERVAL_MS
+#define BENCH_PING_INTERVAL_MS  200
+#endif
+
+/* RTT histogram, bucket i counts the round trips shorter than
+ BENCH_HIST_MIN_US << i, the last bucket counts the rest */
+#define BENCH_HIST_BUCKETS      8
+#define BENCH_HIST_MIN_US       1000
+
+#define BENCH_CMD_QUIT          0
+#define BENCH_CMD_C2S           1
+#define BENCH_CMD_S2C           2
+
+#define BENCH_UDP_FLOOD         1
+#define BENCH_UDP_ECHO          2
+#define BENCH_UDP_REPORT        3
+#define BENCH_UDP_PING          4
+#define BENCH_UDP_PING_REPORT   5
+
+typedef struct
+{
+  u32_t type;
+  u32_t seq;
+  /* flood datagrams and bytes received */
+  u32_t received;
+  u32_t bytes;
+  /* sequence numbers never seen, and datagrams arriving after a higher
+   sequence number */
+  u32_t lost;
+  u32_t late;
+  /* from the first to the last datagram */
+  u32_t us;
+} bench_flood_report_t;
+
+typedef struct
+{
+  u32_t type;
+  u32_t seq;
+  u32_t sent;
+  u32_t received;
+  u32_t min_us;
+  u32_t max_us;
+  u32_t avg_us;
+  u32_t hist[BENCH_HIST_BUCKETS];
+} bench_ping_report_t;
+
+/* Open or close the service. Can be called from any task, the tcpip thread
+ included. Returns ERR_MEM if the request could not be queued. */
+err_t lwip_bench_start(void);
+err_t lwip_bench_stop(void);
+
+#endif /* _LWIP_BENCH_H */
@@ -0,0 +1,83 @@
+/* Receive admission of the WiFi interface, see lwip_esp_interface.c
+ *
+ * ethernetif_input() runs in the SDK task. Instead of posting every frame
+ * to the tcpip thread mailbox, it sorts them into one bounded queue per
+ * class and wakes the tcpip thread once, which then takes them in turn with
+ * weights favouring the control class. Under heap pressure the bulk class,
+ * then the flow class, are dropped before anything is queued, so that ARP,
+ * TCP handshakes and ACKs (the MQTT keepalive among them) still get through
+ * a broadcast storm or a UDP flood.
+ */
+#ifndef _LWIP_ESP_INTERFACE_H
+#define _LWIP_ESP_INTERFACE_H
+
+#include <stdint.h>
+
+/* 0 posts every frame to the tcpip thread with tcpip_input() as before,
+ without classes or counters, "make rxflood" compares the two */
+#ifndef RX_ADMISSION
+#define RX_ADMISSION            1
+#endif
+
+typedef enum
+{
+  /* ARP, TCP segments without data or with SYN, FIN or RST */
+  RX_CLASS_CONTROL = 0,
+  /* unicast TCP data, ICMP, replies of DNS, DHCP and NTP servers */
+  RX_CLASS_FLOW,
+  /* broadcast, multicast, other UDP, fragments */
+  RX_CLASS_BULK,
+  RX_CLASS_NUM
+} rx_class_t;
+
+/* Queue lengths, in frames */
+#ifndef RX_QUEUE_CONTROL
+#define RX_QUEUE_CONTROL        8
+#endif
+#ifndef RX_QUEUE_FLOW
+#define RX_QUEUE_FLOW           8
+#endif
+#ifndef RX_QUEUE_BULK
+#define RX_QUEUE_BULK           4
+#endif
+
+/* Frames taken from each class per round of the tcpip thread */
+#ifndef RX_WEIGHTS
+#define RX_WEIGHTS              { 4, 2, 1 }
+#endif
+
+/* Frames processed per wake up, before the other tcpip messages get a turn */
+#ifndef RX_BUDGET
+#define RX_BUDGET               16
+#endif
+
+/* Ticks before waking the tcpip thread again when its mailbox was full */
+#ifndef RX_RETRY_TICKS
+#define RX_RETRY_TICKS          1
+#endif
+
+/* Free heap below which bulk, then flow frames are dropped on arrival */
+#ifndef RX_HEAP_LOW_BULK
+#define RX_HEAP_LOW_BULK        12288
+#endif
+#ifndef RX_HEAP_LOW_FLOW
+#define RX_HEAP_LOW_FLOW        6144
+#endif
+
+typedef struct
+{
+  /* frames queued */
+  uint32_t queued;
+  /* frames dropped because the queue was full */
+  uint32_t drop_full;
+  /* frames dropped because the heap was low */
+  uint32_t drop_heap;
+  /* deepest the queue has been */
+  uint16_t max;
+} rx_class_stats_t;
+
+/* Copy the counters of the RX_CLASS_NUM classes to 'stats', zero without
+ RX_ADMISSION */
+void ethernetif_get_rx_stats(rx_class_stats_t *stats);
+
+#endif /* _LWIP_ESP_INTERFACE_H */
@@ -0,0 +1,222 @@
+/* Host port of the lwIP core for the host programs of the Makefile, see
+ * lwip_host.c
+ *
+ * The core is built with NO_SYS (lwip_opts.h) and runs from the calling
+ * thread on a simulated clock: lwip_host_run() moves sys_now() on a
+ * millisecond at a time, delivering the frames and running the lwIP timers
+ * that fall due. Runs are repeatable and take the host CPU time they need,
+ * whatever the simulated time.
+ *
+ * The tcpip thread is a mailbox of TCPIP_MBOX_SIZE messages, the frames of
+ * tcpip_input() and the callbacks, which it takes at the next millisecond.
+ * lwip_host_tcpip_rate gives it the time for that many frames a ms, the
+ * messages wait meanwhile and the posts fail once the mailbox is full.
+ *
+ * Netifs are the Ethernet ports of simulated segments, a hub each: a frame
+ * sent on a port reaches the other ports whose MAC it is addressed to,
+ * broadcasts reach all of them, after the time it takes at the rate of the
+ * segment plus its delay, unless it is lost. Received frames are PBUF_REF
+ * pbufs as from the SDK, their buffer goes back through
+ * system_pp_recycle_rx_pkt(), and netif->input (ethernet_input() unless a
+ * program sets another) gets them, or the driver of the port, see
+ * lwip_host_port_driver().
+ *
+ * A link is a segment of two ports that skip ARP, the two ends of a TCP
+ * test in the one stack, see lwip_host_link_add().
+ *
+ * A tap is a port outside the stack, the other end of a test: its input
+ * function gets the frames sent to it and the program builds the frames it
+ * sends, the helpers below answer ARP and carry UDP.
+ *
+ * Not part of the firmware.
+ */
+#ifndef _LWIP_HOST_H
+#define _LWIP_HOST_H
+
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_netif.h"
+#include "lwip/lwip_pbuf.h"
+#include "netif/lwip_etharp.h"
+
+#if !defined(LWIP_HOST) || !NO_SYS
+#error "lwip_host.c is the NO_SYS port of the host programs"
+#endif
+
+/* Ports of a segment */
+#ifndef LWIP_HOST_PORTS
+#define LWIP_HOST_PORTS         64
+#endif
+
+/* Frames in flight on a segment, more are lost */
+#ifndef LWIP_HOST_FRAMES
+#define LWIP_HOST_FRAMES        1024
+#endif
+
+/* Free heap reported by xPortGetFreeHeapSize() until a program sets
+ lwip_host_free_heap */
+#define LWIP_HOST_FREE_HEAP     32768
+
+typedef struct lwip_host_frame lwip_host_frame_t;
+
+/* What the SDK hands a received frame to, ethernetif_input() */
+typedef void (*lwip_host_driver_fn)(struct netif *netif, struct pbuf *p);
+
+typedef struct
+{
+  /* one way delay, in ms */
+  u32_t delay;
+  /* bytes per ms, 0 for no limit */
+  u32_t rate;
+  /* frames lost, per million */
+  u32_t loss;
+  /* counters: frames sent, lost on the way (to loss or a full segment) and
+   delivered to a port, bytes sent */
+  u32_t sent;
+  u32_t lost;
+  u32_t delivered;
+  u32_t bytes;
+  /* private */
+  struct netif *ports[LWIP_HOST_PORTS];
+  lwip_host_driver_fn drivers[LWIP_HOST_PORTS];
+  u8_t num_ports;
+  u8_t index;
+  u32_t busy_until;
+  u32_t in_flight;
+  lwip_host_frame_t *head;
+  lwip_host_frame_t *tail;
+} lwip_host_seg_t;
+
+/* Simulated time in ms, what sys_now() returns */
+extern u32_t lwip_host_now;
+
+/* What xPortGetFreeHeapSize() returns, LWIP_HOST_FREE_HEAP at first */
+extern size_t lwip_host_free_heap;
+
+/* Least lwip_host_heap_malloc() has left of lwip_host_free_heap, as
+ xPortGetMinimumEverFreeHeapSize(), a program resets it between runs */
+extern size_t lwip_host_min_free_heap;
+
+/* RX buffers delivered and not yet recycled, 0 once every pbuf is freed */
+extern u32_t lwip_host_rx_buffers;
+
+/* Frames the tcpip thread gets through per ms, 0 (at first) for no limit:
+ those of tcpip_input(), and those a callback hands to the core, which the
+ driver counts in LINK_STATS */
+extern u32_t lwip_host_tcpip_rate;
+
+/* lwip_pool_init() and lwip_init(), once, and the random numbers reseeded */
+void lwip_host_init(u32_t seed);
+
+/* Random number of the simulation, xorshift32 */
+u32_t lwip_host_rand(void);
+
+/* Empty segment, no delay, rate or loss */
+void lwip_host_seg_init(lwip_host_seg_t *seg);
+
+/* Add 'netif' as the next port of 'seg', up, with a MAC made of the
+ segment and port numbers. Returns NULL if the segment is full. */
+struct netif *lwip_host_port_add(lwip_host_seg_t *seg, struct netif *netif,
+                                 ip_addr_t *ipaddr, ip_addr_t *netmask,
+                                 ip_addr_t *gw);
+
+/* Add 'netif' as one of the two ports of the link 'seg', which sends what
+ it routes to the other port without ARP. Returns NULL if the link has its
+ two ports.
+
+ The two ends of a TCP test share the one stack: the data for an address
+ leaves by the port on its network and arrives at the other port, where
+ ip_input() takes it for any netif. With a port on 10.0.1.0/24 and one on
+ 10.0.2.0/24, a pcb bound to 10.0.2.1 connected to a listener on 10.0.1.1
+ sends from the first port to the second, the answers go the other way,
+ each crossing the link once. The pcbs must be bound to the address of
+ their end, those of tcp_accept() are. */
+struct netif *lwip_host_link_add(lwip_host_seg_t *seg, struct netif *netif,
+                                 ip_addr_t *ipaddr, ip_addr_t *netmask);
+
+/* Hand the frames of port 'netif' of 'seg' to 'driver' rather than to
+ netif->input, as the SDK calls ethernetif_input() which then passes them
+ on to netif->input, tcpip_input() in the firmware */
+void lwip_host_port_driver(lwip_host_seg_t *seg, struct netif *netif,
+                           lwip_host_driver_fn driver);
+
+/* Add 'netif' as a tap of 'seg' with the address 'ipaddr', 'input' gets the
+ frames and frees them. Returns NULL if the segment is full. */
+struct netif *lwip_host_tap_add(lwip_host_seg_t *seg, struct netif *netif,
+                                ip_addr_t *ipaddr, netif_input_fn input);
+
+/* A UDP datagram seen by a tap, 'data' points into the frame */
+typedef struct
+{
+  struct eth_addr mac;
+  ip_addr_t src;
+  ip_addr_t dst;
+  u16_t src_port;
+  u16_t dst_port;
+  const u8_t *data;
+  u16_t len;
+} lwip_host_udp_t;
+
+/* Answer frame 'p' if it is an ARP request for the address of 'tap'.
+ Returns non zero if 'p' is an ARP frame. */
+int lwip_host_tap_arp(struct netif *tap, struct pbuf *p);
+
+/* Fill 'udp' from frame 'p', returns non zero if it is a UDP datagram of an
+ unfragmented IPv4 packet */
+int lwip_host_tap_udp_parse(struct pbuf *p, lwip_host_udp_t *udp);
+
+/* Build the frame of 'udp' from the MAC 'src' to 'udp->mac', without UDP
+ checksum, in 'frame' of SIZEOF_ETH_HDR + IP_HLEN + UDP_HLEN + udp->len
+ bytes. Returns its length. */
+u16_t lwip_host_udp_frame(const struct eth_addr *src, const lwip_host_udp_t *udp,
+                          u8_t *frame);
+
+/* Send 'udp' from 'tap' to the MAC 'udp->mac', without UDP checksum */
+err_t lwip_host_tap_udp_send(struct netif *tap, const lwip_host_udp_t *udp);
+
+/* A received frame as the SDK hands it over, a PBUF_REF pbuf of a copy of
+ 'frame', NULL if out of memory */
+struct pbuf *lwip_host_rx_pbuf(const void *frame, u16_t len);
+
+/* The heap of the device behind lwip_pool.c, for the programs built with
+ LWIP_POOL_HEAP_MALLOC lwip_host_heap_malloc and LWIP_POOL_HEAP_FREE
+ lwip_host_heap_free: what the classes cannot serve comes out of
+ lwip_host_free_heap with the header of a FreeRTOS heap block, and fails
+ once that is used up */
+void *lwip_host_heap_malloc(size_t size);
+void lwip_host_heap_free(void *mem);
+
+/* Run the simulation for 'ms' */
+void lwip_host_run(u32_t ms);
+
+/* Run until done() returns non zero or 'ms' have passed, returns the time
+ it took, 'ms' + 1 if done() never returned non zero */
+u32_t lwip_host_run_until(int (*done)(void *arg), void *arg, u32_t ms);
+
+/* The FreeRTOS software timers of lwip_esp_interface.c, on sys_timeout()
+ with the tick of the firmware */
+#define portTICK_PERIOD_MS      10
+#define pdFALSE                 0
+#define pdTRUE                  1
+#define pdPASS                  1
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef u32_t TickType_t;
+typedef struct lwip_host_timer StaticTimer_t;
+typedef StaticTimer_t *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+struct lwip_host_timer
+{
+  TimerCallbackFunction_t callback;
+  TickType_t period;
+  UBaseType_t reload;
+};
+
+TimerHandle_t xTimerCreateStatic(const char *name, TickType_t period,
+                                 UBaseType_t reload, void *id,
+                                 TimerCallbackFunction_t callback,
+                                 StaticTimer_t *buf);
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t wait);
+
+#endif /* _LWIP_HOST_H */
@@ -0,0 +1,109 @@
+/* Network and system metrics, see lwip_metrics.c
+ *
+ * Every METRICS_PERIOD_MS the tcpip thread copies the lwIP protocol counters
+ * and the state of the active TCP connections into one of two snapshot
+ * buffers, then publishes it by bumping a generation count. A reader in any
+ * task copies the published buffer and checks that the generation did not
+ * move meanwhile, so the two sides never wait for each other and scraping
+ * never takes the tcpip core lock. Pool, receive queue, heap and task
+ * figures are read at formatting time, each under its own short protection.
+ *
+ * lwip_metrics_format_text() writes all of it in the Prometheus text format,
+ * served by httpd on LWIP_HTTPD_METRICS_URI. lwip_metrics_format_json() writes
+ * a one-line summary small enough for an MQTT publish.
+ */
+#ifndef _LWIP_METRICS_H
+#define _LWIP_METRICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_ip_addr.h"
+
+/* Snapshot period of the tcpip thread */
+#ifndef METRICS_PERIOD_MS
+#define METRICS_PERIOD_MS       2000
+#endif
+
+/* Connections detailed per snapshot, the others are only counted */
+#ifndef METRICS_TCP_CONNS
+#define METRICS_TCP_CONNS       4
+#endif
+
+/* Tasks listed by lwip_metrics_format_text() */
+#ifndef METRICS_TASKS
+#define METRICS_TASKS           16
+#endif
+
+/* Room for lwip_stats.link, etharp, ip_frag, ip, icmp, udp and tcp */
+#define METRICS_PROTOS_MAX      7
+
+typedef struct
+{
+  u32_t xmit;
+  u32_t recv;
+  u32_t drop;
+  u32_t chkerr;
+  u32_t memerr;
+  u32_t err;
+} metrics_proto_t;
+
+typedef struct
+{
+  ip_addr_t remote_ip;
+  u16_t local_port;
+  u16_t remote_port;
+  /* enum tcp_state */
+  u8_t state;
+  /* retransmissions of the oldest unacked segment, the current backoff */
+  u8_t nrtx;
+  /* retransmission timeouts and fast retransmits since the connection
+   opened */
+  u16_t rexmit;
+  /* smoothed round trip time and retransmission timeout, with the 500 ms
+   resolution of the TCP slow timer */
+  u32_t srtt_ms;
+  u32_t rto_ms;
+  /* bytes and segments of the send buffer in use, unsent or unacked */
+  u16_t snd_used;
+  u16_t snd_queuelen;
+  u16_t cwnd;
+  u16_t snd_wnd;
+} metrics_tcp_conn_t;
+
+typedef struct
+{
+  /* sys_now() when the snapshot was taken */
+  u32_t time;
+  u8_t num_protos;
+  metrics_proto_t protos[METRICS_PROTOS_MAX];
+  /* sys_mbox_trypost() failures, the tcpip mailbox among them */
+  u32_t mbox_err;
+  /* active and TIME-WAIT connections, the first METRICS_TCP_CONNS active
+   ones are in 'conns' */
+  u16_t tcp_active;
+  u16_t tcp_tw;
+  u8_t num_conns;
+  metrics_tcp_conn_t conns[METRICS_TCP_CONNS];
+} metrics_snapshot_t;
+
+/* Start the snapshots, call once the tcpip thread is running */
+void lwip_metrics_init(void);
+
+/* Copy the latest snapshot to 'snap'. Returns false before the first
+ snapshot, or if the tcpip thread kept replacing it during the copy. */
+bool lwip_metrics_get(metrics_snapshot_t *snap);
+
+/* Name of protos[i] in a snapshot, "link", "tcp"... */
+const char *lwip_metrics_proto_name(u8_t i);
+
+/* Write the metrics in the Prometheus text format, without HELP and TYPE
+ lines. Output that does not fit is cut at a line boundary. Returns the
+ length written, 0 if no snapshot could be taken. */
+size_t lwip_metrics_format_text(char *buf, size_t len);
+
+/* Write a one-line JSON summary, returns the length written or 0 if it did
+ not fit */
+size_t lwip_metrics_format_json(char *buf, size_t len);
+
+#endif /* _LWIP_METRICS_H */
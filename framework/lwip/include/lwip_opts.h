@@ -39,6 +39,19 @@
 #define ESP_TIMEWAIT_THRESHOLD              10000
 #define LWIP_TIMEVAL_PRIVATE                0
 
+/* The host programs of the Makefile (LWIP_HOST, see arch/lwip_cc.h) run the
+ core from one thread without an OS unless they bring a sys_arch, see
+ lwip_host.h */
+#if defined(LWIP_HOST)
+#ifndef NO_SYS
+#define NO_SYS                              1
+#endif
+#if NO_SYS
+#define LWIP_NETCONN                        0
+#define LWIP_SOCKET                         0
+#endif
+#endif /* LWIP_HOST */
+
 /*
  -----------------------------------------------
  ---------- Platform specific locking ----------
@@ -82,6 +95,19 @@
  */
 #define MEMP_MEM_MALLOC                 1
 
+/**
+ * LWIP_POOL==1: Serve mem_malloc() (and so the memp objects) from fixed-block
+ * pools sized at boot instead of the C library heap, see lwip_pool.h.
+ */
+#define LWIP_POOL                       1
+
+#if LWIP_POOL
+#include "lwip_pool.h"
+#define mem_malloc                      lwip_pool_malloc
+#define mem_calloc                      lwip_pool_calloc
+#define mem_free                        lwip_pool_free
+#endif /* LWIP_POOL */
+
 /**
  * MEM_ALIGNMENT: should be set to the alignment of the CPU
  *    4 byte alignment -> #define MEM_ALIGNMENT 4
@@ -193,7 +219,13 @@
  */
 #define LWIP_DNS                        1
 
-#define DNS_TABLE_SIZE 1
+/* Names cached at a time: the MQTT broker, the OTA and NTP servers share the
+ table, refreshed before their TTL expires and answered stale for a day when
+ the servers fail. See lwip_dns.c for the other DNS_ cache options, "make
+ dnstest" tests them on the host. */
+#ifndef DNS_TABLE_SIZE
+#define DNS_TABLE_SIZE 4
+#endif
 #define DNS_MAX_NAME_LENGTH 128
 
 /*
@@ -209,8 +241,13 @@
 /**
  * TCP_QUEUE_OOSEQ==1: TCP will queue segments that arrive out of order.
  * Define to 0 if your device is low on memory.
+ * The queued segments are copied out of the WiFi receive buffers, within
+ * the limits below, so that a lost segment does not throw away the data
+ * in flight behind it. "make ooseqtest" measures it on a lossy link.
  */
-#define TCP_QUEUE_OOSEQ                 0
+#ifndef TCP_QUEUE_OOSEQ
+#define TCP_QUEUE_OOSEQ                 1
+#endif
 
 /*
  *     LWIP_EVENT_API==1: The user defines lwip_tcp_event() to receive all
@@ -220,6 +257,20 @@
  */
 #define TCP_MSS                         1460
 
+/**
+ * TCP_OOSEQ_MAX_BYTES, TCP_OOSEQ_MAX_PBUFS: out of sequence data queued per
+ * pcb, TCP_OOSEQ_GLOBAL_MAX_BYTES: by all pcbs together.
+ */
+#define TCP_OOSEQ_MAX_BYTES             (2 * TCP_MSS)
+#define TCP_OOSEQ_MAX_PBUFS             4
+#define TCP_OOSEQ_GLOBAL_MAX_BYTES      (4 * TCP_MSS)
+
+/**
+ * TCP_OOSEQ_MIN_FREE_HEAP: the out of sequence data is given back to the
+ * heap when it runs below this.
+ */
+#define TCP_OOSEQ_MIN_FREE_HEAP         8192
+
 /**
  * TCP_MAXRTX: Maximum number of retransmissions of data segments.
  */
@@ -252,6 +303,13 @@
  */
 #define LWIP_NETIF_TX_SINGLE_PBUF             1
 
+/**
+ * LWIP_CHECKSUM_ON_COPY==1: Calculate checksum when copying data from
+ * application buffers to pbufs, with LWIP_CHKSUM_COPY() of arch/lwip_cc.h.
+ * The data sent is then read once instead of twice.
+ */
+#define LWIP_CHECKSUM_ON_COPY                 1
+
 /*
  ------------------------------------
  ---------- LOOPIF options ----------
@@ -283,6 +341,23 @@
  */
 #define TCPIP_THREAD_PRIO               (configMAX_PRIORITIES-5)
 
+/**
+ * LWIP_TCPIP_CORE_LOCKING: the netconn and socket API calls lock the core
+ * with a (priority inheriting) mutex and run in the calling task, instead of
+ * posting a message to the tcpip thread and waiting for its answer. This
+ * saves two context switches per call, the callers need the stack for it.
+ */
+#ifndef LWIP_TCPIP_CORE_LOCKING
+#define LWIP_TCPIP_CORE_LOCKING         1
+#endif
+
+/**
+ * LWIP_TCPIP_CORE_LOCKING_INPUT: received packets are still queued to the
+ * tcpip thread (by class, see lwip_esp_interface.h), ethernetif_input() runs
+ * in the SDK task which must not block on the core lock.
+ */
+#define LWIP_TCPIP_CORE_LOCKING_INPUT   0
+
 /**
  * TCPIP_MBOX_SIZE: The mailbox size for the tcpip thread messages
  * The queue size value itself is platform-dependent, but is passed to
@@ -311,6 +386,18 @@
  */
 #define DEFAULT_ACCEPTMBOX_SIZE         6
 
+/**
+ * LWIP_SYS_STATIC==1: Create the tcpip thread and its mailbox in static
+ * storage, and take the mailboxes, semaphores and mutexes of the connections
+ * from small static pools (lwip_sys_arch.c). The heap is used once a pool is
+ * exhausted or for a mailbox larger than LWIP_SYS_STATIC_MBOX_SIZE.
+ */
+#define LWIP_SYS_STATIC                 1
+#define LWIP_SYS_STATIC_MBOXES          6
+#define LWIP_SYS_STATIC_MBOX_SIZE       6
+#define LWIP_SYS_STATIC_SEMS            6
+#define LWIP_SYS_STATIC_MUTEXES         2
+
 /*
  ----------------------------------------------
  ---------- Sequential layer options ----------
@@ -356,6 +443,17 @@
  ---------- Statistics options ----------
  ----------------------------------------
  */
+/**
+ * LWIP_STATS==1: Enable statistics collection in lwip_stats, exported by
+ * lwip_metrics.c.
+ */
+#define LWIP_STATS                      1
+
+/**
+ * LWIP_STATS_LARGE==1: 32-bit counters, the 16-bit ones wrap within minutes
+ * of traffic and read as resets to a scraper.
+ */
+#define LWIP_STATS_LARGE                1
 
 /*
  ---------------------------------
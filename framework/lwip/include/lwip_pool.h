@@ -0,0 +1,65 @@
+/* Segregated fixed-block pools behind mem_malloc()/mem_free()
+ *
+ * With MEMP_MEM_MALLOC every memp object (pcbs, segments, netbufs, pbuf
+ * headers...) and every PBUF_RAM pbuf is a mem_malloc() call. These calls are
+ * served from a few size classes of fixed blocks carved from one arena
+ * allocated at boot, with O(1) allocation and release, so that the heap is not
+ * fragmented by the constant churn of small network objects. Requests larger
+ * than the biggest class or made while their classes are exhausted fall back
+ * to malloc(), except in an ISR, where they fail.
+ */
+#ifndef _LWIP_POOL_H
+#define _LWIP_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Arena size, split between the classes at boot */
+#ifndef LWIP_POOL_BUDGET
+#define LWIP_POOL_BUDGET        12288
+#endif
+
+/* { block size, share of the budget in percent }, sorted by block size.
+ 32: pbuf headers, segments, netbufs, timeouts, udp/raw pcbs
+ 64: netconns, small pbufs
+ 192: tcp pcbs, netdb entries, pbufs of small segments
+ 512: pbufs of medium segments, application buffers
+ 1600: pbufs of full-sized segments
+ */
+#ifndef LWIP_POOL_CLASSES
+#define LWIP_POOL_CLASSES       { { 32, 15 }, { 64, 10 }, { 192, 25 }, \
+                                  { 512, 20 }, { 1600, 30 } }
+#endif
+
+/* Heap of the requests the classes cannot serve, lwip_host.h has one that
+ counts them against the free heap of the device */
+#ifndef LWIP_POOL_HEAP_MALLOC
+#define LWIP_POOL_HEAP_MALLOC   malloc
+#endif
+#ifndef LWIP_POOL_HEAP_FREE
+#define LWIP_POOL_HEAP_FREE     free
+#endif
+
+typedef struct
+{
+  uint16_t size;
+  uint16_t num;
+  uint16_t used;
+  /* high-water mark of used */
+  uint16_t max;
+  /* requests that could not be served from this class or a larger one */
+  uint32_t err;
+} lwip_pool_stats_t;
+
+/* Allocate the arena. Called from sys_init(), allocations made before fall
+ back to malloc(). */
+void lwip_pool_init(void);
+
+void *lwip_pool_malloc(size_t size);
+void *lwip_pool_calloc(size_t count, size_t size);
+void lwip_pool_free(void *mem);
+
+/* Fill 'stats' with up to 'max' classes, return the number of classes */
+uint8_t lwip_pool_get_stats(lwip_pool_stats_t *stats, uint8_t max);
+
+#endif /* _LWIP_POOL_H */
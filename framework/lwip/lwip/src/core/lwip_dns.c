@@ -103,6 +103,30 @@
 #define DNS_MAX_TTL               604800
 #endif
 
+/** Seconds before the TTL expires when an entry looked up since it was
+ * resolved is queried again in the background, 0 to disable */
+#ifndef DNS_REFRESH_MARGIN
+#define DNS_REFRESH_MARGIN        30
+#endif
+
+/** Seconds an address is kept after its TTL expired, to be answered when
+ * the servers fail to resolve the name again (RFC 8767), 0 to disable */
+#ifndef DNS_STALE_TTL
+#define DNS_STALE_TTL             86400
+#endif
+
+/** Seconds a stale address is answered for without asking the servers
+ * again, once they failed */
+#ifndef DNS_STALE_ANSWER_TTL
+#define DNS_STALE_ANSWER_TTL      30
+#endif
+
+/** Seconds a name known not to exist (or without an A record) is answered
+ * as such without asking the servers again (RFC 2308), 0 to disable */
+#ifndef DNS_NEG_TTL
+#define DNS_NEG_TTL               60
+#endif
+
 /* DNS protocol flags */
 #define DNS_FLAG1_RESPONSE        0x80
 #define DNS_FLAG1_OPCODE_STATUS   0x10
@@ -167,7 +191,12 @@ struct dns_answer
 };
 #define SIZEOF_DNS_ANSWER 10
 
-/** DNS table entry */
+/** DNS table entry
+ *
+ * An entry is fresh while its ttl runs, it is answered from the table. With
+ * valid set it holds an address that can still be answered when a new query
+ * fails, until keep runs out. A DONE entry without valid is a negative one.
+ */
 struct dns_table_entry
 {
   u8_t state;
@@ -176,7 +205,12 @@ struct dns_table_entry
   u8_t retries;
   u8_t seqno;
   u8_t err;
+  u8_t valid;
+  /* looked up since it was resolved, refreshed before it expires */
+  u8_t used;
+  /* seconds left of the TTL, and before the entry is dropped */
   u32_t ttl;
+  u32_t keep;
   char name[DNS_MAX_NAME_LENGTH];
   ip_addr_t ipaddr;
   /* pointer to callback on DNS query done */
@@ -214,6 +248,7 @@ static void dns_init_local();
 static void dns_recv(void *s, struct udp_pcb *pcb, struct pbuf *p,
                      ip_addr_t *addr, u16_t port);
 static void dns_check_entries(void);
+static u8_t dns_find(const char *name);
 
 /*-----------------------------------------------------------------------------
  * Globales
@@ -455,6 +490,27 @@ dns_local_addhost(const char *hostname, const ip_addr_t *addr)
 #endif /* DNS_LOCAL_HOSTLIST_IS_DYNAMIC*/
 #endif /* DNS_LOCAL_HOSTLIST */
 
+/**
+ * Find the entry of a hostname in dns_table, whatever its state.
+ *
+ * @param name the hostname to look for
+ * @return index of the entry, DNS_TABLE_SIZE if there is none
+ */
+static u8_t dns_find(const char *name)
+{
+  u8_t i;
+
+  for (i = 0; i < DNS_TABLE_SIZE; ++i)
+  {
+    if ((dns_table[i].state != DNS_STATE_UNUSED)
+        && (strcmp(name, dns_table[i].name) == 0))
+    {
+      break;
+    }
+  }
+  return i;
+}
+
 /**
  * Look up a hostname in the array of known hostnames.
  *
@@ -487,16 +543,16 @@ static u32_t dns_lookup(const char *name)
   }
 #endif /* DNS_LOOKUP_LOCAL_EXTERN */
 
-  /* Walk through name list, return entry if found. If not, return NULL. */
-  for (i = 0; i < DNS_TABLE_SIZE; ++i)
+  /* Walk through name list, return the address of a fresh entry, also while
+   it is refreshed. If not, return IPADDR_NONE. */
+  i = dns_find(name);
+  if ((i < DNS_TABLE_SIZE) && dns_table[i].valid && (dns_table[i].ttl > 0))
   {
-    if ((dns_table[i].state == DNS_STATE_DONE) && (strcmp(name,
-                                                          dns_table[i].name)
-                                                   == 0))
-    {
-      LWIP_DEBUGF(DNS_DEBUG, ("dns_lookup: \"%s\": found = ", name)); ip_addr_debug_print(DNS_DEBUG, &(dns_table[i].ipaddr)); LWIP_DEBUGF(DNS_DEBUG, ("\n"));
-      return ip4_addr_get_u32(&dns_table[i].ipaddr);
-    }
+    LWIP_DEBUGF(DNS_DEBUG, ("dns_lookup: \"%s\": found = ", name)); ip_addr_debug_print(DNS_DEBUG, &(dns_table[i].ipaddr)); LWIP_DEBUGF(DNS_DEBUG, ("\n"));
+    /* the least recently used entry is replaced first */
+    dns_table[i].seqno = dns_seqno++;
+    dns_table[i].used = 1;
+    return ip4_addr_get_u32(&dns_table[i].ipaddr);
   }
 
   return IPADDR_NONE;
@@ -664,12 +720,64 @@ static err_t dns_send(u8_t numdns, const char* name, u8_t id)
   return err;
 }
 
+/**
+ * A query failed: answer the stale address if there is one, else record a
+ * negative entry when the servers told the name does not exist.
+ *
+ * @param pEntry the entry that was queried, pEntry->err holds the DNS error
+ *        code, 0 for a timeout
+ */
+static void dns_fail_entry(struct dns_table_entry *pEntry)
+{
+  dns_found_callback found = pEntry->found;
+
+  pEntry->found = NULL;
+  if (pEntry->err == DNS_FLAG2_ERR_NAME)
+  {
+    pEntry->valid = 0;
+  }
+
+  if (pEntry->valid && (pEntry->keep > 0))
+  {
+    LWIP_DEBUGF(DNS_DEBUG, ("dns_fail_entry: \"%s\": stale\n", pEntry->name));
+    pEntry->state = DNS_STATE_DONE;
+    /* a failed refresh leaves the TTL as it is */
+    if (pEntry->ttl == 0)
+    {
+      pEntry->ttl = LWIP_MIN(DNS_STALE_ANSWER_TTL, pEntry->keep);
+    }
+    if (found)
+    {
+      (*found)(pEntry->name, &pEntry->ipaddr, pEntry->arg);
+    }
+    return;
+  }
+
+  if ((pEntry->err == DNS_FLAG2_ERR_NAME) && (DNS_NEG_TTL > 0))
+  {
+    pEntry->state = DNS_STATE_DONE;
+    pEntry->ttl = pEntry->keep = DNS_NEG_TTL;
+  }
+  else
+  {
+    /* flush this entry */
+    pEntry->state = DNS_STATE_UNUSED;
+  }
+  /* call specified callback function if provided */
+  if (found)
+  {
+    (*found)(pEntry->name, NULL, pEntry->arg);
+  }
+}
+
 /**
  * dns_check_entry() - see if pEntry has not yet been queried and, if so, sends out a query.
  * Check an entry in the dns_table:
  * - send out query for new entries
  * - retry old pending entries on timeout (also with different servers)
- * - remove completed entries from the table if their TTL has expired
+ * - refresh completed entries used since they were resolved before their
+ *   TTL expires
+ * - remove completed entries from the table once they cannot be used
  *
  * @param i index of the dns_table entry to check
  */
@@ -690,6 +798,7 @@ static void dns_check_entry(u8_t i)
       pEntry->numdns = 0;
       pEntry->tmr = 1;
       pEntry->retries = 0;
+      pEntry->err = 0;
 
       /* send DNS packet for this entry */
       err = dns_send(pEntry->numdns, pEntry->name, i);
@@ -703,6 +812,16 @@ static void dns_check_entry(u8_t i)
 
     case DNS_STATE_ASKING:
     {
+      /* a refreshed entry is answered until its TTL expires */
+      if (pEntry->ttl > 0)
+      {
+        pEntry->ttl--;
+      }
+      if (pEntry->keep > 0)
+      {
+        pEntry->keep--;
+      }
+
       if (--pEntry->tmr == 0)
       {
         if (++pEntry->retries == DNS_MAX_RETRIES)
@@ -719,12 +838,7 @@ static void dns_check_entry(u8_t i)
           else
           {
             LWIP_DEBUGF(DNS_DEBUG, ("dns_check_entry: \"%s\": timeout\n", pEntry->name));
-            /* call specified callback function if provided */
-            if (pEntry->found)
-              (*pEntry->found)(pEntry->name, NULL, pEntry->arg);
-            /* flush this entry */
-            pEntry->state = DNS_STATE_UNUSED;
-            pEntry->found = NULL;
+            dns_fail_entry(pEntry);
             break;
           }
         }
@@ -745,8 +859,29 @@ static void dns_check_entry(u8_t i)
 
     case DNS_STATE_DONE:
     {
-      /* if the time to live is nul */
-      if (--pEntry->ttl == 0)
+      if (pEntry->ttl > 0)
+      {
+        pEntry->ttl--;
+      }
+      if (pEntry->keep > 0)
+      {
+        pEntry->keep--;
+      }
+
+      /* only the TTL given by the servers is refreshed, not the time a
+       stale address is answered for after a failure */
+      if (pEntry->valid && pEntry->used && (pEntry->ttl > 0)
+          && (pEntry->ttl <= DNS_REFRESH_MARGIN)
+          && (pEntry->keep > DNS_STALE_TTL))
+      {
+        /* ask again in the background while the address is answered */
+        LWIP_DEBUGF(DNS_DEBUG, ("dns_check_entry: \"%s\": refresh\n", pEntry->name));
+        pEntry->state = DNS_STATE_NEW;
+        pEntry->used = 0;
+        pEntry->found = NULL;
+        dns_check_entry(i);
+      }
+      else if (pEntry->keep == 0)
       {
         LWIP_DEBUGF(DNS_DEBUG, ("dns_check_entry: \"%s\": flush\n", pEntry->name));
         /* flush this entry */
@@ -825,7 +960,6 @@ static void dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
       if (pEntry->state == DNS_STATE_ASKING)
       {
         /* This entry is now completed. */
-        pEntry->state = DNS_STATE_DONE;
         pEntry->err = hdr->flags2 & DNS_FLAG2_ERR_MASK;
 
         /* We only care about the question(s) and the answers. The authrr
@@ -871,18 +1005,25 @@ static void dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
               && (ans.len == PP_HTONS(sizeof(ip_addr_t))))
           {
             /* read the answer resource record's TTL, and maximize it if needed */
+            pEntry->state = DNS_STATE_DONE;
             pEntry->ttl = ntohl(ans.ttl);
             if (pEntry->ttl > DNS_MAX_TTL)
             {
               pEntry->ttl = DNS_MAX_TTL;
             }
+            pEntry->keep = pEntry->ttl + DNS_STALE_TTL;
+            pEntry->valid = 1;
+            pEntry->used = 0;
             /* read the IP address after answer resource record's header */
             SMEMCPY(&(pEntry->ipaddr), (pHostname+SIZEOF_DNS_ANSWER),
                     sizeof(ip_addr_t)); LWIP_DEBUGF(DNS_DEBUG, ("dns_recv: \"%s\": response = ", pEntry->name)); ip_addr_debug_print(DNS_DEBUG, (&(pEntry->ipaddr))); LWIP_DEBUGF(DNS_DEBUG, ("\n"));
             /* call specified callback function if provided */
             if (pEntry->found)
             {
-              (*pEntry->found)(pEntry->name, &pEntry->ipaddr, pEntry->arg);
+              dns_found_callback found = pEntry->found;
+
+              pEntry->found = NULL;
+              (*found)(pEntry->name, &pEntry->ipaddr, pEntry->arg);
             }
             /* deallocate memory and return */
             goto memerr;
@@ -893,7 +1034,8 @@ static void dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
           }
           --nanswers;
         } LWIP_DEBUGF(DNS_DEBUG, ("dns_recv: \"%s\": error in response\n", pEntry->name));
-        /* call callback to indicate error, clean up memory and return */
+        /* no address for this name, cached as if it did not exist */
+        pEntry->err = DNS_FLAG2_ERR_NAME;
         goto responseerr;
       }
     }
@@ -903,14 +1045,9 @@ static void dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
   goto memerr;
 
   responseerr:
-  /* ERROR: call specified callback function with NULL as name to indicate an error */
-  if (pEntry->found)
-  {
-    (*pEntry->found)(pEntry->name, NULL, pEntry->arg);
-  }
-  /* flush this entry */
-  pEntry->state = DNS_STATE_UNUSED;
-  pEntry->found = NULL;
+  /* ERROR: call specified callback function with NULL as name (or the stale
+   address) to indicate an error */
+  dns_fail_entry(pEntry);
 
   memerr:
   /* free pbuf */
@@ -977,6 +1114,10 @@ static err_t dns_enqueue(const char *name, dns_found_callback found,
   /* fill the entry */
   pEntry->state = DNS_STATE_NEW;
   pEntry->seqno = dns_seqno++;
+  pEntry->valid = 0;
+  pEntry->used = 0;
+  pEntry->ttl = 0;
+  pEntry->keep = 0;
   pEntry->found = found;
   pEntry->arg = callback_arg;
   namelen = LWIP_MIN(strlen(name), DNS_MAX_NAME_LENGTH-1);
@@ -1013,6 +1154,8 @@ err_t dns_gethostbyname(const char *hostname, ip_addr_t *addr,
                         dns_found_callback found, void *callback_arg)
 {
   u32_t ipaddr;
+  u8_t i;
+  struct dns_table_entry *pEntry;
   /* not initialized or no valid server yet, or invalid addr pointer
    * or invalid hostname or invalid hostname length */
   if ((dns_pcb == NULL ) || (addr == NULL ) || (!hostname) || (!hostname[0])
@@ -1042,6 +1185,35 @@ err_t dns_gethostbyname(const char *hostname, ip_addr_t *addr,
     return ERR_OK;
   }
 
+  /* a negative, stale or pending entry for this name? */
+  i = dns_find(hostname);
+  if (i < DNS_TABLE_SIZE)
+  {
+    pEntry = &dns_table[i];
+    if (pEntry->state == DNS_STATE_DONE)
+    {
+      if (!pEntry->valid)
+      {
+        LWIP_DEBUGF(DNS_DEBUG, ("dns_gethostbyname: \"%s\": negative\n", hostname));
+        return ERR_VAL;
+      }
+      /* stale: ask again, the address is answered if that fails */
+      pEntry->state = DNS_STATE_NEW;
+      pEntry->seqno = dns_seqno++;
+      pEntry->found = found;
+      pEntry->arg = callback_arg;
+      dns_check_entry(i);
+      return ERR_INPROGRESS;
+    }
+    if (pEntry->found == NULL)
+    {
+      /* wait for the answer of the background refresh */
+      pEntry->found = found;
+      pEntry->arg = callback_arg;
+      return ERR_INPROGRESS;
+    }
+  }
+
   /* queue query with specified callback */
   return dns_enqueue(hostname, found, callback_arg);
 }
@@ -176,6 +176,9 @@ netif_add(struct netif *netif, ip_addr_t *ipaddr, ip_addr_t *netmask,
 #if ENABLE_LOOPBACK && LWIP_LOOPBACK_MAX_PBUFS
   netif->loop_cnt_current = 0;
 #endif /* ENABLE_LOOPBACK && LWIP_LOOPBACK_MAX_PBUFS */
+#if ENABLE_LOOPBACK && LWIP_NETIF_LOOPBACK_MULTITHREADING
+  netif->loop_reschedule = 0;
+#endif /* ENABLE_LOOPBACK && LWIP_NETIF_LOOPBACK_MULTITHREADING */
 
   netif_set_addr(netif, ipaddr, netmask, gw);
 
@@ -634,6 +637,9 @@ netif_loop_output(struct netif *netif, struct pbuf *p,
 #if LWIP_LOOPBACK_MAX_PBUFS
   u8_t clen = 0;
 #endif /* LWIP_LOOPBACK_MAX_PBUFS */
+#if LWIP_NETIF_LOOPBACK_MULTITHREADING
+  u8_t schedule_poll = 0;
+#endif /* LWIP_NETIF_LOOPBACK_MULTITHREADING */
   /* If we have a loopif, SNMP counters are adjusted for it,
    * if not they are adjusted for 'netif'. */
 #if LWIP_SNMP
@@ -697,7 +703,17 @@ netif_loop_output(struct netif *netif, struct pbuf *p,
   {
     netif->loop_first = r;
     netif->loop_last = last;
+#if LWIP_NETIF_LOOPBACK_MULTITHREADING
+    schedule_poll = 1;
+#endif /* LWIP_NETIF_LOOPBACK_MULTITHREADING */
+  }
+#if LWIP_NETIF_LOOPBACK_MULTITHREADING
+  if (netif->loop_reschedule)
+  {
+    netif->loop_reschedule = 0;
+    schedule_poll = 1;
   }
+#endif /* LWIP_NETIF_LOOPBACK_MULTITHREADING */
   SYS_ARCH_UNPROTECT(lev);
 
   LINK_STATS_INC(link.xmit);
@@ -705,8 +721,18 @@ netif_loop_output(struct netif *netif, struct pbuf *p,
   snmp_inc_ifoutucastpkts(stats_if);
 
 #if LWIP_NETIF_LOOPBACK_MULTITHREADING
-  /* For multithreading environment, schedule a call to netif_poll */
-  tcpip_callback((tcpip_callback_fn)netif_poll, netif);
+  /* For multithreading environment, schedule a call to netif_poll, once for
+   the packets queued until it empties the list. Without blocking: this runs
+   on the tcpip thread or with the core locked, which a full mailbox would
+   never drain. If it cannot be posted, the next packet tries again. */
+  if (schedule_poll
+      && (tcpip_callback_with_block((tcpip_callback_fn)netif_poll, netif, 0)
+          != ERR_OK))
+  {
+    SYS_ARCH_PROTECT(lev);
+    netif->loop_reschedule = 1;
+    SYS_ARCH_UNPROTECT(lev);
+  }
 #endif /* LWIP_NETIF_LOOPBACK_MULTITHREADING */
 
   return ERR_OK;
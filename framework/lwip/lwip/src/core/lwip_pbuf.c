@@ -393,6 +393,11 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
   p->ref = 1;
   /* set flags */
   p->flags = 0;
+#ifdef EBUF_LWIP
+  /* pbuf_free() hands it to system_pp_recycle_rx_pkt(), the SDK sets it on
+   the RX pbufs it allocates */
+  p->eb = NULL;
+#endif
   LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_alloc(length=%"U16_F") == %p\n", length, (void *)p));
   return p;
 }
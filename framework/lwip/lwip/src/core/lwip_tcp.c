@@ -53,7 +53,7 @@
 #include "lwip/lwip_debug.h"
 #include "lwip/lwip_stats.h"
 
-#ifdef ESP_RTOS
+#if defined(ESP_RTOS) && !defined(LWIP_HOST)
 #include "freertos.h"
 #endif
 
@@ -1296,6 +1296,75 @@ tcp_seg_copy(struct tcp_seg *seg)
   pbuf_ref(cseg->p);
   return cseg;
 }
+
+/**
+ * Returns a copy of the given received TCP segment, to be put on ooseq.
+ * Unless it is in RAM already, the data and the fixed part of the TCP
+ * header are copied into one PBUF_RAM pbuf, so that the receive buffer of
+ * the WiFi driver holding the segment is given back at once.
+ *
+ * @param seg the received tcp_seg
+ * @return a copy of seg
+ */
+struct tcp_seg *
+tcp_seg_copy_ooseq(struct tcp_seg *seg)
+{
+  struct tcp_seg *cseg;
+  struct pbuf *p;
+
+  if (seg->p->type == PBUF_RAM)
+  {
+    return tcp_seg_copy(seg);
+  }
+
+  p = pbuf_alloc(PBUF_RAW, TCP_HLEN + seg->p->tot_len, PBUF_RAM);
+  if (p == NULL)
+  {
+    return NULL;
+  }
+  cseg = (struct tcp_seg *)memp_malloc(MEMP_TCP_SEG);
+  if (cseg == NULL)
+  {
+    pbuf_free(p);
+    return NULL;
+  }
+  SMEMCPY((u8_t *)cseg, (const u8_t *)seg, sizeof(struct tcp_seg));
+  SMEMCPY(p->payload, seg->tcphdr, TCP_HLEN);
+  pbuf_copy_partial(seg->p, (u8_t *)p->payload + TCP_HLEN, seg->p->tot_len, 0);
+  cseg->tcphdr = (struct tcp_hdr *)p->payload;
+  pbuf_header(p, -TCP_HLEN);
+  cseg->p = p;
+  return cseg;
+}
+
+#if TCP_OOSEQ_MIN_FREE_HEAP
+/**
+ * Frees the out-of-sequence data of all pcbs when the heap runs low.
+ *
+ * @return 1 if the heap is low and nothing should be queued on ooseq
+ */
+u8_t
+tcp_ooseq_reclaim(void)
+{
+  struct tcp_pcb *pcb;
+
+  if (xPortGetFreeHeapSize() >= TCP_OOSEQ_MIN_FREE_HEAP)
+  {
+    return 0;
+  }
+
+  for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next)
+  {
+    if (pcb->ooseq != NULL)
+    {
+      LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_ooseq_reclaim: dropping OOSEQ queued data\n"));
+      tcp_segs_free(pcb->ooseq);
+      pcb->ooseq = NULL;
+    }
+  }
+  return 1;
+}
+#endif /* TCP_OOSEQ_MIN_FREE_HEAP */
 #endif /* TCP_QUEUE_OOSEQ */
 
 #if LWIP_CALLBACK_API
@@ -919,6 +919,33 @@ tcp_oos_insert_segment(struct tcp_seg *cseg, struct tcp_seg *next)
   }
   cseg->next = next;
 }
+
+#if TCP_OOSEQ_GLOBAL_MAX_BYTES
+/**
+ * Count the bytes queued on ooseq by the active pcbs other than pcb
+ *
+ * Called from tcp_receive()
+ */
+static u32_t
+tcp_ooseq_others(struct tcp_pcb *pcb)
+{
+  struct tcp_pcb *other;
+  struct tcp_seg *seg;
+  u32_t len = 0;
+
+  for (other = tcp_active_pcbs; other != NULL; other = other->next)
+  {
+    if (other != pcb)
+    {
+      for (seg = other->ooseq; seg != NULL; seg = seg->next)
+      {
+        len += seg->p->tot_len;
+      }
+    }
+  }
+  return len;
+}
+#endif /* TCP_OOSEQ_GLOBAL_MAX_BYTES */
 #endif /* TCP_QUEUE_OOSEQ */
 
 /**
@@ -945,10 +972,14 @@ static void tcp_receive(struct tcp_pcb *pcb)
   u32_t right_wnd_edge;
   u16_t new_tot_len;
   int found_dupack = 0;
-#if TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS
+#if TCP_QUEUE_OOSEQ
+  u8_t had_ooseq;
+#endif /* TCP_QUEUE_OOSEQ */
+#if TCP_QUEUE_OOSEQ && (TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS)
   u32_t ooseq_blen;
   u16_t ooseq_qlen;
-#endif /* TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS */
+  u32_t ooseq_max;
+#endif /* TCP_QUEUE_OOSEQ && (TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS) */
 
   LWIP_ASSERT("tcp_receive: wrong state", pcb->state >= ESTABLISHED);
 
@@ -1384,6 +1415,7 @@ static void tcp_receive(struct tcp_pcb *pcb)
                       (seqno + tcplen) == (pcb->rcv_nxt + pcb->rcv_wnd));
         }
 #if TCP_QUEUE_OOSEQ
+        had_ooseq = (pcb->ooseq != NULL);
         /* Received in-sequence data, adjust ooseq data if:
          - FIN has been received or
          - inseq overlaps with ooseq */
@@ -1523,6 +1555,15 @@ static void tcp_receive(struct tcp_pcb *pcb)
 #endif /* TCP_QUEUE_OOSEQ */
 
         /* Acknowledge the segment(s). */
+#if TCP_QUEUE_OOSEQ
+        if (had_ooseq)
+        {
+          /* the segment filled (part of) a gap: ack at once so that the
+           sender learns about the next one without waiting (RFC 5681) */
+          tcp_ack_now(pcb);
+        }
+        else
+#endif /* TCP_QUEUE_OOSEQ */
         tcp_ack(pcb);
 
       }
@@ -1531,10 +1572,18 @@ static void tcp_receive(struct tcp_pcb *pcb)
         /* We get here if the incoming segment is out-of-sequence. */
         tcp_send_empty_ack(pcb);
 #if TCP_QUEUE_OOSEQ
+#if TCP_OOSEQ_MIN_FREE_HEAP
+        if (tcp_ooseq_reclaim())
+        {
+          /* the heap runs low, the sender retransmits */
+          LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_receive: heap low, not queued\n"));
+        }
+        else
+#endif /* TCP_OOSEQ_MIN_FREE_HEAP */
         /* We queue the segment on the ->ooseq queue. */
         if (pcb->ooseq == NULL)
         {
-          pcb->ooseq = tcp_seg_copy(&inseg);
+          pcb->ooseq = tcp_seg_copy_ooseq(&inseg);
         }
         else
         {
@@ -1564,7 +1613,7 @@ static void tcp_receive(struct tcp_pcb *pcb)
                 /* The incoming segment is larger than the old
                  segment. We replace some segments with the new
                  one. */
-                cseg = tcp_seg_copy(&inseg);
+                cseg = tcp_seg_copy_ooseq(&inseg);
                 if (cseg != NULL)
                 {
                   if (prev != NULL)
@@ -1597,7 +1646,7 @@ static void tcp_receive(struct tcp_pcb *pcb)
                    than the sequence number of the first segment on the
                    queue. We put the incoming segment first on the
                    queue. */
-                  cseg = tcp_seg_copy(&inseg);
+                  cseg = tcp_seg_copy_ooseq(&inseg);
                   if (cseg != NULL)
                   {
                     pcb->ooseq = cseg;
@@ -1617,7 +1666,7 @@ static void tcp_receive(struct tcp_pcb *pcb)
                    the next segment on ->ooseq. We trim trim the previous
                    segment, delete next segments that included in received segment
                    and trim received, if needed. */
-                  cseg = tcp_seg_copy(&inseg);
+                  cseg = tcp_seg_copy_ooseq(&inseg);
                   if (cseg != NULL)
                   {
                     if (TCP_SEQ_GT(prev->tcphdr->seqno + prev->len, seqno))
@@ -1643,7 +1692,7 @@ static void tcp_receive(struct tcp_pcb *pcb)
                   /* segment "next" already contains all data */
                   break;
                 }
-                next->next = tcp_seg_copy(&inseg);
+                next->next = tcp_seg_copy_ooseq(&inseg);
                 if (next->next != NULL)
                 {
                   if (TCP_SEQ_GT(next->tcphdr->seqno + next->len, seqno))
@@ -1682,6 +1731,12 @@ static void tcp_receive(struct tcp_pcb *pcb)
 #if TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS
         /* Check that the data on ooseq doesn't exceed one of the limits
          and throw away everything above that limit. */
+        ooseq_max = TCP_OOSEQ_MAX_BYTES;
+#if TCP_OOSEQ_GLOBAL_MAX_BYTES
+        ooseq_blen = tcp_ooseq_others(pcb);
+        ooseq_max = LWIP_MIN(ooseq_max, (ooseq_blen < TCP_OOSEQ_GLOBAL_MAX_BYTES)
+            ? TCP_OOSEQ_GLOBAL_MAX_BYTES - ooseq_blen : 0);
+#endif /* TCP_OOSEQ_GLOBAL_MAX_BYTES */
         ooseq_blen = 0;
         ooseq_qlen = 0;
         prev = NULL;
@@ -1690,7 +1745,7 @@ static void tcp_receive(struct tcp_pcb *pcb)
           struct pbuf *p = next->p;
           ooseq_blen += p->tot_len;
           ooseq_qlen += pbuf_clen(p);
-          if ((ooseq_blen > TCP_OOSEQ_MAX_BYTES) ||
+          if ((ooseq_blen > ooseq_max) ||
               (ooseq_qlen > TCP_OOSEQ_MAX_PBUFS))
           {
             /* too much ooseq data, dump this and everything after it */
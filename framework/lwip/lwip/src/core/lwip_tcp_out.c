@@ -1361,6 +1361,9 @@ void tcp_rexmit_rto(struct tcp_pcb *pcb)
 
   /* increment number of retransmissions */
   ++pcb->nrtx;
+#if TCP_STATS
+  ++pcb->rexmit;
+#endif /* TCP_STATS */
 
   /* Don't take any RTT measurements after retransmitting. */
   pcb->rttest = 0;
@@ -1408,6 +1411,9 @@ void tcp_rexmit(struct tcp_pcb *pcb)
 #endif /* TCP_OVERSIZE */
 
   ++pcb->nrtx;
+#if TCP_STATS
+  ++pcb->rexmit;
+#endif /* TCP_STATS */
 
   /* Don't take any rtt measurements after retransmitting. */
   pcb->rttest = 0;
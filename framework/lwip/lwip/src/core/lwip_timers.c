@@ -64,6 +64,44 @@ static struct sys_timeo *next_timeout;
 #if NO_SYS
 static u32_t timeouts_last_time;
 #endif /* NO_SYS */
+#if LWIP_TCPIP_CORE_LOCKING && !NO_SYS
+/* With core locking the API functions run in the application tasks, which
+ add and remove timeouts while the tcpip thread is waiting for the first
+ one. The time it has waited since timeouts_wait_start is then charged to
+ the list first, and a NULL message wakes it up when the first timeout
+ changed so that it does not sleep past it nor fire it early. */
+static u32_t timeouts_wait_start;
+static sys_mbox_t *timeouts_mbox;
+static u8_t timeouts_head_changed;
+
+/* Charge the time waited so far to the first timeout, the core is locked */
+static void
+sys_timeouts_catch_up(void)
+{
+  u32_t now;
+  u32_t diff;
+
+  if ((timeouts_mbox == NULL) || (next_timeout == NULL))
+  {
+    return;
+  }
+  now = sys_now();
+  diff = now - timeouts_wait_start;
+  timeouts_wait_start = now;
+  next_timeout->time = (diff < next_timeout->time) ? next_timeout->time - diff : 0;
+}
+
+static void
+sys_timeouts_wake(void)
+{
+  if (timeouts_mbox != NULL)
+  {
+    timeouts_head_changed = 1;
+    /* a full mailbox wakes the tcpip thread anyway */
+    sys_mbox_trypost(timeouts_mbox, NULL);
+  }
+}
+#endif /* LWIP_TCPIP_CORE_LOCKING && !NO_SYS */
 
 #if LWIP_TCP
 /** global variable that shows if the tcp timer is currently scheduled or not */
@@ -281,9 +319,16 @@ void sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg)
           (void *)timeout, msecs, handler_name, (void *)arg));
 #endif /* LWIP_DEBUG_TIMERNAMES */
 
+#if LWIP_TCPIP_CORE_LOCKING && !NO_SYS
+  sys_timeouts_catch_up();
+#endif /* LWIP_TCPIP_CORE_LOCKING && !NO_SYS */
+
   if (next_timeout == NULL)
   {
     next_timeout = timeout;
+#if LWIP_TCPIP_CORE_LOCKING && !NO_SYS
+    sys_timeouts_wake();
+#endif /* LWIP_TCPIP_CORE_LOCKING && !NO_SYS */
     return;
   }
 
@@ -292,6 +337,9 @@ void sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg)
     next_timeout->time -= msecs;
     timeout->next = next_timeout;
     next_timeout = timeout;
+#if LWIP_TCPIP_CORE_LOCKING && !NO_SYS
+    sys_timeouts_wake();
+#endif /* LWIP_TCPIP_CORE_LOCKING && !NO_SYS */
   }
   else
   {
@@ -331,6 +379,10 @@ void sys_untimeout(sys_timeout_handler handler, void *arg)
     return;
   }
 
+#if LWIP_TCPIP_CORE_LOCKING && !NO_SYS
+  sys_timeouts_catch_up();
+#endif /* LWIP_TCPIP_CORE_LOCKING && !NO_SYS */
+
   for (t = next_timeout, prev_t = NULL ; t != NULL ; prev_t = t, t = t->next)
   {
     if ((t->h == handler) && (t->arg == arg))
@@ -340,6 +392,9 @@ void sys_untimeout(sys_timeout_handler handler, void *arg)
       if (prev_t == NULL)
       {
         next_timeout = t->next;
+#if LWIP_TCPIP_CORE_LOCKING && !NO_SYS
+        sys_timeouts_wake();
+#endif /* LWIP_TCPIP_CORE_LOCKING && !NO_SYS */
       }
       else
       {
@@ -432,6 +487,78 @@ void sys_restart_timeouts(void)
  * @param mbox the mbox to fetch the message from
  * @param msg the place to store the message
  */
+#if LWIP_TCPIP_CORE_LOCKING
+/**
+ * Wait (forever) for a message to arrive in an mbox.
+ * While waiting, timeouts are processed.
+ *
+ * Called and returns with the core locked, the lock is only released while
+ * waiting, so that timeouts added meanwhile by other tasks are seen.
+ *
+ * @param mbox the mbox to fetch the message from
+ * @param msg the place to store the message
+ */
+void
+sys_timeouts_mbox_fetch(sys_mbox_t *mbox, void **msg)
+{
+  u32_t result;
+  u32_t wait;
+  struct sys_timeo *tmptimeout;
+  sys_timeout_handler handler;
+  void *arg;
+
+  while (1)
+  {
+    if ((next_timeout != NULL) && (next_timeout->time == 0))
+    {
+      tmptimeout = next_timeout;
+      next_timeout = tmptimeout->next;
+      handler = tmptimeout->h;
+      arg = tmptimeout->arg;
+#if LWIP_DEBUG_TIMERNAMES
+      if (handler != NULL)
+      {
+        LWIP_DEBUGF(TIMERS_DEBUG, ("stmf calling h=%s arg=%p\n",
+                tmptimeout->handler_name, arg));
+      }
+#endif /* LWIP_DEBUG_TIMERNAMES */
+      memp_free(MEMP_SYS_TIMEOUT, tmptimeout);
+      if (handler != NULL)
+      {
+        handler(arg);
+      }
+      LWIP_TCPIP_THREAD_ALIVE();
+      continue;
+    }
+
+    timeouts_wait_start = sys_now();
+    timeouts_mbox = mbox;
+    timeouts_head_changed = 0;
+    /* read under the lock, other tasks add and remove timeouts once it is
+     released */
+    wait = (next_timeout != NULL) ? next_timeout->time : 0;
+    UNLOCK_TCPIP_CORE();
+    result = sys_arch_mbox_fetch(mbox, msg, wait);
+    LOCK_TCPIP_CORE();
+    sys_timeouts_catch_up();
+    timeouts_mbox = NULL;
+
+    if (result == SYS_ARCH_TIMEOUT)
+    {
+      /* the wait is rounded down to ticks, the first timeout is due unless
+       it was replaced meanwhile */
+      if (!timeouts_head_changed && (next_timeout != NULL))
+      {
+        next_timeout->time = 0;
+      }
+    }
+    else if (*msg != NULL)
+    {
+      return;
+    }
+  }
+}
+#else /* LWIP_TCPIP_CORE_LOCKING */
 void
 sys_timeouts_mbox_fetch(sys_mbox_t *mbox, void **msg)
 {
@@ -502,6 +629,7 @@ sys_timeouts_mbox_fetch(sys_mbox_t *mbox, void **msg)
     }
   }
 }
+#endif /* LWIP_TCPIP_CORE_LOCKING */
 
 #endif /* NO_SYS */
 
@@ -234,6 +234,10 @@ extern "C"
 #if LWIP_LOOPBACK_MAX_PBUFS
       u16_t loop_cnt_current;
 #endif /* LWIP_LOOPBACK_MAX_PBUFS */
+#if LWIP_NETIF_LOOPBACK_MULTITHREADING
+      /* netif_poll() could not be scheduled for the packets on the list */
+      u8_t loop_reschedule;
+#endif /* LWIP_NETIF_LOOPBACK_MULTITHREADING */
 #endif /* ENABLE_LOOPBACK */
 #if LWIP_NETIF_HOSTNAME
       /* the hostname for this netif, NULL is a valid value */
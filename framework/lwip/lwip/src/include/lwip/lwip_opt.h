@@ -1017,6 +1017,24 @@
 #define TCP_OOSEQ_MAX_PBUFS             0
 #endif
 
+/**
+ * TCP_OOSEQ_GLOBAL_MAX_BYTES: The maximum number of bytes queued on ooseq by
+ * all pcbs together, the pcbs that queued first keep their data.
+ * Default is 0 (no limit). Needs TCP_OOSEQ_MAX_BYTES.
+ */
+#ifndef TCP_OOSEQ_GLOBAL_MAX_BYTES
+#define TCP_OOSEQ_GLOBAL_MAX_BYTES      0
+#endif
+
+/**
+ * TCP_OOSEQ_MIN_FREE_HEAP: Below this many free bytes of heap, nothing is
+ * queued on ooseq and the ooseq data of all pcbs is freed.
+ * Default is 0 (no check).
+ */
+#ifndef TCP_OOSEQ_MIN_FREE_HEAP
+#define TCP_OOSEQ_MIN_FREE_HEAP         0
+#endif
+
 /**
  * TCP_LISTEN_BACKLOG: Enable the backlog option for tcp listen pcb.
  */
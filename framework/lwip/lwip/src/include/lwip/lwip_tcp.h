@@ -229,6 +229,9 @@ extern "C"
       u16_t snd_wnd_max; /* the maximum sender window announced by the remote host */
 
       u16_t acked;
+#if TCP_STATS
+      u16_t rexmit; /* retransmission timeouts and fast retransmits */
+#endif /* TCP_STATS */
 
       u16_t snd_buf; /* Available buffer space for sending (in bytes). */
 #define TCP_SNDQUEUELEN_OVERFLOW (0xffffU-3)
@@ -415,6 +415,12 @@ extern "C"
   void tcp_segs_free(struct tcp_seg *seg);
   void tcp_seg_free(struct tcp_seg *seg);
   struct tcp_seg *tcp_seg_copy(struct tcp_seg *seg);
+#if TCP_QUEUE_OOSEQ
+  struct tcp_seg *tcp_seg_copy_ooseq(struct tcp_seg *seg);
+#if TCP_OOSEQ_MIN_FREE_HEAP
+  u8_t tcp_ooseq_reclaim(void);
+#endif /* TCP_OOSEQ_MIN_FREE_HEAP */
+#endif /* TCP_QUEUE_OOSEQ */
 
 #define tcp_ack(pcb)                               \
   do {                                             \
@@ -169,6 +169,28 @@ extern "C"
 }
 #endif
 
+#elif defined(LWIP_HOST) /* !NO_SYS */
+
+#include "lwip/lwip_pbuf.h"
+#include "lwip/lwip_sys.h"
+#include "lwip/lwip_timers.h"
+#include "lwip/lwip_netif.h"
+
+/* The host programs have no tcpip thread, lwip_host.c queues the messages
+ and runs them from its millisecond step, see lwip_host.h */
+typedef void (*tcpip_callback_fn)(void *ctx);
+
+struct tcpip_callback_msg;
+
+err_t tcpip_input(struct pbuf *p, struct netif *inp);
+
+err_t tcpip_callback_with_block(tcpip_callback_fn function, void *ctx, u8_t block);
+#define tcpip_callback(f, ctx)              tcpip_callback_with_block(f, ctx, 1)
+
+struct tcpip_callback_msg* tcpip_callbackmsg_new(tcpip_callback_fn function, void *ctx);
+void tcpip_callbackmsg_delete(struct tcpip_callback_msg* msg);
+err_t tcpip_trycallback(struct tcpip_callback_msg* msg);
+
 #endif /* !NO_SYS */
 
 #endif /* __LWIP_TCPIP_H__ */
@@ -0,0 +1,655 @@
+/* Network benchmark service, see lwip_bench.h.
+
+ Replaces the netio server and the ping sender of the SDK sources
+ (lwip/sdk/lwip_netio.c, lwip_ping.c), which were never built: the TCP part
+ keeps the command framing of netio, the ICMP part the echo exchange of the
+ ping sender, timed with the FRC2 counter instead of the 10 ms tick.
+ */
+#include "lwip/lwip_opt.h"
+
+#if LWIP_TCP && LWIP_UDP && LWIP_RAW
+
+#include "lwip/lwip_def.h"
+#include "lwip/lwip_icmp.h"
+#include "lwip/lwip_inet_chksum.h"
+#include "lwip/lwip_ip.h"
+#include "lwip/lwip_mem.h"
+#include "lwip/lwip_raw.h"
+#include "lwip/lwip_sys.h"
+#include "lwip/lwip_tcp.h"
+#include "lwip/lwip_tcpip.h"
+#include "lwip/lwip_timers.h"
+#include "lwip/lwip_udp.h"
+#include "lwip_bench.h"
+#include "hal_hrtimer.h"
+
+#include <string.h>
+
+#define BENCH_HDR_LEN           8
+#define BENCH_PING_ID           0xBE4C
+#define BENCH_PING_DATA         32
+#define BENCH_IDLE_CHECK_MS     10000
+
+#define BENCH_TCP_CMD           0
+#define BENCH_TCP_SINK          1
+#define BENCH_TCP_SOURCE        2
+
+struct bench_conn
+{
+  struct bench_conn *next;
+  struct tcp_pcb *pcb;
+  u8_t state;
+  u8_t hdr_len;
+  u8_t hdr[BENCH_HDR_LEN];
+  u32_t len;
+  u32_t done;
+  /* FRC2 count of the first byte */
+  u32_t start;
+};
+
+struct bench_ping
+{
+  struct raw_pcb *pcb;
+  ip_addr_t target;
+  u16_t seq;
+  u16_t left;
+  /* FRC2 count when the pending request was sent, 0 once answered */
+  u32_t sent_at;
+  u32_t total_us;
+  bench_ping_report_t report;
+};
+
+struct bench
+{
+  struct tcp_pcb *listen;
+  struct udp_pcb *udp;
+  struct bench_conn *conns;
+  u32_t last_active;
+  /* flood counters */
+  u32_t received;
+  u32_t bytes;
+  u32_t next_seq;
+  u32_t late;
+  u32_t first;
+  u32_t last;
+  struct bench_ping ping;
+};
+
+static struct bench bench;
+
+/* Payload of BENCH_CMD_S2C, never written so it needs no copy */
+static const u8_t bench_pattern[BENCH_CHUNK];
+
+static void bench_stop(void *arg);
+
+static u32_t bench_get_u32(const u8_t *data)
+{
+  return ((u32_t)data[0] << 24) | ((u32_t)data[1] << 16)
+      | ((u32_t)data[2] << 8) | data[3];
+}
+
+static u32_t bench_elapsed_us(u32_t start)
+{
+  return HAL_HRTIMER_CountToUs(HAL_HRTIMER_GetCount() - start);
+}
+
+static void bench_udp_send(struct udp_pcb *pcb, ip_addr_t *addr, u16_t port,
+                           const void *data, u16_t len)
+{
+  struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+
+  if (p == NULL)
+  {
+    return;
+  }
+  pbuf_take(p, data, len);
+  udp_sendto(pcb, p, addr, port);
+  pbuf_free(p);
+}
+
+/* Reports are sent as arrays of big endian words */
+static void bench_hton(u32_t *words, u16_t count)
+{
+  u16_t i;
+
+  for (i = 0; i < count; i++)
+  {
+    words[i] = htonl(words[i]);
+  }
+}
+
+/* ------------------------------------------------------------------------ */
+/* TCP */
+
+static err_t bench_tcp_close(struct bench_conn *conn)
+{
+  struct tcp_pcb *pcb = conn->pcb;
+  struct bench_conn **pp;
+
+  for (pp = &bench.conns; *pp != NULL; pp = &(*pp)->next)
+  {
+    if (*pp == conn)
+    {
+      *pp = conn->next;
+      break;
+    }
+  }
+  mem_free(conn);
+
+  tcp_arg(pcb, NULL);
+  tcp_recv(pcb, NULL);
+  tcp_sent(pcb, NULL);
+  tcp_poll(pcb, NULL, 0);
+  tcp_err(pcb, NULL);
+  if (tcp_close(pcb) != ERR_OK)
+  {
+    tcp_abort(pcb);
+    return ERR_ABRT;
+  }
+  return ERR_OK;
+}
+
+static void bench_tcp_send(struct bench_conn *conn)
+{
+  struct tcp_pcb *pcb = conn->pcb;
+  u16_t len;
+
+  while (conn->done < conn->len)
+  {
+    len = LWIP_MIN(tcp_sndbuf(pcb), BENCH_CHUNK);
+    len = (u16_t)LWIP_MIN(len, conn->len - conn->done);
+    if ((len == 0) || (tcp_write(pcb, bench_pattern, len,
+        (conn->done + len < conn->len) ? TCP_WRITE_FLAG_MORE : 0) != ERR_OK))
+    {
+      /* queue full, bench_tcp_sent() continues */
+      break;
+    }
+    conn->done += len;
+  }
+  if (conn->done == conn->len)
+  {
+    conn->state = BENCH_TCP_CMD;
+  }
+  tcp_output(pcb);
+}
+
+static void bench_tcp_result(struct bench_conn *conn)
+{
+  u32_t result[2];
+
+  result[0] = htonl(conn->done);
+  result[1] = htonl((conn->done != 0) ? bench_elapsed_us(conn->start) : 0);
+  tcp_write(conn->pcb, result, sizeof(result), TCP_WRITE_FLAG_COPY);
+  tcp_output(conn->pcb);
+  conn->state = BENCH_TCP_CMD;
+}
+
+/* Returns ERR_CLSD or ERR_ABRT when the connection is gone */
+static err_t bench_tcp_command(struct bench_conn *conn)
+{
+  u32_t cmd = bench_get_u32(conn->hdr);
+  err_t err;
+
+  conn->hdr_len = 0;
+  conn->len = bench_get_u32(conn->hdr + 4);
+  conn->done = 0;
+  switch (cmd)
+  {
+    case BENCH_CMD_C2S:
+      conn->state = BENCH_TCP_SINK;
+      if (conn->len == 0)
+      {
+        bench_tcp_result(conn);
+      }
+      return ERR_OK;
+
+    case BENCH_CMD_S2C:
+      conn->state = BENCH_TCP_SOURCE;
+      bench_tcp_send(conn);
+      return ERR_OK;
+
+    default:
+      err = bench_tcp_close(conn);
+      return (err == ERR_OK) ? ERR_CLSD : err;
+  }
+}
+
+static err_t bench_tcp_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p,
+                            err_t err)
+{
+  struct bench_conn *conn = (struct bench_conn *)arg;
+  struct pbuf *q;
+  const u8_t *data;
+  u16_t off;
+  u16_t len;
+
+  if (p == NULL)
+  {
+    return bench_tcp_close(conn);
+  }
+  if (err != ERR_OK)
+  {
+    pbuf_free(p);
+    return err;
+  }
+
+  bench.last_active = sys_now();
+  tcp_recved(pcb, p->tot_len);
+  for (q = p; q != NULL; q = q->next)
+  {
+    data = (const u8_t *)q->payload;
+    for (off = 0; off < q->len; off += len)
+    {
+      if (conn->state == BENCH_TCP_SINK)
+      {
+        if (conn->done == 0)
+        {
+          conn->start = HAL_HRTIMER_GetCount();
+        }
+        len = (u16_t)LWIP_MIN((u32_t)(q->len - off), conn->len - conn->done);
+        conn->done += len;
+        if (conn->done == conn->len)
+        {
+          bench_tcp_result(conn);
+        }
+      }
+      else if (conn->state == BENCH_TCP_CMD)
+      {
+        len = 1;
+        conn->hdr[conn->hdr_len++] = data[off];
+        if (conn->hdr_len == BENCH_HDR_LEN)
+        {
+          err = bench_tcp_command(conn);
+          if (err != ERR_OK)
+          {
+            pbuf_free(p);
+            return (err == ERR_ABRT) ? ERR_ABRT : ERR_OK;
+          }
+        }
+      }
+      else
+      {
+        /* nothing is expected while sending */
+        len = q->len - off;
+      }
+    }
+  }
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static err_t bench_tcp_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+  struct bench_conn *conn = (struct bench_conn *)arg;
+
+  LWIP_UNUSED_ARG(pcb);
+  LWIP_UNUSED_ARG(len);
+
+  if (conn->state == BENCH_TCP_SOURCE)
+  {
+    bench.last_active = sys_now();
+    bench_tcp_send(conn);
+  }
+  return ERR_OK;
+}
+
+static err_t bench_tcp_poll(void *arg, struct tcp_pcb *pcb)
+{
+  struct bench_conn *conn = (struct bench_conn *)arg;
+
+  LWIP_UNUSED_ARG(pcb);
+
+  /* retry a tcp_write() that failed for lack of memory */
+  if (conn->state == BENCH_TCP_SOURCE)
+  {
+    bench_tcp_send(conn);
+  }
+  return ERR_OK;
+}
+
+static void bench_tcp_err(void *arg, err_t err)
+{
+  struct bench_conn *conn = (struct bench_conn *)arg;
+  struct bench_conn **pp;
+
+  LWIP_UNUSED_ARG(err);
+
+  /* the pcb is already freed */
+  for (pp = &bench.conns; *pp != NULL; pp = &(*pp)->next)
+  {
+    if (*pp == conn)
+    {
+      *pp = conn->next;
+      break;
+    }
+  }
+  mem_free(conn);
+}
+
+static err_t bench_tcp_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+  struct bench_conn *conn;
+
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+
+  tcp_accepted(bench.listen);
+  conn = (struct bench_conn *)mem_malloc(sizeof(struct bench_conn));
+  if (conn == NULL)
+  {
+    return ERR_MEM;
+  }
+  memset(conn, 0, sizeof(struct bench_conn));
+  conn->pcb = pcb;
+  conn->next = bench.conns;
+  bench.conns = conn;
+  bench.last_active = sys_now();
+
+  tcp_arg(pcb, conn);
+  tcp_recv(pcb, bench_tcp_recv);
+  tcp_sent(pcb, bench_tcp_sent);
+  tcp_poll(pcb, bench_tcp_poll, 2);
+  tcp_err(pcb, bench_tcp_err);
+  return ERR_OK;
+}
+
+/* ------------------------------------------------------------------------ */
+/* ICMP */
+
+static void bench_ping_send(void *arg)
+{
+  struct bench_ping *ping = &bench.ping;
+  struct icmp_echo_hdr *iecho;
+  struct pbuf *p;
+  u16_t len = sizeof(struct icmp_echo_hdr) + BENCH_PING_DATA;
+
+  LWIP_UNUSED_ARG(arg);
+
+  if (ping->left == 0)
+  {
+    return;
+  }
+  ping->left--;
+  ping->seq++;
+
+  p = pbuf_alloc(PBUF_IP, len, PBUF_RAM);
+  if (p == NULL)
+  {
+    sys_timeout(BENCH_PING_INTERVAL_MS, bench_ping_send, NULL);
+    return;
+  }
+  iecho = (struct icmp_echo_hdr *)p->payload;
+  ICMPH_TYPE_SET(iecho, ICMP_ECHO);
+  ICMPH_CODE_SET(iecho, 0);
+  iecho->id = htons(BENCH_PING_ID);
+  iecho->seqno = htons(ping->seq);
+  memset((u8_t *)iecho + sizeof(struct icmp_echo_hdr), 0, BENCH_PING_DATA);
+  iecho->chksum = 0;
+  iecho->chksum = inet_chksum(iecho, len);
+
+  ping->report.sent++;
+  ping->sent_at = HAL_HRTIMER_GetCount();
+  raw_sendto(ping->pcb, p, &ping->target);
+  pbuf_free(p);
+
+  sys_timeout(BENCH_PING_INTERVAL_MS, bench_ping_send, NULL);
+}
+
+static u8_t bench_ping_recv(void *arg, struct raw_pcb *pcb, struct pbuf *p,
+                            ip_addr_t *addr)
+{
+  struct bench_ping *ping = &bench.ping;
+  struct icmp_echo_hdr iecho;
+  u16_t hlen = IPH_HL((struct ip_hdr *)p->payload) * 4;
+  u32_t us;
+  u8_t i;
+
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(pcb);
+
+  if ((pbuf_copy_partial(p, &iecho, sizeof(iecho), hlen) != sizeof(iecho))
+      || (ICMPH_TYPE(&iecho) != ICMP_ER)
+      || (iecho.id != htons(BENCH_PING_ID))
+      || !ip_addr_cmp(addr, &ping->target))
+  {
+    /* not ours */
+    return 0;
+  }
+
+  if ((iecho.seqno == htons(ping->seq)) && (ping->sent_at != 0))
+  {
+    us = bench_elapsed_us(ping->sent_at);
+    ping->sent_at = 0;
+    ping->report.received++;
+    ping->total_us += us;
+    ping->report.min_us = LWIP_MIN(ping->report.min_us, us);
+    ping->report.max_us = LWIP_MAX(ping->report.max_us, us);
+    for (i = 0; (i < BENCH_HIST_BUCKETS - 1)
+        && (us >= ((u32_t)BENCH_HIST_MIN_US << i)); i++)
+    {
+    }
+    ping->report.hist[i]++;
+  }
+  pbuf_free(p);
+  return 1;
+}
+
+static void bench_ping_start(ip_addr_t *addr, u32_t count)
+{
+  struct bench_ping *ping = &bench.ping;
+
+  if (ping->pcb == NULL)
+  {
+    ping->pcb = raw_new(IP_PROTO_ICMP);
+    if (ping->pcb == NULL)
+    {
+      return;
+    }
+    raw_recv(ping->pcb, bench_ping_recv, NULL);
+  }
+  sys_untimeout(bench_ping_send, NULL);
+  memset(&ping->report, 0, sizeof(ping->report));
+  ping->report.min_us = 0xFFFFFFFF;
+  ping->total_us = 0;
+  ping->sent_at = 0;
+  ip_addr_copy(ping->target, *addr);
+  ping->left = (u16_t)LWIP_MIN(count, 0xFFFF);
+  bench_ping_send(NULL);
+}
+
+/* ------------------------------------------------------------------------ */
+/* UDP */
+
+static void bench_udp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                           ip_addr_t *addr, u16_t port)
+{
+  bench_flood_report_t flood;
+  bench_ping_report_t ping;
+  struct pbuf *q;
+  u32_t hdr[2];
+  u32_t seq;
+
+  LWIP_UNUSED_ARG(arg);
+
+  if (pbuf_copy_partial(p, hdr, sizeof(hdr), 0) != sizeof(hdr))
+  {
+    pbuf_free(p);
+    return;
+  }
+  seq = ntohl(hdr[1]);
+  bench.last_active = sys_now();
+
+  switch (ntohl(hdr[0]))
+  {
+    case BENCH_UDP_FLOOD:
+      bench.last = HAL_HRTIMER_GetCount();
+      if (bench.received == 0)
+      {
+        bench.first = bench.last;
+      }
+      bench.received++;
+      bench.bytes += p->tot_len;
+      if (seq >= bench.next_seq)
+      {
+        bench.next_seq = seq + 1;
+      }
+      else
+      {
+        bench.late++;
+      }
+      break;
+
+    case BENCH_UDP_ECHO:
+      /* received pbufs belong to the WiFi driver, answer with a copy */
+      q = pbuf_alloc(PBUF_TRANSPORT, p->tot_len, PBUF_RAM);
+      if (q != NULL)
+      {
+        pbuf_copy(q, p);
+        udp_sendto(pcb, q, addr, port);
+        pbuf_free(q);
+      }
+      break;
+
+    case BENCH_UDP_REPORT:
+      flood.type = BENCH_UDP_REPORT;
+      flood.seq = seq;
+      flood.received = bench.received;
+      flood.bytes = bench.bytes;
+      flood.lost = (bench.next_seq > bench.received)
+          ? bench.next_seq - bench.received : 0;
+      flood.late = bench.late;
+      flood.us = HAL_HRTIMER_CountToUs(bench.last - bench.first);
+      bench_hton((u32_t *)&flood, sizeof(flood) / sizeof(u32_t));
+      bench_udp_send(pcb, addr, port, &flood, sizeof(flood));
+      bench.received = 0;
+      bench.bytes = 0;
+      bench.next_seq = 0;
+      bench.late = 0;
+      break;
+
+    case BENCH_UDP_PING:
+      bench_ping_start(addr, seq);
+      bench_udp_send(pcb, addr, port, hdr, sizeof(hdr));
+      break;
+
+    case BENCH_UDP_PING_REPORT:
+      ping = bench.ping.report;
+      ping.type = BENCH_UDP_PING_REPORT;
+      ping.seq = seq;
+      if (ping.received == 0)
+      {
+        ping.min_us = 0;
+      }
+      ping.avg_us = (ping.received != 0) ? bench.ping.total_us / ping.received
+                                         : 0;
+      bench_hton((u32_t *)&ping, sizeof(ping) / sizeof(u32_t));
+      bench_udp_send(pcb, addr, port, &ping, sizeof(ping));
+      break;
+
+    default:
+      break;
+  }
+  pbuf_free(p);
+}
+
+/* ------------------------------------------------------------------------ */
+
+static void bench_idle(void *arg)
+{
+  LWIP_UNUSED_ARG(arg);
+
+  if ((bench.conns == NULL) && (bench.ping.left == 0)
+      && (sys_now() - bench.last_active > BENCH_IDLE_MS))
+  {
+    LWIP_DEBUGF(LWIP_DBG_ON, ("bench: idle, stopped\n"));
+    bench_stop(NULL);
+    return;
+  }
+  sys_timeout(BENCH_IDLE_CHECK_MS, bench_idle, NULL);
+}
+
+static void bench_start(void *arg)
+{
+  struct tcp_pcb *pcb;
+
+  LWIP_UNUSED_ARG(arg);
+
+  bench.last_active = sys_now();
+  if (bench.listen != NULL)
+  {
+    return;
+  }
+
+  pcb = tcp_new();
+  if ((pcb == NULL) || (tcp_bind(pcb, IP_ADDR_ANY, BENCH_PORT) != ERR_OK))
+  {
+    goto fail;
+  }
+  bench.listen = tcp_listen(pcb);
+  if (bench.listen == NULL)
+  {
+    goto fail;
+  }
+  pcb = NULL;
+  tcp_accept(bench.listen, bench_tcp_accept);
+
+  bench.udp = udp_new();
+  if ((bench.udp == NULL)
+      || (udp_bind(bench.udp, IP_ADDR_ANY, BENCH_PORT) != ERR_OK))
+  {
+    goto fail;
+  }
+  udp_recv(bench.udp, bench_udp_recv, NULL);
+
+  sys_timeout(BENCH_IDLE_CHECK_MS, bench_idle, NULL);
+  return;
+
+fail:
+  if (pcb != NULL)
+  {
+    tcp_close(pcb);
+  }
+  bench_stop(NULL);
+}
+
+static void bench_stop(void *arg)
+{
+  LWIP_UNUSED_ARG(arg);
+
+  sys_untimeout(bench_idle, NULL);
+  sys_untimeout(bench_ping_send, NULL);
+  bench.ping.left = 0;
+
+  while (bench.conns != NULL)
+  {
+    bench_tcp_close(bench.conns);
+  }
+  if (bench.listen != NULL)
+  {
+    tcp_close(bench.listen);
+    bench.listen = NULL;
+  }
+  if (bench.udp != NULL)
+  {
+    udp_remove(bench.udp);
+    bench.udp = NULL;
+  }
+  if (bench.ping.pcb != NULL)
+  {
+    raw_remove(bench.ping.pcb);
+    bench.ping.pcb = NULL;
+  }
+}
+
+err_t lwip_bench_start(void)
+{
+  /* non-blocking, the caller may be the tcpip thread itself (httpd CGI) */
+  return tcpip_callback_with_block(bench_start, NULL, 0);
+}
+
+err_t lwip_bench_stop(void)
+{
+  return tcpip_callback_with_block(bench_stop, NULL, 0);
+}
+
+#endif /* LWIP_TCP && LWIP_UDP && LWIP_RAW */
@@ -0,0 +1,272 @@
+/*
+ * Checksum test and benchmark, a host program ("make chksumtest")
+ *
+ * lwip_esp_chksum() and lwip_esp_chksum_copy() are compared with a byte by
+ * byte sum of RFC 1071, and so is the generic code of lwip_inet_chksum.c,
+ * built beside them with LWIP_ESP_CHKSUM=0 and reached through
+ * inet_chksum() and lwip_chksum_copy(). The cases are every length up to
+ * 256 bytes, random ones up to 64 KiB, each of the four alignments of the
+ * source and of the destination, and data of all ones, where the sums are
+ * largest. The copies must also leave the bytes around the destination alone.
+ *
+ * Both versions are then timed over the same random lengths and alignments,
+ * in bytes per TSC tick (per nanosecond without a TSC), the fastest of
+ * CHKSUM_ROUNDS. The host is not the LX106, the figures compare the two
+ * versions on a 32 bit load and add machine and nothing more.
+ */
+#if defined(LWIP_HOST)
+
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_inet_chksum.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CHKSUM_UNIT     "TSC tick"
+#else
+#include <time.h>
+#define CHKSUM_UNIT     "ns"
+#endif
+
+#if !LWIP_ESP_CHKSUM
+#error "chksumtest needs lwip_esp_chksum.c, LWIP_ESP_CHKSUM=1"
+#endif
+
+/* Random cases after the lengths up to CHKSUM_SHORT */
+#define CHKSUM_CASES    20000
+#define CHKSUM_SHORT    256
+/* Room for the longest length and the alignments, plus guard bytes */
+#define CHKSUM_BUF_LEN  (0x10000 + 16)
+#define CHKSUM_GUARD    0xA5
+/* Segments timed per round, up to a TCP_MSS long, and rounds */
+#define CHKSUM_BENCH    4096
+#define CHKSUM_ROUNDS   16
+
+/* inet_chksum.c built with LWIP_ESP_CHKSUM=0, see the Makefile */
+u16_t lwip_chksum_copy(void *dst, const void *src, u16_t len);
+
+typedef struct
+{
+    u16_t len;
+    u8_t src_off;
+    u8_t dst_off;
+} chksum_case_t;
+
+static u8_t chksum_src[CHKSUM_BUF_LEN];
+static u8_t chksum_dst[CHKSUM_BUF_LEN];
+static u8_t chksum_ref_dst[CHKSUM_BUF_LEN];
+static chksum_case_t chksum_bench[CHKSUM_BENCH];
+static uint32_t chksum_rng = 0x2545F491;
+static unsigned long chksum_failures;
+
+/* xorshift32, the same cases on every run */
+static uint32_t chksum_rand(void)
+{
+  chksum_rng ^= chksum_rng << 13;
+  chksum_rng ^= chksum_rng >> 17;
+  chksum_rng ^= chksum_rng << 5;
+  return chksum_rng;
+}
+
+static uint32_t chksum_now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return (uint32_t)__rdtsc();
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000000UL + ts.tv_nsec);
+#endif
+}
+
+/* RFC 1071, in the byte order of LWIP_CHKSUM: the bytes at even offsets
+ from the start are the low halves of the 16 bit words on this host */
+static u16_t chksum_ref(const u8_t *data, u32_t len)
+{
+  u32_t sum = 0;
+  u32_t i;
+
+  for (i = 0; i < len; i++)
+  {
+    sum += (i & 1) ? ((u32_t)data[i] << 8) : data[i];
+  }
+  while (sum >> 16)
+  {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return (u16_t)sum;
+}
+
+static void chksum_fail(const char *name, u16_t len, u8_t src_off,
+                        u8_t dst_off, u16_t got, u16_t want)
+{
+  if (chksum_failures++ < 10)
+  {
+    printf("chksumtest: %s, %u bytes at +%u to +%u: 0x%04x instead of "
+           "0x%04x\n", name, len, src_off, dst_off, got, want);
+  }
+}
+
+/* The sums of the four functions, and the copies, against chksum_ref() */
+static void chksum_check(u16_t len, u8_t src_off, u8_t dst_off)
+{
+  const u8_t *src = chksum_src + src_off;
+  u16_t want = chksum_ref(src, len);
+  u16_t got;
+
+  got = lwip_esp_chksum((void *)src, len);
+  if (got != want)
+  {
+    chksum_fail("lwip_esp_chksum", len, src_off, 0, got, want);
+  }
+  got = (u16_t)~inet_chksum((void *)src, len);
+  if (got != want)
+  {
+    chksum_fail("generic inet_chksum", len, src_off, 0, got, want);
+  }
+
+  /* guard bytes around the destination must stay */
+  memset(chksum_dst, CHKSUM_GUARD, len + 8);
+  memset(chksum_ref_dst, CHKSUM_GUARD, len + 8);
+  memcpy(chksum_ref_dst + dst_off, src, len);
+  got = lwip_esp_chksum_copy(chksum_dst + dst_off, src, len);
+  if (got != want || memcmp(chksum_dst, chksum_ref_dst, len + 8) != 0)
+  {
+    chksum_fail("lwip_esp_chksum_copy", len, src_off, dst_off, got, want);
+  }
+  memset(chksum_dst, CHKSUM_GUARD, len + 8);
+  got = lwip_chksum_copy(chksum_dst + dst_off, src, len);
+  if (got != want || memcmp(chksum_dst, chksum_ref_dst, len + 8) != 0)
+  {
+    chksum_fail("generic lwip_chksum_copy", len, src_off, dst_off, got,
+                want);
+  }
+}
+
+static void chksum_test(void)
+{
+  unsigned long cases = 0;
+  u32_t len;
+  u8_t src_off;
+  u8_t dst_off;
+  int i;
+
+  for (i = 0; i < CHKSUM_BUF_LEN; i++)
+  {
+    chksum_src[i] = (u8_t)chksum_rand();
+  }
+  for (len = 0; len <= CHKSUM_SHORT; len++)
+  {
+    for (src_off = 0; src_off < 4; src_off++)
+    {
+      for (dst_off = 0; dst_off < 4; dst_off++, cases++)
+      {
+        chksum_check((u16_t)len, src_off, dst_off);
+      }
+    }
+  }
+  for (i = 0; i < CHKSUM_CASES; i++, cases++)
+  {
+    len = chksum_rand() & 0xffff;
+    chksum_check((u16_t)len, chksum_rand() & 3, chksum_rand() & 3);
+  }
+
+  /* all ones: the largest sums, carries in every word */
+  memset(chksum_src, 0xff, CHKSUM_BUF_LEN);
+  for (src_off = 0; src_off < 4; src_off++)
+  {
+    for (dst_off = 0; dst_off < 4; dst_off++, cases += 2)
+    {
+      chksum_check(0xffff, src_off, dst_off);
+      chksum_check(0xfffe, src_off, dst_off);
+    }
+  }
+  printf("  %-26s %8lu cases, %lu failed\n", "checksums and copies", cases,
+         chksum_failures);
+}
+
+/* Bytes per tick of 'run' over chksum_bench[], the fastest round */
+static void chksum_time(const char *name,
+                        u16_t (*run)(const chksum_case_t *c))
+{
+  const chksum_case_t *c;
+  unsigned long bytes = 0;
+  uint32_t best = UINT32_MAX;
+  uint32_t start;
+  uint32_t ticks;
+  volatile u16_t sink = 0;
+  int round;
+
+  for (c = chksum_bench; c < chksum_bench + CHKSUM_BENCH; c++)
+  {
+    bytes += c->len;
+  }
+  /* the first round warms the cache up */
+  for (round = 0; round <= CHKSUM_ROUNDS; round++)
+  {
+    start = chksum_now();
+    for (c = chksum_bench; c < chksum_bench + CHKSUM_BENCH; c++)
+    {
+      sink += run(c);
+    }
+    ticks = chksum_now() - start;
+    if (round > 0 && ticks < best)
+    {
+      best = ticks;
+    }
+  }
+  (void)sink;
+  printf("  %-26s %5lu.%02lu bytes/%s\n", name, bytes / best,
+         bytes % best * 100 / best, CHKSUM_UNIT);
+}
+
+static u16_t chksum_run_esp(const chksum_case_t *c)
+{
+  return lwip_esp_chksum(chksum_src + c->src_off, c->len);
+}
+
+static u16_t chksum_run_generic(const chksum_case_t *c)
+{
+  return inet_chksum(chksum_src + c->src_off, c->len);
+}
+
+static u16_t chksum_run_esp_copy(const chksum_case_t *c)
+{
+  return lwip_esp_chksum_copy(chksum_dst + c->dst_off,
+                              chksum_src + c->src_off, c->len);
+}
+
+static u16_t chksum_run_generic_copy(const chksum_case_t *c)
+{
+  return lwip_chksum_copy(chksum_dst + c->dst_off, chksum_src + c->src_off,
+                          c->len);
+}
+
+static void chksum_benchmark(void)
+{
+  chksum_case_t *c;
+
+  for (c = chksum_bench; c < chksum_bench + CHKSUM_BENCH; c++)
+  {
+    c->len = 1 + chksum_rand() % TCP_MSS;
+    c->src_off = chksum_rand() & 3;
+    c->dst_off = chksum_rand() & 3;
+  }
+  chksum_time("lwip_esp_chksum", chksum_run_esp);
+  chksum_time("generic", chksum_run_generic);
+  chksum_time("lwip_esp_chksum_copy", chksum_run_esp_copy);
+  chksum_time("generic copy", chksum_run_generic_copy);
+}
+
+int main(void)
+{
+  chksum_test();
+  chksum_benchmark();
+  return (chksum_failures == 0) ? 0 : 1;
+}
+
+#endif /* LWIP_HOST */
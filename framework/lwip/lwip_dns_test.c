@@ -0,0 +1,539 @@
+/*
+ * DNS cache test, a host program ("make dnstest")
+ *
+ * The resolver of lwip_dns.c runs on the host port of the core (lwip_host.h)
+ * against a stand-in server: a tap on the segment of the device that answers
+ * ARP and the A queries of its names, NXDOMAIN, or nothing at all. The
+ * segment has a round trip of DNS_TEST_RTT ms.
+ *
+ * The test checks the cache on the simulated clock: answers from the table
+ * while the TTL runs, the background refresh of the names looked up, the
+ * query again of the others, the stale address once the servers time out,
+ * the negative entries and the least recently used replacement.
+ *
+ * The scenario then reconnects the MQTT client, the OTA check and SNTP every
+ * minute for DNS_TEST_HOURS hours, each looking up its server in turn, with
+ * the server down for 10 minutes in the middle. The Makefile builds the
+ * program a second time with one entry and the refresh, stale and negative
+ * options at 0 (DNSTEST_BASELINE), which only runs the scenario.
+ */
+#if defined(LWIP_HOST)
+
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_def.h"
+#include "lwip/lwip_udp.h"
+#include "lwip/lwip_dns.h"
+#include "lwip_host.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if !LWIP_DNS
+#error "dnstest needs LWIP_DNS"
+#endif
+
+/* One way delay of the segment, the round trip is twice that */
+#define DNS_TEST_DELAY          20
+#define DNS_TEST_RTT            (2 * DNS_TEST_DELAY)
+/* Longest a lookup may take, the retries of a silent server included */
+#define DNS_TEST_WAIT           20000
+/* Length of the scenario, and the minutes the server is down for */
+#define DNS_TEST_HOURS          4
+#define DNS_TEST_DOWN_FROM      90
+#define DNS_TEST_DOWN_TO        100
+
+/* DNS_TEST_RETRIES and DNS_TEST_STALE_ANSWER of lwip_dns.c */
+#define DNS_TEST_RETRIES        4
+#define DNS_TEST_STALE_ANSWER   30
+
+#define DNS_TEST_HDR_LEN        12
+#define DNS_TEST_MSG_LEN        512
+#define DNS_TEST_RCODE_NAME     3
+
+typedef enum
+{
+  DNS_TEST_ANSWER,
+  DNS_TEST_NXDOMAIN,
+  /* no A record in the answer */
+  DNS_TEST_EMPTY,
+  DNS_TEST_SILENT
+} dns_test_mode_t;
+
+/* A name of the stand-in server */
+typedef struct
+{
+  const char *name;
+  u32_t addr;
+  u32_t ttl;
+  dns_test_mode_t mode;
+  /* queries received */
+  u32_t queries;
+} dns_test_name_t;
+
+/* A lookup through dns_gethostbyname() */
+typedef struct
+{
+  err_t err;
+  int done;
+  int found;
+  ip_addr_t addr;
+  u32_t start;
+  u32_t time;
+} dns_test_lookup_t;
+
+static dns_test_name_t dns_test_names[] =
+{
+  { "broker.example.com", 0x0A010001, 300, DNS_TEST_ANSWER, 0 },
+  { "ota.example.com", 0x0A010002, 600, DNS_TEST_ANSWER, 0 },
+  { "pool.ntp.example.org", 0x0A010003, 150, DNS_TEST_ANSWER, 0 },
+  { "gone.example.com", 0, 0, DNS_TEST_NXDOMAIN, 0 },
+  { "ipv6only.example.com", 0, 0, DNS_TEST_EMPTY, 0 },
+  { "a.example.com", 0x0A020001, 3600, DNS_TEST_ANSWER, 0 },
+  { "b.example.com", 0x0A020002, 3600, DNS_TEST_ANSWER, 0 },
+  { "c.example.com", 0x0A020003, 3600, DNS_TEST_ANSWER, 0 },
+  { "d.example.com", 0x0A020004, 3600, DNS_TEST_ANSWER, 0 },
+  { "e.example.com", 0x0A020005, 3600, DNS_TEST_ANSWER, 0 },
+};
+
+#define DNS_TEST_NUM_NAMES  (sizeof(dns_test_names) / sizeof(dns_test_names[0]))
+
+static lwip_host_seg_t dns_test_seg;
+static struct netif dns_test_dev;
+static struct netif dns_test_server;
+static unsigned long dns_test_failures;
+
+static dns_test_name_t *dns_test_name(const char *name)
+{
+  size_t i;
+
+  for (i = 0; i < DNS_TEST_NUM_NAMES; i++)
+  {
+    if (strcmp(dns_test_names[i].name, name) == 0)
+    {
+      return &dns_test_names[i];
+    }
+  }
+  return NULL;
+}
+
+static u32_t dns_test_queries(void)
+{
+  u32_t queries = 0;
+  size_t i;
+
+  for (i = 0; i < DNS_TEST_NUM_NAMES; i++)
+  {
+    queries += dns_test_names[i].queries;
+  }
+  return queries;
+}
+
+static void dns_test_check(int ok, const char *what)
+{
+  if (!ok)
+  {
+    dns_test_failures++;
+    printf("dnstest: at %u ms: %s\n", (unsigned)lwip_host_now, what);
+  }
+}
+
+static void dns_test_put16(u8_t *p, u16_t val)
+{
+  p[0] = val >> 8;
+  p[1] = val & 0xFF;
+}
+
+static void dns_test_put32(u8_t *p, u32_t val)
+{
+  dns_test_put16(p, val >> 16);
+  dns_test_put16(p + 2, val & 0xFFFF);
+}
+
+/* Answer the query 'q' of 'len' bytes from 'from' */
+static void dns_test_answer(const lwip_host_udp_t *from, const u8_t *q,
+                            u16_t len)
+{
+  u8_t msg[DNS_TEST_MSG_LEN];
+  char name[DNS_MAX_NAME_LENGTH];
+  lwip_host_udp_t udp;
+  dns_test_name_t *entry;
+  u16_t qlen;
+  u16_t pos;
+  u8_t n;
+
+  /* the question, a name of labels then its type and class */
+  if (len < DNS_TEST_HDR_LEN + 5)
+  {
+    return;
+  }
+  pos = DNS_TEST_HDR_LEN;
+  qlen = 0;
+  while (((n = q[pos]) != 0) && (pos + 1 + n < len - 4)
+         && (qlen + n + 1 < sizeof(name)))
+  {
+    if (qlen > 0)
+    {
+      name[qlen++] = '.';
+    }
+    memcpy(&name[qlen], &q[pos + 1], n);
+    qlen += n;
+    pos += 1 + n;
+  }
+  name[qlen] = '\0';
+  pos += 1 + 4;
+  entry = dns_test_name(name);
+  if ((entry == NULL) || (pos > len))
+  {
+    return;
+  }
+  entry->queries++;
+  if (entry->mode == DNS_TEST_SILENT)
+  {
+    return;
+  }
+
+  memcpy(msg, q, pos);
+  /* a response to a recursive query, recursion available */
+  msg[2] = 0x81;
+  msg[3] = 0x80;
+  dns_test_put16(&msg[6], 0);
+  dns_test_put16(&msg[8], 0);
+  dns_test_put16(&msg[10], 0);
+  if (entry->mode == DNS_TEST_NXDOMAIN)
+  {
+    msg[3] |= DNS_TEST_RCODE_NAME;
+  }
+  else if (entry->mode == DNS_TEST_ANSWER)
+  {
+    dns_test_put16(&msg[6], 1);
+    /* the name of the question, type A, class IN, TTL and the address */
+    dns_test_put16(&msg[pos], 0xC000 | DNS_TEST_HDR_LEN);
+    dns_test_put16(&msg[pos + 2], 1);
+    dns_test_put16(&msg[pos + 4], 1);
+    dns_test_put32(&msg[pos + 6], entry->ttl);
+    dns_test_put16(&msg[pos + 10], 4);
+    dns_test_put32(&msg[pos + 12], entry->addr);
+    pos += 16;
+  }
+
+  udp = *from;
+  udp.src = from->dst;
+  udp.dst = from->src;
+  udp.src_port = from->dst_port;
+  udp.dst_port = from->src_port;
+  udp.data = msg;
+  udp.len = pos;
+  lwip_host_tap_udp_send(&dns_test_server, &udp);
+}
+
+/* netif->input of the server tap */
+static err_t dns_test_server_input(struct pbuf *p, struct netif *netif)
+{
+  lwip_host_udp_t udp;
+
+  if (!lwip_host_tap_arp(netif, p) && lwip_host_tap_udp_parse(p, &udp)
+      && ip_addr_cmp(&udp.dst, &netif->ip_addr) && (udp.dst_port == 53))
+  {
+    dns_test_answer(&udp, udp.data, udp.len);
+  }
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static void dns_test_found(const char *name, ip_addr_t *ipaddr, void *arg)
+{
+  dns_test_lookup_t *lookup = arg;
+
+  (void)name;
+  lookup->done = 1;
+  lookup->time = lwip_host_now - lookup->start;
+  if (ipaddr != NULL)
+  {
+    lookup->found = 1;
+    ip_addr_copy(lookup->addr, *ipaddr);
+  }
+}
+
+static int dns_test_done(void *arg)
+{
+  return ((dns_test_lookup_t *)arg)->done;
+}
+
+/* Start a lookup of 'name', completed by dns_test_wait() */
+static err_t dns_test_start(const char *name, dns_test_lookup_t *lookup)
+{
+  memset(lookup, 0, sizeof(*lookup));
+  lookup->start = lwip_host_now;
+  lookup->err = dns_gethostbyname(name, &lookup->addr, dns_test_found,
+                                  lookup);
+  if (lookup->err != ERR_INPROGRESS)
+  {
+    lookup->done = 1;
+    lookup->found = (lookup->err == ERR_OK);
+  }
+  return lookup->err;
+}
+
+static void dns_test_wait(dns_test_lookup_t *lookup)
+{
+  lwip_host_run_until(dns_test_done, lookup, DNS_TEST_WAIT);
+}
+
+/* Look 'name' up, returns what dns_gethostbyname() returned */
+static err_t dns_test_lookup(const char *name, dns_test_lookup_t *lookup)
+{
+  dns_test_start(name, lookup);
+  dns_test_wait(lookup);
+  return lookup->err;
+}
+
+#if !defined(DNSTEST_BASELINE)
+static int dns_test_is(const dns_test_lookup_t *lookup, const char *name)
+{
+  return lookup->done && lookup->found
+      && (ip4_addr_get_u32(&lookup->addr) == htonl(dns_test_name(name)->addr));
+}
+
+static void dns_test_cache(void)
+{
+  dns_test_name_t *broker = dns_test_name("broker.example.com");
+  dns_test_name_t *ntp = dns_test_name("pool.ntp.example.org");
+  dns_test_name_t *ota = dns_test_name("ota.example.com");
+  dns_test_name_t *gone = dns_test_name("gone.example.com");
+  dns_test_lookup_t lookup;
+  u32_t queries;
+  const char *lru[] = { "a.example.com", "b.example.com", "c.example.com",
+                        "d.example.com" };
+  size_t i;
+
+  /* the first lookup waits for the ARP reply and the answer */
+  dns_test_check(dns_test_lookup(broker->name, &lookup) == ERR_INPROGRESS,
+                 "first lookup not queried");
+  dns_test_check(dns_test_is(&lookup, broker->name), "first lookup failed");
+  dns_test_check(lookup.time == 2 * DNS_TEST_RTT,
+                 "first lookup not done in 2 round trips");
+  printf("  %-34s %5u ms, ARP included\n", "first lookup",
+         (unsigned)lookup.time);
+
+  /* answered from the table, without a query */
+  lwip_host_run(10000);
+  queries = broker->queries;
+  dns_test_check(dns_test_lookup(broker->name, &lookup) == ERR_OK,
+                 "cached lookup not answered");
+  dns_test_check(dns_test_is(&lookup, broker->name), "cached lookup wrong");
+  dns_test_check(broker->queries == queries, "cached lookup queried");
+
+  /* looked up since it was resolved: refreshed before the TTL expires, and
+   answered at once after it */
+  lwip_host_run(broker->ttl * 1000);
+  dns_test_check(broker->queries == queries + 1, "used name not refreshed");
+  dns_test_check(dns_test_lookup(broker->name, &lookup) == ERR_OK,
+                 "refreshed name not answered");
+
+  /* not looked up since it was resolved: asked again once the TTL expired */
+  dns_test_lookup(ntp->name, &lookup);
+  lwip_host_run((ntp->ttl + 10) * 1000);
+  queries = ntp->queries;
+  dns_test_check(dns_test_lookup(ntp->name, &lookup) == ERR_INPROGRESS,
+                 "expired name answered");
+  dns_test_check(dns_test_is(&lookup, ntp->name)
+                 && (lookup.time == DNS_TEST_RTT),
+                 "expired name not resolved in a round trip");
+  dns_test_check(ntp->queries == queries + 1, "expired name not queried");
+
+  /* the server goes silent: a used name is answered while the refresh
+   fails, until its TTL expires */
+  dns_test_lookup(ota->name, &lookup);
+  ota->mode = DNS_TEST_SILENT;
+  queries = ota->queries;
+  dns_test_check(dns_test_lookup(ota->name, &lookup) == ERR_OK,
+                 "cached lookup not answered");
+  lwip_host_run((ota->ttl - 5) * 1000);
+  dns_test_check(dns_test_lookup(ota->name, &lookup) == ERR_OK,
+                 "name not answered during a failed refresh");
+  dns_test_check(ota->queries == queries + DNS_TEST_RETRIES,
+                 "refresh not retried");
+
+  /* that lookup asks again, the stale address is answered when it fails */
+  lwip_host_run(15000);
+  dns_test_check(dns_test_lookup(ota->name, &lookup) == ERR_OK,
+                 "stale address not answered at once");
+  dns_test_check(dns_test_is(&lookup, ota->name), "stale address wrong");
+  dns_test_check(ota->queries == queries + 2 * DNS_TEST_RETRIES,
+                 "second refresh not retried");
+
+  /* once that expires, a lookup waits for the servers to time out */
+  lwip_host_run((DNS_TEST_STALE_ANSWER + 1) * 1000);
+  queries = ota->queries;
+  dns_test_check(dns_test_lookup(ota->name, &lookup) == ERR_INPROGRESS,
+                 "stale address not asked again");
+  dns_test_check(dns_test_is(&lookup, ota->name),
+                 "stale address not answered");
+  dns_test_check(ota->queries == queries + DNS_TEST_RETRIES,
+                 "server not retried");
+  printf("  %-34s %5u ms, %u queries\n", "stale answer, server silent",
+         (unsigned)lookup.time, (unsigned)(ota->queries - queries));
+
+  /* and is not asked for again for a while */
+  queries = ota->queries;
+  lwip_host_run((DNS_TEST_STALE_ANSWER - 10) * 1000);
+  dns_test_check(dns_test_lookup(ota->name, &lookup) == ERR_OK,
+                 "stale address not answered at once");
+  dns_test_check(ota->queries == queries, "stale address queried again");
+  lwip_host_run(20000);
+  dns_test_check(dns_test_start(ota->name, &lookup) == ERR_INPROGRESS,
+                 "stale address answered too long");
+  ota->mode = DNS_TEST_ANSWER;
+  dns_test_wait(&lookup);
+  dns_test_check(dns_test_is(&lookup, ota->name),
+                 "server back, name not resolved");
+
+  /* NXDOMAIN: negative for DNS_NEG_TTL, without a query */
+  dns_test_check(dns_test_lookup(gone->name, &lookup) == ERR_INPROGRESS,
+                 "NXDOMAIN not queried");
+  dns_test_check(lookup.done && !lookup.found, "NXDOMAIN answered");
+  queries = gone->queries;
+  lwip_host_run(30000);
+  dns_test_check(dns_test_lookup(gone->name, &lookup) == ERR_VAL,
+                 "NXDOMAIN not cached");
+  dns_test_check(gone->queries == queries, "negative entry queried");
+  lwip_host_run(40000);
+  dns_test_check(dns_test_lookup(gone->name, &lookup) == ERR_INPROGRESS,
+                 "negative entry kept past its TTL");
+
+  /* a name without an A record is cached the same */
+  dns_test_lookup("ipv6only.example.com", &lookup);
+  dns_test_check(lookup.done && !lookup.found, "empty answer answered");
+  dns_test_check(dns_test_lookup("ipv6only.example.com", &lookup) == ERR_VAL,
+                 "empty answer not cached");
+
+  /* a full table replaces the least recently used name */
+  for (i = 0; i < sizeof(lru) / sizeof(lru[0]); i++)
+  {
+    dns_test_lookup(lru[i], &lookup);
+    dns_test_check(dns_test_is(&lookup, lru[i]), "name not resolved");
+  }
+  dns_test_check(dns_test_lookup(lru[0], &lookup) == ERR_OK,
+                 "first name replaced");
+  dns_test_lookup("e.example.com", &lookup);
+  /* the name replaced last, looking it up replaces another */
+  for (i = 0; i < sizeof(lru) / sizeof(lru[0]); i++)
+  {
+    dns_test_check((i == 1)
+                   || (dns_test_lookup(lru[i], &lookup) == ERR_OK),
+                   "recently used name replaced");
+  }
+  dns_test_check(dns_test_lookup("e.example.com", &lookup) == ERR_OK,
+                 "new name not kept");
+  dns_test_check(dns_test_lookup(lru[1], &lookup) == ERR_INPROGRESS,
+                 "least recently used name kept");
+  printf("  %-34s %5lu failed\n", "cache checks", dns_test_failures);
+}
+#endif /* !DNSTEST_BASELINE */
+
+/* Lookups of the scenario, while the server answers and while it is down */
+typedef struct
+{
+  u32_t lookups;
+  u32_t at_once;
+  u32_t failed;
+  u32_t total;
+  u32_t worst;
+} dns_test_stats_t;
+
+static void dns_test_print(const char *what, const dns_test_stats_t *stats)
+{
+  printf("  %-22s %4u lookups, %3u at once, %2u failed, %4u.%u ms mean, "
+         "%4u ms worst\n", what, (unsigned)stats->lookups,
+         (unsigned)stats->at_once, (unsigned)stats->failed,
+         (unsigned)(stats->total / stats->lookups),
+         (unsigned)(stats->total * 10 / stats->lookups % 10),
+         (unsigned)stats->worst);
+}
+
+/* Reconnects every minute, the lookups in turn as the tasks do */
+static void dns_test_scenario(void)
+{
+  static const char *servers[] = { "broker.example.com", "ota.example.com",
+                                   "pool.ntp.example.org" };
+  dns_test_stats_t stats[2];
+  dns_test_stats_t *s;
+  dns_test_lookup_t lookup;
+  u32_t queries;
+  u32_t minute;
+  int down;
+  size_t i;
+
+  memset(stats, 0, sizeof(stats));
+  queries = dns_test_queries();
+  for (minute = 0; minute < DNS_TEST_HOURS * 60; minute++)
+  {
+    down = (minute >= DNS_TEST_DOWN_FROM) && (minute < DNS_TEST_DOWN_TO);
+    for (i = 0; i < DNS_TEST_NUM_NAMES; i++)
+    {
+      if ((dns_test_names[i].mode == DNS_TEST_ANSWER)
+          || (dns_test_names[i].mode == DNS_TEST_SILENT))
+      {
+        dns_test_names[i].mode = down ? DNS_TEST_SILENT : DNS_TEST_ANSWER;
+      }
+    }
+    s = &stats[down];
+    for (i = 0; i < sizeof(servers) / sizeof(servers[0]); i++)
+    {
+      s->lookups++;
+      if (dns_test_lookup(servers[i], &lookup) == ERR_OK)
+      {
+        s->at_once++;
+      }
+      else if (!lookup.found)
+      {
+        s->failed++;
+      }
+      s->total += lookup.time;
+      if (lookup.time > s->worst)
+      {
+        s->worst = lookup.time;
+      }
+    }
+    lwip_host_run(60000 - (lwip_host_now % 60000));
+  }
+  queries = dns_test_queries() - queries;
+
+  printf("  reconnects every minute for %d h, %u queries\n", DNS_TEST_HOURS,
+         (unsigned)queries);
+  dns_test_print("server up", &stats[0]);
+  dns_test_print("server down", &stats[1]);
+}
+
+int main(void)
+{
+  ip_addr_t addr;
+  ip_addr_t mask;
+  ip_addr_t gw;
+
+  lwip_host_init(1);
+  lwip_host_seg_init(&dns_test_seg);
+  dns_test_seg.delay = DNS_TEST_DELAY;
+  IP4_ADDR(&addr, 10, 0, 0, 2);
+  IP4_ADDR(&mask, 255, 255, 255, 0);
+  IP4_ADDR(&gw, 10, 0, 0, 1);
+  lwip_host_port_add(&dns_test_seg, &dns_test_dev, &addr, &mask, &gw);
+  netif_set_default(&dns_test_dev);
+  lwip_host_tap_add(&dns_test_seg, &dns_test_server, &gw,
+                    dns_test_server_input);
+  dns_setserver(0, &gw);
+
+#if defined(DNSTEST_BASELINE)
+  printf("dnstest, DNS_TABLE_SIZE %d, no refresh, stale or negative entries\n",
+         DNS_TABLE_SIZE);
+#else
+  printf("dnstest, DNS_TABLE_SIZE %d, round trip %d ms\n", DNS_TABLE_SIZE,
+         DNS_TEST_RTT);
+  dns_test_cache();
+#endif
+  dns_test_scenario();
+  dns_test_check(lwip_host_rx_buffers == 0, "RX buffers not recycled");
+  return (dns_test_failures == 0) ? 0 : 1;
+}
+
+#endif /* LWIP_HOST */
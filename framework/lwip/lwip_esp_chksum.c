@@ -0,0 +1,166 @@
+/* Internet checksum for the LX106, see LWIP_CHKSUM in arch/lwip_cc.h.
+
+ The core has no carry flag, so the classic 32-bit one's complement sum
+ needs a compare and a branch per word. Instead, every aligned word w is
+ added whole into 'all' (carries out of bit 31 are lost) and its upper half
+ into 'hi'. The sum of the lower halves is then all - (hi << 16), exact
+ modulo 2^32 and small enough not to wrap for the lengths of a pbuf, which
+ leaves a load, a shift and two adds per 4 bytes.
+
+ The result is the one of the generic lwip_standard_chksum(): the host order
+ sum of the data as if it started at an even address. lwip_esp_chksum_copy()
+ gives the same sum while copying, for LWIP_CHECKSUM_ON_COPY. "make
+ chksumtest" checks both against the generic code on the host and times them.
+ */
+#include "lwip/lwip_opt.h"
+
+#include "lwip/lwip_def.h"
+#include "lwip/lwip_inet_chksum.h"
+#include "common_macros.h"
+
+#include <string.h>
+
+#if LWIP_ESP_CHKSUM
+
+/* Words of the unrolled loop */
+#define CHKSUM_UNROLL   4
+
+/* Sum 'len' bytes from 'src', and copy them to 'dst' unless it is NULL. 'dst'
+ and 'src' must have the same alignment modulo 4. Inlined with a constant
+ 'dst' so that each caller gets its own loop without the test. */
+static inline __attribute__((always_inline)) u16_t
+esp_chksum(u8_t *dst, const u8_t *src, u16_t len)
+{
+  const u32_t *pl;
+  u32_t *dl = NULL;
+  u32_t all = 0;
+  u32_t hi = 0;
+  u32_t sum = 0;
+  u32_t w;
+  u16_t t = 0;
+  int odd = ((mem_ptr_t)src & 1);
+
+  /* Get aligned to u16_t */
+  if (odd && len > 0)
+  {
+    ((u8_t *)&t)[1] = *src;
+    if (dst)
+    {
+      *dst++ = *src;
+    }
+    src++;
+    len--;
+  }
+
+  /* Get aligned to u32_t */
+  if (((mem_ptr_t)src & 2) && len > 1)
+  {
+    sum += *(const u16_t *)src;
+    if (dst)
+    {
+      *(u16_t *)dst = *(const u16_t *)src;
+      dst += 2;
+    }
+    src += 2;
+    len -= 2;
+  }
+
+  pl = (const u32_t *)src;
+  if (dst)
+  {
+    dl = (u32_t *)dst;
+  }
+
+  while (len >= CHKSUM_UNROLL * 4)
+  {
+    w = pl[0]; all += w; hi += w >> 16;
+    if (dst) dl[0] = w;
+    w = pl[1]; all += w; hi += w >> 16;
+    if (dst) dl[1] = w;
+    w = pl[2]; all += w; hi += w >> 16;
+    if (dst) dl[2] = w;
+    w = pl[3]; all += w; hi += w >> 16;
+    if (dst) dl[3] = w;
+    pl += CHKSUM_UNROLL;
+    if (dst)
+    {
+      dl += CHKSUM_UNROLL;
+    }
+    len -= CHKSUM_UNROLL * 4;
+  }
+  while (len >= 4)
+  {
+    w = *pl++;
+    all += w;
+    hi += w >> 16;
+    if (dst)
+    {
+      *dl++ = w;
+    }
+    len -= 4;
+  }
+
+  /* lower halves, then upper halves: both below 2^30 for len < 2^16 */
+  sum += (all - (hi << 16)) + hi;
+
+  src = (const u8_t *)pl;
+  if (dst)
+  {
+    dst = (u8_t *)dl;
+  }
+
+  /* 16-bit aligned word remaining? */
+  if (len > 1)
+  {
+    sum += *(const u16_t *)src;
+    if (dst)
+    {
+      *(u16_t *)dst = *(const u16_t *)src;
+      dst += 2;
+    }
+    src += 2;
+    len -= 2;
+  }
+
+  /* dangling tail byte remaining? */
+  if (len > 0)
+  {
+    ((u8_t *)&t)[0] = *src;
+    if (dst)
+    {
+      *dst = *src;
+    }
+  }
+
+  sum += t;
+
+  /* Fold 32-bit sum to 16 bits */
+  sum = FOLD_U32T(sum);
+  sum = FOLD_U32T(sum);
+
+  /* Swap if alignment was odd */
+  if (odd)
+  {
+    sum = SWAP_BYTES_IN_WORD(sum);
+  }
+
+  return (u16_t)sum;
+}
+
+u16_t IRAM lwip_esp_chksum(void *dataptr, u16_t len)
+{
+  return esp_chksum(NULL, (const u8_t *)dataptr, len);
+}
+
+u16_t IRAM lwip_esp_chksum_copy(void *dst, const void *src, u16_t len)
+{
+  if (((mem_ptr_t)dst ^ (mem_ptr_t)src) & 3)
+  {
+    /* the words cannot be moved as they are loaded */
+    MEMCPY(dst, src, len);
+    return esp_chksum(NULL, (const u8_t *)dst, len);
+  }
+  return esp_chksum((u8_t *)dst, (const u8_t *)src, len);
+}
+
+#endif /* LWIP_ESP_CHKSUM */
@@ -45,6 +45,20 @@
 #include <lwip/lwip_stats.h>
 #include <lwip/lwip_snmp.h>
 #include "netif/lwip_etharp.h"
+#include "lwip/lwip_ip.h"
+#include "lwip/lwip_udp.h"
+#include "lwip/lwip_tcp_impl.h"
+#include "lwip/lwip_tcpip.h"
+#include "lwip/lwip_sys.h"
+#include "lwip_esp_interface.h"
+
+#include <string.h>
+#if !defined(LWIP_HOST)
+#include "freertos_timers.h"
+#else
+/* the netif shim of "make rxflood" */
+#include "lwip_host.h"
+#endif
 
 /* declared in libnet80211.a */
 int8_t sdk_ieee80211_output_pbuf(struct netif *ifp, struct pbuf* pb);
@@ -94,6 +108,261 @@ err_t ethernetif_init(struct netif *netif)
   return ERR_OK;
 }
 
+#if RX_ADMISSION
+/* Receive queue of a class, a ring of frames */
+struct rx_queue
+{
+  struct pbuf **p;
+  struct netif **netif;
+  uint8_t len;
+  uint8_t head;
+  uint8_t count;
+};
+
+static struct pbuf *rx_control_p[RX_QUEUE_CONTROL];
+static struct netif *rx_control_netif[RX_QUEUE_CONTROL];
+static struct pbuf *rx_flow_p[RX_QUEUE_FLOW];
+static struct netif *rx_flow_netif[RX_QUEUE_FLOW];
+static struct pbuf *rx_bulk_p[RX_QUEUE_BULK];
+static struct netif *rx_bulk_netif[RX_QUEUE_BULK];
+
+static struct rx_queue rx_queues[RX_CLASS_NUM] =
+{
+  { rx_control_p, rx_control_netif, RX_QUEUE_CONTROL, 0, 0 },
+  { rx_flow_p, rx_flow_netif, RX_QUEUE_FLOW, 0, 0 },
+  { rx_bulk_p, rx_bulk_netif, RX_QUEUE_BULK, 0, 0 },
+};
+static const uint8_t rx_weights[RX_CLASS_NUM] = RX_WEIGHTS;
+static rx_class_stats_t rx_stats[RX_CLASS_NUM];
+
+/* Wakes the tcpip thread, posted once until rx_drain() runs */
+static struct tcpip_callback_msg *rx_msg;
+static uint8_t rx_posted;
+/* Posts rx_msg again when the tcpip thread mailbox was full */
+static TimerHandle_t rx_retry_timer;
+static StaticTimer_t rx_retry_timer_buf;
+
+/* Post rx_msg, rx_posted is set. When the mailbox is full the post is
+ retried from rx_retry_timer, rx_posted stays set meanwhile. */
+static void rx_post(void)
+{
+  if ((tcpip_trycallback(rx_msg) != ERR_OK)
+      && (xTimerStart(rx_retry_timer, 0) != pdPASS))
+  {
+    /* the timer queue is full too, the next frame tries again */
+    rx_posted = 0;
+  }
+}
+
+/* Runs in the timer service task */
+static void rx_retry(TimerHandle_t timer)
+{
+  rx_post();
+}
+
+/* Sort a frame by its headers, they are in the first pbuf of the frames of
+ the SDK */
+static rx_class_t rx_classify(struct pbuf *p)
+{
+  struct eth_hdr *ethhdr = p->payload;
+  struct ip_hdr *iphdr;
+  struct tcp_hdr *tcphdr;
+  struct udp_hdr *udphdr;
+  u16_t iphlen;
+  u16_t port;
+
+  if (htons(ethhdr->type) == ETHTYPE_ARP)
+  {
+    return RX_CLASS_CONTROL;
+  }
+  if ((ethhdr->dest.addr[0] & 1) || (p->len < SIZEOF_ETH_HDR + IP_HLEN))
+  {
+    /* broadcast or multicast */
+    return RX_CLASS_BULK;
+  }
+
+  iphdr = (struct ip_hdr *)((u8_t *)p->payload + SIZEOF_ETH_HDR);
+  iphlen = IPH_HL(iphdr) * 4;
+  if ((IPH_OFFSET(iphdr) & PP_HTONS(IP_OFFMASK | IP_MF)) != 0)
+  {
+    return RX_CLASS_BULK;
+  }
+
+  switch (IPH_PROTO(iphdr))
+  {
+    case IP_PROTO_TCP:
+      if (p->len < SIZEOF_ETH_HDR + iphlen + TCP_HLEN)
+      {
+        return RX_CLASS_FLOW;
+      }
+      tcphdr = (struct tcp_hdr *)((u8_t *)iphdr + iphlen);
+      if ((TCPH_FLAGS(tcphdr) & (TCP_SYN | TCP_FIN | TCP_RST))
+          || (ntohs(IPH_LEN(iphdr)) <= iphlen + TCPH_HDRLEN(tcphdr) * 4))
+      {
+        return RX_CLASS_CONTROL;
+      }
+      return RX_CLASS_FLOW;
+
+    case IP_PROTO_ICMP:
+      return RX_CLASS_FLOW;
+
+    case IP_PROTO_UDP:
+      if (p->len < SIZEOF_ETH_HDR + iphlen + UDP_HLEN)
+      {
+        return RX_CLASS_BULK;
+      }
+      udphdr = (struct udp_hdr *)((u8_t *)iphdr + iphlen);
+      port = ntohs(udphdr->src);
+      if ((port == 53) || (port == 67) || (port == 123))
+      {
+        return RX_CLASS_FLOW;
+      }
+      return RX_CLASS_BULK;
+
+    default:
+      return RX_CLASS_BULK;
+  }
+}
+
+/* Runs in the tcpip thread: take the frames of the classes in weighted
+ turns, up to RX_BUDGET of them, and post itself again if some are left */
+static void rx_drain(void *ctx)
+{
+  struct rx_queue *queue;
+  struct pbuf *p;
+  struct netif *netif;
+  uint8_t budget = RX_BUDGET;
+  uint8_t left;
+  uint8_t turn;
+  uint8_t c;
+  SYS_ARCH_DECL_PROTECT(old_level);
+
+  SYS_ARCH_PROTECT(old_level);
+  rx_posted = 0;
+  SYS_ARCH_UNPROTECT(old_level);
+
+  do
+  {
+    left = 0;
+    for (c = 0; (c < RX_CLASS_NUM) && budget; c++)
+    {
+      queue = &rx_queues[c];
+      for (turn = rx_weights[c]; turn && budget; turn--)
+      {
+        SYS_ARCH_PROTECT(old_level);
+        if (queue->count == 0)
+        {
+          SYS_ARCH_UNPROTECT(old_level);
+          break;
+        }
+        p = queue->p[queue->head];
+        netif = queue->netif[queue->head];
+        queue->head = (queue->head + 1) % queue->len;
+        queue->count--;
+        left |= queue->count;
+        SYS_ARCH_UNPROTECT(old_level);
+
+        LINK_STATS_INC(link.recv);
+        /* takes the pbuf, as from tcpip_input() */
+        ethernet_input(p, netif);
+        budget--;
+      }
+    }
+  } while (left && budget);
+
+  SYS_ARCH_PROTECT(old_level);
+  left = rx_queues[RX_CLASS_CONTROL].count | rx_queues[RX_CLASS_FLOW].count
+      | rx_queues[RX_CLASS_BULK].count;
+  if (left && !rx_posted)
+  {
+    rx_posted = 1;
+  }
+  else
+  {
+    left = 0;
+  }
+  SYS_ARCH_UNPROTECT(old_level);
+
+  if (left)
+  {
+    rx_post();
+  }
+}
+
+/* Queue a frame in its class, return ERR_OK if it was taken */
+static err_t rx_enqueue(struct netif *netif, struct pbuf *p)
+{
+  rx_class_t c = rx_classify(p);
+  struct rx_queue *queue = &rx_queues[c];
+  size_t heap = xPortGetFreeHeapSize();
+  uint8_t post = 0;
+  SYS_ARCH_DECL_PROTECT(old_level);
+
+  if (((c == RX_CLASS_BULK) && (heap < RX_HEAP_LOW_BULK))
+      || ((c == RX_CLASS_FLOW) && (heap < RX_HEAP_LOW_FLOW)))
+  {
+    rx_stats[c].drop_heap++;
+    return ERR_MEM;
+  }
+
+  if (rx_msg == NULL)
+  {
+    if (rx_retry_timer == NULL)
+    {
+      rx_retry_timer = xTimerCreateStatic("rx_retry", RX_RETRY_TICKS, pdFALSE,
+                                          NULL, rx_retry, &rx_retry_timer_buf);
+    }
+    rx_msg = tcpip_callbackmsg_new(rx_drain, NULL);
+    if (rx_msg == NULL)
+    {
+      rx_stats[c].drop_heap++;
+      return ERR_MEM;
+    }
+  }
+
+  SYS_ARCH_PROTECT(old_level);
+  if (queue->count == queue->len)
+  {
+    SYS_ARCH_UNPROTECT(old_level);
+    rx_stats[c].drop_full++;
+    return ERR_MEM;
+  }
+  queue->p[(queue->head + queue->count) % queue->len] = p;
+  queue->netif[(queue->head + queue->count) % queue->len] = netif;
+  queue->count++;
+  if (queue->count > rx_stats[c].max)
+  {
+    rx_stats[c].max = queue->count;
+  }
+  rx_stats[c].queued++;
+  if (!rx_posted)
+  {
+    rx_posted = post = 1;
+  }
+  SYS_ARCH_UNPROTECT(old_level);
+
+  if (post)
+  {
+    rx_post();
+  }
+  return ERR_OK;
+}
+
+void ethernetif_get_rx_stats(rx_class_stats_t *stats)
+{
+  SYS_ARCH_DECL_PROTECT(old_level);
+
+  SYS_ARCH_PROTECT(old_level);
+  memcpy(stats, rx_stats, sizeof(rx_stats));
+  SYS_ARCH_UNPROTECT(old_level);
+}
+#else /* RX_ADMISSION */
+void ethernetif_get_rx_stats(rx_class_stats_t *stats)
+{
+  memset(stats, 0, RX_CLASS_NUM * sizeof(*stats));
+}
+#endif /* RX_ADMISSION */
+
 /* called from ieee80211_deliver_data with new IP frames */
 void ethernetif_input(struct netif *netif, struct pbuf *p)
 {
@@ -106,10 +375,17 @@ void ethernetif_input(struct netif *netif, struct pbuf *p)
     case ETHTYPE_IP:
     case ETHTYPE_ARP:
 //  case ETHTYPE_IPV6:
-      /* full packet send to tcpip_thread to process */
+      /* full packet queued by class for the tcpip_thread to process, also
+       with LWIP_TCPIP_CORE_LOCKING: this is the SDK task, it must not wait
+       for the core lock held by an application task */
+#if RX_ADMISSION
+      if (rx_enqueue(netif, p) != ERR_OK)
+#else
       if (netif->input(p, netif) != ERR_OK)
+#endif
       {
         LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
+        LINK_STATS_INC(link.drop);
         pbuf_free(p);
         p = NULL;
       }
@@ -0,0 +1,769 @@
+/*
+ * Host port of the lwIP core, see lwip_host.h
+ *
+ * The SDK and FreeRTOS calls of the core are answered here: the clock, the
+ * free heap, which a program lowers to put the stack under pressure, the
+ * recycling of the RX buffers, the address set by the DHCP client and the
+ * software timers. The tcpip thread takes its mailbox at the step of the
+ * next millisecond, as far as lwip_host_tcpip_rate lets it.
+ */
+#if defined(LWIP_HOST)
+
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_init.h"
+#include "lwip/lwip_sys.h"
+#include "lwip/lwip_timers.h"
+#include "lwip/lwip_inet_chksum.h"
+#include "lwip/lwip_ip.h"
+#include "lwip/lwip_udp.h"
+#include "lwip/lwip_tcpip.h"
+#include "lwip/lwip_stats.h"
+#include "netif/lwip_etharp.h"
+#include "lwip_pool.h"
+#include "lwip_host.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A frame in flight, a copy of what the port sent */
+struct lwip_host_frame
+{
+  lwip_host_frame_t *next;
+  u32_t due;
+  u8_t from;
+  u16_t len;
+  u8_t data[];
+};
+
+/* A message of the mailbox of the tcpip thread, a callback or a frame of
+ tcpip_input() */
+struct tcpip_callback_msg
+{
+  tcpip_callback_fn function;
+  void *ctx;
+  struct pbuf *p;
+  struct netif *netif;
+  /* freed once run, those of tcpip_callbackmsg_new() are posted again */
+  bool once;
+};
+
+/* Segments run by lwip_host_run() */
+#define LWIP_HOST_SEGS          8
+
+/* Header of a block of heap_4.c, the size is kept in front of the block */
+#define LWIP_HOST_HEAP_HDR      8
+
+u32_t lwip_host_now;
+size_t lwip_host_free_heap = LWIP_HOST_FREE_HEAP;
+size_t lwip_host_min_free_heap = LWIP_HOST_FREE_HEAP;
+u32_t lwip_host_rx_buffers;
+u32_t lwip_host_tcpip_rate;
+/* lwip_pool.c fails instead of falling back to malloc() in an ISR */
+bool esp_in_isr;
+
+static lwip_host_seg_t *lwip_host_segs[LWIP_HOST_SEGS];
+static u8_t lwip_host_num_segs;
+/* netif->num of the taps, down from 255 away from those of netif_add() */
+static u8_t lwip_host_tap_num = 255;
+static u32_t lwip_host_rng = 1;
+static struct tcpip_callback_msg *lwip_host_mbox[TCPIP_MBOX_SIZE];
+static u8_t lwip_host_mbox_head;
+static u8_t lwip_host_mbox_count;
+/* frames the tcpip thread has time for in this ms, below 0 while it is
+ still busy with those of the previous ones */
+static s32_t lwip_host_tcpip_credit;
+
+u32_t sys_now(void)
+{
+  return lwip_host_now;
+}
+
+/* One thread, nothing to protect from */
+sys_prot_t sys_arch_protect(void)
+{
+  return 0;
+}
+
+void sys_arch_unprotect(sys_prot_t pval)
+{
+  (void)pval;
+}
+
+size_t xPortGetFreeHeapSize(void)
+{
+  return lwip_host_free_heap;
+}
+
+/* 'eb' is NULL for the pbufs not made by lwip_host_rx_pbuf() */
+void system_pp_recycle_rx_pkt(void *eb)
+{
+  if (eb != NULL)
+  {
+    free(eb);
+    lwip_host_rx_buffers--;
+  }
+}
+
+void system_station_got_ip_set(struct ip_addr *ip, struct ip_addr *mask,
+                               struct ip_addr *gw)
+{
+  (void)ip;
+  (void)mask;
+  (void)gw;
+}
+
+void *lwip_host_heap_malloc(size_t size)
+{
+  size_t *block;
+
+  size = LWIP_MEM_ALIGN_SIZE(size) + LWIP_HOST_HEAP_HDR;
+  if (size > lwip_host_free_heap)
+  {
+    return NULL;
+  }
+  block = malloc(size);
+  if (block == NULL)
+  {
+    return NULL;
+  }
+  *block = size;
+  lwip_host_free_heap -= size;
+  if (lwip_host_free_heap < lwip_host_min_free_heap)
+  {
+    lwip_host_min_free_heap = lwip_host_free_heap;
+  }
+  return (u8_t *)block + LWIP_HOST_HEAP_HDR;
+}
+
+void lwip_host_heap_free(void *mem)
+{
+  size_t *block;
+
+  if (mem == NULL)
+  {
+    return;
+  }
+  block = (size_t *)((u8_t *)mem - LWIP_HOST_HEAP_HDR);
+  lwip_host_free_heap += *block;
+  free(block);
+}
+
+static err_t lwip_host_post(struct tcpip_callback_msg *msg)
+{
+  if (lwip_host_mbox_count == TCPIP_MBOX_SIZE)
+  {
+    return ERR_MEM;
+  }
+  lwip_host_mbox[(lwip_host_mbox_head + lwip_host_mbox_count)
+      % TCPIP_MBOX_SIZE] = msg;
+  lwip_host_mbox_count++;
+  return ERR_OK;
+}
+
+static err_t lwip_host_post_once(struct tcpip_callback_msg *msg)
+{
+  struct tcpip_callback_msg *copy;
+
+  copy = malloc(sizeof(*copy));
+  if (copy == NULL)
+  {
+    return ERR_MEM;
+  }
+  *copy = *msg;
+  copy->once = true;
+  if (lwip_host_post(copy) != ERR_OK)
+  {
+    free(copy);
+    return ERR_MEM;
+  }
+  return ERR_OK;
+}
+
+err_t tcpip_input(struct pbuf *p, struct netif *inp)
+{
+  struct tcpip_callback_msg msg = { NULL, NULL, p, inp, true };
+
+  return lwip_host_post_once(&msg);
+}
+
+/* One thread, nothing can wait for room: 'block' or not, the post fails
+ on a full mailbox */
+err_t tcpip_callback_with_block(tcpip_callback_fn function, void *ctx, u8_t block)
+{
+  struct tcpip_callback_msg msg = { function, ctx, NULL, NULL, true };
+
+  (void)block;
+  return lwip_host_post_once(&msg);
+}
+
+struct tcpip_callback_msg *tcpip_callbackmsg_new(tcpip_callback_fn function,
+                                                 void *ctx)
+{
+  struct tcpip_callback_msg *msg;
+
+  msg = malloc(sizeof(*msg));
+  if (msg != NULL)
+  {
+    msg->function = function;
+    msg->ctx = ctx;
+    msg->p = NULL;
+    msg->netif = NULL;
+    msg->once = false;
+  }
+  return msg;
+}
+
+void tcpip_callbackmsg_delete(struct tcpip_callback_msg *msg)
+{
+  free(msg);
+}
+
+err_t tcpip_trycallback(struct tcpip_callback_msg *msg)
+{
+  return lwip_host_post(msg);
+}
+
+static void lwip_host_timer_fire(void *arg)
+{
+  TimerHandle_t timer = arg;
+
+  if (timer->reload)
+  {
+    sys_timeout(timer->period * portTICK_PERIOD_MS, lwip_host_timer_fire,
+                timer);
+  }
+  timer->callback(timer);
+}
+
+TimerHandle_t xTimerCreateStatic(const char *name, TickType_t period,
+                                 UBaseType_t reload, void *id,
+                                 TimerCallbackFunction_t callback,
+                                 StaticTimer_t *buf)
+{
+  (void)name;
+  (void)id;
+  buf->callback = callback;
+  buf->period = period;
+  buf->reload = reload;
+  return buf;
+}
+
+/* Started again if running, as FreeRTOS does */
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t wait)
+{
+  (void)wait;
+  sys_untimeout(lwip_host_timer_fire, timer);
+  sys_timeout(timer->period * portTICK_PERIOD_MS, lwip_host_timer_fire,
+              timer);
+  return pdPASS;
+}
+
+void lwip_host_init(u32_t seed)
+{
+  static bool init;
+
+  if (!init)
+  {
+    init = true;
+    lwip_pool_init();
+    lwip_init();
+  }
+  /* xorshift32 must not start from 0 */
+  lwip_host_rng = seed ? seed : 1;
+}
+
+u32_t lwip_host_rand(void)
+{
+  lwip_host_rng ^= lwip_host_rng << 13;
+  lwip_host_rng ^= lwip_host_rng >> 17;
+  lwip_host_rng ^= lwip_host_rng << 5;
+  return lwip_host_rng;
+}
+
+void lwip_host_seg_init(lwip_host_seg_t *seg)
+{
+  u8_t i;
+
+  memset(seg, 0, sizeof(*seg));
+  for (i = 0; i < lwip_host_num_segs; i++)
+  {
+    if (lwip_host_segs[i] == seg)
+    {
+      seg->index = i;
+      return;
+    }
+  }
+  LWIP_ASSERT("lwip_host_seg_init: too many segments",
+              lwip_host_num_segs < LWIP_HOST_SEGS);
+  seg->index = lwip_host_num_segs;
+  lwip_host_segs[lwip_host_num_segs++] = seg;
+}
+
+/* netif->linkoutput: the frame leaves once the segment is free, at its
+ rate, and arrives 'delay' later */
+static err_t lwip_host_linkoutput(struct netif *netif, struct pbuf *p)
+{
+  lwip_host_seg_t *seg = netif->state;
+  lwip_host_frame_t *frame;
+  u32_t start;
+
+  seg->sent++;
+  seg->bytes += p->tot_len;
+  if ((seg->in_flight == LWIP_HOST_FRAMES)
+      || (lwip_host_rand() % 1000000 < seg->loss))
+  {
+    seg->lost++;
+    return ERR_OK;
+  }
+  frame = malloc(sizeof(*frame) + p->tot_len);
+  if (frame == NULL)
+  {
+    seg->lost++;
+    return ERR_OK;
+  }
+  frame->next = NULL;
+  frame->from = netif->num;
+  frame->len = pbuf_copy_partial(p, frame->data, p->tot_len, 0);
+
+  start = (seg->busy_until > lwip_host_now) ? seg->busy_until
+      : lwip_host_now;
+  if (seg->rate != 0)
+  {
+    start += (frame->len + seg->rate - 1) / seg->rate;
+    seg->busy_until = start;
+  }
+  frame->due = start + seg->delay;
+
+  if (seg->tail == NULL)
+  {
+    seg->head = frame;
+  }
+  else
+  {
+    seg->tail->next = frame;
+  }
+  seg->tail = frame;
+  seg->in_flight++;
+  return ERR_OK;
+}
+
+static err_t lwip_host_netif_init(struct netif *netif)
+{
+  lwip_host_seg_t *seg = netif->state;
+
+  netif->name[0] = 'h';
+  netif->name[1] = 'o';
+  netif->output = etharp_output;
+  netif->linkoutput = lwip_host_linkoutput;
+  netif->hwaddr_len = ETHARP_HWADDR_LEN;
+  netif->hwaddr[0] = 0x02;
+  netif->hwaddr[1] = 0;
+  netif->hwaddr[2] = 0;
+  netif->hwaddr[3] = 0;
+  netif->hwaddr[4] = seg->index;
+  netif->hwaddr[5] = seg->num_ports;
+  netif->mtu = 1500;
+  netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP
+      | NETIF_FLAG_ETHERNET | NETIF_FLAG_LINK_UP;
+  return ERR_OK;
+}
+
+struct netif *lwip_host_port_add(lwip_host_seg_t *seg, struct netif *netif,
+                                 ip_addr_t *ipaddr, ip_addr_t *netmask,
+                                 ip_addr_t *gw)
+{
+  if (seg->num_ports == LWIP_HOST_PORTS)
+  {
+    return NULL;
+  }
+  if (netif_add(netif, ipaddr, netmask, gw, seg, lwip_host_netif_init,
+                ethernet_input) == NULL)
+  {
+    return NULL;
+  }
+  seg->ports[seg->num_ports++] = netif;
+  netif_set_up(netif);
+  return netif;
+}
+
+/* netif->output of the link ports: no ARP, to the other port */
+static err_t lwip_host_p2p_output(struct netif *netif, struct pbuf *p,
+                                  ip_addr_t *ipaddr)
+{
+  lwip_host_seg_t *seg = netif->state;
+  struct netif *peer;
+  struct eth_hdr *ethhdr;
+  err_t err;
+
+  (void)ipaddr;
+  peer = seg->ports[(seg->ports[0] == netif) ? 1 : 0];
+  if (pbuf_header(p, SIZEOF_ETH_HDR) != 0)
+  {
+    return ERR_BUF;
+  }
+  ethhdr = p->payload;
+  ETHADDR16_COPY(&ethhdr->dest, peer->hwaddr);
+  ETHADDR16_COPY(&ethhdr->src, netif->hwaddr);
+  ethhdr->type = PP_HTONS(ETHTYPE_IP);
+  err = netif->linkoutput(netif, p);
+  pbuf_header(p, -SIZEOF_ETH_HDR);
+  return err;
+}
+
+struct netif *lwip_host_link_add(lwip_host_seg_t *seg, struct netif *netif,
+                                 ip_addr_t *ipaddr, ip_addr_t *netmask)
+{
+  if (seg->num_ports == 2)
+  {
+    return NULL;
+  }
+  if (lwip_host_port_add(seg, netif, ipaddr, netmask, IP_ADDR_ANY) == NULL)
+  {
+    return NULL;
+  }
+  netif->output = lwip_host_p2p_output;
+  return netif;
+}
+
+void lwip_host_port_driver(lwip_host_seg_t *seg, struct netif *netif,
+                           lwip_host_driver_fn driver)
+{
+  u8_t i;
+
+  for (i = 0; i < seg->num_ports; i++)
+  {
+    if (seg->ports[i] == netif)
+    {
+      seg->drivers[i] = driver;
+    }
+  }
+}
+
+struct netif *lwip_host_tap_add(lwip_host_seg_t *seg, struct netif *netif,
+                                ip_addr_t *ipaddr, netif_input_fn input)
+{
+  if (seg->num_ports == LWIP_HOST_PORTS)
+  {
+    return NULL;
+  }
+  memset(netif, 0, sizeof(*netif));
+  netif->state = seg;
+  lwip_host_netif_init(netif);
+  ip_addr_copy(netif->ip_addr, *ipaddr);
+  netif->input = input;
+  netif->num = lwip_host_tap_num--;
+  netif->flags |= NETIF_FLAG_UP;
+  seg->ports[seg->num_ports++] = netif;
+  return netif;
+}
+
+int lwip_host_tap_arp(struct netif *tap, struct pbuf *p)
+{
+  struct eth_hdr *ethhdr = p->payload;
+  struct etharp_hdr *hdr;
+  struct pbuf *q;
+  ip_addr_t target;
+
+  if ((p->len < SIZEOF_ETHARP_PACKET) || (ethhdr->type != PP_HTONS(ETHTYPE_ARP)))
+  {
+    return 0;
+  }
+  hdr = (struct etharp_hdr *)(ethhdr + 1);
+  IPADDR2_COPY(&target, &hdr->dipaddr);
+  if ((hdr->opcode != PP_HTONS(ARP_REQUEST))
+      || !ip_addr_cmp(&target, &tap->ip_addr))
+  {
+    return 1;
+  }
+
+  q = pbuf_alloc(PBUF_RAW, SIZEOF_ETHARP_PACKET, PBUF_RAM);
+  if (q != NULL)
+  {
+    memcpy(q->payload, p->payload, SIZEOF_ETHARP_PACKET);
+    ethhdr = q->payload;
+    hdr = (struct etharp_hdr *)(ethhdr + 1);
+    ETHADDR16_COPY(&ethhdr->dest, &hdr->shwaddr);
+    ETHADDR16_COPY(&ethhdr->src, tap->hwaddr);
+    hdr->opcode = PP_HTONS(ARP_REPLY);
+    ETHADDR16_COPY(&hdr->dhwaddr, &hdr->shwaddr);
+    IPADDR2_COPY(&hdr->dipaddr, &hdr->sipaddr);
+    ETHADDR16_COPY(&hdr->shwaddr, tap->hwaddr);
+    IPADDR2_COPY(&hdr->sipaddr, &tap->ip_addr);
+    tap->linkoutput(tap, q);
+    pbuf_free(q);
+  }
+  return 1;
+}
+
+int lwip_host_tap_udp_parse(struct pbuf *p, lwip_host_udp_t *udp)
+{
+  struct eth_hdr *ethhdr = p->payload;
+  struct ip_hdr *iphdr;
+  struct udp_hdr *udphdr;
+  u16_t iphlen;
+  u16_t len;
+
+  if ((p->len < SIZEOF_ETH_HDR + IP_HLEN + UDP_HLEN)
+      || (ethhdr->type != PP_HTONS(ETHTYPE_IP)))
+  {
+    return 0;
+  }
+  iphdr = (struct ip_hdr *)(ethhdr + 1);
+  iphlen = IPH_HL(iphdr) * 4;
+  len = ntohs(IPH_LEN(iphdr));
+  if ((IPH_PROTO(iphdr) != IP_PROTO_UDP)
+      || ((IPH_OFFSET(iphdr) & PP_HTONS(IP_OFFMASK | IP_MF)) != 0)
+      || (len > p->len - SIZEOF_ETH_HDR) || (len < iphlen + UDP_HLEN))
+  {
+    return 0;
+  }
+  udphdr = (struct udp_hdr *)((u8_t *)iphdr + iphlen);
+  ETHADDR16_COPY(&udp->mac, &ethhdr->src);
+  ip_addr_copy(udp->src, iphdr->src);
+  ip_addr_copy(udp->dst, iphdr->dest);
+  udp->src_port = ntohs(udphdr->src);
+  udp->dst_port = ntohs(udphdr->dest);
+  udp->data = (const u8_t *)(udphdr + 1);
+  udp->len = LWIP_MIN(len - iphlen, ntohs(udphdr->len)) - UDP_HLEN;
+  return 1;
+}
+
+u16_t lwip_host_udp_frame(const struct eth_addr *src, const lwip_host_udp_t *udp,
+                          u8_t *frame)
+{
+  static u16_t ip_id;
+  struct eth_hdr *ethhdr;
+  struct ip_hdr *iphdr;
+  struct udp_hdr *udphdr;
+
+  ethhdr = (struct eth_hdr *)frame;
+  ETHADDR16_COPY(&ethhdr->dest, &udp->mac);
+  ETHADDR16_COPY(&ethhdr->src, src);
+  ethhdr->type = PP_HTONS(ETHTYPE_IP);
+
+  iphdr = (struct ip_hdr *)(ethhdr + 1);
+  IPH_VHL_SET(iphdr, 4, IP_HLEN / 4);
+  IPH_TOS_SET(iphdr, 0);
+  IPH_LEN_SET(iphdr, htons(IP_HLEN + UDP_HLEN + udp->len));
+  IPH_ID_SET(iphdr, htons(ip_id));
+  ip_id++;
+  IPH_OFFSET_SET(iphdr, 0);
+  IPH_TTL_SET(iphdr, 64);
+  IPH_PROTO_SET(iphdr, IP_PROTO_UDP);
+  ip_addr_copy(iphdr->src, udp->src);
+  ip_addr_copy(iphdr->dest, udp->dst);
+  IPH_CHKSUM_SET(iphdr, 0);
+  IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, IP_HLEN));
+
+  udphdr = (struct udp_hdr *)(iphdr + 1);
+  udphdr->src = htons(udp->src_port);
+  udphdr->dest = htons(udp->dst_port);
+  udphdr->len = htons(UDP_HLEN + udp->len);
+  udphdr->chksum = 0;
+  memcpy(udphdr + 1, udp->data, udp->len);
+  return SIZEOF_ETH_HDR + IP_HLEN + UDP_HLEN + udp->len;
+}
+
+err_t lwip_host_tap_udp_send(struct netif *tap, const lwip_host_udp_t *udp)
+{
+  struct pbuf *p;
+  err_t err;
+
+  p = pbuf_alloc(PBUF_RAW, SIZEOF_ETH_HDR + IP_HLEN + UDP_HLEN + udp->len,
+                 PBUF_RAM);
+  if (p == NULL)
+  {
+    return ERR_MEM;
+  }
+  lwip_host_udp_frame((const struct eth_addr *)tap->hwaddr, udp, p->payload);
+  err = tap->linkoutput(tap, p);
+  pbuf_free(p);
+  return err;
+}
+
+/* 'eb' is the buffer */
+struct pbuf *lwip_host_rx_pbuf(const void *frame, u16_t len)
+{
+  struct pbuf *p;
+  void *buf;
+
+  buf = malloc(len);
+  p = pbuf_alloc(PBUF_RAW, len, PBUF_REF);
+  if ((buf == NULL) || (p == NULL))
+  {
+    free(buf);
+    if (p != NULL)
+    {
+      pbuf_free(p);
+    }
+    return NULL;
+  }
+  memcpy(buf, frame, len);
+  p->payload = buf;
+  p->eb = buf;
+  lwip_host_rx_buffers++;
+  return p;
+}
+
+/* Hand a copy of 'frame' to port 'i' as the SDK does */
+static void lwip_host_deliver(lwip_host_seg_t *seg, u8_t i,
+                              const lwip_host_frame_t *frame)
+{
+  struct netif *netif = seg->ports[i];
+  struct pbuf *p;
+
+  p = lwip_host_rx_pbuf(frame->data, frame->len);
+  if (p == NULL)
+  {
+    seg->lost++;
+    return;
+  }
+  seg->delivered++;
+  if (seg->drivers[i] != NULL)
+  {
+    seg->drivers[i](netif, p);
+  }
+  else if (netif->input(p, netif) != ERR_OK)
+  {
+    pbuf_free(p);
+  }
+}
+
+/* Deliver the frames of 'seg' due by now, returns non zero if there were */
+static int lwip_host_seg_run(lwip_host_seg_t *seg)
+{
+  lwip_host_frame_t *frame;
+  struct netif *netif;
+  const u8_t *dest;
+  int delivered = 0;
+  u8_t i;
+
+  while ((seg->head != NULL) && ((s32_t)(seg->head->due - lwip_host_now) <= 0))
+  {
+    frame = seg->head;
+    seg->head = frame->next;
+    if (seg->head == NULL)
+    {
+      seg->tail = NULL;
+    }
+    seg->in_flight--;
+
+    dest = frame->data;
+    for (i = 0; i < seg->num_ports; i++)
+    {
+      netif = seg->ports[i];
+      if ((netif->num != frame->from) && netif_is_up(netif)
+          && ((dest[0] & 1) || (memcmp(dest, netif->hwaddr, 6) == 0)))
+      {
+        lwip_host_deliver(seg, i, frame);
+      }
+    }
+    free(frame);
+    delivered = 1;
+  }
+  return delivered;
+}
+
+/* The messages posted by the previous step, as far as the tcpip thread
+ has time for their frames, those posted meanwhile wait for the next one */
+static void lwip_host_tcpip_run(void)
+{
+  struct tcpip_callback_msg *msg;
+  u8_t count = lwip_host_mbox_count;
+#if LINK_STATS
+  u32_t recv;
+#endif
+
+  if (lwip_host_tcpip_rate != 0)
+  {
+    /* time left idle is not saved up */
+    lwip_host_tcpip_credit = LWIP_MIN(lwip_host_tcpip_credit
+                                      + (s32_t)lwip_host_tcpip_rate,
+                                      (s32_t)lwip_host_tcpip_rate);
+  }
+  while ((count > 0)
+         && ((lwip_host_tcpip_rate == 0) || (lwip_host_tcpip_credit > 0)))
+  {
+    count--;
+    msg = lwip_host_mbox[lwip_host_mbox_head];
+    lwip_host_mbox_head = (lwip_host_mbox_head + 1) % TCPIP_MBOX_SIZE;
+    lwip_host_mbox_count--;
+    if (msg->p != NULL)
+    {
+      /* as tcpip_thread() */
+      if (msg->netif->flags & (NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET))
+      {
+        ethernet_input(msg->p, msg->netif);
+      }
+      else
+      {
+        ip_input(msg->p, msg->netif);
+      }
+      lwip_host_tcpip_credit--;
+    }
+    else
+    {
+#if LINK_STATS
+      recv = lwip_stats.link.recv;
+      msg->function(msg->ctx);
+      lwip_host_tcpip_credit -= (s32_t)(lwip_stats.link.recv - recv);
+#else
+      msg->function(msg->ctx);
+#endif
+    }
+    if (msg->once)
+    {
+      free(msg);
+    }
+  }
+}
+
+/* Everything due by now, frames sent meanwhile with no delay included */
+static void lwip_host_step(void)
+{
+  int busy;
+  u8_t i;
+
+  lwip_host_tcpip_run();
+  do
+  {
+    busy = 0;
+    for (i = 0; i < lwip_host_num_segs; i++)
+    {
+      busy |= lwip_host_seg_run(lwip_host_segs[i]);
+    }
+    sys_check_timeouts();
+  } while (busy);
+}
+
+void lwip_host_run(u32_t ms)
+{
+  u32_t end = lwip_host_now + ms;
+
+  lwip_host_step();
+  while (lwip_host_now != end)
+  {
+    lwip_host_now++;
+    lwip_host_step();
+  }
+}
+
+u32_t lwip_host_run_until(int (*done)(void *arg), void *arg, u32_t ms)
+{
+  u32_t start = lwip_host_now;
+
+  lwip_host_step();
+  while (!done(arg))
+  {
+    if (lwip_host_now - start == ms)
+    {
+      return ms + 1;
+    }
+    lwip_host_now++;
+    lwip_host_step();
+  }
+  return lwip_host_now - start;
+}
+
+#endif /* LWIP_HOST */
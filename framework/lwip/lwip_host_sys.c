@@ -0,0 +1,643 @@
+/*
+ * sys_arch of the host programs built with NO_SYS 0, see arch/lwip_sys_arch.h
+ *
+ * The tcpip thread and the tasks of a program are pthreads, the semaphores
+ * and mailboxes those of lwip_sys_arch.c on a mutex and condition variables,
+ * the core lock a priority inheriting mutex as xSemaphoreCreateMutex().
+ * sys_now() is the monotonic clock, the lwIP timers run in real time.
+ *
+ * lwip_host_sys_waits counts the times a thread had to block. On the one
+ * core of the device each is a switch to another task and one back, a
+ * program pins itself to one CPU to keep the host to that.
+ *
+ * The SDK calls of the core are answered as by lwip_host.c, which is the
+ * NO_SYS port and is not linked with this one, so are the FreeRTOS calls of
+ * the tasks of a program, see arch/lwip_sys_arch.h.
+ */
+#if defined(LWIP_HOST)
+
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_sys.h"
+#include "lwip/lwip_stats.h"
+#include "lwip_pool.h"
+
+#if !NO_SYS
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Header of a block of heap_4.c, the size is kept in front of the block */
+#define LWIP_HOST_HEAP_HDR      8
+
+struct lwip_host_sem
+{
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  u32_t count;
+};
+
+struct lwip_host_mbox
+{
+  pthread_mutex_t lock;
+  pthread_cond_t not_empty;
+  pthread_cond_t not_full;
+  int size;
+  int first;
+  int count;
+  void *msgs[];
+};
+
+/* Queue of xQueueCreateStatic(), an item is copied into a message */
+struct lwip_host_queue
+{
+  sys_mbox_t mbox;
+  UBaseType_t item_size;
+};
+
+/* Thread of sys_thread_new() */
+struct lwip_host_thread
+{
+  lwip_thread_fn fn;
+  void *arg;
+};
+
+unsigned long lwip_host_sys_waits;
+size_t lwip_host_free_heap = LWIP_HOST_FREE_HEAP;
+size_t lwip_host_min_free_heap = LWIP_HOST_FREE_HEAP;
+/* lwip_pool.c fails instead of falling back to malloc() in an ISR */
+bool esp_in_isr;
+
+/* SYS_ARCH_PROTECT(), nested in lwip_pool.c and the core */
+static pthread_mutex_t lwip_host_sys_protect;
+
+static void lwip_host_sys_waited(void)
+{
+  __atomic_add_fetch(&lwip_host_sys_waits, 1, __ATOMIC_RELAXED);
+}
+
+static u32_t lwip_host_sys_ms(const struct timespec *ts)
+{
+  return (u32_t)(ts->tv_sec * 1000 + ts->tv_nsec / 1000000);
+}
+
+u32_t sys_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return lwip_host_sys_ms(&ts);
+}
+
+size_t xPortGetFreeHeapSize(void)
+{
+  size_t free_heap;
+
+  pthread_mutex_lock(&lwip_host_sys_protect);
+  free_heap = lwip_host_free_heap;
+  pthread_mutex_unlock(&lwip_host_sys_protect);
+  return free_heap;
+}
+
+/* No frames come from the SDK */
+void system_pp_recycle_rx_pkt(void *eb)
+{
+  (void)eb;
+}
+
+void system_station_got_ip_set(struct ip_addr *ip, struct ip_addr *mask,
+                               struct ip_addr *gw)
+{
+  (void)ip;
+  (void)mask;
+  (void)gw;
+}
+
+void *lwip_host_heap_malloc(size_t size)
+{
+  size_t *block = NULL;
+
+  size = LWIP_MEM_ALIGN_SIZE(size) + LWIP_HOST_HEAP_HDR;
+  pthread_mutex_lock(&lwip_host_sys_protect);
+  if (size <= lwip_host_free_heap)
+  {
+    block = malloc(size);
+  }
+  if (block != NULL)
+  {
+    *block = size;
+    lwip_host_free_heap -= size;
+    if (lwip_host_free_heap < lwip_host_min_free_heap)
+    {
+      lwip_host_min_free_heap = lwip_host_free_heap;
+    }
+  }
+  pthread_mutex_unlock(&lwip_host_sys_protect);
+  return (block != NULL) ? (u8_t *)block + LWIP_HOST_HEAP_HDR : NULL;
+}
+
+void lwip_host_heap_free(void *mem)
+{
+  size_t *block;
+
+  if (mem == NULL)
+  {
+    return;
+  }
+  block = (size_t *)((u8_t *)mem - LWIP_HOST_HEAP_HDR);
+  pthread_mutex_lock(&lwip_host_sys_protect);
+  lwip_host_free_heap += *block;
+  pthread_mutex_unlock(&lwip_host_sys_protect);
+  free(block);
+}
+
+void sys_init(void)
+{
+  pthread_mutexattr_t attr;
+
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&lwip_host_sys_protect, &attr);
+  pthread_mutexattr_destroy(&attr);
+#if LWIP_POOL
+  lwip_pool_init();
+#endif /* LWIP_POOL */
+}
+
+sys_prot_t sys_arch_protect(void)
+{
+  pthread_mutex_lock(&lwip_host_sys_protect);
+  return 0;
+}
+
+void sys_arch_unprotect(sys_prot_t pval)
+{
+  (void)pval;
+  pthread_mutex_unlock(&lwip_host_sys_protect);
+}
+
+/* Condition variables on the monotonic clock */
+static void lwip_host_sys_cond_init(pthread_cond_t *cond)
+{
+  pthread_condattr_t attr;
+
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(cond, &attr);
+  pthread_condattr_destroy(&attr);
+}
+
+/* Wait on 'cond' until 'deadline', forever if NULL. Returns non zero on
+ timeout. */
+static int lwip_host_sys_cond_wait(pthread_cond_t *cond, pthread_mutex_t *lock,
+                                   const struct timespec *deadline)
+{
+  if (deadline == NULL)
+  {
+    pthread_cond_wait(cond, lock);
+    return 0;
+  }
+  return pthread_cond_timedwait(cond, lock, deadline) == ETIMEDOUT;
+}
+
+/* Deadline 'timeout' ms after 'start', NULL for 0 (forever) */
+static const struct timespec *lwip_host_sys_deadline(struct timespec *deadline,
+                                                     const struct timespec *start,
+                                                     u32_t timeout)
+{
+  if (timeout == 0)
+  {
+    return NULL;
+  }
+  deadline->tv_sec = start->tv_sec + timeout / 1000;
+  deadline->tv_nsec = start->tv_nsec + (long)(timeout % 1000) * 1000000;
+  if (deadline->tv_nsec >= 1000000000)
+  {
+    deadline->tv_sec++;
+    deadline->tv_nsec -= 1000000000;
+  }
+  return deadline;
+}
+
+static u32_t lwip_host_sys_elapsed(const struct timespec *start)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return lwip_host_sys_ms(&now) - lwip_host_sys_ms(start);
+}
+
+err_t sys_mutex_new(sys_mutex_t *mutex)
+{
+  pthread_mutexattr_t attr;
+
+  *mutex = malloc(sizeof(**mutex));
+  if (*mutex == NULL)
+  {
+    return ERR_MEM;
+  }
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+  pthread_mutex_init(*mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+  return ERR_OK;
+}
+
+void sys_mutex_lock(sys_mutex_t *mutex)
+{
+  if (pthread_mutex_trylock(*mutex) != 0)
+  {
+    lwip_host_sys_waited();
+    pthread_mutex_lock(*mutex);
+  }
+}
+
+void sys_mutex_unlock(sys_mutex_t *mutex)
+{
+  pthread_mutex_unlock(*mutex);
+}
+
+void sys_mutex_free(sys_mutex_t *mutex)
+{
+  pthread_mutex_destroy(*mutex);
+  free(*mutex);
+  *mutex = NULL;
+}
+
+err_t sys_sem_new(sys_sem_t *sem, u8_t count)
+{
+  *sem = malloc(sizeof(**sem));
+  if (*sem == NULL)
+  {
+    return ERR_MEM;
+  }
+  pthread_mutex_init(&(*sem)->lock, NULL);
+  lwip_host_sys_cond_init(&(*sem)->cond);
+  (*sem)->count = count;
+  SYS_STATS_INC_USED(sem);
+  return ERR_OK;
+}
+
+void sys_sem_signal(sys_sem_t *sem)
+{
+  pthread_mutex_lock(&(*sem)->lock);
+  (*sem)->count++;
+  pthread_cond_signal(&(*sem)->cond);
+  pthread_mutex_unlock(&(*sem)->lock);
+}
+
+u32_t sys_arch_sem_wait(sys_sem_t *sem, u32_t timeout)
+{
+  struct timespec start;
+  struct timespec deadline;
+  const struct timespec *until;
+  u32_t ret = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  until = lwip_host_sys_deadline(&deadline, &start, timeout);
+  pthread_mutex_lock(&(*sem)->lock);
+  if ((*sem)->count == 0)
+  {
+    lwip_host_sys_waited();
+  }
+  while ((*sem)->count == 0)
+  {
+    if (lwip_host_sys_cond_wait(&(*sem)->cond, &(*sem)->lock, until))
+    {
+      ret = SYS_ARCH_TIMEOUT;
+      break;
+    }
+  }
+  if (ret == 0)
+  {
+    (*sem)->count--;
+    ret = lwip_host_sys_elapsed(&start);
+  }
+  pthread_mutex_unlock(&(*sem)->lock);
+  return ret;
+}
+
+void sys_sem_free(sys_sem_t *sem)
+{
+  SYS_STATS_DEC(sem.used);
+  pthread_cond_destroy(&(*sem)->cond);
+  pthread_mutex_destroy(&(*sem)->lock);
+  free(*sem);
+  *sem = NULL;
+}
+
+err_t sys_mbox_new(sys_mbox_t *mbox, int size)
+{
+  *mbox = malloc(sizeof(**mbox) + size * sizeof((*mbox)->msgs[0]));
+  if (*mbox == NULL)
+  {
+    return ERR_MEM;
+  }
+  pthread_mutex_init(&(*mbox)->lock, NULL);
+  lwip_host_sys_cond_init(&(*mbox)->not_empty);
+  lwip_host_sys_cond_init(&(*mbox)->not_full);
+  (*mbox)->size = size;
+  (*mbox)->first = 0;
+  (*mbox)->count = 0;
+  SYS_STATS_INC_USED(mbox);
+  return ERR_OK;
+}
+
+static void lwip_host_sys_mbox_put(sys_mbox_t *mbox, void *msg)
+{
+  struct lwip_host_mbox *m = *mbox;
+
+  m->msgs[(m->first + m->count) % m->size] = msg;
+  m->count++;
+  pthread_cond_signal(&m->not_empty);
+}
+
+void sys_mbox_post(sys_mbox_t *mbox, void *msg)
+{
+  struct lwip_host_mbox *m = *mbox;
+
+  pthread_mutex_lock(&m->lock);
+  if (m->count == m->size)
+  {
+    lwip_host_sys_waited();
+  }
+  while (m->count == m->size)
+  {
+    pthread_cond_wait(&m->not_full, &m->lock);
+  }
+  lwip_host_sys_mbox_put(mbox, msg);
+  pthread_mutex_unlock(&m->lock);
+}
+
+err_t sys_mbox_trypost(sys_mbox_t *mbox, void *msg)
+{
+  struct lwip_host_mbox *m = *mbox;
+  err_t err = ERR_MEM;
+
+  pthread_mutex_lock(&m->lock);
+  if (m->count < m->size)
+  {
+    lwip_host_sys_mbox_put(mbox, msg);
+    err = ERR_OK;
+  }
+  else
+  {
+    SYS_STATS_INC(mbox.err);
+  }
+  pthread_mutex_unlock(&m->lock);
+  return err;
+}
+
+static void *lwip_host_sys_mbox_get(sys_mbox_t *mbox)
+{
+  struct lwip_host_mbox *m = *mbox;
+  void *msg = m->msgs[m->first];
+
+  m->first = (m->first + 1) % m->size;
+  m->count--;
+  pthread_cond_signal(&m->not_full);
+  return msg;
+}
+
+u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout)
+{
+  struct lwip_host_mbox *m = *mbox;
+  struct timespec start;
+  struct timespec deadline;
+  const struct timespec *until;
+  void *dummy;
+  u32_t ret = 0;
+
+  if (msg == NULL)
+  {
+    msg = &dummy;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  until = lwip_host_sys_deadline(&deadline, &start, timeout);
+  pthread_mutex_lock(&m->lock);
+  if (m->count == 0)
+  {
+    lwip_host_sys_waited();
+  }
+  while (m->count == 0)
+  {
+    if (lwip_host_sys_cond_wait(&m->not_empty, &m->lock, until))
+    {
+      ret = SYS_ARCH_TIMEOUT;
+      break;
+    }
+  }
+  if (ret == 0)
+  {
+    *msg = lwip_host_sys_mbox_get(mbox);
+    ret = lwip_host_sys_elapsed(&start);
+  }
+  else
+  {
+    *msg = NULL;
+  }
+  pthread_mutex_unlock(&m->lock);
+  return ret;
+}
+
+u32_t sys_arch_mbox_tryfetch(sys_mbox_t *mbox, void **msg)
+{
+  struct lwip_host_mbox *m = *mbox;
+  void *dummy;
+  u32_t ret = SYS_MBOX_EMPTY;
+
+  if (msg == NULL)
+  {
+    msg = &dummy;
+  }
+  pthread_mutex_lock(&m->lock);
+  if (m->count > 0)
+  {
+    *msg = lwip_host_sys_mbox_get(mbox);
+    ret = 0;
+  }
+  pthread_mutex_unlock(&m->lock);
+  return ret;
+}
+
+void sys_mbox_free(sys_mbox_t *mbox)
+{
+#if SYS_STATS
+  if ((*mbox)->count != 0)
+  {
+    SYS_STATS_INC(mbox.err);
+  }
+  SYS_STATS_DEC(mbox.used);
+#endif /* SYS_STATS */
+  pthread_cond_destroy(&(*mbox)->not_full);
+  pthread_cond_destroy(&(*mbox)->not_empty);
+  pthread_mutex_destroy(&(*mbox)->lock);
+  free(*mbox);
+  *mbox = NULL;
+}
+
+static void *lwip_host_sys_thread(void *arg)
+{
+  struct lwip_host_thread t = *(struct lwip_host_thread *)arg;
+
+  free(arg);
+  t.fn(t.arg);
+  return NULL;
+}
+
+sys_thread_t sys_thread_new(const char *name, lwip_thread_fn thread, void *arg,
+                            int stacksize, int prio)
+{
+  struct lwip_host_thread *t;
+  pthread_t id;
+
+  (void)name;
+  (void)stacksize;
+  (void)prio;
+  t = malloc(sizeof(*t));
+  LWIP_ASSERT("sys_thread_new: out of memory", t != NULL);
+  t->fn = thread;
+  t->arg = arg;
+  if (pthread_create(&id, NULL, lwip_host_sys_thread, t) != 0)
+  {
+    LWIP_ASSERT("sys_thread_new: pthread_create failed", 0);
+  }
+  pthread_detach(id);
+  return id;
+}
+
+/* The FreeRTOS ticks as a timeout of sys_arch_sem_wait() or
+ sys_arch_mbox_fetch(), where 0 is forever */
+static u32_t lwip_host_sys_ticks(TickType_t wait)
+{
+  if (wait == portMAX_DELAY)
+  {
+    return 0;
+  }
+  /* a poll waits a ms */
+  return (wait == 0) ? 1 : wait * portTICK_PERIOD_MS;
+}
+
+/* The semaphores of xSemaphoreCreateBinary() count up to one */
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+  sys_sem_t sem;
+
+  return (sys_sem_new(&sem, 0) == ERR_OK) ? sem : NULL;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait)
+{
+  return (sys_arch_sem_wait(&sem, lwip_host_sys_ticks(wait))
+          == SYS_ARCH_TIMEOUT) ? pdFALSE : pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+  BaseType_t given = pdFALSE;
+
+  pthread_mutex_lock(&sem->lock);
+  if (sem->count == 0)
+  {
+    sem->count = 1;
+    pthread_cond_signal(&sem->cond);
+    given = pdTRUE;
+  }
+  pthread_mutex_unlock(&sem->lock);
+  return given;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name,
+                       unsigned short stack, void *param, UBaseType_t prio,
+                       TaskHandle_t *task)
+{
+  sys_thread_new(name, fn, param, stack, prio);
+  if (task != NULL)
+  {
+    *task = NULL;
+  }
+  return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name,
+                               unsigned long stack, void *param,
+                               UBaseType_t prio, StackType_t *stack_buf,
+                               StaticTask_t *task_buf)
+{
+  (void)stack_buf;
+  (void)task_buf;
+  sys_thread_new(name, fn, param, stack, prio);
+  return NULL;
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t len, UBaseType_t item_size,
+                                 unsigned char *storage,
+                                 StaticQueue_t *queue_buf)
+{
+  struct lwip_host_queue *queue;
+
+  (void)storage;
+  (void)queue_buf;
+  LWIP_ASSERT("xQueueCreateStatic: item larger than a message",
+              item_size <= sizeof(void *));
+  queue = malloc(sizeof(*queue));
+  if ((queue != NULL) && (sys_mbox_new(&queue->mbox, len) != ERR_OK))
+  {
+    free(queue);
+    queue = NULL;
+  }
+  if (queue != NULL)
+  {
+    queue->item_size = item_size;
+  }
+  return queue;
+}
+
+/* Only a poll and portMAX_DELAY, what the tasks of the firmware wait for */
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+  void *msg = NULL;
+
+  memcpy(&msg, item, queue->item_size);
+  if (wait != portMAX_DELAY)
+  {
+    return (sys_mbox_trypost(&queue->mbox, msg) == ERR_OK) ? pdTRUE : pdFALSE;
+  }
+  sys_mbox_post(&queue->mbox, msg);
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+  void *msg;
+
+  if (sys_arch_mbox_fetch(&queue->mbox, &msg, lwip_host_sys_ticks(wait))
+      == SYS_ARCH_TIMEOUT)
+  {
+    return pdFALSE;
+  }
+  memcpy(item, &msg, queue->item_size);
+  return pdTRUE;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+  struct timespec ts;
+
+  lwip_host_sys_waited();
+  ts.tv_sec = ticks * portTICK_PERIOD_MS / 1000;
+  ts.tv_nsec = (long)(ticks * portTICK_PERIOD_MS % 1000) * 1000000;
+  nanosleep(&ts, NULL);
+}
+
+/* The interrupts of the device, before sdk_system_restart(): nothing to mask
+ on the host */
+void vPortEnterCritical(void)
+{
+}
+
+#endif /* !NO_SYS */
+
+#endif /* LWIP_HOST */
@@ -0,0 +1,353 @@
+/*
+ * TCPIP core locking benchmark, a host program ("make lockbench")
+ *
+ * The core runs with the tcpip thread of lwip_tcpip.c on the threads of
+ * lwip_host_sys.c, pinned to one CPU as on the one core of the device. A
+ * client task exchanges LOCK_BENCH_MSG byte messages with an echo task over
+ * the loopback netif, with the calls of mqtt_port.c: select() and send(),
+ * select() and recv(). Then it calls getsockname(), an API call that does
+ * no I/O.
+ *
+ * Per loop: socket calls per second, and per call the times a task had to
+ * wait (lwip_host_sys_waits) and the context switches the host counted
+ * (getrusage()). The Makefile builds the program a second time with
+ * LWIP_TCPIP_CORE_LOCKING 0, where each API call is a message to the tcpip
+ * thread and a wait for its answer.
+ *
+ * Before the loops, timeouts added by the client task must fire on time:
+ * with core locking they are added while the tcpip thread waits for a later
+ * one, see sys_timeouts_mbox_fetch().
+ */
+#if defined(LWIP_HOST)
+
+#define _GNU_SOURCE
+
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_sys.h"
+#include "lwip/lwip_tcpip.h"
+#include "lwip/lwip_timers.h"
+#include "lwip/lwip_sockets.h"
+
+#if NO_SYS || !LWIP_SOCKET || !LWIP_NETIF_LOOPBACK || !LWIP_HAVE_LOOPIF
+#error "lockbench needs the sockets of lwip_host_sys.c and the loopback netif"
+#endif
+
+#define LOCK_BENCH_PORT         7000
+#define LOCK_BENCH_MSG          64
+#define LOCK_BENCH_ROUNDS       20000
+#define LOCK_BENCH_CALLS        100000
+/* The timeouts added by the client task, and how late they may fire */
+#define LOCK_BENCH_TIMEOUTS     10
+#define LOCK_BENCH_TIMEOUT      20
+#define LOCK_BENCH_LATE         50
+
+typedef struct
+{
+  double start;
+  unsigned long waits;
+  long switches;
+  unsigned long calls;
+} lock_bench_mark_t;
+
+static sys_sem_t lock_bench_sem;
+static u32_t lock_bench_t0;
+static unsigned long lock_bench_calls;
+static unsigned long lock_bench_failures;
+
+static void lock_bench_check(int ok, const char *what)
+{
+  if (!ok)
+  {
+    lock_bench_failures++;
+    printf("lockbench: at %u ms: %s\n", (unsigned)(sys_now() - lock_bench_t0),
+           what);
+  }
+}
+
+static double lock_bench_clock(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long lock_bench_switches(void)
+{
+  struct rusage ru;
+
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_nvcsw + ru.ru_nivcsw;
+}
+
+static void lock_bench_called(void)
+{
+  __atomic_add_fetch(&lock_bench_calls, 1, __ATOMIC_RELAXED);
+}
+
+static void lock_bench_mark(lock_bench_mark_t *mark)
+{
+  mark->start = lock_bench_clock();
+  mark->waits = __atomic_load_n(&lwip_host_sys_waits, __ATOMIC_RELAXED);
+  mark->switches = lock_bench_switches();
+  mark->calls = __atomic_load_n(&lock_bench_calls, __ATOMIC_RELAXED);
+}
+
+static void lock_bench_report(const lock_bench_mark_t *mark, const char *what)
+{
+  double secs = lock_bench_clock() - mark->start;
+  unsigned long calls = __atomic_load_n(&lock_bench_calls, __ATOMIC_RELAXED)
+      - mark->calls;
+  unsigned long waits = __atomic_load_n(&lwip_host_sys_waits, __ATOMIC_RELAXED)
+      - mark->waits;
+  long switches = lock_bench_switches() - mark->switches;
+
+  printf("  %-12s %7lu calls %9.0f calls/s %5.2f waits/call "
+         "%5.2f switches/call\n", what, calls, calls / secs,
+         (double)waits / calls, (double)switches / calls);
+}
+
+static void lock_bench_init_done(void *arg)
+{
+  sys_sem_signal((sys_sem_t *)arg);
+}
+
+static void lock_bench_timeout(void *arg)
+{
+  sys_sem_signal((sys_sem_t *)arg);
+}
+
+static void lock_bench_add_timeout(void *arg)
+{
+  sys_timeout(LOCK_BENCH_TIMEOUT, lock_bench_timeout, arg);
+}
+
+/* Timeouts added by this task fire after LOCK_BENCH_TIMEOUT, not before and
+ not when the tcpip thread wakes up for a later one */
+static void lock_bench_timeouts(void)
+{
+  u32_t waited;
+  int i;
+
+  for (i = 0; i < LOCK_BENCH_TIMEOUTS; i++)
+  {
+#if LWIP_TCPIP_CORE_LOCKING
+    LOCK_TCPIP_CORE();
+    lock_bench_add_timeout(&lock_bench_sem);
+    UNLOCK_TCPIP_CORE();
+#else
+    tcpip_callback(lock_bench_add_timeout, &lock_bench_sem);
+#endif /* LWIP_TCPIP_CORE_LOCKING */
+    waited = sys_arch_sem_wait(&lock_bench_sem, 1000);
+    lock_bench_check(waited != SYS_ARCH_TIMEOUT, "timeout never fired");
+    lock_bench_check(waited + 1 >= LOCK_BENCH_TIMEOUT, "timeout fired early");
+    lock_bench_check((waited == SYS_ARCH_TIMEOUT)
+                     || (waited < LOCK_BENCH_TIMEOUT + LOCK_BENCH_LATE),
+                     "timeout fired late");
+  }
+}
+
+/* recv() or send() the 'len' bytes of 'buf' */
+static int lock_bench_io(int s, char *buf, int len, int out)
+{
+  int done = 0;
+  int n;
+
+  while (done < len)
+  {
+    if (out)
+    {
+      n = lwip_send(s, buf + done, len - done, 0);
+    }
+    else
+    {
+      n = lwip_recv(s, buf + done, len - done, 0);
+    }
+    if (n <= 0)
+    {
+      return -1;
+    }
+    lock_bench_called();
+    done += n;
+  }
+  return 0;
+}
+
+/* select() for reading or writing, as mqtt_port.c before each call */
+static int lock_bench_select(int s, int out)
+{
+  fd_set fds;
+  struct timeval tv;
+  int n;
+
+  FD_ZERO(&fds);
+  FD_SET(s, &fds);
+  tv.tv_sec = 1;
+  tv.tv_usec = 0;
+  n = lwip_select(s + 1, out ? NULL : &fds, out ? &fds : NULL, NULL, &tv);
+  lock_bench_called();
+  return n;
+}
+
+static void lock_bench_echo(void *arg)
+{
+  char buf[LOCK_BENCH_MSG];
+  int listener = *(int *)arg;
+  int s;
+
+  s = lwip_accept(listener, NULL, NULL);
+  sys_sem_signal(&lock_bench_sem);
+  while ((s >= 0) && (lock_bench_io(s, buf, sizeof(buf), 0) == 0)
+         && (lock_bench_io(s, buf, sizeof(buf), 1) == 0))
+  {
+  }
+  lwip_close(s);
+  sys_sem_signal(&lock_bench_sem);
+}
+
+static int lock_bench_listen(void)
+{
+  struct sockaddr_in addr;
+  int s;
+
+  s = lwip_socket(AF_INET, SOCK_STREAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(LOCK_BENCH_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if ((s < 0) || (lwip_bind(s, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+      || (lwip_listen(s, 1) != 0))
+  {
+    return -1;
+  }
+  return s;
+}
+
+static int lock_bench_connect(void)
+{
+  struct sockaddr_in addr;
+  int one = 1;
+  int s;
+
+  s = lwip_socket(AF_INET, SOCK_STREAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(LOCK_BENCH_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if ((s < 0) || (lwip_connect(s, (struct sockaddr *)&addr, sizeof(addr)) != 0))
+  {
+    return -1;
+  }
+  lwip_setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return s;
+}
+
+/* LOCK_BENCH_ROUNDS messages to the echo task and back */
+static void lock_bench_rounds(int s)
+{
+  char out[LOCK_BENCH_MSG];
+  char in[LOCK_BENCH_MSG];
+  lock_bench_mark_t mark;
+  u32_t round;
+
+  lock_bench_mark(&mark);
+  for (round = 0; round < LOCK_BENCH_ROUNDS; round++)
+  {
+    memset(out, 0, sizeof(out));
+    memcpy(out, &round, sizeof(round));
+    if ((lock_bench_select(s, 1) != 1)
+        || (lock_bench_io(s, out, sizeof(out), 1) != 0)
+        || (lock_bench_select(s, 0) != 1)
+        || (lock_bench_io(s, in, sizeof(in), 0) != 0))
+    {
+      lock_bench_check(0, "echo failed");
+      return;
+    }
+    if (memcmp(in, out, sizeof(in)) != 0)
+    {
+      lock_bench_check(0, "echo corrupted");
+      return;
+    }
+  }
+  lock_bench_report(&mark, "echo");
+}
+
+/* LOCK_BENCH_CALLS getsockname() */
+static void lock_bench_getsockname(int s)
+{
+  struct sockaddr_in addr;
+  socklen_t len;
+  lock_bench_mark_t mark;
+  int i;
+
+  lock_bench_mark(&mark);
+  for (i = 0; i < LOCK_BENCH_CALLS; i++)
+  {
+    len = sizeof(addr);
+    if (lwip_getsockname(s, (struct sockaddr *)&addr, &len) != 0)
+    {
+      lock_bench_check(0, "getsockname failed");
+      return;
+    }
+    lock_bench_called();
+  }
+  lock_bench_check(addr.sin_addr.s_addr == htonl(INADDR_LOOPBACK),
+                   "getsockname wrong address");
+  lock_bench_report(&mark, "getsockname");
+}
+
+int main(void)
+{
+  cpu_set_t cpus;
+  int listener;
+  int s;
+
+  /* the threads of lwip_host_sys.c inherit it */
+  CPU_ZERO(&cpus);
+  CPU_SET(0, &cpus);
+  sched_setaffinity(0, sizeof(cpus), &cpus);
+
+  printf("lockbench, LWIP_TCPIP_CORE_LOCKING %d, %d B messages over loopback, "
+         "one CPU\n", LWIP_TCPIP_CORE_LOCKING, LOCK_BENCH_MSG);
+  lock_bench_t0 = sys_now();
+  sys_sem_new(&lock_bench_sem, 0);
+  tcpip_init(lock_bench_init_done, &lock_bench_sem);
+  sys_sem_wait(&lock_bench_sem);
+
+  lock_bench_timeouts();
+
+  listener = lock_bench_listen();
+  lock_bench_check(listener >= 0, "listen failed");
+  if (listener < 0)
+  {
+    return 1;
+  }
+  sys_thread_new("echo", lock_bench_echo, &listener, 0, 0);
+  s = lock_bench_connect();
+  lock_bench_check(s >= 0, "connect failed");
+  if (s < 0)
+  {
+    return 1;
+  }
+  sys_sem_wait(&lock_bench_sem);
+
+  lock_bench_rounds(s);
+  lock_bench_getsockname(s);
+  /* the timers still run with the connection busy */
+  lock_bench_timeouts();
+
+  lwip_close(s);
+  lock_bench_check(sys_arch_sem_wait(&lock_bench_sem, 1000) != SYS_ARCH_TIMEOUT,
+                   "echo task did not see the close");
+  lwip_close(listener);
+
+  return (lock_bench_failures == 0) ? 0 : 1;
+}
+
+#endif /* LWIP_HOST */
@@ -0,0 +1,431 @@
+/* Network and system metrics, see lwip_metrics.h.
+
+ The snapshot is written by the tcpip thread only, into the buffer that is
+ not published, and published by incrementing metrics_gen. Readers copy the
+ buffer of the current generation: the writer only comes back to that buffer
+ after publishing the next generation, so a copy during which metrics_gen
+ did not change is whole. The CPU has a single core, a compiler barrier is
+ enough to order the accesses.
+ */
+#include "lwip/lwip_opt.h"
+
+#include "lwip/lwip_def.h"
+#include "lwip/lwip_stats.h"
+#include "lwip/lwip_sys.h"
+#include "lwip/lwip_tcp_impl.h"
+#include "lwip/lwip_tcpip.h"
+#include "lwip/lwip_timers.h"
+#include "lwip_esp_interface.h"
+#include "lwip_metrics.h"
+#include "lwip_pool.h"
+
+#include "freertos.h"
+#include "freertos_task.h"
+#include "heap_stats.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define METRICS_BARRIER()   __asm__ volatile("" ::: "memory")
+
+/* Copies attempted by lwip_metrics_get() */
+#define METRICS_GET_TRIES   4
+
+/* Pool classes exported */
+#define METRICS_POOLS       8
+
+typedef struct
+{
+  char *buf;
+  size_t len;
+  size_t pos;
+  bool full;
+} metrics_out_t;
+
+/* Everything a formatter reads, allocated per call to stay off the stack of
+ the tcpip thread */
+typedef struct
+{
+  metrics_snapshot_t snap;
+  heap_stats_t heap;
+#if LWIP_POOL
+  lwip_pool_stats_t pools[METRICS_POOLS];
+#endif /* LWIP_POOL */
+  rx_class_stats_t rx[RX_CLASS_NUM];
+} metrics_work_t;
+
+#if LWIP_STATS
+static const struct
+{
+  const char *name;
+  const struct stats_proto *stats;
+} metrics_protos[] =
+{
+#if LINK_STATS
+  { "link", &lwip_stats.link },
+#endif /* LINK_STATS */
+#if ETHARP_STATS
+  { "etharp", &lwip_stats.etharp },
+#endif /* ETHARP_STATS */
+#if IPFRAG_STATS
+  { "ip_frag", &lwip_stats.ip_frag },
+#endif /* IPFRAG_STATS */
+#if IP_STATS
+  { "ip", &lwip_stats.ip },
+#endif /* IP_STATS */
+#if ICMP_STATS
+  { "icmp", &lwip_stats.icmp },
+#endif /* ICMP_STATS */
+#if UDP_STATS
+  { "udp", &lwip_stats.udp },
+#endif /* UDP_STATS */
+#if TCP_STATS
+  { "tcp", &lwip_stats.tcp },
+#endif /* TCP_STATS */
+};
+
+#define METRICS_PROTOS  (sizeof(metrics_protos) / sizeof(metrics_protos[0]))
+#else /* LWIP_STATS */
+#define METRICS_PROTOS  0
+#endif /* LWIP_STATS */
+
+static const char * const metrics_rx_names[RX_CLASS_NUM] =
+{ "control", "flow", "bulk" };
+
+static metrics_snapshot_t metrics_buf[2];
+static volatile u32_t metrics_gen;
+static u8_t metrics_started;
+
+/* Runs in the tcpip thread */
+static void metrics_take(void *arg)
+{
+  metrics_snapshot_t *snap = &metrics_buf[(metrics_gen + 1) & 1];
+  metrics_tcp_conn_t *conn;
+  struct tcp_pcb *pcb;
+  u8_t i;
+
+  LWIP_UNUSED_ARG(arg);
+
+  snap->time = sys_now();
+  snap->num_protos = METRICS_PROTOS;
+#if LWIP_STATS
+  for (i = 0; i < METRICS_PROTOS; i++)
+  {
+    snap->protos[i].xmit = metrics_protos[i].stats->xmit;
+    snap->protos[i].recv = metrics_protos[i].stats->recv;
+    snap->protos[i].drop = metrics_protos[i].stats->drop;
+    snap->protos[i].chkerr = metrics_protos[i].stats->chkerr;
+    snap->protos[i].memerr = metrics_protos[i].stats->memerr;
+    snap->protos[i].err = metrics_protos[i].stats->err;
+  }
+#endif /* LWIP_STATS */
+#if SYS_STATS
+  snap->mbox_err = lwip_stats.sys.mbox.err;
+#else /* SYS_STATS */
+  snap->mbox_err = 0;
+#endif /* SYS_STATS */
+
+  snap->tcp_active = 0;
+  snap->num_conns = 0;
+  for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next)
+  {
+    snap->tcp_active++;
+    if (snap->num_conns == METRICS_TCP_CONNS)
+    {
+      continue;
+    }
+    conn = &snap->conns[snap->num_conns++];
+    ip_addr_copy(conn->remote_ip, pcb->remote_ip);
+    conn->local_port = pcb->local_port;
+    conn->remote_port = pcb->remote_port;
+    conn->state = pcb->state;
+    conn->nrtx = pcb->nrtx;
+#if TCP_STATS
+    conn->rexmit = pcb->rexmit;
+#else /* TCP_STATS */
+    conn->rexmit = 0;
+#endif /* TCP_STATS */
+    /* sa is 8 times the smoothed RTT, in slow timer ticks */
+    conn->srtt_ms = (pcb->sa > 0) ? (u32_t)(pcb->sa >> 3) * TCP_SLOW_INTERVAL
+                                  : 0;
+    conn->rto_ms = (u32_t)pcb->rto * TCP_SLOW_INTERVAL;
+    conn->snd_used = TCP_SND_BUF - pcb->snd_buf;
+    conn->snd_queuelen = pcb->snd_queuelen;
+    conn->cwnd = pcb->cwnd;
+    conn->snd_wnd = pcb->snd_wnd;
+  }
+  snap->tcp_tw = 0;
+  for (pcb = tcp_tw_pcbs; pcb != NULL; pcb = pcb->next)
+  {
+    snap->tcp_tw++;
+  }
+
+  METRICS_BARRIER();
+  metrics_gen++;
+
+  sys_timeout(METRICS_PERIOD_MS, metrics_take, NULL);
+}
+
+static void metrics_printf(metrics_out_t *out, const char *fmt, ...)
+{
+  va_list args;
+  int n;
+
+  if (out->full)
+  {
+    return;
+  }
+  va_start(args, fmt);
+  n = vsnprintf(out->buf + out->pos, out->len - out->pos, fmt, args);
+  va_end(args);
+  if ((n < 0) || ((size_t)n >= out->len - out->pos))
+  {
+    /* drop the partial lines, the output stays parseable */
+    out->buf[out->pos] = '\0';
+    out->full = true;
+    return;
+  }
+  out->pos += n;
+}
+
+static void metrics_text_tasks(metrics_out_t *out)
+{
+  UBaseType_t max = uxTaskGetNumberOfTasks();
+  TaskStatus_t *tasks;
+  UBaseType_t count;
+  UBaseType_t i;
+
+  if (max > METRICS_TASKS)
+  {
+    max = METRICS_TASKS;
+  }
+  tasks = malloc(max * sizeof(TaskStatus_t));
+  if (tasks == NULL)
+  {
+    return;
+  }
+  count = uxTaskGetSystemState(tasks, max, NULL);
+  metrics_printf(out, "tasks %u\n", (unsigned)uxTaskGetNumberOfTasks());
+  for (i = 0; i < count; i++)
+  {
+    metrics_printf(out, "task_stack_free_words{task=\"%s\"} %u\n",
+                   tasks[i].pcTaskName,
+                   (unsigned)tasks[i].usStackHighWaterMark);
+  }
+  free(tasks);
+}
+
+void lwip_metrics_init(void)
+{
+  u8_t start;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  start = !metrics_started;
+  metrics_started = 1;
+  SYS_ARCH_UNPROTECT(lev);
+
+  if (start && (tcpip_callback(metrics_take, NULL) != ERR_OK))
+  {
+    /* the tcpip thread is not up yet, the next call tries again */
+    metrics_started = 0;
+  }
+}
+
+bool lwip_metrics_get(metrics_snapshot_t *snap)
+{
+  u32_t gen;
+  u8_t i;
+
+  for (i = 0; i < METRICS_GET_TRIES; i++)
+  {
+    gen = metrics_gen;
+    if (gen == 0)
+    {
+      return false;
+    }
+    METRICS_BARRIER();
+    memcpy(snap, &metrics_buf[gen & 1], sizeof(*snap));
+    METRICS_BARRIER();
+    if (metrics_gen == gen)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *lwip_metrics_proto_name(u8_t i)
+{
+#if LWIP_STATS
+  if (i < METRICS_PROTOS)
+  {
+    return metrics_protos[i].name;
+  }
+#endif /* LWIP_STATS */
+  return "";
+}
+
+size_t lwip_metrics_format_text(char *buf, size_t len)
+{
+  metrics_work_t *work;
+  metrics_snapshot_t *snap;
+  metrics_tcp_conn_t *conn;
+  metrics_out_t out = { buf, len, 0, false };
+  const char *name;
+#if LWIP_POOL
+  u8_t count;
+#endif /* LWIP_POOL */
+  u8_t i;
+
+  if (len == 0)
+  {
+    return 0;
+  }
+  work = malloc(sizeof(metrics_work_t));
+  if (work == NULL)
+  {
+    return 0;
+  }
+  snap = &work->snap;
+  if (!lwip_metrics_get(snap))
+  {
+    free(work);
+    return 0;
+  }
+
+  metrics_printf(&out, "uptime_seconds %u\n", snap->time / 1000);
+  for (i = 0; i < snap->num_protos; i++)
+  {
+    name = lwip_metrics_proto_name(i);
+    metrics_printf(&out, "lwip_%s_xmit %u\nlwip_%s_recv %u\n"
+                   "lwip_%s_drop %u\nlwip_%s_chkerr %u\n"
+                   "lwip_%s_memerr %u\nlwip_%s_err %u\n",
+                   name, snap->protos[i].xmit, name, snap->protos[i].recv,
+                   name, snap->protos[i].drop, name, snap->protos[i].chkerr,
+                   name, snap->protos[i].memerr, name, snap->protos[i].err);
+  }
+  metrics_printf(&out, "lwip_mbox_err %u\n", snap->mbox_err);
+
+  metrics_printf(&out, "lwip_tcp_active %u\nlwip_tcp_time_wait %u\n",
+                 snap->tcp_active, snap->tcp_tw);
+  for (i = 0; i < snap->num_conns; i++)
+  {
+    conn = &snap->conns[i];
+    metrics_printf(&out, "lwip_tcp_conn{c=\"%u\",local=\"%u\","
+                   "remote=\"%u.%u.%u.%u:%u\",state=\"%s\"} 1\n",
+                   i, conn->local_port, ip4_addr1_16(&conn->remote_ip),
+                   ip4_addr2_16(&conn->remote_ip),
+                   ip4_addr3_16(&conn->remote_ip),
+                   ip4_addr4_16(&conn->remote_ip), conn->remote_port,
+                   tcp_debug_state_str((enum tcp_state)conn->state));
+    metrics_printf(&out, "lwip_tcp_srtt_ms{c=\"%u\"} %u\n"
+                   "lwip_tcp_rto_ms{c=\"%u\"} %u\n"
+                   "lwip_tcp_nrtx{c=\"%u\"} %u\n"
+                   "lwip_tcp_rexmit{c=\"%u\"} %u\n"
+                   "lwip_tcp_snd_used{c=\"%u\"} %u\n"
+                   "lwip_tcp_snd_queuelen{c=\"%u\"} %u\n"
+                   "lwip_tcp_cwnd{c=\"%u\"} %u\n"
+                   "lwip_tcp_snd_wnd{c=\"%u\"} %u\n",
+                   i, conn->srtt_ms, i, conn->rto_ms, i, conn->nrtx,
+                   i, conn->rexmit, i, conn->snd_used, i, conn->snd_queuelen,
+                   i, conn->cwnd, i, conn->snd_wnd);
+  }
+
+#if LWIP_POOL
+  count = lwip_pool_get_stats(work->pools, METRICS_POOLS);
+  for (i = 0; (i < count) && (i < METRICS_POOLS); i++)
+  {
+    metrics_printf(&out, "lwip_pool_num{size=\"%u\"} %u\n"
+                   "lwip_pool_used{size=\"%u\"} %u\n"
+                   "lwip_pool_max{size=\"%u\"} %u\n"
+                   "lwip_pool_err{size=\"%u\"} %u\n",
+                   work->pools[i].size, work->pools[i].num,
+                   work->pools[i].size, work->pools[i].used,
+                   work->pools[i].size, work->pools[i].max,
+                   work->pools[i].size, work->pools[i].err);
+  }
+#endif /* LWIP_POOL */
+
+  ethernetif_get_rx_stats(work->rx);
+  for (i = 0; i < RX_CLASS_NUM; i++)
+  {
+    name = metrics_rx_names[i];
+    metrics_printf(&out, "rx_queued{class=\"%s\"} %u\n"
+                   "rx_drop_full{class=\"%s\"} %u\n"
+                   "rx_drop_heap{class=\"%s\"} %u\n"
+                   "rx_queue_max{class=\"%s\"} %u\n",
+                   name, work->rx[i].queued, name, work->rx[i].drop_full,
+                   name, work->rx[i].drop_heap, name, work->rx[i].max);
+  }
+
+  heap_get_stats(&work->heap);
+  metrics_printf(&out, "heap_free %u\nheap_largest %u\nheap_live %u\n"
+                 "heap_blocks %u\nheap_fails %u\n", work->heap.free,
+                 work->heap.largest, work->heap.live, work->heap.blocks,
+                 work->heap.fails);
+  free(work);
+
+  metrics_text_tasks(&out);
+
+  return out.pos;
+}
+
+size_t lwip_metrics_format_json(char *buf, size_t len)
+{
+  metrics_snapshot_t *snap;
+  rx_class_stats_t rx[RX_CLASS_NUM];
+  heap_stats_t heap;
+  metrics_proto_t tcp;
+  u32_t rtt = 0;
+  u32_t rexmit = 0;
+  u32_t rx_drop = 0;
+  int n;
+  u8_t i;
+
+  snap = malloc(sizeof(metrics_snapshot_t));
+  if (snap == NULL)
+  {
+    return 0;
+  }
+  if (!lwip_metrics_get(snap))
+  {
+    free(snap);
+    return 0;
+  }
+
+  memset(&tcp, 0, sizeof(tcp));
+  for (i = 0; i < snap->num_protos; i++)
+  {
+    if (!strcmp(lwip_metrics_proto_name(i), "tcp"))
+    {
+      tcp = snap->protos[i];
+    }
+  }
+  for (i = 0; i < snap->num_conns; i++)
+  {
+    rtt = LWIP_MAX(rtt, snap->conns[i].srtt_ms);
+    rexmit += snap->conns[i].rexmit;
+  }
+  ethernetif_get_rx_stats(rx);
+  for (i = 0; i < RX_CLASS_NUM; i++)
+  {
+    rx_drop += rx[i].drop_full + rx[i].drop_heap;
+  }
+  heap_get_stats(&heap);
+
+  n = snprintf(buf, len, "{\"up\":%u,\"heap\":%u,\"heap_max\":%u,"
+               "\"tcp_tx\":%u,\"tcp_rx\":%u,\"tcp_drop\":%u,\"conns\":%u,"
+               "\"rtt_ms\":%u,\"rexmit\":%u,\"rx_drop\":%u}",
+               snap->time / 1000, heap.free, heap.largest, tcp.xmit, tcp.recv,
+               tcp.drop, snap->tcp_active, rtt, rexmit, rx_drop);
+  free(snap);
+
+  if ((n < 0) || ((size_t)n >= len))
+  {
+    return 0;
+  }
+  return n;
+}
@@ -0,0 +1,310 @@
+/*
+ * Out of order queue test, a host program ("make ooseqtest")
+ *
+ * A peer uploads OOSEQ_TEST_BYTES to a listener of the device, as a POST to
+ * the web server does, over a link of the host port of the core
+ * (lwip_host.h) at OOSEQ_TEST_RATE with a round trip of OOSEQ_TEST_RTT ms.
+ * Frames are lost both ways at 0, 1, 5 and 10 %, OOSEQ_TEST_RUNS uploads
+ * each, and the goodput is the bytes received over the time the uploads
+ * took, with the fast retransmits and the retransmission timeouts of the
+ * peer.
+ *
+ * The peer stands for a PC: the Makefile raises TCP_SND_BUF so that it fills
+ * the window of the device. Throughout, the out of order data of the device
+ * must stay within TCP_OOSEQ_MAX_BYTES and TCP_OOSEQ_MAX_PBUFS, and the 5 %
+ * uploads are repeated with the free heap below TCP_OOSEQ_MIN_FREE_HEAP,
+ * where nothing may be queued.
+ *
+ * The Makefile builds the program a second time with TCP_QUEUE_OOSEQ 0.
+ */
+#if defined(LWIP_HOST)
+
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_tcp.h"
+#include "lwip/lwip_tcp_impl.h"
+#include "lwip_host.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if !LWIP_TCP
+#error "ooseqtest needs LWIP_TCP"
+#endif
+
+/* Link of 5 Mbit/s, bytes per ms, with a round trip of 20 ms */
+#define OOSEQ_TEST_RATE         625
+#define OOSEQ_TEST_DELAY        10
+#define OOSEQ_TEST_RTT          (2 * OOSEQ_TEST_DELAY)
+/* Uploads per loss rate, and their length */
+#define OOSEQ_TEST_RUNS         32
+#define OOSEQ_TEST_BYTES        (256 * 1024)
+/* Longest an upload may take */
+#define OOSEQ_TEST_WAIT         (600 * 1000)
+#define OOSEQ_TEST_PORT         80
+
+typedef struct
+{
+  struct tcp_pcb *peer;
+  struct tcp_pcb *dev;
+  u32_t to_send;
+  u32_t received;
+  int aborted;
+  /* fast retransmits and retransmission timeouts of the peer */
+  u32_t fast;
+  u32_t rto;
+  u8_t nrtx;
+  u8_t infr;
+  /* out of order data of the device, the most seen */
+  u32_t ooseq_bytes;
+  u32_t ooseq_pbufs;
+} ooseq_test_upload_t;
+
+static const u32_t ooseq_test_loss[] = { 0, 10000, 50000, 100000 };
+
+static lwip_host_seg_t ooseq_test_link;
+static struct netif ooseq_test_dev;
+static struct netif ooseq_test_peer;
+static struct tcp_pcb *ooseq_test_listen;
+static ooseq_test_upload_t ooseq_test_upload;
+static u8_t ooseq_test_data[TCP_MSS];
+static unsigned long ooseq_test_failures;
+
+static void ooseq_test_check(int ok, const char *what)
+{
+  if (!ok)
+  {
+    ooseq_test_failures++;
+    printf("ooseqtest: at %u ms: %s\n", (unsigned)lwip_host_now, what);
+  }
+}
+
+static void ooseq_test_err(void *arg, err_t err)
+{
+  ooseq_test_upload_t *upload = arg;
+
+  (void)err;
+  upload->aborted = 1;
+  upload->peer = NULL;
+  upload->dev = NULL;
+}
+
+/* Keep the send buffer of the peer full */
+static void ooseq_test_fill(struct tcp_pcb *pcb, ooseq_test_upload_t *upload)
+{
+  u16_t len;
+
+  while ((upload->to_send > 0) && (tcp_sndbuf(pcb) > 0)
+         && (tcp_sndqueuelen(pcb) < TCP_SND_QUEUELEN))
+  {
+    len = LWIP_MIN(LWIP_MIN(tcp_sndbuf(pcb), sizeof(ooseq_test_data)),
+                   upload->to_send);
+    if (tcp_write(pcb, ooseq_test_data, len, TCP_WRITE_FLAG_COPY) != ERR_OK)
+    {
+      break;
+    }
+    upload->to_send -= len;
+  }
+  tcp_output(pcb);
+}
+
+static err_t ooseq_test_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+  (void)len;
+  ooseq_test_fill(pcb, arg);
+  return ERR_OK;
+}
+
+static err_t ooseq_test_connected(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+  (void)err;
+  ooseq_test_fill(pcb, arg);
+  return ERR_OK;
+}
+
+static err_t ooseq_test_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p,
+                             err_t err)
+{
+  ooseq_test_upload_t *upload = arg;
+
+  (void)err;
+  if (p == NULL)
+  {
+    return ERR_OK;
+  }
+  upload->received += p->tot_len;
+  tcp_recved(pcb, p->tot_len);
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static err_t ooseq_test_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+  (void)arg;
+  (void)err;
+  tcp_accepted(ooseq_test_listen);
+  ooseq_test_upload.dev = pcb;
+  tcp_arg(pcb, &ooseq_test_upload);
+  tcp_recv(pcb, ooseq_test_recv);
+  tcp_err(pcb, ooseq_test_err);
+  return ERR_OK;
+}
+
+/* lwip_host_run_until() calls it every ms: count the retransmissions of
+ the peer and measure the out of order queue of the device */
+static int ooseq_test_done(void *arg)
+{
+  ooseq_test_upload_t *upload = arg;
+#if TCP_QUEUE_OOSEQ
+  struct tcp_seg *seg;
+  u32_t bytes = 0;
+  u32_t pbufs = 0;
+
+  if (upload->dev != NULL)
+  {
+    for (seg = upload->dev->ooseq; seg != NULL; seg = seg->next)
+    {
+      bytes += seg->p->tot_len;
+      pbufs += pbuf_clen(seg->p);
+    }
+  }
+  upload->ooseq_bytes = LWIP_MAX(upload->ooseq_bytes, bytes);
+  upload->ooseq_pbufs = LWIP_MAX(upload->ooseq_pbufs, pbufs);
+#endif /* TCP_QUEUE_OOSEQ */
+  if (upload->peer != NULL)
+  {
+    if ((upload->peer->flags & TF_INFR) && !upload->infr)
+    {
+      upload->fast++;
+    }
+    else if (upload->peer->nrtx > upload->nrtx)
+    {
+      upload->rto++;
+    }
+    upload->nrtx = upload->peer->nrtx;
+    upload->infr = upload->peer->flags & TF_INFR;
+  }
+  return upload->aborted || (upload->received == OOSEQ_TEST_BYTES);
+}
+
+/* One upload, returns the time it took in ms, 0 if it failed */
+static u32_t ooseq_test_run(ooseq_test_upload_t *upload)
+{
+  u32_t time;
+
+  memset(upload, 0, sizeof(*upload));
+  upload->to_send = OOSEQ_TEST_BYTES;
+  upload->peer = tcp_new();
+  if (upload->peer == NULL)
+  {
+    return 0;
+  }
+  tcp_arg(upload->peer, upload);
+  tcp_err(upload->peer, ooseq_test_err);
+  tcp_sent(upload->peer, ooseq_test_sent);
+  tcp_bind(upload->peer, &ooseq_test_peer.ip_addr, 0);
+  tcp_connect(upload->peer, &ooseq_test_dev.ip_addr, OOSEQ_TEST_PORT,
+              ooseq_test_connected);
+
+  time = lwip_host_run_until(ooseq_test_done, upload, OOSEQ_TEST_WAIT);
+  ooseq_test_check(!upload->aborted && (time <= OOSEQ_TEST_WAIT),
+                   "upload failed");
+  ooseq_test_check(upload->ooseq_bytes <= TCP_OOSEQ_MAX_BYTES,
+                   "out of order bytes above TCP_OOSEQ_MAX_BYTES");
+  ooseq_test_check(upload->ooseq_pbufs <= TCP_OOSEQ_MAX_PBUFS,
+                   "out of order pbufs above TCP_OOSEQ_MAX_PBUFS");
+
+  /* done with both ends, the frames in flight are dropped */
+  if (upload->peer != NULL)
+  {
+    tcp_arg(upload->peer, NULL);
+    tcp_err(upload->peer, NULL);
+    tcp_abort(upload->peer);
+  }
+  if (upload->dev != NULL)
+  {
+    tcp_arg(upload->dev, NULL);
+    tcp_err(upload->dev, NULL);
+    tcp_abort(upload->dev);
+  }
+  lwip_host_run(1000);
+  return upload->aborted ? 0 : time;
+}
+
+/* OOSEQ_TEST_RUNS uploads, returns the most out of order bytes seen */
+static u32_t ooseq_test_loss_rate(u32_t loss, const char *what)
+{
+  u32_t bytes = 0;
+  u32_t total = 0;
+  u32_t fast = 0;
+  u32_t rto = 0;
+  u32_t ooseq = 0;
+  u32_t time;
+  int run;
+
+  ooseq_test_link.loss = loss;
+  for (run = 0; run < OOSEQ_TEST_RUNS; run++)
+  {
+    lwip_host_init(run + 1);
+    time = ooseq_test_run(&ooseq_test_upload);
+    if (time == 0)
+    {
+      continue;
+    }
+    bytes += ooseq_test_upload.received;
+    total += time;
+    fast += ooseq_test_upload.fast;
+    rto += ooseq_test_upload.rto;
+    ooseq = LWIP_MAX(ooseq, ooseq_test_upload.ooseq_bytes);
+  }
+  printf("  loss %2u %% %-9s %5.1f kB/s, %5u ms/upload, %3u fast, %3u timeouts, "
+         "%4u bytes out of order\n", (unsigned)(loss / 10000), what,
+         total ? bytes * 1000.0 / total / 1024 : 0.0,
+         (unsigned)(total / OOSEQ_TEST_RUNS), (unsigned)fast, (unsigned)rto,
+         (unsigned)ooseq);
+  return ooseq;
+}
+
+int main(void)
+{
+  ip_addr_t addr;
+  ip_addr_t mask;
+  size_t i;
+
+  lwip_host_init(1);
+  lwip_host_seg_init(&ooseq_test_link);
+  ooseq_test_link.rate = OOSEQ_TEST_RATE;
+  ooseq_test_link.delay = OOSEQ_TEST_DELAY;
+  IP4_ADDR(&mask, 255, 255, 255, 0);
+  IP4_ADDR(&addr, 10, 0, 1, 1);
+  lwip_host_link_add(&ooseq_test_link, &ooseq_test_dev, &addr, &mask);
+  IP4_ADDR(&addr, 10, 0, 2, 1);
+  lwip_host_link_add(&ooseq_test_link, &ooseq_test_peer, &addr, &mask);
+
+  ooseq_test_listen = tcp_new();
+  tcp_bind(ooseq_test_listen, &ooseq_test_dev.ip_addr, OOSEQ_TEST_PORT);
+  ooseq_test_listen = tcp_listen(ooseq_test_listen);
+  tcp_accept(ooseq_test_listen, ooseq_test_accept);
+  for (i = 0; i < sizeof(ooseq_test_data); i++)
+  {
+    ooseq_test_data[i] = (u8_t)i;
+  }
+
+  printf("ooseqtest, TCP_QUEUE_OOSEQ %d, %u kB uploads, %d kB/s, "
+         "round trip %d ms\n", TCP_QUEUE_OOSEQ, OOSEQ_TEST_BYTES / 1024,
+         OOSEQ_TEST_RATE * 1000 / 1024, OOSEQ_TEST_RTT);
+  for (i = 0; i < sizeof(ooseq_test_loss) / sizeof(ooseq_test_loss[0]); i++)
+  {
+    ooseq_test_loss_rate(ooseq_test_loss[i], "");
+  }
+#if TCP_QUEUE_OOSEQ && TCP_OOSEQ_MIN_FREE_HEAP
+  /* under heap pressure nothing is queued */
+  lwip_host_free_heap = TCP_OOSEQ_MIN_FREE_HEAP - 1;
+  ooseq_test_check(ooseq_test_loss_rate(50000, "heap low") == 0,
+                   "out of order data queued with the heap low");
+  lwip_host_free_heap = LWIP_HOST_FREE_HEAP;
+#endif
+  ooseq_test_check(lwip_host_rx_buffers == 0, "RX buffers not recycled");
+  return (ooseq_test_failures == 0) ? 0 : 1;
+}
+
+#endif /* LWIP_HOST */
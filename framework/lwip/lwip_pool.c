@@ -0,0 +1,191 @@
+/* Segregated fixed-block pools behind mem_malloc()/mem_free(), see
+ lwip_pool.h.
+
+ Each class is a contiguous run of equal blocks inside one arena, free blocks
+ are kept in a singly linked list threaded through the blocks themselves.
+ The class of a block is found from its address, so no header is needed.
+ */
+#include "lwip/lwip_opt.h"
+
+#include "lwip/lwip_def.h"
+#include "lwip/lwip_mem.h"
+#include "lwip/lwip_sys.h"
+#include "lwip_pool.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if LWIP_POOL
+
+extern bool esp_in_isr;
+
+struct pool_block
+{
+  struct pool_block *next;
+};
+
+struct pool_class
+{
+  struct pool_block *free;
+  uint8_t *start;
+  uint8_t *end;
+  lwip_pool_stats_t stats;
+};
+
+static const uint16_t pool_config[][2] = LWIP_POOL_CLASSES;
+
+#define POOL_NUM_CLASSES  (sizeof(pool_config) / sizeof(pool_config[0]))
+
+static struct pool_class pool_classes[POOL_NUM_CLASSES];
+static uint8_t *pool_arena;
+static uint8_t *pool_arena_end;
+
+void lwip_pool_init(void)
+{
+  size_t size = 0;
+  uint8_t *block;
+  uint8_t i;
+  uint16_t j;
+
+  if (pool_arena != NULL)
+  {
+    return;
+  }
+
+  for (i = 0; i < POOL_NUM_CLASSES; i++)
+  {
+    struct pool_class *pool = &pool_classes[i];
+
+    LWIP_ASSERT("pool classes must be sorted by size",
+                (i == 0) || (pool_config[i][0] > pool_config[i - 1][0]));
+    pool->stats.size = LWIP_MEM_ALIGN_SIZE(pool_config[i][0]);
+    pool->stats.num = (uint32_t)LWIP_POOL_BUDGET * pool_config[i][1] / 100
+        / pool->stats.size;
+    size += (size_t)pool->stats.size * pool->stats.num;
+  }
+
+  pool_arena = malloc(size);
+  if (pool_arena == NULL)
+  {
+    LWIP_DEBUGF(MEM_DEBUG | LWIP_DBG_LEVEL_SERIOUS,
+                ("lwip_pool_init: no memory for %u bytes\n", (unsigned)size));
+    return;
+  }
+  pool_arena_end = pool_arena + size;
+
+  block = pool_arena;
+  for (i = 0; i < POOL_NUM_CLASSES; i++)
+  {
+    struct pool_class *pool = &pool_classes[i];
+
+    pool->start = block;
+    for (j = 0; j < pool->stats.num; j++)
+    {
+      ((struct pool_block *)block)->next = pool->free;
+      pool->free = (struct pool_block *)block;
+      block += pool->stats.size;
+    }
+    pool->end = block;
+  }
+}
+
+void *lwip_pool_malloc(size_t size)
+{
+  struct pool_block *block = NULL;
+  uint8_t i;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if (pool_arena != NULL)
+  {
+    /* first class that fits */
+    for (i = 0; (i < POOL_NUM_CLASSES) && (pool_classes[i].stats.size < size);
+        i++)
+      ;
+
+    SYS_ARCH_PROTECT(lev);
+    if (i < POOL_NUM_CLASSES)
+    {
+      struct pool_class *pool = &pool_classes[i];
+
+      /* use the next larger class when this one is exhausted */
+      while ((pool->free == NULL) && (pool < &pool_classes[POOL_NUM_CLASSES - 1]))
+      {
+        pool++;
+      }
+      block = pool->free;
+      if (block != NULL)
+      {
+        pool->free = block->next;
+        pool->stats.used++;
+        if (pool->stats.used > pool->stats.max)
+        {
+          pool->stats.max = pool->stats.used;
+        }
+      }
+      else
+      {
+        pool_classes[i].stats.err++;
+      }
+    }
+    SYS_ARCH_UNPROTECT(lev);
+  }
+
+  if (block == NULL)
+  {
+    /* the C library heap takes a lock that cannot be taken in an ISR */
+    return esp_in_isr ? NULL : LWIP_POOL_HEAP_MALLOC(size);
+  }
+  return block;
+}
+
+void *lwip_pool_calloc(size_t count, size_t size)
+{
+  void *mem = lwip_pool_malloc(count * size);
+
+  if (mem != NULL)
+  {
+    memset(mem, 0, count * size);
+  }
+  return mem;
+}
+
+void lwip_pool_free(void *mem)
+{
+  uint8_t *block = mem;
+  struct pool_class *pool;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if ((block < pool_arena) || (block >= pool_arena_end))
+  {
+    LWIP_POOL_HEAP_FREE(mem);
+    return;
+  }
+
+  for (pool = pool_classes; block >= pool->end; pool++)
+    ;
+  LWIP_ASSERT("lwip_pool_free: not a block start",
+              ((block - pool->start) % pool->stats.size) == 0);
+
+  SYS_ARCH_PROTECT(lev);
+  ((struct pool_block *)block)->next = pool->free;
+  pool->free = (struct pool_block *)block;
+  pool->stats.used--;
+  SYS_ARCH_UNPROTECT(lev);
+}
+
+uint8_t lwip_pool_get_stats(lwip_pool_stats_t *stats, uint8_t max)
+{
+  uint8_t i;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  for (i = 0; (i < POOL_NUM_CLASSES) && (i < max); i++)
+  {
+    stats[i] = pool_classes[i].stats;
+  }
+  SYS_ARCH_UNPROTECT(lev);
+  return POOL_NUM_CLASSES;
+}
+
+#endif /* LWIP_POOL */
@@ -0,0 +1,453 @@
+/*
+ * RX flood test, a host program ("make rxflood")
+ *
+ * The device keeps an MQTT connection to a broker over a link of the host
+ * port of the core (lwip_host.h) and sends a PINGREQ every
+ * RX_TEST_PING_INTERVAL, while a broadcast storm and a UDP flood are handed
+ * to ethernetif_input() of lwip_esp_interface.c, the netif shim, at 0 up to
+ * 16 frames a ms. The frames of the broker come in among those of the flood,
+ * at a random place each ms. The tcpip thread of the device gets through
+ * RX_TEST_TCPIP_RATE frames a ms, the broker is another machine.
+ *
+ * The round trips of the pings are measured, with those over the keepalive
+ * of the application, which count towards a disconnect, the frames dropped
+ * and the counters of the classes. The PINGRESP must keep its round trip
+ * through any flood, the control and flow classes may not overflow and the
+ * flood must still get some of the time. Under heap pressure the flood is
+ * dropped on arrival.
+ *
+ * The Makefile builds the program a second time with RX_ADMISSION 0, every
+ * frame posted to the mailbox of the tcpip thread as before.
+ */
+#if defined(LWIP_HOST)
+
+#include "lwip/lwip_opt.h"
+#include "lwip/lwip_tcp.h"
+#include "lwip/lwip_tcp_impl.h"
+#include "lwip/lwip_udp.h"
+#include "lwip/lwip_tcpip.h"
+#include "lwip/lwip_stats.h"
+#include "lwip_esp_interface.h"
+#include "lwip_host.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !LWIP_TCP || !LINK_STATS
+#error "rxflood needs LWIP_TCP and LINK_STATS"
+#endif
+
+/* Frames the tcpip thread of the device gets through a ms, a rough figure
+ for the ESP8266, both builds get the same */
+#define RX_TEST_TCPIP_RATE      4
+/* One way delay of the link to the broker, in ms */
+#define RX_TEST_DELAY           2
+/* Ping period and run length per flood rate */
+#define RX_TEST_PING_INTERVAL   1000
+#define RX_TEST_TIME            (120 * 1000)
+#define RX_TEST_PINGS           (RX_TEST_TIME / RX_TEST_PING_INTERVAL)
+/* keepAliveInterval of the application, a PINGRESP later than that is a
+ failed keepalive, MQTT_MAX_FAIL_ALLOWED of them a disconnect */
+#define RX_TEST_KEEPALIVE       (10 * 1000)
+#define RX_TEST_MQTT_PORT       1883
+/* UDP port of the flood the device listens on */
+#define RX_TEST_SINK_PORT       5000
+#define RX_TEST_FLOOD_LEN       256
+/* Frames of the link held for the tick of the ms */
+#define RX_TEST_PENDING         8
+
+typedef struct
+{
+  struct tcp_pcb *client;
+  struct tcp_pcb *broker;
+  int connected;
+  /* the PINGREQ waiting for its PINGRESP */
+  int outstanding;
+  u32_t sent_at;
+  u32_t rtts[RX_TEST_PINGS];
+  u32_t count;
+  u32_t late;
+} rx_test_mqtt_t;
+
+static const u8_t rx_test_pingreq[] = { 0xC0, 0x00 };
+static const u8_t rx_test_pingresp[] = { 0xD0, 0x00 };
+
+static lwip_host_seg_t rx_test_link;
+static struct netif rx_test_dev;
+static struct netif rx_test_broker;
+static struct tcp_pcb *rx_test_listen;
+static struct udp_pcb *rx_test_sink;
+static rx_test_mqtt_t rx_test_mqtt;
+/* a broadcast storm frame and a flood frame to the sink */
+static u8_t rx_test_storm[SIZEOF_ETH_HDR + IP_HLEN + UDP_HLEN
+                          + RX_TEST_FLOOD_LEN];
+static u8_t rx_test_flood[sizeof(rx_test_storm)];
+static u16_t rx_test_frame_len;
+static u32_t rx_test_rate;
+static u32_t rx_test_injected;
+static u32_t rx_test_sunk;
+static struct pbuf *rx_test_pending[RX_TEST_PENDING];
+static u8_t rx_test_num_pending;
+static int rx_test_pinging;
+static unsigned long rx_test_failures;
+
+/* sdk_internal.h, the SDK hands each received frame to it */
+void ethernetif_input(struct netif *netif, struct pbuf *p);
+
+static void rx_test_check(int ok, const char *what)
+{
+  if (!ok)
+  {
+    rx_test_failures++;
+    printf("rxflood: at %u ms: %s\n", (unsigned)lwip_host_now, what);
+  }
+}
+
+/* libnet80211.a, the device port sends with the linkoutput of the host
+ port */
+int8_t sdk_ieee80211_output_pbuf(struct netif *ifp, struct pbuf *pb)
+{
+  (void)ifp;
+  (void)pb;
+  return 0;
+}
+
+static void rx_test_sink_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                              ip_addr_t *addr, u16_t port)
+{
+  (void)arg;
+  (void)pcb;
+  (void)addr;
+  (void)port;
+  rx_test_sunk++;
+  pbuf_free(p);
+}
+
+static void rx_test_err(void *arg, err_t err)
+{
+  rx_test_mqtt_t *mqtt = arg;
+
+  (void)err;
+  mqtt->client = NULL;
+  mqtt->broker = NULL;
+  mqtt->connected = 0;
+}
+
+/* The broker answers each PINGREQ */
+static err_t rx_test_broker_recv(void *arg, struct tcp_pcb *pcb,
+                                 struct pbuf *p, err_t err)
+{
+  u16_t i;
+
+  (void)arg;
+  (void)err;
+  if (p == NULL)
+  {
+    return ERR_OK;
+  }
+  for (i = 0; i + sizeof(rx_test_pingreq) <= p->tot_len;
+       i += sizeof(rx_test_pingreq))
+  {
+    tcp_write(pcb, rx_test_pingresp, sizeof(rx_test_pingresp),
+              TCP_WRITE_FLAG_COPY);
+  }
+  tcp_output(pcb);
+  tcp_recved(pcb, p->tot_len);
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static err_t rx_test_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+  (void)arg;
+  (void)err;
+  tcp_accepted(rx_test_listen);
+  rx_test_mqtt.broker = pcb;
+  tcp_arg(pcb, &rx_test_mqtt);
+  tcp_recv(pcb, rx_test_broker_recv);
+  tcp_err(pcb, rx_test_err);
+  tcp_nagle_disable(pcb);
+  return ERR_OK;
+}
+
+/* The device takes the PINGRESP */
+static err_t rx_test_client_recv(void *arg, struct tcp_pcb *pcb,
+                                 struct pbuf *p, err_t err)
+{
+  rx_test_mqtt_t *mqtt = arg;
+
+  (void)err;
+  if (p == NULL)
+  {
+    return ERR_OK;
+  }
+  if (mqtt->outstanding && (mqtt->count < RX_TEST_PINGS))
+  {
+    mqtt->rtts[mqtt->count++] = lwip_host_now - mqtt->sent_at;
+    if (lwip_host_now - mqtt->sent_at > RX_TEST_KEEPALIVE)
+    {
+      mqtt->late++;
+    }
+  }
+  mqtt->outstanding = 0;
+  tcp_recved(pcb, p->tot_len);
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static err_t rx_test_connected(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+  rx_test_mqtt_t *mqtt = arg;
+
+  (void)pcb;
+  (void)err;
+  mqtt->connected = 1;
+  return ERR_OK;
+}
+
+static int rx_test_is_connected(void *arg)
+{
+  return ((rx_test_mqtt_t *)arg)->connected
+      && (((rx_test_mqtt_t *)arg)->broker != NULL);
+}
+
+/* Driver of the device port: the frames of the link wait for the tick of
+ this ms, which hands them over among those of the flood */
+static void rx_test_driver(struct netif *netif, struct pbuf *p)
+{
+  if (rx_test_num_pending == RX_TEST_PENDING)
+  {
+    ethernetif_input(netif, p);
+    return;
+  }
+  rx_test_pending[rx_test_num_pending++] = p;
+}
+
+/* Every ms: the flood with the frames of the link at a random place among
+ them, as they come over the air, and a PINGREQ every
+ RX_TEST_PING_INTERVAL unless one is outstanding, as the keepalive of the
+ MQTT client. The application task writes under the core lock, not through
+ the mailbox. */
+static void rx_test_tick(void *arg)
+{
+  rx_test_mqtt_t *mqtt = arg;
+  struct pbuf *p;
+  u32_t place = lwip_host_rand() % (rx_test_rate + 1);
+  u32_t i;
+  u8_t j;
+
+  for (i = 0; i <= rx_test_rate; i++)
+  {
+    if (i == place)
+    {
+      for (j = 0; j < rx_test_num_pending; j++)
+      {
+        ethernetif_input(&rx_test_dev, rx_test_pending[j]);
+      }
+      rx_test_num_pending = 0;
+    }
+    if (i == rx_test_rate)
+    {
+      break;
+    }
+    p = lwip_host_rx_pbuf((i & 1) ? rx_test_flood : rx_test_storm,
+                          rx_test_frame_len);
+    if (p != NULL)
+    {
+      rx_test_injected++;
+      ethernetif_input(&rx_test_dev, p);
+    }
+  }
+  if (rx_test_pinging && (lwip_host_now % RX_TEST_PING_INTERVAL == 0)
+      && !mqtt->outstanding && (mqtt->client != NULL))
+  {
+    mqtt->outstanding = 1;
+    mqtt->sent_at = lwip_host_now;
+    tcp_write(mqtt->client, rx_test_pingreq, sizeof(rx_test_pingreq),
+              TCP_WRITE_FLAG_COPY);
+    tcp_output(mqtt->client);
+  }
+  sys_timeout(1, rx_test_tick, arg);
+}
+
+static int rx_test_cmp(const void *a, const void *b)
+{
+  u32_t x = *(const u32_t *)a;
+  u32_t y = *(const u32_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+/* RX_TEST_TIME of pings with 'rate' flood frames a ms, returns the longest
+ round trip, RX_TEST_TIME if a ping went unanswered */
+static u32_t rx_test_run(u32_t rate, const char *what)
+{
+  rx_test_mqtt_t *mqtt = &rx_test_mqtt;
+  rx_class_stats_t before[RX_CLASS_NUM];
+  rx_class_stats_t after[RX_CLASS_NUM];
+  u32_t injected = rx_test_injected;
+  u32_t sunk = rx_test_sunk;
+  u32_t drop = lwip_stats.link.drop;
+  u32_t lost;
+  u32_t longest;
+  int c;
+
+  memset(mqtt, 0, sizeof(*mqtt));
+  mqtt->client = tcp_new();
+  tcp_arg(mqtt->client, mqtt);
+  tcp_err(mqtt->client, rx_test_err);
+  tcp_recv(mqtt->client, rx_test_client_recv);
+  tcp_nagle_disable(mqtt->client);
+  tcp_bind(mqtt->client, &rx_test_dev.ip_addr, 0);
+  tcp_connect(mqtt->client, &rx_test_broker.ip_addr, RX_TEST_MQTT_PORT,
+              rx_test_connected);
+  rx_test_check(lwip_host_run_until(rx_test_is_connected, mqtt, 1000) <= 1000,
+                "no connection to the broker");
+
+  ethernetif_get_rx_stats(before);
+  rx_test_rate = rate;
+  rx_test_pinging = 1;
+  lwip_host_run(RX_TEST_TIME);
+  rx_test_rate = 0;
+  /* the last PINGRESP may come */
+  lwip_host_run(RX_TEST_KEEPALIVE);
+  rx_test_pinging = 0;
+  ethernetif_get_rx_stats(after);
+
+  lost = RX_TEST_PINGS - mqtt->count;
+  qsort(mqtt->rtts, mqtt->count, sizeof(mqtt->rtts[0]), rx_test_cmp);
+  longest = lost ? RX_TEST_TIME
+      : (mqtt->count ? mqtt->rtts[mqtt->count - 1] : 0);
+  printf("  flood %2u/ms %-9s ping %5u ms p50 %5u ms p99 %5u ms max, %2u late, "
+         "%2u lost, %3.0f %% of %7u frames dropped, %6u sunk\n", (unsigned)rate,
+         what, (unsigned)(mqtt->count ? mqtt->rtts[mqtt->count / 2] : 0),
+         (unsigned)(mqtt->count ? mqtt->rtts[mqtt->count * 99 / 100] : 0),
+         (unsigned)(mqtt->count ? mqtt->rtts[mqtt->count - 1] : 0),
+         (unsigned)mqtt->late, (unsigned)lost,
+         (rx_test_injected - injected) ? (lwip_stats.link.drop - drop) * 100.0
+             / (rx_test_injected - injected) : 0.0,
+         (unsigned)(rx_test_injected - injected),
+         (unsigned)(rx_test_sunk - sunk));
+#if RX_ADMISSION
+  for (c = 0; c < RX_CLASS_NUM; c++)
+  {
+    printf("    class %d: %7u queued, %7u full, %7u heap, %2u deepest\n", c,
+           (unsigned)(after[c].queued - before[c].queued),
+           (unsigned)(after[c].drop_full - before[c].drop_full),
+           (unsigned)(after[c].drop_heap - before[c].drop_heap),
+           (unsigned)after[c].max);
+  }
+  rx_test_check(after[RX_CLASS_CONTROL].drop_full
+                == before[RX_CLASS_CONTROL].drop_full,
+                "control frames dropped on a full queue");
+  rx_test_check(after[RX_CLASS_FLOW].drop_full == before[RX_CLASS_FLOW].drop_full,
+                "flow frames dropped on a full queue");
+  if (rate > 0 && (lwip_host_free_heap >= RX_HEAP_LOW_BULK))
+  {
+    rx_test_check(rx_test_sunk != sunk, "flood starved");
+  }
+  if (lwip_host_free_heap < RX_HEAP_LOW_BULK)
+  {
+    rx_test_check((after[RX_CLASS_BULK].drop_heap
+                   - before[RX_CLASS_BULK].drop_heap)
+                  == (rx_test_injected - injected),
+                  "flood not dropped with the heap low");
+  }
+#else
+  (void)c;
+  (void)before;
+  (void)after;
+#endif /* RX_ADMISSION */
+
+  if (mqtt->client != NULL)
+  {
+    tcp_arg(mqtt->client, NULL);
+    tcp_err(mqtt->client, NULL);
+    tcp_abort(mqtt->client);
+  }
+  if (mqtt->broker != NULL)
+  {
+    tcp_arg(mqtt->broker, NULL);
+    tcp_err(mqtt->broker, NULL);
+    tcp_abort(mqtt->broker);
+  }
+  lwip_host_run(1000);
+  rx_test_check(lwip_host_rx_buffers == 0, "RX frames left queued");
+  return longest;
+}
+
+int main(void)
+{
+  static const u32_t rates[] = { 0, 2, 4, 8, 16 };
+  static u8_t payload[RX_TEST_FLOOD_LEN];
+  lwip_host_udp_t udp;
+  struct eth_addr src = { { 0x02, 0x66, 0x10, 0x0d, 0x00, 0x01 } };
+  ip_addr_t addr;
+  ip_addr_t mask;
+  u32_t longest;
+  size_t i;
+
+  lwip_host_init(1);
+  lwip_host_seg_init(&rx_test_link);
+  rx_test_link.delay = RX_TEST_DELAY;
+  IP4_ADDR(&mask, 255, 255, 255, 0);
+  IP4_ADDR(&addr, 10, 0, 1, 1);
+  lwip_host_link_add(&rx_test_link, &rx_test_dev, &addr, &mask);
+  IP4_ADDR(&addr, 10, 0, 2, 1);
+  lwip_host_link_add(&rx_test_link, &rx_test_broker, &addr, &mask);
+  /* the SDK hands the frames of the device to ethernetif_input(), which
+   passes them on to tcpip_input() without RX_ADMISSION */
+  rx_test_dev.input = tcpip_input;
+  lwip_host_port_driver(&rx_test_link, &rx_test_dev, rx_test_driver);
+  lwip_host_tcpip_rate = RX_TEST_TCPIP_RATE;
+  sys_timeout(1, rx_test_tick, &rx_test_mqtt);
+
+  rx_test_listen = tcp_new();
+  tcp_bind(rx_test_listen, &rx_test_broker.ip_addr, RX_TEST_MQTT_PORT);
+  rx_test_listen = tcp_listen(rx_test_listen);
+  tcp_accept(rx_test_listen, rx_test_accept);
+  rx_test_sink = udp_new();
+  udp_bind(rx_test_sink, &rx_test_dev.ip_addr, RX_TEST_SINK_PORT);
+  udp_recv(rx_test_sink, rx_test_sink_recv, NULL);
+
+  /* SSDP broadcasts of a LAN host, and bulk UDP to the device */
+  memset(&udp, 0, sizeof(udp));
+  memset(&udp.mac, 0xff, sizeof(udp.mac));
+  IP4_ADDR(&udp.src, 10, 0, 1, 77);
+  ip_addr_copy(udp.dst, *IP_ADDR_BROADCAST);
+  udp.src_port = 1900;
+  udp.dst_port = 1900;
+  udp.data = payload;
+  udp.len = sizeof(payload);
+  rx_test_frame_len = lwip_host_udp_frame(&src, &udp, rx_test_storm);
+  memcpy(&udp.mac, rx_test_dev.hwaddr, sizeof(udp.mac));
+  ip_addr_copy(udp.dst, rx_test_dev.ip_addr);
+  udp.src_port = 40000;
+  udp.dst_port = RX_TEST_SINK_PORT;
+  lwip_host_udp_frame(&src, &udp, rx_test_flood);
+
+  printf("rxflood, RX_ADMISSION %d, tcpip thread %d frames/ms, ping every "
+         "%d ms for %d s\n", RX_ADMISSION, RX_TEST_TCPIP_RATE,
+         RX_TEST_PING_INTERVAL, RX_TEST_TIME / 1000);
+  for (i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+  {
+    longest = rx_test_run(rates[i], "");
+    if ((rates[i] == 0) || RX_ADMISSION)
+    {
+      rx_test_check(longest <= RX_TEST_KEEPALIVE / 10,
+                    "ping round trip over a tenth of the keepalive");
+    }
+  }
+#if RX_ADMISSION
+  /* under heap pressure the flood goes before it is queued */
+  lwip_host_free_heap = RX_HEAP_LOW_BULK - 1;
+  longest = rx_test_run(16, "heap low");
+  rx_test_check(longest <= RX_TEST_KEEPALIVE / 10,
+                "ping round trip over a tenth of the keepalive, heap low");
+  lwip_host_free_heap = LWIP_HOST_FREE_HEAP;
+#endif
+  return (rx_test_failures == 0) ? 0 : 1;
+}
+
+#endif /* LWIP_HOST */
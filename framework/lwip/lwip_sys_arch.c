@@ -61,6 +61,93 @@ static inline bool is_inside_isr()
   return esp_in_isr;
 }
 
+#if LWIP_SYS_STATIC
+#include <string.h>
+
+struct sys_static_mbox
+{
+  /* first, so that the queue handle is the address of the entry */
+  StaticQueue_t queue;
+  void *storage[LWIP_SYS_STATIC_MBOX_SIZE];
+};
+
+static StaticQueue_t sys_tcpip_mbox;
+static void *sys_tcpip_mbox_storage[TCPIP_MBOX_SIZE];
+static StaticTask_t sys_tcpip_task;
+static StackType_t sys_tcpip_task_stack[TCPIP_THREAD_STACKSIZE];
+static bool sys_tcpip_mbox_used;
+static bool sys_tcpip_task_used;
+
+static struct sys_static_mbox sys_mboxes[LWIP_SYS_STATIC_MBOXES];
+static StaticSemaphore_t sys_sems[LWIP_SYS_STATIC_SEMS];
+static StaticSemaphore_t sys_mutexes[LWIP_SYS_STATIC_MUTEXES];
+/* Bit n set while entry n of the pool is in use */
+static uint32_t sys_mboxes_used;
+static uint32_t sys_sems_used;
+static uint32_t sys_mutexes_used;
+
+/* Claim a free entry of a pool, -1 when it is exhausted */
+static int sys_static_claim(uint32_t *used, int num)
+{
+  int i;
+
+  taskENTER_CRITICAL();
+  for (i = 0; (i < num) && (*used & (1UL << i)); i++)
+    ;
+  if (i < num)
+  {
+    *used |= 1UL << i;
+  }
+  taskEXIT_CRITICAL();
+
+  return (i < num) ? i : -1;
+}
+
+/* Give back the entry holding 'obj', false if it is not from the pool */
+static bool sys_static_release(uint32_t *used, const void *pool, size_t size,
+                               int num, const void *obj)
+{
+  uint32_t offset = (uint32_t)obj - (uint32_t)pool;
+
+  if (offset >= size * num)
+  {
+    return false;
+  }
+
+  taskENTER_CRITICAL();
+  *used &= ~(1UL << (offset / size));
+  taskEXIT_CRITICAL();
+  return true;
+}
+
+static QueueHandle_t sys_static_mbox_new(int iSize)
+{
+  int i;
+
+  if (iSize > LWIP_SYS_STATIC_MBOX_SIZE)
+  {
+    /* the tcpip thread mailbox, created once */
+    if ((iSize > TCPIP_MBOX_SIZE) || sys_tcpip_mbox_used)
+    {
+      return NULL;
+    }
+    sys_tcpip_mbox_used = true;
+    return xQueueCreateStatic(iSize, sizeof(void *),
+                              (uint8_t *)sys_tcpip_mbox_storage,
+                              &sys_tcpip_mbox);
+  }
+
+  i = sys_static_claim(&sys_mboxes_used, LWIP_SYS_STATIC_MBOXES);
+  if (i < 0)
+  {
+    return NULL;
+  }
+  return xQueueCreateStatic(iSize, sizeof(void *),
+                            (uint8_t *)sys_mboxes[i].storage,
+                            &sys_mboxes[i].queue);
+}
+#endif /* LWIP_SYS_STATIC */
+
 /*---------------------------------------------------------------------------*
  * Routine:  sys_mbox_new
  *---------------------------------------------------------------------------*
@@ -74,6 +161,10 @@ static inline bool is_inside_isr()
 err_t sys_mbox_new(sys_mbox_t *pxMailBox, int iSize){
     err_t xReturn = ERR_MEM;
 
+#if LWIP_SYS_STATIC
+    *pxMailBox = sys_static_mbox_new(iSize);
+    if( *pxMailBox == NULL )
+#endif /* LWIP_SYS_STATIC */
     *pxMailBox = xQueueCreate(iSize,
                                                            sizeof( void * ));
 
@@ -117,6 +208,10 @@ unsigned long ulMessagesWaiting;
 #endif /* SYS_STATS */
 
 vQueueDelete( *pxMailBox );
+#if LWIP_SYS_STATIC
+sys_static_release(&sys_mboxes_used, sys_mboxes, sizeof(sys_mboxes[0]),
+                   LWIP_SYS_STATIC_MBOXES, *pxMailBox);
+#endif /* LWIP_SYS_STATIC */
 }
 
 /*---------------------------------------------------------------------------*
@@ -313,6 +408,23 @@ return ulReturn;
 err_t sys_sem_new(sys_sem_t *pxSemaphore, u8_t ucCount){
 err_t xReturn = ERR_MEM;
 
+#if LWIP_SYS_STATIC
+    int i = sys_static_claim(&sys_sems_used, LWIP_SYS_STATIC_SEMS);
+
+    if( i >= 0 )
+    {
+        /* created empty */
+        *pxSemaphore = xSemaphoreCreateBinaryStatic(&sys_sems[i]);
+        if( ucCount != 0U )
+        {
+            xSemaphoreGive(*pxSemaphore);
+        }
+        xReturn = ERR_OK;
+        SYS_STATS_INC_USED(sem);
+        return xReturn;
+    }
+#endif /* LWIP_SYS_STATIC */
+
     vSemaphoreCreateBinary(
 ( *pxSemaphore ));
 
@@ -401,6 +513,13 @@ unsigned long ulReturn;
 err_t sys_mutex_new(sys_mutex_t *pxMutex){
 err_t xReturn = ERR_MEM;
 
+#if LWIP_SYS_STATIC
+    int i = sys_static_claim(&sys_mutexes_used, LWIP_SYS_STATIC_MUTEXES);
+
+    if( i >= 0 )
+        *pxMutex = xSemaphoreCreateMutexStatic(&sys_mutexes[i]);
+    else
+#endif /* LWIP_SYS_STATIC */
     *pxMutex = xSemaphoreCreateMutex();
 
     if( *pxMutex != NULL )
@@ -435,6 +554,10 @@ void sys_mutex_unlock(sys_mutex_t *pxMutex){
 void sys_mutex_free(sys_mutex_t *pxMutex){
     SYS_STATS_DEC(mutex.used);
 vQueueDelete( *pxMutex );
+#if LWIP_SYS_STATIC
+sys_static_release(&sys_mutexes_used, sys_mutexes, sizeof(sys_mutexes[0]),
+                   LWIP_SYS_STATIC_MUTEXES, *pxMutex);
+#endif /* LWIP_SYS_STATIC */
 }
 
 
@@ -469,6 +592,10 @@ portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
  *---------------------------------------------------------------------------*/
 void sys_sem_free(sys_sem_t *pxSemaphore){
     SYS_STATS_DEC(sem.used); vQueueDelete( *pxSemaphore );
+#if LWIP_SYS_STATIC
+sys_static_release(&sys_sems_used, sys_sems, sizeof(sys_sems[0]),
+                   LWIP_SYS_STATIC_SEMS, *pxSemaphore);
+#endif /* LWIP_SYS_STATIC */
 }
 
 /*---------------------------------------------------------------------------*
@@ -479,6 +606,9 @@ void sys_sem_free(sys_sem_t *pxSemaphore){
  *---------------------------------------------------------------------------*/
 void sys_init(void)
 {
+#if LWIP_POOL
+lwip_pool_init();
+#endif /* LWIP_POOL */
 }
 
 u32_t sys_now(void)
@@ -511,6 +641,17 @@ TaskHandle_t xCreatedTask;
 portBASE_TYPE xResult;
 sys_thread_t xReturn;
 
+#if LWIP_SYS_STATIC
+/* the tcpip thread runs for ever */
+if( !sys_tcpip_task_used && ( iStackSize <= TCPIP_THREAD_STACKSIZE )
+    && ( strcmp( pcName, TCPIP_THREAD_NAME ) == 0 ) )
+{
+sys_tcpip_task_used = true;
+xCreatedTask = xTaskCreateStatic( pxThread, pcName, TCPIP_THREAD_STACKSIZE, pvArg, iPriority, sys_tcpip_task_stack, &sys_tcpip_task );
+xResult = ( xCreatedTask != NULL ) ? pdPASS : pdFAIL;
+}
+else
+#endif /* LWIP_SYS_STATIC */
 xResult = xTaskCreate( pxThread, pcName, iStackSize, pvArg, iPriority, &xCreatedTask );
 
 if( xResult == pdPASS )
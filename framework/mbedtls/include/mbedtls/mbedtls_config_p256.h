@@ -0,0 +1,109 @@
+/**
+ * \file mbedtls_config_p256.h
+ *
+ * \brief Device TLS configuration, ECDHE-ECDSA on secp256r1 only
+ *
+ * The firmware builds with this file (MBEDTLS_CONFIG_FILE in the Makefile)
+ * instead of mbedtls_config.h, which enables every curve, RSA and all the
+ * ciphers. What is left is a TLS 1.2 client for
+ * TLS-ECDHE-ECDSA-WITH-AES-128-GCM-SHA256, plus the hashes and encodings the
+ * rest of the firmware uses.
+ *
+ * Elliptic curve operations are the cost of a handshake here:
+ * - MBEDTLS_ECP_NIST_OPTIM reduces modulo P-256 without a division;
+ * - MBEDTLS_ECP_FIXED_POINT_OPTIM selects the comb table of the generator
+ *   that mbedtls_ecp_curves.c keeps in flash, so that multiplications of
+ *   G (key generation, signature, half of a verification) take fewer steps
+ *   and no RAM, while MBEDTLS_ECP_WINDOW_SIZE keeps the other ones small;
+ * - MBEDTLS_ECP_YIELD lets other tasks run during a multiplication, see
+ *   mbedtls_ecp_yield.c.
+ *
+ * "make cryptobench" measures the handshake operations and a whole handshake
+ * with this file, and with mbedtls_config.h for comparison.
+ *
+ * Allocations come from the arena of mbedtls_tls_arena.c rather than the
+ * system heap. Records are MBEDTLS_SSL_MAX_CONTENT_LEN long at most, which
+ * mbedtls_tls_arena_conf() negotiates with the server.
+ */
+#ifndef MBEDTLS_CONFIG_H
+#define MBEDTLS_CONFIG_H
+
+/* System support */
+#define MBEDTLS_HAVE_ASM
+#define MBEDTLS_PLATFORM_C
+#define MBEDTLS_PLATFORM_MEMORY
+#define MBEDTLS_NO_PLATFORM_ENTROPY
+#define MBEDTLS_ENTROPY_HARDWARE_ALT
+
+/* LX106 implementations, framework/mbedtls/mbedtls_*_alt.c */
+#define MBEDTLS_SHA256_PROCESS_ALT
+#define MBEDTLS_AES_ENCRYPT_ALT
+#define MBEDTLS_AES_DECRYPT_ALT
+#define MBEDTLS_AES_ROM_TABLES
+
+/* Elliptic curves */
+#define MBEDTLS_ECP_DP_SECP256R1_ENABLED
+#define MBEDTLS_ECP_NIST_OPTIM
+#define MBEDTLS_ECP_YIELD
+#define MBEDTLS_ECDSA_DETERMINISTIC
+
+/* TLS */
+#define MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED
+#define MBEDTLS_SSL_PROTO_TLS1_2
+#define MBEDTLS_SSL_SERVER_NAME_INDICATION
+#define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+#define MBEDTLS_SSL_EXTENDED_MASTER_SECRET
+
+/* TLS arena, mbedtls_tls_arena.c, MBEDTLS_MEMORY_DEBUG keeps its peak */
+#define MBEDTLS_MEMORY_BUFFER_ALLOC_C
+#define MBEDTLS_MEMORY_DEBUG
+
+/* Self tests of mbedtls_bench_run() */
+#define MBEDTLS_SELF_TEST
+
+/* Modules */
+#define MBEDTLS_AES_C
+#define MBEDTLS_ASN1_PARSE_C
+#define MBEDTLS_ASN1_WRITE_C
+#define MBEDTLS_BASE64_C
+#define MBEDTLS_BIGNUM_C
+#define MBEDTLS_CIPHER_C
+#define MBEDTLS_CTR_DRBG_C
+#define MBEDTLS_ECDH_C
+#define MBEDTLS_ECDSA_C
+#define MBEDTLS_ECP_C
+#define MBEDTLS_ENTROPY_C
+#define MBEDTLS_GCM_C
+#define MBEDTLS_HMAC_DRBG_C
+#define MBEDTLS_MD_C
+#define MBEDTLS_NET_C
+#define MBEDTLS_OID_C
+#define MBEDTLS_PEM_PARSE_C
+#define MBEDTLS_PK_C
+#define MBEDTLS_PK_PARSE_C
+#define MBEDTLS_SHA1_C
+#define MBEDTLS_SHA256_C
+#define MBEDTLS_SSL_CLI_C
+#define MBEDTLS_SSL_TLS_C
+#define MBEDTLS_X509_CRT_PARSE_C
+#define MBEDTLS_X509_USE_C
+#if defined(MBEDTLS_BENCH_HOST)
+/* the peer of the host handshakes, mbedtls_bench_tls.c */
+#define MBEDTLS_SSL_SRV_C
+#endif
+
+/* Sizes, 256 bit numbers at most */
+#define MBEDTLS_MPI_WINDOW_SIZE            1
+#define MBEDTLS_MPI_MAX_SIZE              32
+#define MBEDTLS_ECP_MAX_BITS             256
+#define MBEDTLS_ECP_WINDOW_SIZE            2
+#define MBEDTLS_ECP_FIXED_POINT_OPTIM      1
+#define MBEDTLS_ENTROPY_FORCE_SHA256
+#define MBEDTLS_CTR_DRBG_RESEED_INTERVAL 1000
+#define MBEDTLS_SSL_MAX_CONTENT_LEN     4096
+#define MBEDTLS_SSL_CIPHERSUITES \
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256
+
+#include "mbedtls/mbedtls_check_config.h"
+
+#endif /* MBEDTLS_CONFIG_H */
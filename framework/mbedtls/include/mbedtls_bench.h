@@ -0,0 +1,40 @@
+/* Crypto benchmark, see mbedtls_bench.c
+ *
+ * Runs the mbed TLS self tests of SHA-256, AES and ECP, then times the
+ * functions that framework/mbedtls replaces for the LX106 and prints cycles
+ * per byte. With ECDH and ECDSA on secp256r1 in the configuration it goes on
+ * with the public key operations of a client handshake, in milliseconds and
+ * peak bytes of heap. The same source builds for the host with "make
+ * cryptobench", so that a change to the code can be compared on both sides;
+ * there it also times whole ECDHE-ECDSA handshakes against an in-memory
+ * server, see mbedtls_bench_tls.h.
+ */
+#ifndef _MBEDTLS_BENCH_H
+#define _MBEDTLS_BENCH_H
+
+/* Bytes hashed or encrypted by each measure */
+#ifndef MBEDTLS_BENCH_LEN
+#define MBEDTLS_BENCH_LEN       1024
+#endif
+
+/* Measures per case, the fastest is reported */
+#ifndef MBEDTLS_BENCH_ROUNDS
+#define MBEDTLS_BENCH_ROUNDS    16
+#endif
+
+/* Measures per elliptic curve case and handshakes, the fastest is reported */
+#ifndef MBEDTLS_BENCH_ECC_ROUNDS
+#define MBEDTLS_BENCH_ECC_ROUNDS 3
+#endif
+
+/**
+ * Run the self tests and the benchmark, printing the results. Blocks the
+ * caller for a few seconds on the target. The heap of the ECC cases is counted
+ * by swapping the mbedtls_calloc() of the platform layer, no other task
+ * should use mbed TLS meanwhile.
+ *
+ * Returns 0, or -1 if a self test failed or memory ran out.
+ */
+int mbedtls_bench_run(void);
+
+#endif /* _MBEDTLS_BENCH_H */
@@ -0,0 +1,34 @@
+/* In-memory TLS peer of the host programs, see mbedtls_bench_tls.c
+ *
+ * A P-256 test CA, a server certificate it signed for
+ * MBEDTLS_BENCH_TLS_HOSTNAME and the server's key, and two memory pipes
+ * between a client and a server context. Used by "make cryptobench" to time
+ * a real handshake and by "make tlssoak"; not part of the firmware.
+ */
+#ifndef _MBEDTLS_BENCH_TLS_H
+#define _MBEDTLS_BENCH_TLS_H
+
+#include <stddef.h>
+#include "mbedtls/mbedtls_ssl.h"
+
+#define MBEDTLS_BENCH_TLS_HOSTNAME  "soak.plusfarm"
+
+/* Bytes each pipe holds before the sender gets MBEDTLS_ERR_SSL_WANT_WRITE */
+#define MBEDTLS_BENCH_TLS_PIPE_LEN  (4 * MBEDTLS_SSL_MAX_CONTENT_LEN)
+
+/* PEM, the sizes count the terminating '\0' as mbedtls_x509_crt_parse()
+ wants */
+extern const char mbedtls_bench_tls_ca_crt[];
+extern const size_t mbedtls_bench_tls_ca_crt_len;
+extern const char mbedtls_bench_tls_srv_crt[];
+extern const size_t mbedtls_bench_tls_srv_crt_len;
+extern const char mbedtls_bench_tls_srv_key[];
+extern const size_t mbedtls_bench_tls_srv_key_len;
+
+/* Empty both pipes, before a new connection */
+void mbedtls_bench_tls_reset(void);
+
+/* Connect 'ssl' to its end of the pipes, 'server' 1 for the server side */
+void mbedtls_bench_tls_set_bio(mbedtls_ssl_context *ssl, int server);
+
+#endif /* _MBEDTLS_BENCH_TLS_H */
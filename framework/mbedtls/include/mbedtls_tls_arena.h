@@ -0,0 +1,74 @@
+/* TLS memory arena, see mbedtls_tls_arena.c
+ *
+ * mbed TLS allocates its records, handshake state and parsed certificates
+ * through mbedtls_calloc(). mbedtls_tls_arena_init() points it at
+ * mbedtls_memory_buffer_alloc.c over a buffer reserved at link time, so that
+ * TLS neither fragments the system heap nor fails on it after uptime, and a
+ * closed session goes back to the free blocks it was carved from.
+ *
+ * Records are MBEDTLS_SSL_MAX_CONTENT_LEN long, 4 KB in
+ * mbedtls_config_p256.h. mbedtls_tls_arena_conf() asks the server for
+ * records no longer than that with the max_fragment_length extension; a
+ * server that ignores it can still send 16 KB records, which then fail with
+ * MBEDTLS_ERR_SSL_INVALID_RECORD.
+ *
+ * "make tlssoak" runs reconnects against an in-memory server on the host and
+ * checks that the arena comes back to the same state after each of them.
+ */
+#ifndef _MBEDTLS_TLS_ARENA_H
+#define _MBEDTLS_TLS_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mbedtls/mbedtls_ssl.h"
+
+/* Bytes of the arena, two records, a certificate chain and the handshake */
+#ifndef MBEDTLS_TLS_ARENA_SIZE
+#define MBEDTLS_TLS_ARENA_SIZE  (20 * 1024)
+#endif
+
+/* 1 to log the arena peak of each handshake */
+#ifndef MBEDTLS_TLS_ARENA_LOG
+#define MBEDTLS_TLS_ARENA_LOG   1
+#endif
+
+typedef struct
+{
+  /* bytes of the arena */
+  size_t size;
+  /* bytes and blocks in use, as requested by the callers */
+  size_t used;
+  size_t blocks;
+  /* high-water mark of 'used' during the last handshake */
+  size_t peak;
+  /* free bytes, and the largest block they make */
+  size_t free;
+  size_t largest;
+  /* handshakes completed, allocations that did not fit */
+  uint32_t handshakes;
+  uint32_t fails;
+} mbedtls_tls_arena_stats_t;
+
+/**
+ * Make mbedtls_calloc() and mbedtls_free() allocate from the arena, from any
+ * task. Call once, before anything is allocated through them.
+ *
+ * Returns 0, or -1 if the lock could not be created.
+ */
+int mbedtls_tls_arena_init(void);
+
+/**
+ * Negotiate records of MBEDTLS_SSL_MAX_CONTENT_LEN bytes at most on 'conf',
+ * a client configuration. Returns 0 or an MBEDTLS_ERR_SSL_* code.
+ */
+int mbedtls_tls_arena_conf(mbedtls_ssl_config *conf);
+
+/**
+ * mbedtls_ssl_handshake() that records the arena peak of the handshake, from
+ * its first call to the one that completes it, and logs it.
+ */
+int mbedtls_tls_arena_handshake(mbedtls_ssl_context *ssl);
+
+void mbedtls_tls_arena_get_stats(mbedtls_tls_arena_stats_t *stats);
+
+#endif /* _MBEDTLS_TLS_ARENA_H */
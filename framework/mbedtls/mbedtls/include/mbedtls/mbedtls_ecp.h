@@ -216,6 +216,22 @@ extern "C"
 #define MBEDTLS_ECP_FIXED_POINT_OPTIM  1   /**< Enable fixed-point speed-up */
 #endif /* MBEDTLS_ECP_FIXED_POINT_OPTIM */
 
+  /*
+   * Window of the comb tables of the generator that ecp_curves.c keeps in
+   * flash when MBEDTLS_ECP_FIXED_POINT_OPTIM is 1, secp256r1 only for now
+   * (util/ecpcomb.py). They take no RAM, so MBEDTLS_ECP_WINDOW_SIZE does not
+   * apply to them.
+   */
+#define MBEDTLS_ECP_STATIC_COMB_W      7
+
+#if defined(MBEDTLS_ECP_YIELD)
+  /*
+   * Called between the steps of a scalar multiplication, a few milliseconds
+   * apart on a slow CPU, so that the platform can let other tasks run.
+   */
+  void mbedtls_ecp_yield( void );
+#endif
+
   /* \} name SECTION: Module settings */
 
   /*
@@ -131,6 +131,15 @@ extern "C"
    */
   int mbedtls_memory_buffer_alloc_verify(void);
 
+  /**
+   * \brief   Get the free space of the buffer, a largest block much smaller
+   *          than the total tells of fragmentation
+   *
+   * \param free_bytes    Bytes in free blocks, headers not counted
+   * \param largest       Bytes of the largest free block
+   */
+  void mbedtls_memory_buffer_alloc_free_get( size_t *free_bytes, size_t *largest );
+
 #if defined(MBEDTLS_SELF_TEST)
   /**
    * \brief          Checkup routine
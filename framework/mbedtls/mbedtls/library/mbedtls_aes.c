@@ -198,6 +198,8 @@ static const unsigned char FSb[256] =
     V(C3,41,41,82), V(B0,99,99,29), V(77,2D,2D,5A), V(11,0F,0F,1E), \
     V(CB,B0,B0,7B), V(FC,54,54,A8), V(D6,BB,BB,6D), V(3A,16,16,2C)
 
+/* Only the block encryption reads the forward tables */
+#if !defined(MBEDTLS_AES_ENCRYPT_ALT)
 #define V(a,b,c,d) 0x##a##b##c##d
 static const uint32_t FT0[256] =
 { FT};
@@ -217,9 +219,11 @@ static const uint32_t FT2[256] =
 static const uint32_t FT3[256] =
 { FT};
 #undef V
+#endif /* !MBEDTLS_AES_ENCRYPT_ALT */
 
 #undef FT
 
+#if !defined(MBEDTLS_AES_DECRYPT_ALT)
 /*
  * Reverse S-box
  */
@@ -258,6 +262,7 @@ static const unsigned char RSb[256] =
   0x17, 0x2B, 0x04, 0x7E, 0xBA, 0x77, 0xD6, 0x26,
   0xE1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0C, 0x7D
 };
+#endif /* !MBEDTLS_AES_DECRYPT_ALT */
 
 /*
  * Reverse tables
@@ -1232,7 +1237,9 @@ int mbedtls_aes_self_test( int verbose )
   int ret = 0, i, j, u, v;
   unsigned char key[32];
   unsigned char buf[64];
+#if defined(MBEDTLS_CIPHER_MODE_CBC) || defined(MBEDTLS_CIPHER_MODE_CFB)
   unsigned char iv[16];
+#endif
 #if defined(MBEDTLS_CIPHER_MODE_CBC)
   unsigned char prv[16];
 #endif
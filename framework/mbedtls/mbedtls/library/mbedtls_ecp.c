@@ -66,6 +66,13 @@
 #define inline __inline
 #endif
 
+/* Between the steps of the scalar multiplications, see mbedtls_ecp_yield() */
+#if defined(MBEDTLS_ECP_YIELD)
+#define ECP_YIELD()     mbedtls_ecp_yield()
+#else
+#define ECP_YIELD()
+#endif
+
 /* Implementation that should never be optimized out by the compiler */
 static void mbedtls_zeroize( void *v, size_t n )
 {
@@ -334,7 +341,8 @@ void mbedtls_ecp_group_free( mbedtls_ecp_group *grp )
     mbedtls_mpi_free( &grp->N );
   }
 
-  if( grp->T != NULL )
+  /* T_size is 0 for the tables in flash of mbedtls_ecp_curves.c */
+  if( grp->T != NULL && grp->T_size != 0 )
   {
     for( i = 0; i < grp->T_size; i++ )
     mbedtls_ecp_point_free( &grp->T[i] );
@@ -1194,7 +1202,10 @@ static int ecp_precompute_comb( const mbedtls_ecp_group *grp,
     cur = T + i;
     MBEDTLS_MPI_CHK( mbedtls_ecp_copy( cur, T + ( i >> 1 ) ) );
     for( j = 0; j < d; j++ )
-    MBEDTLS_MPI_CHK( ecp_double_jac( grp, cur, cur ) );
+    {
+      MBEDTLS_MPI_CHK( ecp_double_jac( grp, cur, cur ) );
+      ECP_YIELD();
+    }
 
     TT[k++] = cur;
   }
@@ -1279,6 +1290,7 @@ static int ecp_mul_comb_core( const mbedtls_ecp_group *grp, mbedtls_ecp_point *R
     MBEDTLS_MPI_CHK( ecp_double_jac( grp, R, R ) );
     MBEDTLS_MPI_CHK( ecp_select_comb( grp, &Txi, T, t_len, x[i] ) );
     MBEDTLS_MPI_CHK( ecp_add_mixed( grp, R, R, &Txi ) );
+    ECP_YIELD();
   }
 
   cleanup:
@@ -1340,6 +1352,10 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
   if( w >= grp->nbits )
   w = 2;
 
+  /* A table of the generator in flash has a window of its own */
+  if( p_eq_g && grp->T != NULL && grp->T_size == 0 )
+  w = MBEDTLS_ECP_STATIC_COMB_W;
+
   /* Other sizes that depend on w */
   pre_len = 1U << ( w - 1 );
   d = ( grp->nbits + w - 1 ) / w;
@@ -1578,6 +1594,7 @@ static int ecp_mul_mxz( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     MBEDTLS_MPI_CHK( ecp_double_add_mxz( grp, R, &RP, R, &RP, &PX ) );
     MBEDTLS_MPI_CHK( mbedtls_mpi_safe_cond_swap( &R->X, &RP.X, b ) );
     MBEDTLS_MPI_CHK( mbedtls_mpi_safe_cond_swap( &R->Z, &RP.Z, b ) );
+    ECP_YIELD();
   }
 
   MBEDTLS_MPI_CHK( ecp_normalize_mxz( grp, R ) );
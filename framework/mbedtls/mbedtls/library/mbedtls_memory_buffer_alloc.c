@@ -511,6 +511,21 @@ int mbedtls_memory_buffer_alloc_verify()
   return verify_chain();
 }
 
+void mbedtls_memory_buffer_alloc_free_get( size_t *free_bytes, size_t *largest )
+{
+  memory_header *cur = heap.first_free;
+
+  *free_bytes = 0;
+  *largest = 0;
+  while( cur != NULL )
+  {
+    *free_bytes += cur->size;
+    if( cur->size > *largest )
+    *largest = cur->size;
+    cur = cur->next_free;
+  }
+}
+
 #if defined(MBEDTLS_MEMORY_DEBUG)
 void mbedtls_memory_buffer_alloc_status()
 {
@@ -0,0 +1,736 @@
+/*
+ * Crypto benchmark, cut down from programs/test/mbedtls_benchmark.c to the
+ * cases this port accelerates. The target counts CPU cycles with CCOUNT, the
+ * host with the TSC where there is one and nanoseconds otherwise.
+ *
+ * The elliptic curve cases are the public key operations of a TLS client
+ * handshake with ECDHE-ECDSA on secp256r1, timed in milliseconds. Each one
+ * loads its group as the TLS layer does, so that the precomputation of a
+ * configuration without the flash table is part of the cost. Allocations
+ * through mbedtls_calloc() are counted to give the peak heap of each.
+ *
+ * The host build then runs whole handshakes, a client verifying the server
+ * of mbedtls_bench_tls.c over memory pipes, and reports the time and the peak
+ * heap of the client side alone.
+ */
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/mbedtls_config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mbedtls/mbedtls_platform.h"
+#include "mbedtls/mbedtls_sha256.h"
+#include "mbedtls/mbedtls_aes.h"
+#include "mbedtls_bench.h"
+
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECDSA_C) && \
+    defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+#include "mbedtls/mbedtls_ecdh.h"
+#include "mbedtls/mbedtls_ecdsa.h"
+#define BENCH_ECC
+#endif
+
+#if defined(MBEDTLS_PLATFORM_MEMORY) && \
+    !defined(MBEDTLS_PLATFORM_CALLOC_MACRO) && \
+    !defined(MBEDTLS_PLATFORM_FREE_MACRO)
+#define BENCH_HEAP
+#endif
+
+#if defined(MBEDTLS_BENCH_HOST) && defined(BENCH_ECC) && \
+    defined(BENCH_HEAP) && defined(MBEDTLS_SSL_CLI_C) && \
+    defined(MBEDTLS_SSL_SRV_C) && defined(MBEDTLS_CTR_DRBG_C) && \
+    defined(MBEDTLS_PK_PARSE_C) && defined(MBEDTLS_X509_CRT_PARSE_C) && \
+    defined(MBEDTLS_PEM_PARSE_C)
+#include "mbedtls/mbedtls_ctr_drbg.h"
+#include "mbedtls/mbedtls_pk.h"
+#include "mbedtls/mbedtls_ssl.h"
+#include "mbedtls/mbedtls_x509_crt.h"
+#include "mbedtls_bench_tls.h"
+#define BENCH_TLS
+#endif
+
+#if defined(__xtensa__)
+#include "xtensa_ops.h"
+#include "sdk/esp_common.h"
+#define BENCH_UNIT    "cycles"
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#include <time.h>
+#define BENCH_UNIT    "TSC ticks"
+#else
+#include <time.h>
+#define BENCH_UNIT    "ns"
+#endif
+
+#if !defined(MBEDTLS_PLATFORM_C)
+#include <stdio.h>
+#include <stdlib.h>
+#define mbedtls_printf  printf
+#define mbedtls_calloc  calloc
+#define mbedtls_free    free
+#endif
+
+typedef struct
+{
+    const char *name;
+    unsigned int key_bits;
+    void (*run)(mbedtls_aes_context *aes, uint8_t *buf, size_t len);
+} bench_case_t;
+
+static uint32_t bench_now(void)
+{
+#if defined(__xtensa__)
+  uint32_t ccount;
+
+  RSR(ccount, ccount);
+  return ccount;
+#elif defined(__x86_64__) || defined(__i386__)
+  return (uint32_t)__rdtsc();
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000000UL + ts.tv_nsec);
+#endif
+}
+
+/* Microseconds, for the cases too long for a 32 bit cycle count */
+static uint32_t bench_usec(void)
+{
+#if defined(__xtensa__)
+  return sdk_system_get_time();
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000UL + ts.tv_nsec / 1000);
+#endif
+}
+
+static void bench_sha256(mbedtls_aes_context *aes, uint8_t *buf, size_t len)
+{
+  mbedtls_sha256_context sha;
+  uint8_t hash[32];
+
+  (void)aes;
+  mbedtls_sha256_init(&sha);
+  mbedtls_sha256_starts(&sha, 0);
+  mbedtls_sha256_update(&sha, buf, len);
+  mbedtls_sha256_finish(&sha, hash);
+  mbedtls_sha256_free(&sha);
+  /* chain the rounds so that none can be optimized away */
+  memcpy(buf, hash, sizeof(hash));
+}
+
+static void bench_aes_enc(mbedtls_aes_context *aes, uint8_t *buf, size_t len)
+{
+  size_t i;
+
+  for (i = 0; i + 16 <= len; i += 16)
+  {
+    mbedtls_aes_encrypt(aes, buf + i, buf + i);
+  }
+}
+
+static void bench_aes_dec(mbedtls_aes_context *aes, uint8_t *buf, size_t len)
+{
+  size_t i;
+
+  for (i = 0; i + 16 <= len; i += 16)
+  {
+    mbedtls_aes_decrypt(aes, buf + i, buf + i);
+  }
+}
+
+static const bench_case_t bench_cases[] =
+{
+  { "SHA-256", 0, bench_sha256 },
+  { "AES-128 encrypt", 128, bench_aes_enc },
+  { "AES-128 decrypt", 128, bench_aes_dec },
+  { "AES-256 encrypt", 256, bench_aes_enc },
+  { "AES-256 decrypt", 256, bench_aes_dec },
+};
+
+#define BENCH_NUM_CASES (sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+#if defined(BENCH_HEAP)
+/* Room for the size in front of each block, keeps the alignment of calloc() */
+#define BENCH_HEAP_HDR  8
+
+static void *(*bench_heap_calloc)(size_t n, size_t size);
+static void (*bench_heap_free)(void *ptr);
+static size_t bench_heap_cur;
+static size_t bench_heap_peak;
+/* 0 while the server of a handshake runs, its blocks are not counted */
+static int bench_heap_count = 1;
+
+static void *bench_calloc(size_t n, size_t size)
+{
+  uint8_t *p;
+  size_t len;
+
+  if (size != 0 && n > (SIZE_MAX - BENCH_HEAP_HDR) / size)
+  {
+    return NULL;
+  }
+  len = n * size;
+  p = bench_heap_calloc(1, len + BENCH_HEAP_HDR);
+  if (p == NULL)
+  {
+    return NULL;
+  }
+  if (!bench_heap_count)
+  {
+    len = 0;
+  }
+  memcpy(p, &len, sizeof(len));
+  bench_heap_cur += len;
+  if (bench_heap_cur > bench_heap_peak)
+  {
+    bench_heap_peak = bench_heap_cur;
+  }
+  return p + BENCH_HEAP_HDR;
+}
+
+static void bench_free(void *ptr)
+{
+  uint8_t *p = ptr;
+  size_t len;
+
+  if (p == NULL)
+  {
+    return;
+  }
+  p -= BENCH_HEAP_HDR;
+  memcpy(&len, p, sizeof(len));
+  bench_heap_cur -= len;
+  bench_heap_free(p);
+}
+#endif /* BENCH_HEAP */
+
+#if defined(BENCH_ECC)
+/* The server's key and its signature of a handshake hash */
+typedef struct
+{
+    mbedtls_ecdsa_context key;
+    mbedtls_mpi r;
+    mbedtls_mpi s;
+    uint8_t hash[32];
+    uint32_t rng;
+} bench_ecc_t;
+
+typedef struct
+{
+    const char *name;
+    int (*run)(bench_ecc_t *ecc, mbedtls_ecp_group *grp);
+} bench_ecc_case_t;
+
+#if defined(MBEDTLS_BENCH_HOST) && defined(MBEDTLS_ECP_YIELD)
+/* Longest run of the ECC code between two calls of mbedtls_ecp_yield(), the
+ firmware sleeps there (mbedtls_ecp_yield.c) */
+static uint32_t bench_yield_last;
+static uint32_t bench_yield_step;
+
+void mbedtls_ecp_yield(void)
+{
+  uint32_t now = bench_usec();
+
+  if (now - bench_yield_last > bench_yield_step)
+  {
+    bench_yield_step = now - bench_yield_last;
+  }
+  bench_yield_last = now;
+}
+#endif
+
+/* xorshift32, the same numbers on every run */
+static int bench_rand(void *state, unsigned char *out, size_t len)
+{
+  uint32_t *x = state;
+
+  while (len-- > 0)
+  {
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    *out++ = (unsigned char)*x;
+  }
+  return 0;
+}
+
+/* Client ephemeral key */
+static int bench_ecdh_gen(bench_ecc_t *ecc, mbedtls_ecp_group *grp)
+{
+  mbedtls_ecp_point q;
+  mbedtls_mpi d;
+  int ret;
+
+  mbedtls_ecp_point_init(&q);
+  mbedtls_mpi_init(&d);
+  ret = mbedtls_ecdh_gen_public(grp, &d, &q, bench_rand, &ecc->rng);
+  mbedtls_mpi_free(&d);
+  mbedtls_ecp_point_free(&q);
+  return ret;
+}
+
+/* Premaster secret from the server's ephemeral key */
+static int bench_ecdh_secret(bench_ecc_t *ecc, mbedtls_ecp_group *grp)
+{
+  mbedtls_mpi z;
+  int ret;
+
+  mbedtls_mpi_init(&z);
+  ret = mbedtls_ecdh_compute_shared(grp, &z, &ecc->key.Q, &ecc->key.d,
+                                    bench_rand, &ecc->rng);
+  mbedtls_mpi_free(&z);
+  return ret;
+}
+
+/* ServerKeyExchange, or a certificate, signature */
+static int bench_ecdsa_verify(bench_ecc_t *ecc, mbedtls_ecp_group *grp)
+{
+  return mbedtls_ecdsa_verify(grp, ecc->hash, sizeof(ecc->hash), &ecc->key.Q,
+                              &ecc->r, &ecc->s);
+}
+
+/* CertificateVerify, with a client certificate */
+static int bench_ecdsa_sign(bench_ecc_t *ecc, mbedtls_ecp_group *grp)
+{
+  mbedtls_mpi r;
+  mbedtls_mpi s;
+  int ret;
+
+  mbedtls_mpi_init(&r);
+  mbedtls_mpi_init(&s);
+  ret = mbedtls_ecdsa_sign(grp, &r, &s, &ecc->key.d, ecc->hash,
+                           sizeof(ecc->hash), bench_rand, &ecc->rng);
+  mbedtls_mpi_free(&s);
+  mbedtls_mpi_free(&r);
+  return ret;
+}
+
+static const bench_ecc_case_t bench_ecc_cases[] =
+{
+  { "ECDHE keygen", bench_ecdh_gen },
+  { "ECDHE secret", bench_ecdh_secret },
+  { "ECDSA verify", bench_ecdsa_verify },
+  { "ECDSA sign", bench_ecdsa_sign },
+};
+
+#define BENCH_NUM_ECC_CASES                                                   \
+  (sizeof(bench_ecc_cases) / sizeof(bench_ecc_cases[0]))
+
+static int bench_ecc_run(void)
+{
+  const bench_ecc_case_t *c;
+  bench_ecc_t ecc;
+  mbedtls_ecp_group grp;
+  uint32_t best;
+  uint32_t start;
+  uint32_t usec;
+  size_t peak;
+  int ret;
+  int i;
+
+  memset(&ecc, 0, sizeof(ecc));
+  ecc.rng = 0x2545F491;
+  mbedtls_ecdsa_init(&ecc.key);
+  mbedtls_mpi_init(&ecc.r);
+  mbedtls_mpi_init(&ecc.s);
+  bench_rand(&ecc.rng, ecc.hash, sizeof(ecc.hash));
+  ret = mbedtls_ecdsa_genkey(&ecc.key, MBEDTLS_ECP_DP_SECP256R1, bench_rand,
+                             &ecc.rng);
+  if (ret == 0)
+  {
+    ret = mbedtls_ecdsa_sign(&ecc.key.grp, &ecc.r, &ecc.s, &ecc.key.d,
+                             ecc.hash, sizeof(ecc.hash), bench_rand, &ecc.rng);
+  }
+
+#if defined(MBEDTLS_BENCH_HOST) && defined(MBEDTLS_ECP_YIELD)
+  bench_yield_step = 0;
+#endif
+  for (c = bench_ecc_cases; ret == 0 && c < bench_ecc_cases
+      + BENCH_NUM_ECC_CASES; c++)
+  {
+    best = UINT32_MAX;
+    peak = 0;
+    for (i = 0; ret == 0 && i < MBEDTLS_BENCH_ECC_ROUNDS; i++)
+    {
+#if defined(BENCH_HEAP)
+      bench_heap_peak = bench_heap_cur;
+#endif
+      start = bench_usec();
+#if defined(MBEDTLS_BENCH_HOST) && defined(MBEDTLS_ECP_YIELD)
+      bench_yield_last = start;
+#endif
+      mbedtls_ecp_group_init(&grp);
+      ret = mbedtls_ecp_group_load(&grp, MBEDTLS_ECP_DP_SECP256R1);
+      if (ret == 0)
+      {
+        ret = c->run(&ecc, &grp);
+      }
+      mbedtls_ecp_group_free(&grp);
+      usec = bench_usec() - start;
+      if (usec < best)
+      {
+        best = usec;
+      }
+#if defined(BENCH_HEAP)
+      if (bench_heap_peak - bench_heap_cur > peak)
+      {
+        peak = bench_heap_peak - bench_heap_cur;
+      }
+#endif
+    }
+    if (ret != 0)
+    {
+      break;
+    }
+    mbedtls_printf("  %-16s %5lu.%lu ms %6lu bytes", c->name,
+                   (unsigned long)(best / 1000),
+                   (unsigned long)(best % 1000 / 100), (unsigned long)peak);
+  }
+
+  if (ret == 0)
+  {
+#if defined(MBEDTLS_BENCH_HOST) && defined(MBEDTLS_ECP_YIELD)
+    mbedtls_printf("  %-16s %5lu.%lu ms", "yield step",
+                   (unsigned long)(bench_yield_step / 1000),
+                   (unsigned long)(bench_yield_step % 1000 / 100));
+#endif
+  }
+  else
+  {
+    mbedtls_printf("crypto bench: ECC failed, -0x%04X", -ret);
+  }
+  mbedtls_mpi_free(&ecc.s);
+  mbedtls_mpi_free(&ecc.r);
+  mbedtls_ecdsa_free(&ecc.key);
+  return (ret == 0) ? 0 : -1;
+}
+#endif /* BENCH_ECC */
+
+#if defined(BENCH_TLS)
+/* Calls of each side before a handshake is given up */
+#define BENCH_TLS_STEPS 64
+
+typedef struct
+{
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_ssl_config conf;
+    mbedtls_x509_crt crt;
+    mbedtls_pk_context key;
+} bench_tls_peer_t;
+
+/* The curve of the device's servers, in both configurations */
+static const mbedtls_ecp_group_id bench_tls_curves[] =
+{
+  MBEDTLS_ECP_DP_SECP256R1, MBEDTLS_ECP_DP_NONE
+};
+
+static int bench_tls_pending(int ret)
+{
+  return ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+static int bench_tls_conf(bench_tls_peer_t *peer, int server, uint32_t *seed)
+{
+  int ret;
+
+  mbedtls_ctr_drbg_init(&peer->drbg);
+  mbedtls_ssl_config_init(&peer->conf);
+  mbedtls_x509_crt_init(&peer->crt);
+  mbedtls_pk_init(&peer->key);
+  ret = mbedtls_ctr_drbg_seed(&peer->drbg, bench_rand, seed, NULL, 0);
+  if (ret == 0 && server)
+  {
+    ret = mbedtls_x509_crt_parse(&peer->crt,
+        (const unsigned char *)mbedtls_bench_tls_srv_crt,
+        mbedtls_bench_tls_srv_crt_len);
+  }
+  else if (ret == 0)
+  {
+    ret = mbedtls_x509_crt_parse(&peer->crt,
+        (const unsigned char *)mbedtls_bench_tls_ca_crt,
+        mbedtls_bench_tls_ca_crt_len);
+  }
+  if (ret == 0 && server)
+  {
+    ret = mbedtls_pk_parse_key(&peer->key,
+        (const unsigned char *)mbedtls_bench_tls_srv_key,
+        mbedtls_bench_tls_srv_key_len, NULL, 0);
+  }
+  if (ret == 0)
+  {
+    ret = mbedtls_ssl_config_defaults(&peer->conf,
+        server ? MBEDTLS_SSL_IS_SERVER : MBEDTLS_SSL_IS_CLIENT,
+        MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+  }
+  if (ret == 0)
+  {
+    mbedtls_ssl_conf_rng(&peer->conf, mbedtls_ctr_drbg_random, &peer->drbg);
+    mbedtls_ssl_conf_curves(&peer->conf, bench_tls_curves);
+  }
+  if (ret == 0 && server)
+  {
+    ret = mbedtls_ssl_conf_own_cert(&peer->conf, &peer->crt, &peer->key);
+  }
+  else if (ret == 0)
+  {
+    mbedtls_ssl_conf_authmode(&peer->conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&peer->conf, &peer->crt, NULL);
+  }
+  return ret;
+}
+
+static void bench_tls_conf_free(bench_tls_peer_t *peer)
+{
+  mbedtls_pk_free(&peer->key);
+  mbedtls_x509_crt_free(&peer->crt);
+  mbedtls_ssl_config_free(&peer->conf);
+  mbedtls_ctr_drbg_free(&peer->drbg);
+}
+
+/* One handshake, the microseconds spent in the client's calls in 'usec' */
+static int bench_tls_handshake(bench_tls_peer_t *cli_peer,
+                               bench_tls_peer_t *srv_peer, uint32_t *usec,
+                               const char **suite)
+{
+  mbedtls_ssl_context cli;
+  mbedtls_ssl_context srv;
+  uint32_t start;
+  int cli_ret = MBEDTLS_ERR_SSL_WANT_READ;
+  int srv_ret = MBEDTLS_ERR_SSL_WANT_READ;
+  int step;
+  int ret;
+
+  mbedtls_bench_tls_reset();
+  bench_heap_count = 0;
+  mbedtls_ssl_init(&srv);
+  ret = mbedtls_ssl_setup(&srv, &srv_peer->conf);
+  mbedtls_bench_tls_set_bio(&srv, 1);
+  bench_heap_count = 1;
+
+  start = bench_usec();
+  mbedtls_ssl_init(&cli);
+  if (ret == 0)
+  {
+    ret = mbedtls_ssl_setup(&cli, &cli_peer->conf);
+  }
+  if (ret == 0)
+  {
+    ret = mbedtls_ssl_set_hostname(&cli, MBEDTLS_BENCH_TLS_HOSTNAME);
+  }
+  mbedtls_bench_tls_set_bio(&cli, 0);
+  *usec = bench_usec() - start;
+
+  for (step = 0; ret == 0 && (cli_ret != 0 || srv_ret != 0)
+      && step < BENCH_TLS_STEPS; step++)
+  {
+    if (cli_ret != 0)
+    {
+      start = bench_usec();
+      cli_ret = mbedtls_ssl_handshake(&cli);
+      *usec += bench_usec() - start;
+    }
+    if (srv_ret != 0)
+    {
+      bench_heap_count = 0;
+      srv_ret = mbedtls_ssl_handshake(&srv);
+      bench_heap_count = 1;
+    }
+    if (!bench_tls_pending(cli_ret) && cli_ret != 0)
+    {
+      ret = cli_ret;
+    }
+    else if (!bench_tls_pending(srv_ret) && srv_ret != 0)
+    {
+      ret = srv_ret;
+    }
+  }
+  if (ret == 0 && (cli_ret != 0 || srv_ret != 0))
+  {
+    ret = -1;
+  }
+  if (ret == 0)
+  {
+    *suite = mbedtls_ssl_get_ciphersuite(&cli);
+  }
+
+  mbedtls_ssl_free(&cli);
+  bench_heap_count = 0;
+  mbedtls_ssl_free(&srv);
+  bench_heap_count = 1;
+  return ret;
+}
+
+static int bench_tls_run(void)
+{
+  bench_tls_peer_t cli_peer;
+  bench_tls_peer_t srv_peer;
+  const char *suite = "";
+  uint32_t cli_seed = 0x13579BDF;
+  uint32_t srv_seed = 0x2468ACE0;
+  uint32_t best = UINT32_MAX;
+  uint32_t usec;
+  size_t peak = 0;
+  int srv_ret;
+  int ret;
+  int i;
+
+  /* the configurations and the CA stay, as in the firmware, and are not part
+   of the peak */
+  bench_heap_count = 0;
+  srv_ret = bench_tls_conf(&srv_peer, 1, &srv_seed);
+  bench_heap_count = 1;
+  ret = bench_tls_conf(&cli_peer, 0, &cli_seed);
+  if (srv_ret != 0)
+  {
+    ret = srv_ret;
+  }
+
+  for (i = 0; ret == 0 && i < MBEDTLS_BENCH_ECC_ROUNDS; i++)
+  {
+    bench_heap_peak = bench_heap_cur;
+    ret = bench_tls_handshake(&cli_peer, &srv_peer, &usec, &suite);
+    if (usec < best)
+    {
+      best = usec;
+    }
+    if (bench_heap_peak - bench_heap_cur > peak)
+    {
+      peak = bench_heap_peak - bench_heap_cur;
+    }
+  }
+
+  if (ret == 0)
+  {
+    mbedtls_printf("  %-16s %5lu.%lu ms %6lu bytes  %s", "TLS handshake",
+                   (unsigned long)(best / 1000),
+                   (unsigned long)(best % 1000 / 100), (unsigned long)peak,
+                   suite);
+  }
+  else
+  {
+    mbedtls_printf("crypto bench: TLS handshake failed, -0x%04X", -ret);
+  }
+  bench_tls_conf_free(&cli_peer);
+  bench_heap_count = 0;
+  bench_tls_conf_free(&srv_peer);
+  bench_heap_count = 1;
+  return (ret == 0) ? 0 : -1;
+}
+#endif /* BENCH_TLS */
+
+int mbedtls_bench_run(void)
+{
+  static const uint8_t key[32] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2,
+                                   0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF,
+                                   0x4F, 0x3C };
+  const bench_case_t *c;
+  mbedtls_aes_context aes;
+  uint32_t best;
+  uint32_t start;
+  uint32_t ticks;
+  uint8_t *buf;
+  int ret = 0;
+  int i;
+
+  if (mbedtls_sha256_self_test(0) != 0 || mbedtls_aes_self_test(0) != 0
+#if defined(BENCH_ECC)
+      || mbedtls_ecp_self_test(0) != 0
+#endif
+      )
+  {
+    mbedtls_printf("crypto bench: self test failed");
+    return -1;
+  }
+
+  buf = mbedtls_calloc(1, MBEDTLS_BENCH_LEN);
+  if (buf == NULL)
+  {
+    return -1;
+  }
+
+  mbedtls_aes_init(&aes);
+  for (c = bench_cases; c < bench_cases + BENCH_NUM_CASES; c++)
+  {
+    if (c->run == bench_aes_dec)
+    {
+      mbedtls_aes_setkey_dec(&aes, key, c->key_bits);
+    }
+    else if (c->key_bits != 0)
+    {
+      mbedtls_aes_setkey_enc(&aes, key, c->key_bits);
+    }
+
+    /* the first run warms the cache up */
+    best = UINT32_MAX;
+    for (i = 0; i <= MBEDTLS_BENCH_ROUNDS; i++)
+    {
+      start = bench_now();
+      c->run(&aes, buf, MBEDTLS_BENCH_LEN);
+      ticks = bench_now() - start;
+      if (i > 0 && ticks < best)
+      {
+        best = ticks;
+      }
+    }
+    mbedtls_printf("  %-16s %5lu.%02lu %s/byte", c->name,
+                   (unsigned long)(best / MBEDTLS_BENCH_LEN),
+                   (unsigned long)(best % MBEDTLS_BENCH_LEN * 100
+                       / MBEDTLS_BENCH_LEN), BENCH_UNIT);
+  }
+  mbedtls_aes_free(&aes);
+  mbedtls_free(buf);
+
+#if defined(BENCH_ECC)
+#if defined(BENCH_HEAP)
+  bench_heap_calloc = mbedtls_calloc;
+  bench_heap_free = mbedtls_free;
+  bench_heap_cur = 0;
+  mbedtls_platform_set_calloc_free(bench_calloc, bench_free);
+#endif
+  ret = bench_ecc_run();
+#if defined(BENCH_TLS)
+  if (ret == 0)
+  {
+    ret = bench_tls_run();
+  }
+#endif
+#if defined(BENCH_HEAP)
+  mbedtls_platform_set_calloc_free(bench_heap_calloc, bench_heap_free);
+#endif
+#endif
+  return ret;
+}
+
+#if defined(MBEDTLS_BENCH_HOST)
+#include <stdarg.h>
+#include <stdio.h>
+
+/* log.h of the firmware, which mbedtls_platform.h prints through, ends the
+ lines itself */
+void Log_Printf(const char *format, ...)
+{
+  size_t len = strlen(format);
+  va_list args;
+
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+  if (len == 0 || format[len - 1] != '\n')
+  {
+    putchar('\n');
+  }
+}
+
+int main(void)
+{
+  return (mbedtls_bench_run() == 0) ? 0 : 1;
+}
+#endif /* MBEDTLS_BENCH_HOST */
@@ -0,0 +1,38 @@
+/*
+ * Let other tasks run during an elliptic curve operation
+ *
+ * A P-256 multiplication takes hundreds of milliseconds at 80 MHz, and a
+ * handshake several of them. mbedtls_ecp.c calls mbedtls_ecp_yield() after
+ * each doubling and addition, which sleeps for a tick once MBEDTLS_ECP_YIELD_MS
+ * went by, so that tasks of lower priority are not starved meanwhile.
+ */
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/mbedtls_config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_ECP_C) && defined(MBEDTLS_ECP_YIELD)
+
+#include "mbedtls/mbedtls_ecp.h"
+#include "freertos.h"
+#include "freertos_task.h"
+
+/* Longest run of computation without sleeping */
+#ifndef MBEDTLS_ECP_YIELD_MS
+#define MBEDTLS_ECP_YIELD_MS    30
+#endif
+
+void mbedtls_ecp_yield(void)
+{
+  static TickType_t last;
+  TickType_t now = xTaskGetTickCount();
+
+  if (now - last >= pdMS_TO_TICKS(MBEDTLS_ECP_YIELD_MS))
+  {
+    vTaskDelay(1);
+    last = xTaskGetTickCount();
+  }
+}
+
+#endif /* MBEDTLS_ECP_C && MBEDTLS_ECP_YIELD */
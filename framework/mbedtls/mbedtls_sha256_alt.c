@@ -0,0 +1,130 @@
+/*
+ * SHA-256 compression for the LX106, MBEDTLS_SHA256_PROCESS_ALT.
+ *
+ * MBEDTLS_SHA256_SMALLER shifts the eight working variables through memory
+ * every round, and the full version keeps a 256 byte message schedule. Here
+ * sixteen rounds are unrolled so that the variables rotate by renaming and
+ * the schedule is a 16 word window updated in place, with a constant index
+ * in every round. The rotations compile to an SSAI/SRC pair. K[] is read
+ * once per round and ld/program.ld keeps it in DRAM with the .rodata of
+ * this unit.
+ */
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/mbedtls_config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_SHA256_C) && !defined(MBEDTLS_SHA256_ALT) &&              \
+    defined(MBEDTLS_SHA256_PROCESS_ALT)
+
+#include <stdint.h>
+#include "mbedtls/mbedtls_sha256.h"
+
+static const uint32_t K[64] =
+{
+  0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
+  0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+  0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+  0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+  0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC,
+  0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+  0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7,
+  0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+  0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+  0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+  0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+  0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+  0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5,
+  0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+  0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+  0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+#define ROTR(x, n)  (((x) >> (n)) | ((x) << (32 - (n))))
+
+#define S0(x)       (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define S1(x)       (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+#define S2(x)       (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define S3(x)       (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+
+#define F0(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+#define F1(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+
+#define GET_UINT32_BE(b, i)                                                   \
+  (((uint32_t)(b)[(i)] << 24) | ((uint32_t)(b)[(i) + 1] << 16) |              \
+   ((uint32_t)(b)[(i) + 2] << 8) | (uint32_t)(b)[(i) + 3])
+
+/* W[t] of rounds 16 to 63, in the slot of W[t - 16] */
+#define R(t)                                                                  \
+  (W[(t) & 15] += S1(W[((t) - 2) & 15]) + W[((t) - 7) & 15] +                 \
+                  S0(W[((t) - 15) & 15]))
+
+#define P(a, b, c, d, e, f, g, h, x, k)                                       \
+  do                                                                          \
+  {                                                                           \
+    temp1 = (h) + S3(e) + F1(e, f, g) + (k) + (x);                            \
+    temp2 = S2(a) + F0(a, b, c);                                              \
+    (d) += temp1;                                                             \
+    (h) = temp1 + temp2;                                                      \
+  } while (0)
+
+/* Sixteen rounds, WORD(t) gives the word of round t */
+#define P16(WORD)                                                             \
+  do                                                                          \
+  {                                                                           \
+    P(A, B, C, D, E, F, G, H, WORD(0), k[0]);                                 \
+    P(H, A, B, C, D, E, F, G, WORD(1), k[1]);                                 \
+    P(G, H, A, B, C, D, E, F, WORD(2), k[2]);                                 \
+    P(F, G, H, A, B, C, D, E, WORD(3), k[3]);                                 \
+    P(E, F, G, H, A, B, C, D, WORD(4), k[4]);                                 \
+    P(D, E, F, G, H, A, B, C, WORD(5), k[5]);                                 \
+    P(C, D, E, F, G, H, A, B, WORD(6), k[6]);                                 \
+    P(B, C, D, E, F, G, H, A, WORD(7), k[7]);                                 \
+    P(A, B, C, D, E, F, G, H, WORD(8), k[8]);                                 \
+    P(H, A, B, C, D, E, F, G, WORD(9), k[9]);                                 \
+    P(G, H, A, B, C, D, E, F, WORD(10), k[10]);                               \
+    P(F, G, H, A, B, C, D, E, WORD(11), k[11]);                               \
+    P(E, F, G, H, A, B, C, D, WORD(12), k[12]);                               \
+    P(D, E, F, G, H, A, B, C, WORD(13), k[13]);                               \
+    P(C, D, E, F, G, H, A, B, WORD(14), k[14]);                               \
+    P(B, C, D, E, F, G, H, A, WORD(15), k[15]);                               \
+  } while (0)
+
+#define W_LOAD(t)   (W[t] = GET_UINT32_BE(data, 4 * (t)))
+#define W_NEXT(t)   R(t)
+
+void mbedtls_sha256_process(mbedtls_sha256_context *ctx,
+                            const unsigned char data[64])
+{
+  const uint32_t *k = K;
+  uint32_t A, B, C, D, E, F, G, H;
+  uint32_t temp1, temp2;
+  uint32_t W[16];
+
+  A = ctx->state[0];
+  B = ctx->state[1];
+  C = ctx->state[2];
+  D = ctx->state[3];
+  E = ctx->state[4];
+  F = ctx->state[5];
+  G = ctx->state[6];
+  H = ctx->state[7];
+
+  P16(W_LOAD);
+  for (k += 16; k < K + 64; k += 16)
+  {
+    P16(W_NEXT);
+  }
+
+  ctx->state[0] += A;
+  ctx->state[1] += B;
+  ctx->state[2] += C;
+  ctx->state[3] += D;
+  ctx->state[4] += E;
+  ctx->state[5] += F;
+  ctx->state[6] += G;
+  ctx->state[7] += H;
+}
+
+#endif /* MBEDTLS_SHA256_C && MBEDTLS_SHA256_PROCESS_ALT */
@@ -0,0 +1,170 @@
+/*
+ * TLS memory arena, mbedtls_memory_buffer_alloc.c over a static buffer
+ *
+ * The allocator has no lock of its own without MBEDTLS_THREADING_C, so its
+ * functions are wrapped in a mutex here; the statistics are read under the
+ * same mutex.
+ */
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/mbedtls_config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C) && defined(MBEDTLS_SSL_TLS_C)
+
+#include "mbedtls/mbedtls_platform.h"
+#include "mbedtls/mbedtls_memory_buffer_alloc.h"
+#include "mbedtls_tls_arena.h"
+
+#if defined(MBEDTLS_BENCH_HOST)
+/* tlssoak, a single thread */
+#define ARENA_LOCK()
+#define ARENA_UNLOCK()
+#else
+#include "freertos.h"
+#include "freertos_semphr.h"
+
+static SemaphoreHandle_t arena_mutex;
+static StaticSemaphore_t arena_mutex_buf;
+
+#define ARENA_LOCK()    xSemaphoreTake(arena_mutex, portMAX_DELAY)
+#define ARENA_UNLOCK()  xSemaphoreGive(arena_mutex)
+#endif
+
+#if MBEDTLS_SSL_MAX_CONTENT_LEN >= 4096
+#define ARENA_MAX_FRAG_LEN      MBEDTLS_SSL_MAX_FRAG_LEN_4096
+#elif MBEDTLS_SSL_MAX_CONTENT_LEN >= 2048
+#define ARENA_MAX_FRAG_LEN      MBEDTLS_SSL_MAX_FRAG_LEN_2048
+#elif MBEDTLS_SSL_MAX_CONTENT_LEN >= 1024
+#define ARENA_MAX_FRAG_LEN      MBEDTLS_SSL_MAX_FRAG_LEN_1024
+#else
+#define ARENA_MAX_FRAG_LEN      MBEDTLS_SSL_MAX_FRAG_LEN_512
+#endif
+
+/* 8 byte aligned for the 64 bit limbs of a host build */
+static uint64_t arena[MBEDTLS_TLS_ARENA_SIZE / sizeof(uint64_t)];
+
+/* functions of mbedtls_memory_buffer_alloc.c */
+static void *(*arena_calloc)(size_t n, size_t size);
+static void (*arena_free)(void *ptr);
+
+static size_t arena_peak;
+static uint32_t arena_handshakes;
+static uint32_t arena_fails;
+
+static void *arena_calloc_locked(size_t n, size_t size)
+{
+  void *p;
+
+  ARENA_LOCK();
+  p = arena_calloc(n, size);
+  if (p == NULL)
+  {
+    arena_fails++;
+  }
+  ARENA_UNLOCK();
+  return p;
+}
+
+static void arena_free_locked(void *ptr)
+{
+  ARENA_LOCK();
+  arena_free(ptr);
+  ARENA_UNLOCK();
+}
+
+int mbedtls_tls_arena_init(void)
+{
+#if !defined(MBEDTLS_BENCH_HOST)
+  arena_mutex = xSemaphoreCreateMutexStatic(&arena_mutex_buf);
+  if (arena_mutex == NULL)
+  {
+    return -1;
+  }
+#endif
+  mbedtls_memory_buffer_alloc_init((unsigned char *)arena, sizeof(arena));
+  arena_calloc = mbedtls_calloc;
+  arena_free = mbedtls_free;
+  mbedtls_platform_set_calloc_free(arena_calloc_locked, arena_free_locked);
+  return 0;
+}
+
+int mbedtls_tls_arena_conf(mbedtls_ssl_config *conf)
+{
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+  return mbedtls_ssl_conf_max_frag_len(conf, ARENA_MAX_FRAG_LEN);
+#else
+  (void)conf;
+  return 0;
+#endif
+}
+
+int mbedtls_tls_arena_handshake(mbedtls_ssl_context *ssl)
+{
+  size_t blocks;
+  int ret;
+
+#if defined(MBEDTLS_MEMORY_DEBUG)
+  if (ssl->state == MBEDTLS_SSL_HELLO_REQUEST)
+  {
+    ARENA_LOCK();
+    mbedtls_memory_buffer_alloc_max_reset();
+    ARENA_UNLOCK();
+  }
+#endif
+
+  ret = mbedtls_ssl_handshake(ssl);
+  if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE)
+  {
+    return ret;
+  }
+
+#if defined(MBEDTLS_MEMORY_DEBUG)
+  ARENA_LOCK();
+  mbedtls_memory_buffer_alloc_max_get(&arena_peak, &blocks);
+  ARENA_UNLOCK();
+#else
+  blocks = 0;
+#endif
+  if (ret == 0)
+  {
+    arena_handshakes++;
+  }
+#if MBEDTLS_TLS_ARENA_LOG
+  if (ret == 0)
+  {
+    mbedtls_printf("TLS handshake: arena peak %lu of %lu bytes, %lu blocks",
+                   (unsigned long)arena_peak, (unsigned long)sizeof(arena),
+                   (unsigned long)blocks);
+  }
+  else
+  {
+    mbedtls_printf("TLS handshake: -0x%04X, arena peak %lu of %lu bytes",
+                   -ret, (unsigned long)arena_peak,
+                   (unsigned long)sizeof(arena));
+  }
+#else
+  (void)blocks;
+#endif
+  return ret;
+}
+
+void mbedtls_tls_arena_get_stats(mbedtls_tls_arena_stats_t *stats)
+{
+  ARENA_LOCK();
+#if defined(MBEDTLS_MEMORY_DEBUG)
+  mbedtls_memory_buffer_alloc_cur_get(&stats->used, &stats->blocks);
+#else
+  stats->used = 0;
+  stats->blocks = 0;
+#endif
+  mbedtls_memory_buffer_alloc_free_get(&stats->free, &stats->largest);
+  stats->peak = arena_peak;
+  stats->handshakes = arena_handshakes;
+  stats->fails = arena_fails;
+  ARENA_UNLOCK();
+  stats->size = sizeof(arena);
+}
+
+#endif /* MBEDTLS_MEMORY_BUFFER_ALLOC_C && MBEDTLS_SSL_TLS_C */
@@ -0,0 +1,376 @@
+/*
+ * TLS arena soak test, a host program ("make tlssoak")
+ *
+ * A client on the arena of mbedtls_tls_arena.c and a server on the C library
+ * heap talk through two memory pipes. The client keeps its configuration and
+ * CA chain across the reconnects, as the firmware would. Each reconnect sets
+ * up a session, completes an ECDHE-ECDSA handshake with verification,
+ * exchanges a request and a reply of random lengths, closes and frees it.
+ * The arena must then be back to the bytes in use and the largest free block
+ * it had after the first reconnect, i.e. sessions leave no fragmentation.
+ */
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/mbedtls_config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_BENCH_HOST)
+
+#if !defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C) || \
+    !defined(MBEDTLS_SSL_CLI_C) || !defined(MBEDTLS_SSL_SRV_C) || \
+    !defined(MBEDTLS_CTR_DRBG_C) || !defined(MBEDTLS_PK_PARSE_C) || \
+    !defined(MBEDTLS_X509_CRT_PARSE_C) || !defined(MBEDTLS_PEM_PARSE_C)
+#error "tlssoak needs the TLS client, server and arena of mbedtls_config_p256.h"
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mbedtls/mbedtls_platform.h"
+#include "mbedtls/mbedtls_ctr_drbg.h"
+#include "mbedtls/mbedtls_pk.h"
+#include "mbedtls/mbedtls_ssl.h"
+#include "mbedtls/mbedtls_x509_crt.h"
+#include "mbedtls_bench_tls.h"
+#include "mbedtls_tls_arena.h"
+
+/* Reconnects, unless given on the command line */
+#define SOAK_RECONNECTS     1000
+/* Longest request and reply, the reply spans several records */
+#define SOAK_REQUEST_MAX    1024
+#define SOAK_REPLY_MAX      (3 * MBEDTLS_SSL_MAX_CONTENT_LEN)
+/* Calls of each side before a handshake is given up */
+#define SOAK_STEPS_MAX      64
+
+/* mbedtls_calloc() and mbedtls_free() of the client, the arena */
+static void *(*soak_arena_calloc)(size_t n, size_t size);
+static void (*soak_arena_free)(void *ptr);
+
+static unsigned char soak_data[SOAK_REPLY_MAX];
+
+static void soak_server_heap(int server)
+{
+  if (server)
+  {
+    mbedtls_platform_set_calloc_free(calloc, free);
+  }
+  else
+  {
+    mbedtls_platform_set_calloc_free(soak_arena_calloc, soak_arena_free);
+  }
+}
+
+/* xorshift32, entropy of the DRBGs and lengths of the messages */
+static int soak_rand(void *state, unsigned char *out, size_t len)
+{
+  uint32_t *x = state;
+
+  while (len-- > 0)
+  {
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    *out++ = (unsigned char)*x;
+  }
+  return 0;
+}
+
+static int soak_pending(int ret)
+{
+  return ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+/* Move 'len' bytes of application data from 'from' to 'to' */
+static int soak_transfer(mbedtls_ssl_context *from, int from_server,
+                         mbedtls_ssl_context *to, size_t len)
+{
+  static unsigned char rx[SOAK_REPLY_MAX];
+  size_t sent = 0;
+  size_t got = 0;
+  int step;
+  int ret;
+
+  for (step = 0; got < len && step < SOAK_STEPS_MAX * 4; step++)
+  {
+    if (sent < len)
+    {
+      soak_server_heap(from_server);
+      ret = mbedtls_ssl_write(from, soak_data + sent, len - sent);
+      if (ret > 0)
+      {
+        sent += ret;
+      }
+      else if (!soak_pending(ret))
+      {
+        return ret;
+      }
+    }
+    soak_server_heap(!from_server);
+    ret = mbedtls_ssl_read(to, rx + got, len - got);
+    if (ret > 0)
+    {
+      got += ret;
+    }
+    else if (!soak_pending(ret))
+    {
+      return ret;
+    }
+  }
+  if (got != len || memcmp(rx, soak_data, len) != 0)
+  {
+    return -1;
+  }
+  return 0;
+}
+
+static int soak_reconnect(mbedtls_ssl_config *cli_conf,
+                          mbedtls_ssl_config *srv_conf, uint32_t *rng)
+{
+  mbedtls_ssl_context cli;
+  mbedtls_ssl_context srv;
+  uint16_t len[2];
+  int cli_ret = MBEDTLS_ERR_SSL_WANT_READ;
+  int srv_ret = MBEDTLS_ERR_SSL_WANT_READ;
+  int step;
+  int ret;
+
+  mbedtls_bench_tls_reset();
+  soak_server_heap(1);
+  mbedtls_ssl_init(&srv);
+  ret = mbedtls_ssl_setup(&srv, srv_conf);
+  mbedtls_bench_tls_set_bio(&srv, 1);
+  soak_server_heap(0);
+  mbedtls_ssl_init(&cli);
+  if (ret == 0)
+  {
+    ret = mbedtls_ssl_setup(&cli, cli_conf);
+  }
+  if (ret == 0)
+  {
+    ret = mbedtls_ssl_set_hostname(&cli, MBEDTLS_BENCH_TLS_HOSTNAME);
+  }
+  mbedtls_bench_tls_set_bio(&cli, 0);
+
+  for (step = 0; ret == 0 && (cli_ret != 0 || srv_ret != 0)
+      && step < SOAK_STEPS_MAX; step++)
+  {
+    if (cli_ret != 0)
+    {
+      soak_server_heap(0);
+      cli_ret = mbedtls_tls_arena_handshake(&cli);
+    }
+    if (srv_ret != 0)
+    {
+      soak_server_heap(1);
+      srv_ret = mbedtls_ssl_handshake(&srv);
+    }
+    if (!soak_pending(cli_ret) && cli_ret != 0)
+    {
+      ret = cli_ret;
+    }
+    else if (!soak_pending(srv_ret) && srv_ret != 0)
+    {
+      ret = srv_ret;
+    }
+  }
+  if (ret == 0 && (cli_ret != 0 || srv_ret != 0))
+  {
+    ret = -1;
+  }
+
+  if (ret == 0)
+  {
+    soak_rand(rng, (unsigned char *)len, sizeof(len));
+    ret = soak_transfer(&cli, 0, &srv, 1 + len[0] % SOAK_REQUEST_MAX);
+  }
+  if (ret == 0)
+  {
+    ret = soak_transfer(&srv, 1, &cli, 1 + len[1] % SOAK_REPLY_MAX);
+  }
+  if (ret == 0)
+  {
+    soak_server_heap(0);
+    ret = mbedtls_ssl_close_notify(&cli);
+  }
+
+  soak_server_heap(0);
+  mbedtls_ssl_free(&cli);
+  soak_server_heap(1);
+  mbedtls_ssl_free(&srv);
+  return ret;
+}
+
+#if defined(MBEDTLS_ECP_YIELD)
+/* The firmware lets other tasks run there, see mbedtls_ecp_yield.c */
+void mbedtls_ecp_yield(void)
+{
+}
+#endif
+
+/* log.h of the firmware, which mbedtls_platform.h prints through, ends the
+ lines itself */
+void Log_Printf(const char *format, ...)
+{
+  size_t len = strlen(format);
+  va_list args;
+
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+  if (len == 0 || format[len - 1] != '\n')
+  {
+    putchar('\n');
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  mbedtls_tls_arena_stats_t first;
+  mbedtls_tls_arena_stats_t stats;
+  mbedtls_ctr_drbg_context cli_drbg;
+  mbedtls_ctr_drbg_context srv_drbg;
+  mbedtls_ssl_config cli_conf;
+  mbedtls_ssl_config srv_conf;
+  mbedtls_x509_crt ca;
+  mbedtls_x509_crt srv_crt;
+  mbedtls_pk_context srv_key;
+  uint32_t cli_seed = 0x13579BDF;
+  uint32_t srv_seed = 0x2468ACE0;
+  uint32_t rng = 0x9E3779B9;
+  size_t peak = 0;
+  size_t largest = SIZE_MAX;
+  long reconnects = (argc > 1) ? atol(argv[1]) : SOAK_RECONNECTS;
+  long i;
+  int ret;
+
+  memset(&first, 0, sizeof(first));
+  memset(&stats, 0, sizeof(stats));
+  mbedtls_tls_arena_init();
+  soak_arena_calloc = mbedtls_calloc;
+  soak_arena_free = mbedtls_free;
+
+  /* the server, on the C library heap */
+  soak_server_heap(1);
+  mbedtls_ctr_drbg_init(&srv_drbg);
+  mbedtls_ssl_config_init(&srv_conf);
+  mbedtls_x509_crt_init(&srv_crt);
+  mbedtls_pk_init(&srv_key);
+  ret = mbedtls_ctr_drbg_seed(&srv_drbg, soak_rand, &srv_seed, NULL, 0);
+  if (ret == 0)
+  {
+    ret = mbedtls_x509_crt_parse(&srv_crt,
+        (const unsigned char *)mbedtls_bench_tls_srv_crt,
+        mbedtls_bench_tls_srv_crt_len);
+  }
+  if (ret == 0)
+  {
+    ret = mbedtls_pk_parse_key(&srv_key,
+        (const unsigned char *)mbedtls_bench_tls_srv_key,
+        mbedtls_bench_tls_srv_key_len, NULL, 0);
+  }
+  if (ret == 0)
+  {
+    ret = mbedtls_ssl_config_defaults(&srv_conf, MBEDTLS_SSL_IS_SERVER,
+                                      MBEDTLS_SSL_TRANSPORT_STREAM,
+                                      MBEDTLS_SSL_PRESET_DEFAULT);
+  }
+  if (ret == 0)
+  {
+    mbedtls_ssl_conf_rng(&srv_conf, mbedtls_ctr_drbg_random, &srv_drbg);
+    ret = mbedtls_ssl_conf_own_cert(&srv_conf, &srv_crt, &srv_key);
+  }
+
+  /* the client, on the arena, kept for all the reconnects */
+  soak_server_heap(0);
+  mbedtls_ctr_drbg_init(&cli_drbg);
+  mbedtls_ssl_config_init(&cli_conf);
+  mbedtls_x509_crt_init(&ca);
+  if (ret == 0)
+  {
+    ret = mbedtls_ctr_drbg_seed(&cli_drbg, soak_rand, &cli_seed, NULL, 0);
+  }
+  if (ret == 0)
+  {
+    ret = mbedtls_x509_crt_parse(&ca,
+        (const unsigned char *)mbedtls_bench_tls_ca_crt,
+        mbedtls_bench_tls_ca_crt_len);
+  }
+  if (ret == 0)
+  {
+    ret = mbedtls_ssl_config_defaults(&cli_conf, MBEDTLS_SSL_IS_CLIENT,
+                                      MBEDTLS_SSL_TRANSPORT_STREAM,
+                                      MBEDTLS_SSL_PRESET_DEFAULT);
+  }
+  if (ret == 0)
+  {
+    mbedtls_ssl_conf_authmode(&cli_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&cli_conf, &ca, NULL);
+    mbedtls_ssl_conf_rng(&cli_conf, mbedtls_ctr_drbg_random, &cli_drbg);
+    ret = mbedtls_tls_arena_conf(&cli_conf);
+  }
+  soak_rand(&rng, soak_data, sizeof(soak_data));
+
+  for (i = 0; ret == 0 && i < reconnects; i++)
+  {
+    ret = soak_reconnect(&cli_conf, &srv_conf, &rng);
+    mbedtls_tls_arena_get_stats(&stats);
+    if (i == 0)
+    {
+      first = stats;
+    }
+    if (stats.peak > peak)
+    {
+      peak = stats.peak;
+    }
+    if (stats.largest < largest)
+    {
+      largest = stats.largest;
+    }
+  }
+
+  if (ret != 0)
+  {
+    mbedtls_printf("tlssoak: reconnect %ld failed, -0x%04X", i, -ret);
+  }
+  mbedtls_printf("  reconnects       %8ld", i);
+  mbedtls_printf("  handshake peak   %8lu of %lu bytes, %lu allocations "
+                 "failed", (unsigned long)peak, (unsigned long)stats.size,
+                 (unsigned long)stats.fails);
+  mbedtls_printf("  in use           %8lu bytes in %lu blocks after the "
+                 "first, %lu in %lu after the last",
+                 (unsigned long)first.used, (unsigned long)first.blocks,
+                 (unsigned long)stats.used, (unsigned long)stats.blocks);
+  mbedtls_printf("  largest free     %8lu bytes after the first, %lu at "
+                 "least after the others", (unsigned long)first.largest,
+                 (unsigned long)largest);
+  if (ret == 0 && (stats.used != first.used || stats.blocks != first.blocks
+      || largest != first.largest))
+  {
+    mbedtls_printf("tlssoak: the arena changed across reconnects");
+    ret = -1;
+  }
+
+  soak_server_heap(0);
+  mbedtls_x509_crt_free(&ca);
+  mbedtls_ssl_config_free(&cli_conf);
+  mbedtls_ctr_drbg_free(&cli_drbg);
+  soak_server_heap(1);
+  mbedtls_pk_free(&srv_key);
+  mbedtls_x509_crt_free(&srv_crt);
+  mbedtls_ssl_config_free(&srv_conf);
+  mbedtls_ctr_drbg_free(&srv_drbg);
+
+  mbedtls_tls_arena_get_stats(&stats);
+  if (ret == 0 && stats.used != 0)
+  {
+    mbedtls_printf("tlssoak: %lu bytes left in the arena",
+                   (unsigned long)stats.used);
+    ret = -1;
+  }
+  return (ret == 0) ? 0 : 1;
+}
+
+#endif /* MBEDTLS_BENCH_HOST */
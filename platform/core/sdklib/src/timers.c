@@ -10,117 +10,276 @@
 #include "etstimer.h"
 #include "stdio.h"
 
-struct timer_list_st
-{
-  struct timer_list_st *next;
-  ETSTimer *timer;
-};
+/* The original code registers every ETSTimer in a malloc'd list and backs each
+ armed one with a FreeRTOS software timer. Here armed timers are linked
+ directly into a hierarchical timer wheel (as in the Linux kernel before 4.8):
+ TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SIZE slots, level n slots spanning
+ TIMER_WHEEL_SIZE^n ticks. Arm and disarm are O(1) list operations and need
+ no memory, the slots of a level are cascaded into the level below each time
+ it wraps.
 
-static struct timer_list_st *timer_list;
-static uint8_t armed_timer_count;
+ The tick hook only checks whether the slot of the current tick holds
+ anything (or a cascade is due) and then defers the work to the timer service
+ task, so the callbacks still run in the same task as before.
+ */
+#define TIMER_WHEEL_BITS    5
+#define TIMER_WHEEL_SIZE    (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK    (TIMER_WHEEL_SIZE - 1)
+#define TIMER_WHEEL_LEVELS  4
+/* Longest delay the wheel holds, longer timers are cascaded again when they
+ reach the end of it (2.9 hours at 100 Hz) */
+#define TIMER_WHEEL_MAX     ((1UL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
 
-void sdk_os_timer_setfn(ETSTimer *ptimer, ETSTimerFunc *pfunction, void *parg)
+#define TIMER_INDEX(tick, level) \
+    (((tick) >> ((level) * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK)
+
+static ETSTimer *timer_wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE];
+/* Next tick to be processed */
+static uint32_t timer_now;
+static uint16_t armed_timer_count;
+/* Last tick looked at by the tick hook */
+static uint32_t timer_checked;
+static volatile bool timer_pending;
+
+/* ETSTimers are also declared on the stack or inside malloc'd structures
+ that are never cleared, so nothing in a timer is trusted before
+ sdk_os_timer_setfn() has set it up. Called inside a critical section. */
+static bool timer_in_wheel(ETSTimer *ptimer)
 {
-  struct timer_list_st *entry = 0;
-  struct timer_list_st *new_entry;
-  struct timer_list_st **tailptr;
+  ETSTimer *t;
+  uint8_t level;
+  uint8_t index;
 
-  if (timer_list)
+  for (level = 0; armed_timer_count && (level < TIMER_WHEEL_LEVELS); level++)
   {
-    for (entry = timer_list;; entry = entry->next)
+    for (index = 0; index < TIMER_WHEEL_SIZE; index++)
     {
-      if (entry->timer == ptimer)
+      for (t = timer_wheel[level][index]; t != 0; t = t->timer_next)
       {
-        if (ptimer->timer_arg == parg && ptimer->timer_func == pfunction)
+        if (t == ptimer)
         {
-          return;
+          return true;
         }
-        if (ptimer->timer_handle)
-        {
-          if (!xTimerDelete(ptimer->timer_handle, 50))
-          {
-            printf("Timer Delete Failed\n");
-          }
-          armed_timer_count--;
-        }
-        ptimer->timer_func = pfunction;
-        ptimer->timer_arg = parg;
-        ptimer->timer_handle = 0;
-        ptimer->timer_ms = 0;
-        return;
       }
-      if (!entry->next)
+    }
+  }
+  return false;
+}
+
+/* Called inside a critical section */
+static void timer_link(ETSTimer *ptimer)
+{
+  uint32_t delta = ptimer->timer_expire - timer_now;
+  uint32_t expire = ptimer->timer_expire;
+  ETSTimer **slot;
+  uint8_t level;
+
+  if ((int32_t)delta < 0)
+  {
+    /* already due, run with the next processed tick */
+    expire = timer_now;
+    delta = 0;
+  }
+  else if (delta > TIMER_WHEEL_MAX)
+  {
+    expire = timer_now + TIMER_WHEEL_MAX;
+    delta = TIMER_WHEEL_MAX;
+  }
+
+  for (level = 0; delta >= (1UL << ((level + 1) * TIMER_WHEEL_BITS)); level++)
+    ;
+  slot = &timer_wheel[level][TIMER_INDEX(expire, level)];
+
+  ptimer->timer_next = *slot;
+  if (*slot)
+  {
+    (*slot)->timer_pprev = &ptimer->timer_next;
+  }
+  *slot = ptimer;
+  ptimer->timer_pprev = slot;
+  ptimer->timer_armed = 1;
+}
+
+/* Called inside a critical section */
+static void timer_unlink(ETSTimer *ptimer)
+{
+  *ptimer->timer_pprev = ptimer->timer_next;
+  if (ptimer->timer_next)
+  {
+    ptimer->timer_next->timer_pprev = ptimer->timer_pprev;
+  }
+  ptimer->timer_next = 0;
+  ptimer->timer_pprev = 0;
+  ptimer->timer_armed = 0;
+}
+
+/* Move the timers of a slot into the lower levels, return the index of the
+ slot */
+static uint8_t timer_cascade(uint8_t level)
+{
+  uint8_t index = TIMER_INDEX(timer_now, level);
+  ETSTimer *ptimer;
+
+  while ((ptimer = timer_wheel[level][index]) != 0)
+  {
+    timer_unlink(ptimer);
+    timer_link(ptimer);
+  }
+  return index;
+}
+
+/* Run in the timer service task, processes all ticks up to the current one */
+static void timer_process(void *param1, uint32_t param2)
+{
+  TickType_t tick = xTaskGetTickCount();
+  ETSTimer *expired;
+  ETSTimer *ptimer;
+  uint8_t index;
+  uint8_t level;
+
+  taskENTER_CRITICAL();
+  timer_pending = false;
+  while (armed_timer_count && ((int32_t)(tick - timer_now) >= 0))
+  {
+    index = timer_now & TIMER_WHEEL_MASK;
+    for (level = 1; !index && (level < TIMER_WHEEL_LEVELS); level++)
+    {
+      /* the next level only wraps when this one does */
+      if (timer_cascade(level))
       {
         break;
       }
     }
+    timer_now++;
+
+    /* move the slot to a local list first, a timer armed from a callback
+     may land in this same slot one wheel turn later */
+    expired = timer_wheel[0][index];
+    timer_wheel[0][index] = 0;
+    if (expired)
+    {
+      expired->timer_pprev = &expired;
+    }
+
+    while ((ptimer = expired) != 0)
+    {
+      timer_unlink(ptimer);
+      if (ptimer->timer_repeat)
+      {
+        ptimer->timer_expire += ptimer->timer_period;
+        timer_link(ptimer);
+      }
+      else
+      {
+        armed_timer_count--;
+      }
+
+      /* the callback may arm, disarm or set up any timer, this one too */
+      taskEXIT_CRITICAL();
+      ptimer->timer_func(ptimer->timer_arg);
+      taskENTER_CRITICAL();
+    }
   }
-  ptimer->timer_func = pfunction;
-  ptimer->timer_arg = parg;
-  ptimer->timer_handle = 0;
-  ptimer->timer_ms = 0;
-  new_entry = (struct timer_list_st *)pvPortMalloc(8);
-  new_entry->timer = ptimer;
-  new_entry->next = 0;
-  tailptr = &entry->next;
-  if (!timer_list)
-  {
-    tailptr = &timer_list;
-  }
-  *tailptr = new_entry;
+  taskEXIT_CRITICAL();
 }
 
-static void timer_tramp(TimerHandle_t xTimer)
+void vApplicationTickHook(void)
 {
-  ETSTimer *ptimer = pvTimerGetTimerID(xTimer);
-  ptimer->timer_func(ptimer->timer_arg);
+  TickType_t tick = xTaskGetTickCountFromISR();
+
+  if (!armed_timer_count || timer_pending)
+  {
+    timer_checked = tick;
+    return;
+  }
+
+  /* one tick at a time, several after the scheduler was suspended, and
+   at most a wheel turn since a cascade always triggers processing */
+  while (timer_checked != tick)
+  {
+    timer_checked++;
+    if (timer_wheel[0][timer_checked & TIMER_WHEEL_MASK]
+        || !(timer_checked & TIMER_WHEEL_MASK))
+    {
+      /* a pended call wakes the timer task, xTaskIncrementTick() requests
+       the context switch */
+      timer_pending = xTimerPendFunctionCallFromISR(timer_process, 0, 0, 0);
+      if (timer_pending)
+      {
+        timer_checked = tick;
+      }
+      else
+      {
+        /* timer queue full, try again on the next tick */
+        timer_checked--;
+      }
+      break;
+    }
+  }
 }
 
-void sdk_os_timer_arm(ETSTimer *ptimer, uint32_t milliseconds, bool repeat_flag)
+void sdk_os_timer_setfn(ETSTimer *ptimer, ETSTimerFunc *pfunction, void *parg)
 {
-  if (!ptimer->timer_handle)
+  taskENTER_CRITICAL();
+  if (timer_in_wheel(ptimer))
   {
-    ptimer->timer_repeat = repeat_flag;
-    ptimer->timer_ms = milliseconds;
-    ptimer->timer_handle = xTimerCreate(0, milliseconds / 10, repeat_flag,
-                                        ptimer, timer_tramp);
-    armed_timer_count++;
-    if (!ptimer->timer_handle)
+    if (ptimer->timer_arg == parg && ptimer->timer_func == pfunction)
     {
-      //FIXME: should print an error? (original code doesn't)
+      taskEXIT_CRITICAL();
       return;
     }
+    timer_unlink(ptimer);
+    armed_timer_count--;
   }
-  if (ptimer->timer_repeat != repeat_flag)
+  taskEXIT_CRITICAL();
+
+  ptimer->timer_func = pfunction;
+  ptimer->timer_arg = parg;
+  ptimer->timer_next = 0;
+  ptimer->timer_pprev = 0;
+  ptimer->timer_period = 0;
+  ptimer->timer_armed = 0;
+}
+
+void sdk_os_timer_arm(ETSTimer *ptimer, uint32_t milliseconds, bool repeat_flag)
+{
+  uint32_t ticks = milliseconds / portTICK_PERIOD_MS;
+
+  if (!ticks)
   {
-    ptimer->timer_repeat = repeat_flag;
-    // FIXME: This is wrong.  The original code is directly modifying
-    // internal FreeRTOS structures to try to change the uxAutoReload of an
-    // existing timer.  The correct way to do this is probably to use
-    // xTimerDelete and then xTimerCreate to recreate the timer with a
-    // different uxAutoReload setting.
-    ((uint32_t *)ptimer->timer_handle)[7] = repeat_flag;
+    ticks = 1;
   }
-  if (ptimer->timer_ms != milliseconds)
+
+  taskENTER_CRITICAL();
+  if (ptimer->timer_armed)
   {
-    ptimer->timer_ms = milliseconds;
-    xTimerChangePeriod(ptimer->timer_handle, milliseconds / 10, 10);
+    timer_unlink(ptimer);
   }
-  if (!xTimerStart(ptimer->timer_handle, 50))
+  else
   {
-    printf("Timer Start Failed\n");
+    if (!armed_timer_count)
+    {
+      /* nothing in the wheel, bring it to the present */
+      timer_now = xTaskGetTickCount();
+    }
+    armed_timer_count++;
   }
+  ptimer->timer_repeat = repeat_flag;
+  ptimer->timer_period = ticks;
+  ptimer->timer_expire = xTaskGetTickCount() + ticks;
+  timer_link(ptimer);
+  taskEXIT_CRITICAL();
 }
 
 void sdk_os_timer_disarm(ETSTimer *ptimer)
 {
-  if (ptimer->timer_handle)
+  taskENTER_CRITICAL();
+  if (ptimer->timer_armed)
   {
-    if (!xTimerStop(ptimer->timer_handle, 50))
-    {
-      printf("Timer Stop Failed\n");
-    }
+    timer_unlink(ptimer);
+    armed_timer_count--;
   }
+  taskEXIT_CRITICAL();
 }
 
 #endif /* OPEN_LIBMAIN_TIMERS */
@@ -0,0 +1,93 @@
+/* Heap instrumentation
+ *
+ * malloc(), calloc(), realloc() and free() are wrapped at link time
+ * (-Wl,--wrap in the Makefile, pvPortMalloc/vPortFree in program.ld point at
+ * the wrappers) so that every allocation made by the application, FreeRTOS
+ * and the SDK libraries carries an 8 byte header with its size and the task
+ * that made it. This gives live bytes, peak and allocation count per task,
+ * while the fragmentation figures come from walking the free list of newlib
+ * nano-malloc on request.
+ *
+ * Blocks allocated inside newlib itself (stdio buffers, reent) go through
+ * _malloc_r() directly, they have no header and are not accounted.
+ */
+#ifndef _HEAP_STATS_H
+#define _HEAP_STATS_H
+
+#include <stdint.h>
+#include "freertos.h"
+
+/* Number of task slots. Slot 0 collects allocations made before the
+ scheduler starts and from interrupts, the last slot collects the tasks that
+ do not fit in the table. A slot stays assigned when its task is deleted so
+ that the blocks it leaked remain visible. */
+#ifndef HEAP_STATS_TASKS
+#define HEAP_STATS_TASKS        12
+#endif
+
+/* Recent allocations and frees kept with their caller PC, 0 disables the
+ ring */
+#ifndef HEAP_STATS_TRACE_LEN
+#define HEAP_STATS_TRACE_LEN    16
+#endif
+
+/* Free chunks visited by heap_get_stats(), bounds the time spent in the
+ critical section on a badly fragmented (or corrupted) heap */
+#ifndef HEAP_STATS_WALK_MAX
+#define HEAP_STATS_WALK_MAX     256
+#endif
+
+/* Free chunk histogram, bucket i counts the chunks smaller than
+ HEAP_STATS_HIST_LIMIT(i), the last bucket counts the rest */
+#define HEAP_STATS_HIST_BUCKETS 8
+#define HEAP_STATS_HIST_MIN     32
+#define HEAP_STATS_HIST_LIMIT(i)  (HEAP_STATS_HIST_MIN << (i))
+/* Smallest chunk of the last bucket */
+#define HEAP_STATS_HIST_LAST    HEAP_STATS_HIST_LIMIT(HEAP_STATS_HIST_BUCKETS - 2)
+
+typedef struct
+{
+  char name[configMAX_TASK_NAME_LEN];
+  uint32_t live;
+  /* high-water mark of live */
+  uint32_t peak;
+  /* allocations made since boot */
+  uint32_t count;
+} heap_task_stats_t;
+
+typedef struct
+{
+  /* same as xPortGetFreeHeapSize() */
+  uint32_t free;
+  /* largest free chunk, counting the top of the heap */
+  uint32_t largest;
+  /* space between brk and the supervisor stack, not yet claimed by the heap */
+  uint32_t top;
+  /* free chunks inside the heap, by size */
+  uint16_t hist[HEAP_STATS_HIST_BUCKETS];
+  /* bytes and blocks in use, as requested by the callers */
+  uint32_t live;
+  uint32_t blocks;
+  /* failed allocations */
+  uint32_t fails;
+  /* frees of blocks without a header, from newlib internals */
+  uint32_t foreign;
+  /* cost of the instrumentation: calls made and CPU cycles spent in the
+   accounting, and header bytes of the live blocks */
+  uint32_t calls;
+  uint32_t cycles;
+  uint32_t overhead;
+} heap_stats_t;
+
+void heap_get_stats(heap_stats_t *stats);
+
+/* Fill 'stats' with up to 'max' task slots in use, return the number
+ filled */
+uint8_t heap_get_task_stats(heap_task_stats_t *stats, uint8_t max);
+
+/* Print the fragmentation figures, the task table and the recent
+ allocations ring to stdout. The caller PCs are printed as addresses that
+ util/filteroutput.py resolves to source lines. */
+void heap_dump_stats(void);
+
+#endif /* _HEAP_STATS_H */
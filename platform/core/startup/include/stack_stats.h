@@ -0,0 +1,77 @@
+/* Task stack profiling
+ *
+ * The stack of every task is sampled periodically with
+ * uxTaskGetStackHighWaterMark() and the deepest use seen per task name is
+ * kept in RTC memory, so that it survives resets (watchdog, exceptions,
+ * software restarts) and builds up over many boots. A stack overflow caught
+ * by the kernel is recorded there as well before anything else happens.
+ *
+ * stack_stats_report() prints one line per task with the configured depth,
+ * the peak and a recommended depth. Saved from the console into a file, the
+ * report is what util/stackcheck.py compares against the stack depths
+ * given to xTaskCreate() in the sources (make STACK_PROFILE=<file>).
+ */
+#ifndef _STACK_STATS_H
+#define _STACK_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos.h"
+#include "freertos_task.h"
+
+/* Task names tracked, the record of a task that does not fit is lost */
+#ifndef STACK_STATS_TASKS
+#define STACK_STATS_TASKS       16
+#endif
+
+/* Sampling period of the timer */
+#ifndef STACK_STATS_PERIOD_MS
+#define STACK_STATS_PERIOD_MS   5000
+#endif
+
+/* Recommended depth: the peak plus this margin in percent, rounded up to
+ STACK_STATS_ROUND words */
+#ifndef STACK_STATS_MARGIN
+#define STACK_STATS_MARGIN      25
+#endif
+#define STACK_STATS_ROUND       32
+
+/* Word address in the RTC memory, after the rboot data (64..66) */
+#define STACK_STATS_RTC_ADDR    72
+
+/* Characters of the task name kept in RTC memory */
+#define STACK_STATS_NAME_LEN    12
+
+typedef struct
+{
+  char name[STACK_STATS_NAME_LEN + 1];
+  /* in words, as given to xTaskCreate() */
+  uint16_t depth;
+  /* deepest use in words since the record was cleared */
+  uint16_t peak;
+  uint16_t recommended;
+  bool overflowed;
+} stack_task_stats_t;
+
+/* Load the record kept in RTC memory and start sampling. The record is
+ reset on a cold boot, detected with a magic value and a checksum. */
+void stack_stats_init(void);
+
+/* Sample every task now */
+void stack_stats_sample(void);
+
+/* Fill 'stats' with up to 'max' tasks of the record, return the number
+ filled. Boots counts the resets the record went through. */
+uint8_t stack_stats_get(stack_task_stats_t *stats, uint8_t max,
+                        uint16_t *boots);
+
+/* Forget the peaks */
+void stack_stats_clear(void);
+
+/* Print the record to stdout, in the format read by util/stackcheck.py */
+void stack_stats_report(void);
+
+/* Called from vApplicationStackOverflowHook() */
+void stack_stats_overflow(TaskHandle_t task, const char *name);
+
+#endif /* _STACK_STATS_H */
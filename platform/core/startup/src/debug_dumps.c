@@ -15,6 +15,7 @@
 #include <unistd.h>
 
 #include "debug_dumps.h"
+#include "heap_stats.h"
 #include "common_macros.h"
 #include "xtensa_ops.h"
 #include "rom.h"
@@ -250,6 +251,9 @@ void dump_heapinfo(void)
   printf(
       "arena (total_size) %d fordblks (free_size) %d uordblocks (used_size) %d\n",
       mi.arena, mi.fordblks, mi.uordblks);
+
+  /* fragmentation, live bytes per task and the last allocations */
+  heap_dump_stats();
 }
 
 /* Main part of abort handler, can be run from flash to save some
@@ -0,0 +1,400 @@
+/* Heap instrumentation, see heap_stats.h.
+ *
+ * The wrappers run in IRAM like the newlib allocator they wrap, and the
+ * accounting only touches this file's tables inside a critical section, so
+ * its cost is a few hundred cycles per call whatever the heap state. The cost
+ * is measured with the cycle counter and reported with the statistics.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <freertos.h>
+#include <freertos_task.h>
+
+#include "heap_stats.h"
+#include "common_macros.h"
+#include "xtensa_ops.h"
+
+#define HEAP_MAGIC    0x4853
+
+/* Keeps the user data 8 byte aligned like nano-malloc does */
+struct heap_header
+{
+  uint32_t size;
+  uint16_t magic;
+  uint8_t task;
+  uint8_t reserved;
+};
+
+/* Free chunk of newlib nano-malloc, the list is sorted by address */
+struct heap_chunk
+{
+  long size;
+  struct heap_chunk *next;
+};
+
+struct heap_task
+{
+  TaskHandle_t handle;
+  heap_task_stats_t stats;
+};
+
+struct heap_trace
+{
+  void *ptr;
+  void *caller;
+  /* negative for a free */
+  int32_t size;
+  uint8_t task;
+};
+
+void *__real_malloc(size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+extern struct heap_chunk *__malloc_free_list;
+extern void * volatile pxCurrentTCB;
+extern uint32_t xPortSupervisorStackPointer;
+extern bool esp_in_isr;
+
+static struct heap_task heap_tasks[HEAP_STATS_TASKS] =
+{
+  [0] = { .stats = { .name = "boot/isr" } },
+  [HEAP_STATS_TASKS - 1] = { .stats = { .name = "other" } }
+};
+static heap_stats_t heap_stats;
+#if HEAP_STATS_TRACE_LEN
+static struct heap_trace heap_trace[HEAP_STATS_TRACE_LEN];
+static uint8_t heap_trace_next;
+#endif
+
+/* Slot of the running task, called inside the critical section */
+static uint8_t IRAM heap_task_slot(void)
+{
+  TaskHandle_t task = pxCurrentTCB;
+  uint8_t i;
+
+  if (esp_in_isr || (xPortSupervisorStackPointer == 0))
+  {
+    return 0;
+  }
+
+  for (i = 1; i < HEAP_STATS_TASKS - 1; i++)
+  {
+    if (heap_tasks[i].handle == task)
+    {
+      return i;
+    }
+    if (heap_tasks[i].handle == NULL)
+    {
+      /* the only call out of IRAM, once per task */
+      heap_tasks[i].handle = task;
+      strncpy(heap_tasks[i].stats.name, pcTaskGetName(task),
+              configMAX_TASK_NAME_LEN - 1);
+      return i;
+    }
+  }
+  return HEAP_STATS_TASKS - 1;
+}
+
+static void IRAM heap_record(void *ptr, int32_t size, uint8_t task,
+                             void *caller)
+{
+#if HEAP_STATS_TRACE_LEN
+  struct heap_trace *trace = &heap_trace[heap_trace_next];
+
+  trace->ptr = ptr;
+  trace->caller = caller;
+  trace->size = size;
+  trace->task = task;
+  if (++heap_trace_next == HEAP_STATS_TRACE_LEN)
+  {
+    heap_trace_next = 0;
+  }
+#endif
+}
+
+/* Account a new block, called inside the critical section */
+static void IRAM heap_account(struct heap_header *hdr, size_t size,
+                              void *caller)
+{
+  heap_task_stats_t *stats;
+
+  hdr->size = size;
+  hdr->magic = HEAP_MAGIC;
+  hdr->task = heap_task_slot();
+
+  stats = &heap_tasks[hdr->task].stats;
+  stats->live += size;
+  stats->count++;
+  if (stats->live > stats->peak)
+  {
+    stats->peak = stats->live;
+  }
+  heap_stats.live += size;
+  heap_stats.blocks++;
+  heap_record(hdr + 1, size, hdr->task, caller);
+}
+
+/* Release the accounting of a block, called inside the critical section */
+static void IRAM heap_unaccount(struct heap_header *hdr, void *caller)
+{
+  heap_tasks[hdr->task].stats.live -= hdr->size;
+  heap_stats.live -= hdr->size;
+  heap_stats.blocks--;
+  heap_record(hdr + 1, -(int32_t)hdr->size, hdr->task, caller);
+}
+
+static void IRAM heap_measure(uint32_t start)
+{
+  uint32_t end;
+
+  RSR(end, ccount);
+  heap_stats.calls++;
+  heap_stats.cycles += end - start;
+}
+
+static void * IRAM heap_malloc(size_t size, void *caller)
+{
+  struct heap_header *hdr = NULL;
+  uint32_t start;
+
+  if (size <= SIZE_MAX - sizeof(*hdr))
+  {
+    hdr = __real_malloc(size + sizeof(*hdr));
+  }
+
+  taskENTER_CRITICAL();
+  RSR(start, ccount);
+  if (hdr != NULL)
+  {
+    heap_account(hdr, size, caller);
+  }
+  else
+  {
+    heap_stats.fails++;
+  }
+  heap_measure(start);
+  taskEXIT_CRITICAL();
+
+  return (hdr != NULL) ? hdr + 1 : NULL;
+}
+
+static void IRAM heap_free(void *ptr, void *caller)
+{
+  struct heap_header *hdr = (struct heap_header *)ptr - 1;
+  uint32_t start;
+
+  if (ptr == NULL)
+  {
+    return;
+  }
+
+  taskENTER_CRITICAL();
+  RSR(start, ccount);
+  if (hdr->magic != HEAP_MAGIC)
+  {
+    heap_stats.foreign++;
+    hdr = NULL;
+  }
+  else
+  {
+    heap_unaccount(hdr, caller);
+    /* catches a second free of the same block */
+    hdr->magic = 0;
+  }
+  heap_measure(start);
+  taskEXIT_CRITICAL();
+
+  __real_free((hdr != NULL) ? (void *)hdr : ptr);
+}
+
+void * IRAM __wrap_malloc(size_t size)
+{
+  return heap_malloc(size, __builtin_return_address(0));
+}
+
+void * IRAM __wrap_calloc(size_t count, size_t size)
+{
+  void *ptr = NULL;
+
+  if ((size == 0) || (count <= SIZE_MAX / size))
+  {
+    ptr = heap_malloc(count * size, __builtin_return_address(0));
+  }
+  if (ptr != NULL)
+  {
+    memset(ptr, 0, count * size);
+  }
+  return ptr;
+}
+
+void * IRAM __wrap_realloc(void *ptr, size_t size)
+{
+  void *caller = __builtin_return_address(0);
+  struct heap_header *hdr = (struct heap_header *)ptr - 1;
+  uint32_t start;
+
+  if (ptr == NULL)
+  {
+    return heap_malloc(size, caller);
+  }
+  if (size == 0)
+  {
+    heap_free(ptr, caller);
+    return NULL;
+  }
+  if (hdr->magic != HEAP_MAGIC)
+  {
+    return __real_realloc(ptr, size);
+  }
+
+  if (size <= SIZE_MAX - sizeof(*hdr))
+  {
+    /* the header is moved along with the data, the old block stays
+     accounted until the new one exists */
+    hdr = __real_realloc(hdr, size + sizeof(*hdr));
+  }
+  else
+  {
+    hdr = NULL;
+  }
+
+  taskENTER_CRITICAL();
+  RSR(start, ccount);
+  if (hdr != NULL)
+  {
+    heap_unaccount(hdr, caller);
+    heap_account(hdr, size, caller);
+  }
+  else
+  {
+    heap_stats.fails++;
+  }
+  heap_measure(start);
+  taskEXIT_CRITICAL();
+
+  return (hdr != NULL) ? hdr + 1 : NULL;
+}
+
+void IRAM __wrap_free(void *ptr)
+{
+  heap_free(ptr, __builtin_return_address(0));
+}
+
+void heap_get_stats(heap_stats_t *stats)
+{
+  extern char _heap_start;
+  struct mallinfo mi = mallinfo();
+  struct heap_chunk *chunk;
+  uint32_t brk_val;
+  uint32_t sp = xPortSupervisorStackPointer;
+  uint32_t size;
+  uint16_t walked = 0;
+  uint8_t i;
+
+  if (sp == 0)
+  {
+    SP(sp);
+  }
+
+  taskENTER_CRITICAL();
+  *stats = heap_stats;
+  brk_val = (uint32_t)sbrk(0);
+  stats->top = sp - brk_val;
+  stats->largest = stats->top;
+  memset(stats->hist, 0, sizeof(stats->hist));
+  for (chunk = __malloc_free_list;
+       (chunk != NULL) && (walked < HEAP_STATS_WALK_MAX); chunk = chunk->next)
+  {
+    /* stop at anything that does not look like a chunk of the heap */
+    if (((char *)chunk < &_heap_start) || ((uint32_t)chunk >= brk_val)
+        || (chunk->size <= 0))
+    {
+      break;
+    }
+    size = chunk->size;
+    for (i = 0; (i < HEAP_STATS_HIST_BUCKETS - 1)
+         && (size >= HEAP_STATS_HIST_LIMIT(i)); i++)
+      ;
+    stats->hist[i]++;
+    if (size > stats->largest)
+    {
+      stats->largest = size;
+    }
+    walked++;
+  }
+  taskEXIT_CRITICAL();
+
+  stats->free = stats->top + mi.fordblks;
+  stats->overhead = stats->blocks * sizeof(struct heap_header);
+}
+
+uint8_t heap_get_task_stats(heap_task_stats_t *stats, uint8_t max)
+{
+  uint8_t i;
+  uint8_t n = 0;
+
+  taskENTER_CRITICAL();
+  for (i = 0; (i < HEAP_STATS_TASKS) && (n < max); i++)
+  {
+    if ((i == 0) || (heap_tasks[i].stats.count != 0))
+    {
+      stats[n++] = heap_tasks[i].stats;
+    }
+  }
+  taskEXIT_CRITICAL();
+  return n;
+}
+
+void heap_dump_stats(void)
+{
+  heap_stats_t stats;
+  heap_task_stats_t tasks[HEAP_STATS_TASKS];
+  uint8_t n;
+  uint8_t i;
+
+  heap_get_stats(&stats);
+  printf("largest free %u, top %u, %u bytes in %u blocks (+%u header), "
+         "%u fails, %u foreign\n", stats.largest, stats.top, stats.live,
+         stats.blocks, stats.overhead, stats.fails, stats.foreign);
+  printf("free chunks:");
+  for (i = 0; i < HEAP_STATS_HIST_BUCKETS - 1; i++)
+  {
+    printf(" <%u:%u", HEAP_STATS_HIST_LIMIT(i), stats.hist[i]);
+  }
+  printf(" >=%u:%u\n", HEAP_STATS_HIST_LAST, stats.hist[i]);
+  if (stats.calls != 0)
+  {
+    printf("accounting %u calls, %u cycles avg\n", stats.calls,
+           stats.cycles / stats.calls);
+  }
+
+  n = heap_get_task_stats(tasks, HEAP_STATS_TASKS);
+  for (i = 0; i < n; i++)
+  {
+    printf("%-16s live %6u peak %6u allocs %u\n", tasks[i].name,
+           tasks[i].live, tasks[i].peak, tasks[i].count);
+  }
+
+#if HEAP_STATS_TRACE_LEN
+  /* oldest first */
+  for (i = heap_trace_next, n = 0; n < HEAP_STATS_TRACE_LEN; n++)
+  {
+    struct heap_trace *trace = &heap_trace[i];
+
+    if (trace->caller != NULL)
+    {
+      printf("%s %5d at %p by 0x%08x (%s)\n",
+             (trace->size < 0) ? "free " : "alloc",
+             (trace->size < 0) ? -trace->size : trace->size, trace->ptr,
+             (uint32_t)trace->caller, heap_tasks[trace->task].stats.name);
+    }
+    if (++i == HEAP_STATS_TRACE_LEN)
+    {
+      i = 0;
+    }
+  }
+#endif
+}
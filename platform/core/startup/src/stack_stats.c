@@ -0,0 +1,264 @@
+/* Task stack profiling, see stack_stats.h.
+ *
+ * The record lives in a DRAM copy that is written through to RTC memory
+ * (268 bytes) only when a peak grows, which stops happening after the first
+ * minutes of a run.
+ */
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos.h>
+#include <freertos_task.h>
+#include <freertos_timers.h>
+
+#include "stack_stats.h"
+#include "common_macros.h"
+#include "sdk/esp_system.h"
+
+#define STACK_STATS_MAGIC   0x53544B31
+
+/* Record kept in RTC memory, a multiple of 4 bytes */
+struct stack_entry
+{
+  char name[STACK_STATS_NAME_LEN];
+  uint16_t depth;
+  /* peak, STACK_STATS_OVERFLOW set once the task overflowed */
+  uint16_t peak;
+};
+
+#define STACK_STATS_OVERFLOW  0x8000
+
+struct stack_record
+{
+  uint32_t magic;
+  uint16_t count;
+  uint16_t boots;
+  struct stack_entry tasks[STACK_STATS_TASKS];
+  uint32_t checksum;
+};
+
+static struct stack_record stack_record;
+static TimerHandle_t stack_timer;
+static StaticTimer_t stack_timer_buf;
+
+static uint32_t stack_checksum(const struct stack_record *record)
+{
+  const uint32_t *word = (const uint32_t *)record;
+  uint32_t sum = 0;
+  uint8_t i;
+
+  for (i = 0; i < offsetof(struct stack_record, checksum) / 4; i++)
+  {
+    sum = (sum << 1 | sum >> 31) ^ word[i];
+  }
+  return sum;
+}
+
+static void stack_save(void)
+{
+  stack_record.checksum = stack_checksum(&stack_record);
+  sdk_system_rtc_mem_write(STACK_STATS_RTC_ADDR, &stack_record,
+                           sizeof(stack_record));
+}
+
+static struct stack_entry *stack_find(const char *name)
+{
+  struct stack_entry *entry;
+  uint8_t i;
+
+  for (i = 0; i < stack_record.count; i++)
+  {
+    entry = &stack_record.tasks[i];
+    if (!strncmp(entry->name, name, STACK_STATS_NAME_LEN))
+    {
+      return entry;
+    }
+  }
+  if (stack_record.count == STACK_STATS_TASKS)
+  {
+    return NULL;
+  }
+
+  entry = &stack_record.tasks[stack_record.count++];
+  strncpy(entry->name, name, STACK_STATS_NAME_LEN);
+  entry->depth = 0;
+  entry->peak = 0;
+  return entry;
+}
+
+/* Update the entry of a task, return true when the record changed */
+static bool stack_update(const char *name, uint16_t depth, uint16_t used,
+                         bool overflowed)
+{
+  struct stack_entry *entry = stack_find(name);
+  uint16_t peak;
+
+  if (entry == NULL)
+  {
+    return false;
+  }
+
+  peak = (entry->peak & ~STACK_STATS_OVERFLOW);
+  if ((entry->depth == depth) && (used <= peak) && !overflowed)
+  {
+    return false;
+  }
+
+  /* a new depth, ie a new firmware, starts from the samples of this run */
+  if (entry->depth != depth)
+  {
+    entry->depth = depth;
+    entry->peak = 0;
+  }
+  if (used > peak)
+  {
+    entry->peak = (entry->peak & STACK_STATS_OVERFLOW) | used;
+  }
+  if (overflowed)
+  {
+    entry->peak |= STACK_STATS_OVERFLOW;
+  }
+  return true;
+}
+
+static void stack_timer_cb(TimerHandle_t timer)
+{
+  stack_stats_sample();
+}
+
+static uint16_t stack_recommend(uint16_t peak)
+{
+  uint32_t depth = (uint32_t)peak * (100 + STACK_STATS_MARGIN) / 100;
+
+  return (depth + STACK_STATS_ROUND - 1) / STACK_STATS_ROUND
+      * STACK_STATS_ROUND;
+}
+
+void stack_stats_init(void)
+{
+  if (stack_timer != NULL)
+  {
+    return;
+  }
+
+  if (!sdk_system_rtc_mem_read(STACK_STATS_RTC_ADDR, &stack_record,
+                               sizeof(stack_record))
+      || (stack_record.magic != STACK_STATS_MAGIC)
+      || (stack_record.count > STACK_STATS_TASKS)
+      || (stack_record.checksum != stack_checksum(&stack_record)))
+  {
+    memset(&stack_record, 0, sizeof(stack_record));
+    stack_record.magic = STACK_STATS_MAGIC;
+  }
+  else
+  {
+    stack_record.boots++;
+  }
+  stack_save();
+
+  stack_timer = xTimerCreateStatic("stack_stats",
+                                   STACK_STATS_PERIOD_MS / portTICK_PERIOD_MS,
+                                   pdTRUE, NULL, stack_timer_cb,
+                                   &stack_timer_buf);
+  if (stack_timer != NULL)
+  {
+    xTimerStart(stack_timer, 0);
+  }
+}
+
+void stack_stats_sample(void)
+{
+  UBaseType_t max = uxTaskGetNumberOfTasks();
+  TaskStatus_t *tasks = malloc(max * sizeof(TaskStatus_t));
+  UBaseType_t count;
+  UBaseType_t i;
+  uint16_t depth;
+  bool changed = false;
+
+  if (tasks == NULL)
+  {
+    return;
+  }
+
+  count = uxTaskGetSystemState(tasks, max, NULL);
+  taskENTER_CRITICAL();
+  for (i = 0; i < count; i++)
+  {
+    depth = uxTaskGetStackDepth(tasks[i].xHandle);
+    changed |= stack_update(tasks[i].pcTaskName, depth,
+                            depth - tasks[i].usStackHighWaterMark, false);
+  }
+  if (changed)
+  {
+    stack_save();
+  }
+  taskEXIT_CRITICAL();
+  free(tasks);
+}
+
+uint8_t stack_stats_get(stack_task_stats_t *stats, uint8_t max,
+                        uint16_t *boots)
+{
+  struct stack_entry *entry;
+  uint8_t i;
+
+  taskENTER_CRITICAL();
+  for (i = 0; (i < stack_record.count) && (i < max); i++)
+  {
+    entry = &stack_record.tasks[i];
+    memcpy(stats[i].name, entry->name, STACK_STATS_NAME_LEN);
+    stats[i].name[STACK_STATS_NAME_LEN] = '\0';
+    stats[i].depth = entry->depth;
+    stats[i].peak = entry->peak & ~STACK_STATS_OVERFLOW;
+    stats[i].overflowed = !!(entry->peak & STACK_STATS_OVERFLOW);
+    /* the real need of an overflowed task is unknown, double its depth */
+    stats[i].recommended = stack_recommend(stats[i].overflowed
+        ? entry->depth * 2 : stats[i].peak);
+  }
+  if (boots != NULL)
+  {
+    *boots = stack_record.boots;
+  }
+  taskEXIT_CRITICAL();
+
+  return i;
+}
+
+void stack_stats_clear(void)
+{
+  taskENTER_CRITICAL();
+  stack_record.count = 0;
+  memset(stack_record.tasks, 0, sizeof(stack_record.tasks));
+  stack_save();
+  taskEXIT_CRITICAL();
+}
+
+void stack_stats_report(void)
+{
+  static stack_task_stats_t stats[STACK_STATS_TASKS];
+  uint16_t boots;
+  uint8_t count = stack_stats_get(stats, STACK_STATS_TASKS, &boots);
+  uint8_t i;
+
+  printf("# stack profile over %u resets, margin %u%%\n", boots,
+         STACK_STATS_MARGIN);
+  for (i = 0; i < count; i++)
+  {
+    printf("stack %-12s %5u %5u %5u%s\n", stats[i].name, stats[i].depth,
+           stats[i].peak, stats[i].recommended,
+           stats[i].overflowed ? " overflow" : "");
+  }
+}
+
+/* Runs in the context switch, only the record and RTC memory are touched */
+void stack_stats_overflow(TaskHandle_t task, const char *name)
+{
+  uint16_t depth = uxTaskGetStackDepth(task);
+
+  if (stack_record.magic == STACK_STATS_MAGIC)
+  {
+    stack_update(name, depth, depth, true);
+    stack_save();
+  }
+}
@@ -29,11 +29,16 @@ typedef void ETSTimerFunc(void *);
 typedef struct ETSTimer_st
 {
     struct ETSTimer_st *timer_next;
-    TimerHandle_t timer_handle;
-    uint32_t _unknown;
-    uint32_t timer_ms;
+    /* The SDK keeps a FreeRTOS timer handle here, the open libmain links the
+       timer into its timer wheel instead (see timers.c) */
+    struct ETSTimer_st **timer_pprev;
+    uint32_t timer_expire;
+    uint32_t timer_period;
     ETSTimerFunc *timer_func;
     bool timer_repeat;
+    /* Set while linked into the timer wheel, in the padding before
+       timer_arg so that the layout the SDK libraries use does not change */
+    uint8_t timer_armed;
     void *timer_arg;
 } ETSTimer;
 
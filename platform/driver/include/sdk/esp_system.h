@@ -6,6 +6,9 @@
 #ifndef __ESP_SYSTEM_H__
 #define __ESP_SYSTEM_H__
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #ifdef	__cplusplus
 extern "C"
 {
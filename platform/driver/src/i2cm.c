@@ -26,6 +26,7 @@ static bool                     i2cm_initialized = false;
 static uint8_t                  i2cm_delay_half_cycle;
 static uint8_t                  i2cm_delay_quarter_cycle;
 static SemaphoreHandle_t        i2cm_semaphore;
+static StaticSemaphore_t        i2cm_semaphore_buf;
 
 /* Public function definition section ======================================= */
 void I2CM_Init(void)
@@ -54,7 +55,7 @@ void I2CM_Init(void)
     HAL_GPIO_SetHigh(gpio_sda.pin);
 
     /* Create semaphore to protect Tx/Rx in multiple tasks */
-    i2cm_semaphore = xSemaphoreCreateMutex();
+    i2cm_semaphore = xSemaphoreCreateMutexStatic(&i2cm_semaphore_buf);
 
     /* Set initialization status */
     i2cm_initialized = true;
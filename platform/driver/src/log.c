@@ -10,6 +10,7 @@
 
 /* Private macro definition section ========================================= */
 #define LOG_QUEUE_SIZE              50
+#define LOG_TASK_STACK_SIZE         256
 
 /* Private type definition section ========================================== */
 typedef struct
@@ -35,6 +36,10 @@ static void log_get_time(log_time_t *time, uint32_t ms);
 /* Private variable section ================================================= */
 #if LOG_VERBOSE
 static QueueHandle_t         log_queue;
+static StaticQueue_t         log_queue_buf;
+static uint8_t               log_queue_storage[LOG_QUEUE_SIZE * sizeof(log_msg_t)];
+static StaticTask_t          log_task_buf;
+static StackType_t           log_task_stack[LOG_TASK_STACK_SIZE];
 #endif
 
 /* Public function definition section ======================================= */
@@ -45,9 +50,11 @@ void Log_Init(void)
 
 #if LOG_VERBOSE
   /* Initialize log queue */
-  log_queue = xQueueCreate(LOG_QUEUE_SIZE, sizeof(log_msg_t));
+  log_queue = xQueueCreateStatic(LOG_QUEUE_SIZE, sizeof(log_msg_t),
+                                 log_queue_storage, &log_queue_buf);
   /* Create log task */
-  xTaskCreate(task_log, "task_log", 256, NULL, 5, NULL);
+  xTaskCreateStatic(task_log, "task_log", LOG_TASK_STACK_SIZE, NULL, 5,
+                    log_task_stack, &log_task_buf);
 #endif
 }
 
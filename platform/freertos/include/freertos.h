@@ -199,6 +199,10 @@ extern "C"
 #define INCLUDE_uxTaskGetStackHighWaterMark 0
 #endif
 
+#ifndef configRECORD_STACK_HIGH_ADDRESS
+#define configRECORD_STACK_HIGH_ADDRESS 0
+#endif
+
 #ifndef INCLUDE_eTaskGetState
 #define INCLUDE_eTaskGetState 0
 #endif
@@ -31,7 +31,7 @@
 #define configUSE_IDLE_HOOK			0
 #endif
 #ifndef configUSE_TICK_HOOK
-#define configUSE_TICK_HOOK			0
+#define configUSE_TICK_HOOK			1
 #endif
 #ifndef configCPU_CLOCK_HZ
 /* This is the _default_ clock speed for the CPU. Can be either 80MHz
@@ -58,8 +58,17 @@
 #ifndef configMAX_TASK_NAME_LEN
 #define configMAX_TASK_NAME_LEN		( 16 )
 #endif
+/* Trace recorder and run-time statistics, see freertos_trace.h. Off by
+ default, debugging builds turn it on with "make TRACE=1" */
+#ifndef configUSE_TRACE_RECORDER
+#define configUSE_TRACE_RECORDER	0
+#endif
+/* uxTaskGetSystemState() of stack_stats.c and lwip_metrics.c */
 #ifndef configUSE_TRACE_FACILITY
-#define configUSE_TRACE_FACILITY	0
+#define configUSE_TRACE_FACILITY	1
+#endif
+#ifndef configGENERATE_RUN_TIME_STATS
+#define configGENERATE_RUN_TIME_STATS	configUSE_TRACE_RECORDER
 #endif
 #ifndef configUSE_STATS_FORMATTING_FUNCTIONS
 #define configUSE_STATS_FORMATTING_FUNCTIONS 0
@@ -81,6 +90,15 @@
 #ifndef configCHECK_FOR_STACK_OVERFLOW
 #define configCHECK_FOR_STACK_OVERFLOW  2
 #endif
+/* Objects created once at boot take static storage rather than the heap,
+ see vApplicationGetIdleTaskMemory() in freertos_port.c */
+#ifndef configSUPPORT_STATIC_ALLOCATION
+#define configSUPPORT_STATIC_ALLOCATION 1
+#endif
+/* Keeps the stack depth of each task for the stack profiler (stack_stats.h) */
+#ifndef configRECORD_STACK_HIGH_ADDRESS
+#define configRECORD_STACK_HIGH_ADDRESS 1
+#endif
 #ifndef configUSE_MUTEXES
 #define configUSE_MUTEXES  1
 #endif
@@ -140,9 +158,18 @@
 #define INCLUDE_uxTaskGetStackHighWaterMark 1
 #endif
 
+/* The ETSTimer wheel (sdklib timers.c) hands its work to the timer task */
+#ifndef INCLUDE_xTimerPendFunctionCall
+#define INCLUDE_xTimerPendFunctionCall 1
+#endif
+
 #ifndef configENABLE_BACKWARD_COMPATIBILITY
 #define configENABLE_BACKWARD_COMPATIBILITY 0
 #endif
 
+#if configUSE_TRACE_RECORDER
+#include "freertos_trace.h"
+#endif
+
 #endif /* __DEFAULT_FREERTOS_CONFIG_H */
 
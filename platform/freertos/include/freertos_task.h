@@ -1392,6 +1392,21 @@ extern "C"
   UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask)
   PRIVILEGED_FUNCTION;
 
+  /**
+   * task.h
+   * <PRE>UBaseType_t uxTaskGetStackDepth( TaskHandle_t xTask );</PRE>
+   *
+   * INCLUDE_uxTaskGetStackHighWaterMark and configRECORD_STACK_HIGH_ADDRESS
+   * must be set to 1 in FreeRTOSConfig.h for this function to be available.
+   *
+   * Returns the stack depth xTask was created with, in words like
+   * uxTaskGetStackHighWaterMark().
+   *
+   * @param xTask Handle of the task.  Set xTask to NULL for the calling task.
+   */
+  UBaseType_t uxTaskGetStackDepth(TaskHandle_t xTask)
+  PRIVILEGED_FUNCTION;
+
   /* When using trace macros it is sometimes necessary to include task.h before
    FreeRTOS.h.  When this is done TaskHookFunction_t will not yet have been defined,
    so the following two prototypes will cause a compilation error.  This can be
@@ -0,0 +1,124 @@
+/* FreeRTOS trace recorder and run-time statistics
+ *
+ * The trace macros of tasks.c and queue.c, and the interrupt dispatcher in
+ * hal_interrupts.c, record 8 byte events stamped with the CPU cycle counter
+ * into a RAM ring. The ring is dumped as text through a write callback (UART
+ * or a TCP connection), util/trace2chrome.py turns a dump into Chrome
+ * trace_event JSON for chrome://tracing.
+ *
+ * The run-time statistics of FreeRTOS are counted on FRC2, the per-task CPU
+ * usage is computed from the difference between two samples so that the
+ * counter wrapping does not matter.
+ *
+ * Included from freertos_config.h, the macros below replace the empty
+ * defaults of freertos.h.
+ */
+#ifndef __FREERTOS_TRACE_H
+#define __FREERTOS_TRACE_H
+
+/* Events kept, the oldest are overwritten */
+#ifndef TRACE_RING_LEN
+#define TRACE_RING_LEN          256
+#endif
+
+/* Tasks with a context switch count, by task number */
+#ifndef TRACE_MAX_TASKS
+#define TRACE_MAX_TASKS         24
+#endif
+
+/* Task numbers of the events recorded for the running task and for
+ interrupts, FreeRTOS numbers tasks from 1 */
+#define TRACE_TASK_CURRENT      0x00
+#define TRACE_TASK_ISR          0xFF
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef enum
+{
+  TRACE_SWITCHED_IN = 1,
+  TRACE_SWITCHED_OUT,
+  TRACE_QUEUE_SEND,
+  TRACE_QUEUE_RECEIVE,
+  TRACE_QUEUE_BLOCK_SEND,
+  TRACE_QUEUE_BLOCK_RECEIVE,
+  TRACE_QUEUE_SEND_ISR,
+  TRACE_QUEUE_RECEIVE_ISR,
+  TRACE_ISR_ENTER,
+  TRACE_ISR_EXIT,
+  TRACE_TASK_DELAY
+} trace_event_type_t;
+
+typedef struct
+{
+  /* CPU cycles */
+  uint32_t ts;
+  uint8_t event;
+  uint8_t task;
+  /* queue as (address - DRAM start) / 4, interrupt number for ISR events */
+  uint16_t obj;
+} trace_event_t;
+
+typedef struct
+{
+  char name[16];
+  uint8_t number;
+  /* tenths of a percent since the previous call */
+  uint16_t cpu;
+  uint32_t switches;
+} trace_cpu_t;
+
+typedef void (*trace_write_fn)(const char *data, size_t len, void *ctx);
+
+void trace_record(uint8_t event, uint8_t task, uint16_t obj);
+void trace_switched_in(uint8_t task);
+void trace_isr_enter(uint8_t inum);
+void trace_isr_exit(uint8_t inum);
+uint32_t trace_runtime_counter(void);
+
+/* Recording is on at boot, it is suspended while the ring is dumped */
+void trace_enable(bool enable);
+
+/* Write the task names and the ring, oldest event first */
+void trace_dump(trace_write_fn write, void *ctx);
+void trace_dump_uart(void);
+
+/* CPU usage of up to 'max' tasks since the previous call, returns the number
+ of tasks filled */
+uint8_t trace_get_cpu(trace_cpu_t *cpu, uint8_t max);
+void trace_print_cpu(void);
+
+#define TRACE_QUEUE_OBJ(q)      ((uint16_t)(((uint32_t)(q) - 0x3FFE8000) >> 2))
+
+/* Only expanded in tasks.c, where pxCurrentTCB is visible */
+#define traceTASK_SWITCHED_IN() \
+    trace_switched_in(pxCurrentTCB->uxTCBNumber)
+#define traceTASK_SWITCHED_OUT() \
+    trace_record(TRACE_SWITCHED_OUT, pxCurrentTCB->uxTCBNumber, 0)
+#define traceTASK_DELAY() \
+    trace_record(TRACE_TASK_DELAY, pxCurrentTCB->uxTCBNumber, 0)
+#define traceTASK_DELAY_UNTIL(x) \
+    trace_record(TRACE_TASK_DELAY, pxCurrentTCB->uxTCBNumber, 0)
+
+#define traceQUEUE_SEND(q) \
+    trace_record(TRACE_QUEUE_SEND, TRACE_TASK_CURRENT, TRACE_QUEUE_OBJ(q))
+#define traceQUEUE_RECEIVE(q) \
+    trace_record(TRACE_QUEUE_RECEIVE, TRACE_TASK_CURRENT, TRACE_QUEUE_OBJ(q))
+#define traceBLOCKING_ON_QUEUE_SEND(q) \
+    trace_record(TRACE_QUEUE_BLOCK_SEND, TRACE_TASK_CURRENT, TRACE_QUEUE_OBJ(q))
+#define traceBLOCKING_ON_QUEUE_RECEIVE(q) \
+    trace_record(TRACE_QUEUE_BLOCK_RECEIVE, TRACE_TASK_CURRENT, TRACE_QUEUE_OBJ(q))
+#define traceQUEUE_SEND_FROM_ISR(q) \
+    trace_record(TRACE_QUEUE_SEND_ISR, TRACE_TASK_ISR, TRACE_QUEUE_OBJ(q))
+#define traceQUEUE_RECEIVE_FROM_ISR(q) \
+    trace_record(TRACE_QUEUE_RECEIVE_ISR, TRACE_TASK_ISR, TRACE_QUEUE_OBJ(q))
+
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE() trace_runtime_counter()
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* __FREERTOS_TRACE_H */
@@ -79,6 +79,7 @@
 #include "freertos_task.h"
 #include "freertos_xtensa.h"
 #include "hal_wdev_regs.h"
+#include "stack_stats.h"
 
 unsigned cpu_sr;
 char level1_int_disabled;
@@ -278,9 +279,40 @@ signed portBASE_TYPE xTaskGenericCreate(TaskFunction_t pxTaskCode,
                      pvParameters, uxPriority, pxCreatedTask);
 }
 
+#if configSUPPORT_STATIC_ALLOCATION
+/* The idle and timer service tasks live as long as the scheduler, their
+ stacks and TCBs are never freed */
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                   StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize)
+{
+  static StaticTask_t idle_tcb;
+  static StackType_t idle_stack[configMINIMAL_STACK_SIZE];
+
+  *ppxIdleTaskTCBBuffer = &idle_tcb;
+  *ppxIdleTaskStackBuffer = idle_stack;
+  *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+#if configUSE_TIMERS
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer,
+                                    StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize)
+{
+  static StaticTask_t timer_tcb;
+  static StackType_t timer_stack[configTIMER_TASK_STACK_DEPTH];
+
+  *ppxTimerTaskTCBBuffer = &timer_tcb;
+  *ppxTimerTaskStackBuffer = timer_stack;
+  *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+#endif
+#endif /* configSUPPORT_STATIC_ALLOCATION */
+
 // .text+0x3a8
 void IRAM vApplicationStackOverflowHook(TaskHandle_t task, char *task_name)
 {
+  stack_stats_overflow(task, task_name);
   printf("Task stack overflow (high water mark=%lu name=\"%s\")\n",
          uxTaskGetStackHighWaterMark(task), task_name);
 }
@@ -294,7 +326,7 @@ void __attribute__((weak)) IRAM vApplicationIdleHook(void)
 // .text+0x404
 void __attribute__((weak)) IRAM vApplicationTickHook(void)
 {
-  printf("tick %u\n", WDEV.SYS_TIME);
+  /* replaced by the ETSTimer wheel in sdklib timers.c */
 }
 
 
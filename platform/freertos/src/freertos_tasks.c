@@ -304,8 +304,8 @@ typedef struct tskTaskControlBlock
   StackType_t *pxStack; /*< Points to the start of the stack. */
   char pcTaskName[configMAX_TASK_NAME_LEN];/*< Descriptive name given to the task when created.  Facilitates debugging only. *//*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 
-#if ( portSTACK_GROWTH > 0 )
-  StackType_t *pxEndOfStack; /*< Points to the end of the stack on architectures where the stack grows up from low memory. */
+#if ( ( portSTACK_GROWTH > 0 ) || ( configRECORD_STACK_HIGH_ADDRESS == 1 ) )
+  StackType_t *pxEndOfStack; /*< Points to the highest valid address for the stack. */
 #endif
 
 #if ( portCRITICAL_NESTING_IN_TCB == 1 )
@@ -816,6 +816,14 @@ uxPriority &= ~portPRIVILEGE_BIT;
 
   /* Check the alignment of the calculated top of stack is correct. */
   configASSERT( ( ( ( portPOINTER_SIZE_TYPE ) pxTopOfStack & ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK ) == 0UL ) );
+
+#if( configRECORD_STACK_HIGH_ADDRESS == 1 )
+  {
+    /* Also record the stack's high address, before the alignment, so that
+     the depth the task was created with can be given back. */
+    pxNewTCB->pxEndOfStack = pxNewTCB->pxStack + (ulStackDepth - (uint32_t)1);
+  }
+#endif /* configRECORD_STACK_HIGH_ADDRESS */
 }
 #else /* portSTACK_GROWTH */
 {
@@ -3605,6 +3613,20 @@ return uxReturn;
 #endif /* INCLUDE_uxTaskGetStackHighWaterMark */
 /*-----------------------------------------------------------*/
 
+#if ( ( INCLUDE_uxTaskGetStackHighWaterMark == 1 ) && ( configRECORD_STACK_HIGH_ADDRESS == 1 ) )
+
+UBaseType_t uxTaskGetStackDepth(TaskHandle_t xTask)
+{
+TCB_t *pxTCB;
+
+pxTCB = prvGetTCBFromHandle(xTask);
+
+return (UBaseType_t)(pxTCB->pxEndOfStack - pxTCB->pxStack) + 1;
+}
+
+#endif /* INCLUDE_uxTaskGetStackHighWaterMark && configRECORD_STACK_HIGH_ADDRESS */
+/*-----------------------------------------------------------*/
+
 #if ( INCLUDE_vTaskDelete == 1 )
 
 static void prvDeleteTCB(TCB_t *pxTCB)
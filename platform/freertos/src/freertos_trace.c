@@ -0,0 +1,214 @@
+/* FreeRTOS trace recorder and run-time statistics, see freertos_trace.h.
+ *
+ * trace_record() is called from the scheduler and from interrupts, it only
+ * masks interrupts for the few stores of an event and lives in IRAM with its
+ * callers. Everything that walks the task list runs in task context.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos.h>
+#include <freertos_task.h>
+#include <sdk/esp_system.h>
+
+#include "common_macros.h"
+#include "xtensa_ops.h"
+#include "hal_interrupts.h"
+#include "hal_timer.h"
+
+#if configUSE_TRACE_RECORDER
+
+static trace_event_t trace_ring[TRACE_RING_LEN];
+/* Next event written, and events written since boot */
+static uint16_t trace_head;
+static uint32_t trace_count;
+static volatile bool trace_enabled = true;
+/* Task switched in last, events of TRACE_TASK_CURRENT are charged to it */
+static uint8_t trace_current;
+
+/* Indexed by task number, tasks above TRACE_MAX_TASKS share the last entry */
+static uint32_t trace_switches[TRACE_MAX_TASKS];
+static uint32_t trace_prev_switches[TRACE_MAX_TASKS];
+static uint32_t trace_prev_runtime[TRACE_MAX_TASKS];
+
+static inline uint8_t trace_slot(UBaseType_t number)
+{
+  return (number < TRACE_MAX_TASKS) ? number : TRACE_MAX_TASKS - 1;
+}
+
+void IRAM trace_record(uint8_t event, uint8_t task, uint16_t obj)
+{
+  trace_event_t *entry;
+  uint32_t ps;
+  uint32_t ts;
+
+  if (!trace_enabled)
+  {
+    return;
+  }
+
+  ps = _xt_disable_interrupts();
+  RSR(ts, ccount);
+  entry = &trace_ring[trace_head];
+  entry->ts = ts;
+  entry->event = event;
+  entry->task = (task == TRACE_TASK_CURRENT) ? trace_current : task;
+  entry->obj = obj;
+  if (++trace_head == TRACE_RING_LEN)
+  {
+    trace_head = 0;
+  }
+  trace_count++;
+  _xt_restore_interrupts(ps);
+}
+
+/* Called by vTaskSwitchContext() with the new pxCurrentTCB */
+void IRAM trace_switched_in(uint8_t task)
+{
+  trace_current = task;
+  trace_switches[trace_slot(task)]++;
+  trace_record(TRACE_SWITCHED_IN, task, 0);
+}
+
+void IRAM trace_isr_enter(uint8_t inum)
+{
+  trace_record(TRACE_ISR_ENTER, TRACE_TASK_ISR, inum);
+}
+
+void IRAM trace_isr_exit(uint8_t inum)
+{
+  trace_record(TRACE_ISR_EXIT, TRACE_TASK_ISR, inum);
+}
+
+/* FRC2 runs free from boot at the divider set by the SDK, 3.2 us per count
+ by default. The FreeRTOS total wraps with it after 3.8 hours, which is why
+ trace_get_cpu() only works on differences. */
+uint32_t IRAM trace_runtime_counter(void)
+{
+  return TIMER(FRC2).COUNT;
+}
+
+void trace_enable(bool enable)
+{
+  trace_enabled = enable;
+}
+
+/* Task table of the scheduler, freed by the caller */
+static TaskStatus_t *trace_get_tasks(UBaseType_t *count)
+{
+  UBaseType_t max = uxTaskGetNumberOfTasks();
+  TaskStatus_t *tasks = malloc(max * sizeof(TaskStatus_t));
+
+  *count = tasks ? uxTaskGetSystemState(tasks, max, NULL) : 0;
+  return tasks;
+}
+
+void trace_dump(trace_write_fn write, void *ctx)
+{
+  TaskStatus_t *tasks;
+  UBaseType_t count;
+  UBaseType_t i;
+  uint16_t index;
+  uint16_t len;
+  char line[48];
+  int n;
+
+  trace_enable(false);
+
+  /* the ring is only complete once it wrapped */
+  len = (trace_count < TRACE_RING_LEN) ? trace_count : TRACE_RING_LEN;
+  index = (trace_head + TRACE_RING_LEN - len) % TRACE_RING_LEN;
+
+  n = snprintf(line, sizeof(line), "# trace %d %u\n",
+               sdk_system_get_cpu_freq() * 1000000, len);
+  write(line, n, ctx);
+
+  tasks = trace_get_tasks(&count);
+  for (i = 0; i < count; i++)
+  {
+    n = snprintf(line, sizeof(line), "# task %u %s\n",
+                 (unsigned)tasks[i].xTaskNumber, tasks[i].pcTaskName);
+    write(line, n, ctx);
+  }
+  free(tasks);
+
+  while (len--)
+  {
+    trace_event_t *entry = &trace_ring[index];
+
+    n = snprintf(line, sizeof(line), "%u %u %u %u\n", entry->ts,
+                 entry->event, entry->task, entry->obj);
+    write(line, n, ctx);
+    index = (index + 1) % TRACE_RING_LEN;
+  }
+  write("# end\n", 6, ctx);
+
+  trace_enable(true);
+}
+
+static void trace_write_uart(const char *data, size_t len, void *ctx)
+{
+  fwrite(data, 1, len, stdout);
+}
+
+void trace_dump_uart(void)
+{
+  trace_dump(trace_write_uart, NULL);
+  fflush(stdout);
+}
+
+uint8_t trace_get_cpu(trace_cpu_t *cpu, uint8_t max)
+{
+  TaskStatus_t *tasks;
+  UBaseType_t count;
+  UBaseType_t i;
+  uint32_t delta;
+  uint32_t total = 0;
+  uint8_t slot;
+  uint8_t filled = 0;
+
+  tasks = trace_get_tasks(&count);
+  for (i = 0; i < count; i++)
+  {
+    slot = trace_slot(tasks[i].xTaskNumber);
+    total += tasks[i].ulRunTimeCounter - trace_prev_runtime[slot];
+  }
+
+  for (i = 0; i < count; i++)
+  {
+    slot = trace_slot(tasks[i].xTaskNumber);
+    delta = tasks[i].ulRunTimeCounter - trace_prev_runtime[slot];
+    trace_prev_runtime[slot] = tasks[i].ulRunTimeCounter;
+    if (filled >= max)
+    {
+      continue;
+    }
+
+    strncpy(cpu[filled].name, tasks[i].pcTaskName, sizeof(cpu[filled].name) - 1);
+    cpu[filled].name[sizeof(cpu[filled].name) - 1] = '\0';
+    cpu[filled].number = tasks[i].xTaskNumber;
+    cpu[filled].cpu = total ? (uint64_t)delta * 1000 / total : 0;
+    cpu[filled].switches = trace_switches[slot] - trace_prev_switches[slot];
+    trace_prev_switches[slot] = trace_switches[slot];
+    filled++;
+  }
+  free(tasks);
+
+  return filled;
+}
+
+void trace_print_cpu(void)
+{
+  static trace_cpu_t cpu[TRACE_MAX_TASKS];
+  uint8_t count = trace_get_cpu(cpu, TRACE_MAX_TASKS);
+  uint8_t i;
+
+  printf("%-16s %3s %6s %8s\n", "task", "num", "cpu%", "switches");
+  for (i = 0; i < count; i++)
+  {
+    printf("%-16s %3u %4u.%u %8u\n", cpu[i].name, cpu[i].number,
+           cpu[i].cpu / 10, cpu[i].cpu % 10, cpu[i].switches);
+  }
+}
+
+#endif /* configUSE_TRACE_RECORDER */
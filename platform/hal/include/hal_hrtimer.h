@@ -0,0 +1,89 @@
+#ifndef __HAL_HRTIMER_H__
+#define __HAL_HRTIMER_H__
+
+/* Inclusion section ======================================================== */
+#include "stdbool.h"
+#include "stdint.h"
+
+/* Public macro definition section ========================================== */
+/* High resolution timers beside the 10 ms FreeRTOS tick.
+ *
+ * Time is read from the free-running FRC2 counter, whose divider is set by
+ * sdk_ets_timer_init() (312.5 kHz by default, 3.2 us per count). FRC2's alarm
+ * belongs to the SDK timers, so the expiries are raised by FRC1 in one-shot
+ * mode instead, reprogrammed for the earliest armed timer each time.
+ */
+
+/* Waits shorter than this are spun on the counter by HAL_HRTIMER_SleepUs()
+ rather than paying for two context switches */
+#define HAL_HRTIMER_SPIN_US             50
+
+/* Deferred callbacks waiting to run, and the task running them */
+#define HAL_HRTIMER_WORK_QUEUE_LEN      8
+#define HAL_HRTIMER_TASK_PRIORITY       (configMAX_PRIORITIES - 1)
+#define HAL_HRTIMER_TASK_STACK_SIZE     256
+
+/* Public type definition section =========================================== */
+typedef enum
+{
+  HAL_HRTIMER_ONE_SHOT      = 0x00,
+  HAL_HRTIMER_PERIODIC      = 0x01
+} HAL_HRTIMER_ModeType;
+
+typedef enum
+{
+  /* callback runs in the hrtimer task */
+  HAL_HRTIMER_DEFERRED      = 0x00,
+  /* callback runs in the FRC1 interrupt, it must be short and in IRAM */
+  HAL_HRTIMER_ISR           = 0x01
+} HAL_HRTIMER_ContextType;
+
+typedef struct HAL_HRTIMER_Timer
+{
+  struct HAL_HRTIMER_Timer  *next;
+  /* FRC2 counts */
+  uint32_t                  deadline;
+  uint32_t                  period;
+  void                      (*callback)(void *arg);
+  void                      *arg;
+  HAL_HRTIMER_ContextType   context;
+  volatile bool             armed;
+  /* waiting in the work queue */
+  volatile bool             queued;
+} HAL_HRTIMER_TimerType;
+
+typedef struct
+{
+  /* expiries, and expiries later than HAL_HRTIMER_SPIN_US */
+  uint32_t                  fired;
+  uint32_t                  late;
+  /* worst expiry latency seen in the interrupt, in us */
+  uint32_t                  max_latency_us;
+  /* periods skipped because the previous callback had not run yet or the
+   work queue was full */
+  uint32_t                  overruns;
+} HAL_HRTIMER_StatsType;
+
+/* Public function prototype section ======================================== */
+/* Must be called after sdk_ets_timer_init(), ie from user_init() */
+void HAL_HRTIMER_Init(void);
+uint32_t HAL_HRTIMER_GetCount(void);
+uint32_t HAL_HRTIMER_CountToUs(uint32_t count);
+uint32_t HAL_HRTIMER_UsToCount(uint32_t us);
+void HAL_HRTIMER_Setup(HAL_HRTIMER_TimerType *timer,
+                       void (*callback)(void *arg), void *arg,
+                       HAL_HRTIMER_ContextType context);
+/* (Re)arm a timer 'us' microseconds from now, a periodic timer keeps its
+ phase whatever the callback latency */
+void HAL_HRTIMER_Start(HAL_HRTIMER_TimerType *timer, uint32_t us,
+                       HAL_HRTIMER_ModeType mode);
+/* A callback already waiting in the work queue is dropped as well, the
+ structure must however stay valid until the hrtimer task has seen it */
+void HAL_HRTIMER_Stop(HAL_HRTIMER_TimerType *timer);
+/* Block the calling task for 'us' microseconds. Uses the task notification
+ of the calling task, a notification received meanwhile is consumed. */
+void HAL_HRTIMER_SleepUs(uint32_t us);
+void HAL_HRTIMER_GetStats(HAL_HRTIMER_StatsType *stats);
+
+#endif
+/* ============================= End of file ================================ */
@@ -0,0 +1,282 @@
+/* Inclusion section ======================================================== */
+#include "hal_hrtimer.h"
+#include "hal_timer.h"
+#include "hal_interrupts.h"
+#include "common_macros.h"
+#include "freertos.h"
+#include "freertos_queue.h"
+#include "freertos_task.h"
+
+/* Private macro definition section ========================================= */
+/* FRC1 counts at 5 MHz for the alarms, up to 1.67 s per shot */
+#define HRTIMER_ALARM_DIV               16
+#define HRTIMER_ALARM_CLKDIV            TIMER_CLKDIV_16
+/* Both timers count the 80 MHz APB clock */
+#define HRTIMER_APB_MHZ                 80
+
+/* Private type definition section ========================================== */
+
+/* Private function prototype section ======================================= */
+static void IRAM hrtimer_insert(HAL_HRTIMER_TimerType *timer);
+static void IRAM hrtimer_remove(HAL_HRTIMER_TimerType *timer);
+static void IRAM hrtimer_program(void);
+static void IRAM hrtimer_isr(void);
+static void IRAM hrtimer_wake(void *arg);
+static void hrtimer_task(void *param);
+
+/* Private variable section ================================================= */
+static HAL_HRTIMER_TimerType    *hrtimer_list;
+static QueueHandle_t            hrtimer_queue;
+static StaticQueue_t            hrtimer_queue_buf;
+static uint8_t                  hrtimer_queue_storage[HAL_HRTIMER_WORK_QUEUE_LEN
+                                    * sizeof(HAL_HRTIMER_TimerType *)];
+static StaticTask_t             hrtimer_task_buf;
+static StackType_t              hrtimer_task_stack[HAL_HRTIMER_TASK_STACK_SIZE];
+/* FRC2 divider, set up by the SDK */
+static uint16_t                 hrtimer_div;
+static HAL_HRTIMER_StatsType    hrtimer_stats;
+
+/* Public function definition section ======================================= */
+void HAL_HRTIMER_Init(void)
+{
+  static const uint16_t divs[] = { 1, 16, 256 };
+
+  if (hrtimer_queue != NULL)
+    return;
+
+  hrtimer_div = divs[FIELD2VAL(TIMER_CTRL_CLKDIV, TIMER(FRC2).CTRL)];
+  hrtimer_queue = xQueueCreateStatic(HAL_HRTIMER_WORK_QUEUE_LEN,
+                                     sizeof(HAL_HRTIMER_TimerType *),
+                                     hrtimer_queue_storage, &hrtimer_queue_buf);
+  xTaskCreateStatic(hrtimer_task, "hrtimer", HAL_HRTIMER_TASK_STACK_SIZE, NULL,
+                    HAL_HRTIMER_TASK_PRIORITY, hrtimer_task_stack,
+                    &hrtimer_task_buf);
+
+  timer_set_interrupts(FRC1, false);
+  timer_set_run(FRC1, false);
+  timer_set_divider(FRC1, HRTIMER_ALARM_CLKDIV);
+  timer_set_reload(FRC1, false);
+  _xt_isr_attach(INUM_TIMER_FRC1, hrtimer_isr);
+  timer_set_interrupts(FRC1, true);
+}
+
+uint32_t IRAM HAL_HRTIMER_GetCount(void)
+{
+  return TIMER(FRC2).COUNT;
+}
+
+uint32_t HAL_HRTIMER_CountToUs(uint32_t count)
+{
+  return (uint64_t)count * hrtimer_div / HRTIMER_APB_MHZ;
+}
+
+uint32_t HAL_HRTIMER_UsToCount(uint32_t us)
+{
+  /* round up, a timer never fires early */
+  return ((uint64_t)us * HRTIMER_APB_MHZ + hrtimer_div - 1) / hrtimer_div;
+}
+
+void HAL_HRTIMER_Setup(HAL_HRTIMER_TimerType *timer,
+                       void (*callback)(void *arg), void *arg,
+                       HAL_HRTIMER_ContextType context)
+{
+  timer->next = NULL;
+  timer->callback = callback;
+  timer->arg = arg;
+  timer->context = context;
+  timer->armed = false;
+  timer->queued = false;
+}
+
+void HAL_HRTIMER_Start(HAL_HRTIMER_TimerType *timer, uint32_t us,
+                       HAL_HRTIMER_ModeType mode)
+{
+  uint32_t count = HAL_HRTIMER_UsToCount(us);
+
+  taskENTER_CRITICAL();
+  if (timer->armed)
+    hrtimer_remove(timer);
+  timer->period = (mode == HAL_HRTIMER_PERIODIC) ? count : 0;
+  timer->deadline = TIMER(FRC2).COUNT + count;
+  hrtimer_insert(timer);
+  if (hrtimer_list == timer)
+    hrtimer_program();
+  taskEXIT_CRITICAL();
+}
+
+void HAL_HRTIMER_Stop(HAL_HRTIMER_TimerType *timer)
+{
+  taskENTER_CRITICAL();
+  if (timer->armed)
+    hrtimer_remove(timer);
+  timer->queued = false;
+  taskEXIT_CRITICAL();
+}
+
+void HAL_HRTIMER_SleepUs(uint32_t us)
+{
+  HAL_HRTIMER_TimerType timer;
+  uint32_t start = TIMER(FRC2).COUNT;
+
+  if (us < HAL_HRTIMER_SPIN_US)
+  {
+    uint32_t count = HAL_HRTIMER_UsToCount(us);
+
+    while (TIMER(FRC2).COUNT - start < count)
+      ;
+    return;
+  }
+
+  HAL_HRTIMER_Setup(&timer, hrtimer_wake, xTaskGetCurrentTaskHandle(),
+                    HAL_HRTIMER_ISR);
+  HAL_HRTIMER_Start(&timer, us, HAL_HRTIMER_ONE_SHOT);
+  /* the wake up is the only notification given after the timer expired */
+  do
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  } while (timer.armed);
+}
+
+void HAL_HRTIMER_GetStats(HAL_HRTIMER_StatsType *stats)
+{
+  taskENTER_CRITICAL();
+  *stats = hrtimer_stats;
+  taskEXIT_CRITICAL();
+}
+
+/* Private function definition section ====================================== */
+/* Keep the list sorted by deadline, timers with the same deadline fire in the
+ order they were armed */
+static void IRAM hrtimer_insert(HAL_HRTIMER_TimerType *timer)
+{
+  HAL_HRTIMER_TimerType **prev = &hrtimer_list;
+
+  while ((*prev != NULL)
+      && ((int32_t)(timer->deadline - (*prev)->deadline) >= 0))
+    prev = &(*prev)->next;
+
+  timer->next = *prev;
+  *prev = timer;
+  timer->armed = true;
+}
+
+static void IRAM hrtimer_remove(HAL_HRTIMER_TimerType *timer)
+{
+  HAL_HRTIMER_TimerType **prev = &hrtimer_list;
+
+  while ((*prev != NULL) && (*prev != timer))
+    prev = &(*prev)->next;
+
+  if (*prev != NULL)
+    *prev = timer->next;
+  timer->next = NULL;
+  timer->armed = false;
+}
+
+/* Arm FRC1 for the earliest deadline, called with interrupts disabled */
+static void IRAM hrtimer_program(void)
+{
+  int32_t delta;
+  uint32_t load;
+
+  if (hrtimer_list == NULL)
+  {
+    timer_set_run(FRC1, false);
+    return;
+  }
+
+  delta = hrtimer_list->deadline - TIMER(FRC2).COUNT;
+  if (delta < 1)
+    delta = 1;
+  /* a deadline beyond a shot takes several, checked again in the ISR */
+  if ((uint32_t)delta > TIMER_FRC1_MAX_LOAD / hrtimer_div * HRTIMER_ALARM_DIV)
+    load = TIMER_FRC1_MAX_LOAD;
+  else
+    load = (uint32_t)delta * hrtimer_div / HRTIMER_ALARM_DIV;
+  if (load == 0)
+    load = 1;
+
+  timer_set_load(FRC1, load);
+  timer_set_run(FRC1, true);
+}
+
+static void IRAM hrtimer_isr(void)
+{
+  HAL_HRTIMER_TimerType *timer;
+  BaseType_t woken = pdFALSE;
+  uint32_t now = TIMER(FRC2).COUNT;
+  uint32_t latency;
+
+  while (((timer = hrtimer_list) != NULL)
+      && ((int32_t)(timer->deadline - now) <= 0))
+  {
+    hrtimer_list = timer->next;
+    timer->next = NULL;
+    timer->armed = false;
+
+    latency = (now - timer->deadline) * hrtimer_div / HRTIMER_APB_MHZ;
+    hrtimer_stats.fired++;
+    if (latency > HAL_HRTIMER_SPIN_US)
+      hrtimer_stats.late++;
+    if (latency > hrtimer_stats.max_latency_us)
+      hrtimer_stats.max_latency_us = latency;
+
+    if (timer->period)
+    {
+      /* stay on the original phase, skipping the periods already missed */
+      do
+      {
+        timer->deadline += timer->period;
+      } while ((int32_t)(timer->deadline - now) <= 0);
+      hrtimer_insert(timer);
+    }
+
+    if (timer->context == HAL_HRTIMER_ISR)
+    {
+      timer->callback(timer->arg);
+    }
+    else if (timer->queued
+        || (xQueueSendFromISR(hrtimer_queue, &timer, &woken) != pdTRUE))
+    {
+      hrtimer_stats.overruns++;
+    }
+    else
+    {
+      timer->queued = true;
+    }
+    now = TIMER(FRC2).COUNT;
+  }
+
+  hrtimer_program();
+  portEND_SWITCHING_ISR(woken);
+}
+
+static void IRAM hrtimer_wake(void *arg)
+{
+  BaseType_t woken = pdFALSE;
+
+  vTaskNotifyGiveFromISR((TaskHandle_t)arg, &woken);
+  portEND_SWITCHING_ISR(woken);
+}
+
+static void hrtimer_task(void *param)
+{
+  HAL_HRTIMER_TimerType *timer;
+  bool queued;
+
+  while (1)
+  {
+    if (xQueueReceive(hrtimer_queue, &timer, portMAX_DELAY) != pdTRUE)
+      continue;
+
+    taskENTER_CRITICAL();
+    queued = timer->queued;
+    timer->queued = false;
+    taskEXIT_CRITICAL();
+
+    /* cleared by HAL_HRTIMER_Stop() */
+    if (queued)
+      timer->callback(timer->arg);
+  }
+}
+/* ============================= End of file ================================ */
@@ -6,6 +6,7 @@
  * BSD Licensed as described in the file LICENSE
  */
 #include <hal_interrupts.h>
+#include <freertos.h>
 
 _xt_isr isr[16];
 
@@ -37,7 +38,13 @@ uint16_t IRAM _xt_isr_handler(uint16_t intset)
     uint8_t index = __builtin_ffs(intset) - 1;
     uint16_t mask = BIT(index);
     _xt_clear_ints(mask);
+#if configUSE_TRACE_RECORDER
+    trace_isr_enter(index);
     isr[index]();
+    trace_isr_exit(index);
+#else
+    isr[index]();
+#endif
     intset -= mask;
   }
 
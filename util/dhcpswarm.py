@@ -0,0 +1,171 @@
+#!/usr/bin/env python
+#
+# Load the DHCP server of framework/dhcpserver from a host joined to the
+# softAP: a swarm of simulated clients, each with its own MAC, runs
+# DISCOVER/OFFER then REQUEST/ACK, and the offer and ack rates, the round
+# trips and the NAKs are reported.
+#
+#   sudo dhcpswarm.py --clients 32 --rounds 5 --iface-addr 172.16.0.100
+#
+# Replies are broadcast to port 68, so binding it needs root, and the host's
+# own DHCP client must leave that port free (or run the swarm from a second
+# interface). The simulated clients only ever hold the addresses on paper,
+# the host keeps its own.
+#
+import argparse
+import os
+import random
+import socket
+import struct
+import sys
+import time
+
+SERVER_PORT = 67
+CLIENT_PORT = 68
+COOKIE = 0x63825363
+DISCOVER, OFFER, REQUEST, DECLINE, ACK, NAK, RELEASE = 1, 2, 3, 4, 5, 6, 7
+
+OPT_REQUESTED_IP = 50
+OPT_MESSAGE_TYPE = 53
+OPT_SERVER_ID = 54
+OPT_END = 255
+
+def build(kind, xid, mac, requested=None, server=None):
+    msg = struct.pack("!BBBBIHH4s4s4s4s16s64s128sI", 1, 1, 6, 0, xid, 0,
+                      0x8000, b"\0" * 4, b"\0" * 4, b"\0" * 4, b"\0" * 4,
+                      mac, b"", b"", COOKIE)
+    opts = struct.pack("BBB", OPT_MESSAGE_TYPE, 1, kind)
+    if requested:
+        opts += struct.pack("BB4s", OPT_REQUESTED_IP, 4, requested)
+    if server:
+        opts += struct.pack("BB4s", OPT_SERVER_ID, 4, server)
+    opts += struct.pack("B", OPT_END)
+    return (msg + opts).ljust(300, b"\0")
+
+def parse(data):
+    if len(data) < 240 or data[0:1] != b"\x02":
+        return None
+    xid, = struct.unpack_from("!I", data, 4)
+    yiaddr = data[16:20]
+    mac = data[28:34]
+    opts = {}
+    i = 240
+    while i < len(data):
+        kind = ord(data[i:i + 1])
+        if kind == OPT_END:
+            break
+        if kind == 0:
+            i += 1
+            continue
+        length = ord(data[i + 1:i + 2])
+        opts[kind] = data[i + 2:i + 2 + length]
+        i += 2 + length
+    kind = opts.get(OPT_MESSAGE_TYPE)
+    return (ord(kind) if kind else 0), xid, mac, yiaddr, opts
+
+def exchange(sock, requests, expect, timeout):
+    # send every message, then collect the answers matching their xid
+    pending = {}
+    for xid, data in requests:
+        pending[xid] = time.time()
+        sock.sendto(data, ("255.255.255.255", SERVER_PORT))
+    answers = {}
+    naks = 0
+    deadline = time.time() + timeout
+    while pending and time.time() < deadline:
+        sock.settimeout(max(0.01, deadline - time.time()))
+        try:
+            data, _ = sock.recvfrom(1500)
+        except socket.timeout:
+            break
+        reply = parse(data)
+        if not reply or reply[1] not in pending:
+            continue
+        kind, xid = reply[0], reply[1]
+        if kind == NAK:
+            naks += 1
+            del pending[xid]
+        elif kind == expect:
+            answers[xid] = (time.time() - pending.pop(xid), reply)
+    return answers, naks
+
+def percentile(values, p):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p))] if values else 0
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="DHCP client swarm against the softAP DHCP server")
+    parser.add_argument("--clients", type=int, default=16)
+    parser.add_argument("--rounds", type=int, default=3,
+                        help="DISCOVER/REQUEST rounds per client")
+    parser.add_argument("--timeout", type=float, default=2.0,
+                        help="seconds to wait for the answers of a round")
+    parser.add_argument("--iface-addr", default="",
+                        help="address of the host on the softAP network")
+    parser.add_argument("--release", action="store_true",
+                        help="release the leases at the end")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+    try:
+        sock.bind((args.iface_addr, CLIENT_PORT))
+    except socket.error as e:
+        sys.stderr.write("dhcpswarm: cannot bind port %d: %s\n"
+                         % (CLIENT_PORT, e))
+        return 1
+
+    # locally administered MACs
+    macs = [b"\x02" + os.urandom(5) for _ in range(args.clients)]
+    offers = acks = naks = lost = 0
+    offer_rtt = []
+    ack_rtt = []
+    leases = {}
+    busy = 0.0
+    for _ in range(args.rounds):
+        xids = dict((random.getrandbits(32), mac) for mac in macs)
+        start = time.time()
+        answers, n = exchange(sock, [(x, build(DISCOVER, x, m))
+                                     for x, m in xids.items()],
+                              OFFER, args.timeout)
+        busy += max(r[0] for r in answers.values()) if answers else 0
+        naks += n
+        offers += len(answers)
+        lost += len(xids) - len(answers) - n
+        offer_rtt += [r[0] for r in answers.values()]
+
+        requests = []
+        for xid, (_, reply) in answers.items():
+            requests.append((xid, build(REQUEST, xid, xids[xid],
+                                        reply[3], reply[4].get(OPT_SERVER_ID))))
+        answers, n = exchange(sock, requests, ACK, args.timeout)
+        naks += n
+        acks += len(answers)
+        lost += len(requests) - len(answers) - n
+        ack_rtt += [r[0] for r in answers.values()]
+        for xid, (_, reply) in answers.items():
+            leases[xids[xid]] = (reply[3], reply[4].get(OPT_SERVER_ID))
+
+    if args.release:
+        for mac, (addr, server) in leases.items():
+            sock.sendto(build(RELEASE, random.getrandbits(32), mac, None,
+                              server), ("255.255.255.255", SERVER_PORT))
+
+    print("%d clients, %d rounds" % (args.clients, args.rounds))
+    print("  offers %d, acks %d, naks %d, unanswered %d" % (offers, acks, naks,
+                                                            lost))
+    if busy > 0:
+        print("  offers per second %.1f" % (len(offer_rtt) / busy))
+    for name, rtts in (("offer", offer_rtt), ("ack", ack_rtt)):
+        if rtts:
+            print("  %s round trip: median %.1f ms, p90 %.1f ms, max %.1f ms"
+                  % (name, 1000 * percentile(rtts, 0.5),
+                     1000 * percentile(rtts, 0.9), 1000 * max(rtts)))
+    addrs = set(socket.inet_ntoa(a) for a, _ in leases.values())
+    print("  distinct addresses bound %d" % len(addrs))
+    return 0 if lost == 0 and naks == 0 else 2
+
+if __name__ == "__main__":
+    sys.exit(main())
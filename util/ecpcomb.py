@@ -0,0 +1,100 @@
+#!/usr/bin/env python
+#
+# Print the fixed-base comb table of the secp256r1 generator that
+# mbedtls_ecp_curves.c keeps in flash, for the window MBEDTLS_ECP_STATIC_COMB_W
+# of mbedtls_ecp.h.
+#
+#   ecpcomb.py --window 7 > table.txt
+#
+# The points are those ecp_precompute_comb() of mbedtls_ecp.c computes at run
+# time: with i = i_{w-1} ... i_1 in binary and d = ceil(256 / w),
+#
+#   T[i] = i_{w-1} 2^((w-1)d) G + ... + i_1 2^d G + G
+#
+# in affine coordinates, the limbs little endian as the other constants of
+# the file.
+#
+import argparse
+import sys
+
+P = 0xFFFFFFFF00000001000000000000000000000000FFFFFFFFFFFFFFFFFFFFFFFF
+A = P - 3
+GX = 0x6B17D1F2E12C4247F8BCE6E563A440F277037D812DEB33A0F4A13945D898C296
+GY = 0x4FE342E2FE1A7F9B8EE7EB4A7C0F9E162BCE33576B315ECECBB6406837BF51F5
+BITS = 256
+
+def add(p1, p2):
+    if p1 is None:
+        return p2
+    if p2 is None:
+        return p1
+    x1, y1 = p1
+    x2, y2 = p2
+    if x1 == x2:
+        if (y1 + y2) % P == 0:
+            return None
+        lam = (3 * x1 * x1 + A) * pow(2 * y1, P - 2, P) % P
+    else:
+        lam = (y2 - y1) * pow(x2 - x1, P - 2, P) % P
+    x3 = (lam * lam - x1 - x2) % P
+    return x3, (lam * (x1 - x3) - y1) % P
+
+def mul(k, p):
+    r = None
+    while k:
+        if k & 1:
+            r = add(r, p)
+        p = add(p, p)
+        k >>= 1
+    return r
+
+def comb_table(w):
+    d = (BITS + w - 1) // w
+    teeth = [mul(1 << (d * (b + 1)), (GX, GY)) for b in range(w - 1)]
+    table = []
+    for i in range(1 << (w - 1)):
+        pt = (GX, GY)
+        for b in range(w - 1):
+            if i & (1 << b):
+                pt = add(pt, teeth[b])
+        table.append(pt)
+    return table
+
+def limbs(n):
+    data = n.to_bytes(BITS // 8, "little")
+    lines = []
+    for i in range(0, len(data), 8):
+        lines.append("  BYTES_TO_T_UINT_8( %s )," %
+                     ", ".join("0x%02X" % b for b in data[i:i + 8]))
+    return lines
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Print the secp256r1 comb table of mbedtls_ecp_curves.c")
+    parser.add_argument("--window", type=int, default=7,
+                        help="MBEDTLS_ECP_STATIC_COMB_W, 2 to 7")
+    args = parser.parse_args()
+    if not 2 <= args.window <= 7:
+        sys.stderr.write("ecpcomb: the window is 2 to 7\n")
+        return 1
+
+    table = comb_table(args.window)
+    out = []
+    for i, (x, y) in enumerate(table):
+        for name, val in (("X", x), ("Y", y)):
+            out.append("static const mbedtls_mpi_uint secp256r1_T_%d_%s[] ="
+                       % (i, name))
+            out.append("{")
+            out.extend(limbs(val))
+            out.append("};")
+    out.append("static const mbedtls_ecp_point secp256r1_T[%d] =" % len(table))
+    out.append("{")
+    for i in range(len(table)):
+        out.append("  ECP_POINT_INIT_XY_Z0( secp256r1_T_%d_X, "
+                   "secp256r1_T_%d_Y )," % (i, i))
+    out.append("};")
+    sys.stdout.write("\n".join(out) + "\n")
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
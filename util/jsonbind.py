@@ -0,0 +1,231 @@
+#!/usr/bin/env python
+#
+# Generate the C struct and the jsmn_bind tables of a flat JSON object from
+# a schema, see framework/jsmn/include/jsmn_bind.h.
+#
+#   make jsonbind
+#   jsonbind.py --include app/include --src app/src app/schema/*.json
+#
+# A schema names the struct and lists its fields:
+#
+#   {
+#     "name": "app_settings",
+#     "fields": [
+#       { "name": "led", "type": "bool" },
+#       { "name": "period", "type": "uint16", "min": 5, "max": 3600,
+#         "required": true },
+#       { "name": "label", "type": "string", "size": 16 }
+#     ]
+#   }
+#
+# Types are bool, int8, int16, int32, uint8, uint16, uint32 and string, whose
+# size counts the '\0'. Integer limits default to those of the type. The
+# generated files are committed, the build picks sources up by wildcard
+# before anything could be generated.
+#
+import argparse
+import json
+import os
+import sys
+
+MAX_FIELDS = 32
+MAX_SEED = 1 << 20
+
+INT_TYPES = {
+    "int8": ("int8_t", 1, -(1 << 7), (1 << 7) - 1),
+    "int16": ("int16_t", 2, -(1 << 15), (1 << 15) - 1),
+    "int32": ("int32_t", 4, -(1 << 31), (1 << 31) - 1),
+    "uint8": ("uint8_t", 1, 0, (1 << 8) - 1),
+    "uint16": ("uint16_t", 2, 0, (1 << 16) - 1),
+    "uint32": ("uint32_t", 4, 0, (1 << 32) - 1),
+}
+
+def bind_hash(seed, key):
+    # jsmn_bind_hash()
+    h = (seed ^ 2166136261) & 0xFFFFFFFF
+    for c in bytearray(key.encode()):
+        h = ((h ^ c) * 16777619) & 0xFFFFFFFF
+    return h ^ (h >> 16)
+
+def perfect_hash(keys):
+    size = 1
+    while size < len(keys):
+        size <<= 1
+    # a table twice as large is tried once the seeds run out
+    while size <= 256:
+        for seed in range(MAX_SEED):
+            slots = set(bind_hash(seed, k) & (size - 1) for k in keys)
+            if len(slots) == len(keys):
+                return seed, size
+        size <<= 1
+    raise ValueError("no perfect hash found")
+
+def c_string(s):
+    return '"%s"' % s.replace("\\", "\\\\").replace('"', '\\"')
+
+def load(path):
+    with open(path) as f:
+        schema = json.load(f)
+    name = schema["name"]
+    fields = schema["fields"]
+    if not 0 < len(fields) <= MAX_FIELDS:
+        raise ValueError("%s: 1 to %d fields" % (path, MAX_FIELDS))
+    keys = [f["name"] for f in fields]
+    if len(set(keys)) != len(keys):
+        raise ValueError("%s: duplicate field" % path)
+    for f in fields:
+        t = f["type"]
+        if t in INT_TYPES:
+            ctype, size, lo, hi = INT_TYPES[t]
+            f["min"] = f.get("min", lo)
+            f["max"] = f.get("max", hi)
+            if not lo <= f["min"] <= f["max"] <= hi:
+                raise ValueError("%s: bad limits for %s" % (path, f["name"]))
+        elif t == "string":
+            if not 2 <= f.get("size", 0) <= 255:
+                raise ValueError("%s: %s needs a size of 2 to 255"
+                                 % (path, f["name"]))
+        elif t != "bool":
+            raise ValueError("%s: unknown type %s" % (path, t))
+    return name, fields
+
+def json_max(fields):
+    # '{', '}' and '\0', then '"key":' and ',' per field
+    n = 3 + len(fields) - 1
+    for f in fields:
+        n += len(f["name"]) + 3
+        t = f["type"]
+        if t == "bool":
+            n += 5
+        elif t == "string":
+            # every character escaped as \u00XX
+            n += 2 + 6 * (f["size"] - 1)
+        else:
+            n += max(len(str(f["min"])), len(str(f["max"])))
+    return n
+
+def generate(path, include_dir, src_dir):
+    name, fields = load(path)
+    upper = name.upper()
+    seed, table_size = perfect_hash([f["name"] for f in fields])
+    slots = [0xFF] * table_size
+    for i, f in enumerate(fields):
+        slots[bind_hash(seed, f["name"]) & (table_size - 1)] = i
+    banner = ("/* Generated by util/jsonbind.py from %s, do not edit */"
+              % os.path.relpath(path).replace(os.sep, "/"))
+
+    h = [banner, ""]
+    h.append("#ifndef _%s_BIND_H" % upper)
+    h.append("#define _%s_BIND_H" % upper)
+    h.append("")
+    h.append("#include <stdbool.h>")
+    h.append("#include <stdint.h>")
+    h.append('#include "jsmn_bind.h"')
+    h.append("")
+    h.append("typedef struct")
+    h.append("{")
+    for f in fields:
+        t = f["type"]
+        if t == "bool":
+            h.append("  bool %s;" % f["name"])
+        elif t == "string":
+            h.append("  char %s[%d];" % (f["name"], f["size"]))
+        else:
+            h.append("  %s %s;" % (INT_TYPES[t][0], f["name"]))
+    h.append("} %s_t;" % name)
+    h.append("")
+    h.append("/* Bits of the 'seen' mask of %s_decode() */" % name)
+    for i, f in enumerate(fields):
+        h.append("#define %s_%s (1UL << %d)" % (upper, f["name"].upper(), i))
+    h.append("")
+    h.append("/* Longest output of %s_encode(), '\\0' included */" % name)
+    h.append("#define %s_JSON_MAX %d" % (upper, json_max(fields)))
+    h.append("")
+    h.append("extern const jsmn_bind_schema_t %s_schema;" % name)
+    h.append("")
+    h.append("static inline int %s_decode(%s_t *obj, const char *js," % (name,
+                                                                       name))
+    h.append("    const jsmntok_t *tokens, int num_tokens, uint32_t *seen)")
+    h.append("{")
+    h.append("  return jsmn_bind_decode(&%s_schema, obj, js, tokens, "
+             "num_tokens, seen);" % name)
+    h.append("}")
+    h.append("")
+    h.append("static inline size_t %s_encode(const %s_t *obj, char *buf,"
+             % (name, name))
+    h.append("    size_t len)")
+    h.append("{")
+    h.append("  return jsmn_bind_encode(&%s_schema, obj, buf, len);" % name)
+    h.append("}")
+    h.append("")
+    h.append("#endif /* _%s_BIND_H */" % upper)
+
+    c = [banner, ""]
+    c.append("#include <stddef.h>")
+    c.append('#include "%s_bind.h"' % name)
+    c.append("")
+    c.append("static const jsmn_bind_field_t %s_fields[] =" % name)
+    c.append("{")
+    for f in fields:
+        t = f["type"]
+        if t == "bool":
+            kind, size, lo, hi = "JSMN_BIND_BOOL", 1, 0, 1
+        elif t == "string":
+            kind, size, lo, hi = "JSMN_BIND_STRING", f["size"], 0, 0
+        else:
+            kind = "JSMN_BIND_UINT" if t.startswith("u") else "JSMN_BIND_INT"
+            size, lo, hi = INT_TYPES[t][1], f["min"], f["max"]
+        c.append("  { %s, %d, %s, %d, offsetof(%s_t, %s), %dLL, %dLL },"
+                 % (c_string(f["name"]), len(f["name"]), kind, size, name,
+                    f["name"], lo, hi))
+    c.append("};")
+    c.append("")
+    c.append("static const uint8_t %s_slots[%d] =" % (name, table_size))
+    c.append("{")
+    c.append("  " + ", ".join("0x%02X" % s if s == 0xFF else str(s)
+                              for s in slots))
+    c.append("};")
+    c.append("")
+    c.append("const jsmn_bind_schema_t %s_schema =" % name)
+    c.append("{")
+    c.append("  .fields = %s_fields," % name)
+    c.append("  .slots = %s_slots," % name)
+    c.append("  .seed = %dUL," % seed)
+    c.append("  .required = 0x%08XUL," % sum(1 << i for i, f in enumerate(fields)
+                                           if f.get("required")))
+    c.append("  .num_fields = %d," % len(fields))
+    c.append("  .slot_mask = %d" % (table_size - 1))
+    c.append("};")
+
+    outputs = ((os.path.join(include_dir, name + "_bind.h"), h),
+               (os.path.join(src_dir, name + "_bind.c"), c))
+    for out, lines in outputs:
+        text = "\n".join(lines) + "\n"
+        # leave unchanged files alone so that make does not rebuild them
+        if os.path.exists(out):
+            with open(out) as f:
+                if f.read() == text:
+                    continue
+        with open(out, "w") as f:
+            f.write(text)
+        print("  GEN  %s" % out)
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Generate jsmn_bind tables from JSON schemas")
+    parser.add_argument("--include", default=".",
+                        help="directory of the generated headers")
+    parser.add_argument("--src", default=".",
+                        help="directory of the generated sources")
+    parser.add_argument("schemas", nargs="+")
+    args = parser.parse_args()
+    try:
+        for path in args.schemas:
+            generate(path, args.include, args.src)
+    except (ValueError, KeyError) as e:
+        sys.stderr.write("jsonbind: %s\n" % e)
+        return 1
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,341 @@
+#!/usr/bin/env python
+#
+# Drive the benchmark service of framework/lwip/lwip_bench.c and print a
+# report: TCP upload and download at several sizes, UDP floods at several
+# payload sizes and rates with their loss, the UDP echo round trip seen from
+# the host and the ICMP round trip seen from the node.
+#
+#   netbench.py --start 192.168.1.50
+#   netbench.py --loopback
+#
+# --start opens the service through the httpd CGI first, it can also be
+# opened by publishing "start" on the MQTT topic "bench". --loopback runs
+# the same matrix against an in-process stand-in of the node on 127.0.0.1,
+# to check the driver without hardware; the stand-in cannot send ICMP
+# without root and reports the echo round trips as the node ping.
+#
+import argparse
+import socket
+import struct
+import sys
+import threading
+import time
+
+try:
+    from urllib.request import urlopen
+except ImportError:
+    from urllib2 import urlopen
+
+# lwip_bench.h
+PORT = 18767
+CMD_QUIT, CMD_C2S, CMD_S2C = 0, 1, 2
+UDP_FLOOD, UDP_ECHO, UDP_REPORT, UDP_PING, UDP_PING_REPORT = 1, 2, 3, 4, 5
+HIST_BUCKETS = 8
+HIST_MIN_US = 1000
+PING_INTERVAL_MS = 200
+
+FLOOD_REPORT = struct.Struct("!7I")
+PING_REPORT = struct.Struct("!%dI" % (7 + HIST_BUCKETS))
+HDR = struct.Struct("!II")
+
+TCP_SIZES = (16 * 1024, 64 * 1024, 256 * 1024)
+UDP_SIZES = (64, 512, 1400)
+UDP_RATES = (100, 500, 2000)
+
+def hist_bucket(us):
+    i = 0
+    while i < HIST_BUCKETS - 1 and us >= HIST_MIN_US << i:
+        i += 1
+    return i
+
+def hist_labels():
+    labels = ["<%dms" % ((HIST_MIN_US << i) // 1000)
+              for i in range(HIST_BUCKETS - 1)]
+    return labels + [">=%dms" % ((HIST_MIN_US << (HIST_BUCKETS - 2)) // 1000)]
+
+def recv_exact(sock, n):
+    data = b""
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise IOError("connection closed")
+        data += chunk
+    return data
+
+def kbps(nbytes, seconds):
+    return nbytes * 8 / 1000.0 / seconds if seconds > 0 else 0.0
+
+#
+# Host side
+#
+
+def tcp_upload(sock, size):
+    sock.sendall(HDR.pack(CMD_C2S, size))
+    block = b"\0" * 4096
+    start = time.time()
+    left = size
+    while left:
+        n = min(left, len(block))
+        sock.sendall(block[:n])
+        left -= n
+    received, us = HDR.unpack(recv_exact(sock, HDR.size))
+    host = time.time() - start
+    return received, kbps(received, us / 1e6), kbps(size, host)
+
+def tcp_download(sock, size):
+    start = time.time()
+    sock.sendall(HDR.pack(CMD_S2C, size))
+    recv_exact(sock, size)
+    return kbps(size, time.time() - start)
+
+def udp_request(sock, addr, kind, seq, size, timeout=1.0, tries=3):
+    sock.settimeout(timeout)
+    for _ in range(tries):
+        sock.sendto(HDR.pack(kind, seq), addr)
+        try:
+            while True:
+                data, _ = sock.recvfrom(2048)
+                if len(data) >= size and HDR.unpack_from(data) == (kind, seq):
+                    return data
+        except socket.timeout:
+            pass
+    raise IOError("no answer to UDP request %d" % kind)
+
+def udp_flood(sock, addr, size, rate, seconds):
+    count = int(rate * seconds)
+    payload = b"\0" * max(0, size - HDR.size)
+    interval = 1.0 / rate
+    start = time.time()
+    for seq in range(count):
+        sock.sendto(HDR.pack(UDP_FLOOD, seq) + payload, addr)
+        delay = start + (seq + 1) * interval - time.time()
+        if delay > 0:
+            time.sleep(delay)
+    # let the last datagrams land before asking
+    time.sleep(0.2)
+    report = FLOOD_REPORT.unpack(udp_request(sock, addr, UDP_REPORT, count,
+                                             FLOOD_REPORT.size))
+    _, _, received, nbytes, lost, late, us = report
+    # datagrams after the highest one received are not seen by the node
+    lost = count - received
+    return count, received, lost, late, kbps(nbytes, us / 1e6)
+
+def udp_echo(sock, addr, count, size):
+    payload = b"\0" * max(0, size - HDR.size)
+    sock.settimeout(0.5)
+    rtts = []
+    for seq in range(count):
+        start = time.time()
+        sock.sendto(HDR.pack(UDP_ECHO, seq) + payload, addr)
+        try:
+            while True:
+                data, _ = sock.recvfrom(2048)
+                if HDR.unpack_from(data) == (UDP_ECHO, seq):
+                    rtts.append(int((time.time() - start) * 1e6))
+                    break
+        except socket.timeout:
+            pass
+    hist = [0] * HIST_BUCKETS
+    for us in rtts:
+        hist[hist_bucket(us)] += 1
+    return count, rtts, hist
+
+def node_ping(sock, addr, count):
+    udp_request(sock, addr, UDP_PING, count, HDR.size)
+    time.sleep(count * PING_INTERVAL_MS / 1000.0 + 0.5)
+    report = PING_REPORT.unpack(udp_request(sock, addr, UDP_PING_REPORT, count,
+                                            PING_REPORT.size))
+    return report[2:7], list(report[7:])
+
+#
+# Loopback stand-in of the node
+#
+
+class StandIn(object):
+    def __init__(self, host="127.0.0.1"):
+        self.tcp = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.tcp.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.tcp.bind((host, 0))
+        self.port = self.tcp.getsockname()[1]
+        self.tcp.listen(2)
+        self.udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.udp.bind((host, self.port))
+        self.flood = [0, 0, 0, 0, 0.0, 0.0]
+        self.ping = []
+        for target in (self.serve_tcp, self.serve_udp):
+            t = threading.Thread(target=target)
+            t.daemon = True
+            t.start()
+
+    def serve_tcp(self):
+        while True:
+            conn, _ = self.tcp.accept()
+            t = threading.Thread(target=self.serve_conn, args=(conn,))
+            t.daemon = True
+            t.start()
+
+    def serve_conn(self, conn):
+        try:
+            while True:
+                cmd, length = HDR.unpack(recv_exact(conn, HDR.size))
+                if cmd == CMD_C2S:
+                    start = time.time()
+                    recv_exact(conn, length)
+                    us = int((time.time() - start) * 1e6)
+                    conn.sendall(HDR.pack(length, us))
+                elif cmd == CMD_S2C:
+                    conn.sendall(b"\0" * length)
+                else:
+                    break
+        except IOError:
+            pass
+        conn.close()
+
+    def serve_udp(self):
+        f = self.flood
+        while True:
+            data, addr = self.udp.recvfrom(2048)
+            if len(data) < HDR.size:
+                continue
+            kind, seq = HDR.unpack_from(data)
+            if kind == UDP_FLOOD:
+                f[5] = time.time()
+                if f[0] == 0:
+                    f[4] = f[5]
+                f[0] += 1
+                f[1] += len(data)
+                if seq >= f[2]:
+                    f[2] = seq + 1
+                else:
+                    f[3] += 1
+            elif kind == UDP_ECHO:
+                self.udp.sendto(data, addr)
+            elif kind == UDP_REPORT:
+                self.udp.sendto(FLOOD_REPORT.pack(
+                    kind, seq, f[0], f[1], max(0, f[2] - f[0]), f[3],
+                    int((f[5] - f[4]) * 1e6)), addr)
+                f[:] = [0, 0, 0, 0, 0.0, 0.0]
+            elif kind == UDP_PING:
+                self.ping = []
+                t = threading.Thread(target=self.ping_self, args=(seq,))
+                t.daemon = True
+                t.start()
+                self.udp.sendto(data, addr)
+            elif kind == UDP_PING_REPORT:
+                rtts = self.ping
+                hist = [0] * HIST_BUCKETS
+                for us in rtts:
+                    hist[hist_bucket(us)] += 1
+                n = len(rtts)
+                self.udp.sendto(PING_REPORT.pack(
+                    kind, seq, seq, n, min(rtts or [0]), max(rtts or [0]),
+                    sum(rtts) // n if n else 0, *hist), addr)
+
+    def ping_self(self, count):
+        # no raw socket without root, time UDP echoes instead
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.settimeout(0.5)
+        for i in range(count):
+            start = time.time()
+            sock.sendto(HDR.pack(UDP_ECHO, i), self.udp.getsockname())
+            try:
+                sock.recvfrom(64)
+                self.ping.append(int((time.time() - start) * 1e6))
+            except socket.timeout:
+                pass
+        sock.close()
+
+#
+# Report
+#
+
+def run(host, port, args):
+    addr = (host, port)
+    print("TCP on %s:%d" % addr)
+    print("  %10s %12s %12s %12s  (kbit/s)" % ("bytes", "up node",
+                                                "up host", "down host"))
+    sock = socket.create_connection(addr, timeout=30)
+    for size in args.tcp_sizes:
+        received, node_up, host_up = tcp_upload(sock, size)
+        down = tcp_download(sock, size)
+        print("  %10d %12.0f %12.0f %12.0f%s" % (
+            size, node_up, host_up, down,
+            "" if received == size else "  (node got %d)" % received))
+    sock.sendall(HDR.pack(CMD_QUIT, 0))
+    sock.close()
+
+    udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    print("UDP flood, %.1f s each" % args.seconds)
+    print("  %6s %6s %7s %7s %7s %5s %7s %10s" % (
+        "size", "rate", "sent", "recv", "lost", "late", "loss", "kbit/s"))
+    for size in args.udp_sizes:
+        for rate in args.udp_rates:
+            sent, received, lost, late, goodput = udp_flood(
+                udp, addr, size, rate, args.seconds)
+            print("  %6d %6d %7d %7d %7d %5d %6.1f%% %10.0f" % (
+                size, rate, sent, received, lost, late,
+                100.0 * lost / sent if sent else 0.0, goodput))
+
+    labels = hist_labels()
+    count, rtts, hist = udp_echo(udp, addr, args.count, 64)
+    print("UDP echo round trip, host side: %d/%d answered" % (len(rtts),
+                                                              count))
+    if rtts:
+        print("  min %d us, avg %d us, max %d us" % (
+            min(rtts), sum(rtts) // len(rtts), max(rtts)))
+    print("  " + " ".join("%s:%d" % (l, n) for l, n in zip(labels, hist)))
+
+    (sent, received, lo, hi, avg), hist = node_ping(udp, addr, args.count)
+    print("ICMP round trip, node side: %d/%d answered" % (received, sent))
+    if received:
+        print("  min %d us, avg %d us, max %d us" % (lo, avg, hi))
+    print("  " + " ".join("%s:%d" % (l, n) for l, n in zip(labels, hist)))
+    udp.close()
+
+def sizes(text):
+    return tuple(int(x) for x in text.split(","))
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Throughput and latency test against lwip_bench")
+    parser.add_argument("host", nargs="?", help="address of the node")
+    parser.add_argument("--port", type=int, default=PORT)
+    parser.add_argument("--start", action="store_true",
+                        help="open the service with GET /bench?run=1 first")
+    parser.add_argument("--stop", action="store_true",
+                        help="close the service with GET /bench?run=0 after")
+    parser.add_argument("--loopback", action="store_true",
+                        help="test against a local stand-in of the node")
+    parser.add_argument("--tcp-sizes", type=sizes, default=TCP_SIZES)
+    parser.add_argument("--udp-sizes", type=sizes, default=UDP_SIZES)
+    parser.add_argument("--udp-rates", type=sizes, default=UDP_RATES,
+                        help="datagrams per second")
+    parser.add_argument("--seconds", type=float, default=2.0,
+                        help="duration of each flood")
+    parser.add_argument("--count", type=int, default=50,
+                        help="echo and ping round trips")
+    args = parser.parse_args()
+
+    if args.loopback:
+        standin = StandIn()
+        host, port = "127.0.0.1", standin.port
+    elif args.host:
+        host, port = args.host, args.port
+    else:
+        parser.error("a host or --loopback is needed")
+
+    if args.start and not args.loopback:
+        urlopen("http://%s/bench?run=1" % host, timeout=10).read()
+        time.sleep(0.5)
+    try:
+        run(host, port, args)
+    except (IOError, socket.error) as e:
+        sys.stderr.write("netbench: %s\n" % e)
+        return 1
+    finally:
+        if args.stop and not args.loopback:
+            urlopen("http://%s/bench?run=0" % host, timeout=10).read()
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
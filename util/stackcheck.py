@@ -0,0 +1,148 @@
+#!/usr/bin/env python
+#
+# Compare the stack depths given to xTaskCreate(), xTaskCreateStatic() and
+# sys_thread_new() in the sources with a stack profile printed by
+# stack_stats_report() on the device, and fail when a task is given more
+# than --slack percent above its measured peak.
+#
+#   make STACK_PROFILE=stack.txt STACK_SLACK=50
+#   stackcheck.py --slack 50 stack.txt app framework platform
+#
+# Depths are resolved when they are integer literals or macros defined as
+# such in the scanned sources, other tasks are listed and skipped.
+#
+import argparse
+import os
+import re
+import sys
+
+# Characters of the task name kept by the profiler
+NAME_LEN = 12
+
+# Task name and depth arguments of the calls creating a task: xTaskCreate()
+# and xTaskCreateStatic() take the name second, lwIP's sys_thread_new() first.
+# The name is a string or a macro, calls may span lines.
+RE_NAME = r'("[^"]+"|\w+)'
+RE_CREATES = (
+    re.compile(r'\bxTaskCreate(?:Static)?\s*\(\s*[^,]+,\s*' + RE_NAME +
+               r'\s*,\s*([^,]+),'),
+    re.compile(r'\bsys_thread_new\s*\(\s*' + RE_NAME +
+               r'\s*,\s*[^,]+,\s*[^,]+,\s*([^,]+),'),
+)
+RE_COMMENT = re.compile(r'//[^\n]*|/\*.*?\*/', re.S)
+RE_IFNDEF = re.compile(r'^\s*#\s*ifndef\s+(\w+)')
+RE_DEFINE = re.compile(r'^\s*#\s*define\s+(\w+)\s+(.+?)\s*(/[*/].*)?$')
+RE_CAST = re.compile(r'\(\s*(unsigned\s+)?(short|int|long|uint\d+_t)\s*\)')
+
+def read_profile(path):
+    profile = {}
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) >= 5 and fields[0] == "stack":
+                profile[fields[1]] = (int(fields[2]), int(fields[3]),
+                                      "overflow" in fields[5:])
+    return profile
+
+def strip_comments(text):
+    # keep the newlines, so that line numbers still match
+    return RE_COMMENT.sub(lambda m: "\n" * m.group(0).count("\n"), text)
+
+def scan_sources(dirs):
+    creates = []
+    defines = {}
+    defaults = {}
+    for top in dirs:
+        for root, _, files in os.walk(top):
+            for name in files:
+                if not name.endswith((".c", ".h")):
+                    continue
+                path = os.path.join(root, name)
+                with open(path, errors="replace") as f:
+                    text = strip_comments(f.read())
+                guard = None
+                for line in text.splitlines():
+                    m = RE_IFNDEF.match(line)
+                    if m:
+                        guard = m.group(1)
+                        continue
+                    m = RE_DEFINE.match(line)
+                    if m:
+                        # an #ifndef default gives way to the configuration
+                        if m.group(1) == guard:
+                            defaults.setdefault(m.group(1), m.group(2))
+                        else:
+                            defines.setdefault(m.group(1), m.group(2))
+                    guard = None
+                if not name.endswith(".c"):
+                    continue
+                for regex in RE_CREATES:
+                    for m in regex.finditer(text):
+                        number = text.count("\n", 0, m.start()) + 1
+                        creates.append((m.group(1), m.group(2).strip(),
+                                        "%s:%d" % (path, number)))
+    for name, value in defaults.items():
+        defines.setdefault(name, value)
+    return creates, defines
+
+def resolve_name(expr, defines, depth=0):
+    if expr.startswith('"'):
+        return expr.strip('"')
+    if depth < 8 and expr in defines:
+        return resolve_name(defines[expr].strip(), defines, depth + 1)
+    return None
+
+def resolve(expr, defines, depth=0):
+    expr = RE_CAST.sub("", expr).strip()
+    while expr.startswith("(") and expr.endswith(")"):
+        expr = expr[1:-1].strip()
+    try:
+        return int(expr, 0)
+    except ValueError:
+        pass
+    if depth < 8 and expr in defines:
+        return resolve(defines[expr], defines, depth + 1)
+    return None
+
+def main():
+    parser = argparse.ArgumentParser(description='Check task stack depths against a measured profile', prog='stackcheck')
+    parser.add_argument('--slack', type=int, default=50,
+                        help='percent above the measured peak allowed, 50 by default')
+    parser.add_argument('profile', help='output of stack_stats_report()')
+    parser.add_argument('dirs', nargs='+', help='source directories to scan')
+    args = parser.parse_args()
+
+    profile = read_profile(args.profile)
+    creates, defines = scan_sources(args.dirs)
+    failed = False
+
+    for name_expr, expr, where in creates:
+        name = resolve_name(name_expr, defines)
+        if name is None:
+            print("%s: name '%s' not resolved, skipped" % (where, name_expr))
+            continue
+        depth = resolve(expr, defines)
+        if depth is None:
+            print("%s: %s: depth '%s' not resolved, skipped" % (where, name, expr))
+            continue
+        key = name[:NAME_LEN]
+        if key not in profile:
+            print("%s: %s: not in the profile, skipped" % (where, name))
+            continue
+        measured_depth, peak, overflow = profile[key]
+        if overflow:
+            print("%s: %s: overflowed a depth of %d" % (where, name, measured_depth))
+            failed |= depth <= measured_depth
+            continue
+        if peak == 0:
+            continue
+        limit = peak * (100 + args.slack) // 100
+        if depth > limit:
+            print("%s: %s: depth %d, peak %d, more than %d%% above" %
+                  (where, name, depth, peak, args.slack))
+            failed = True
+
+    sys.exit(1 if failed else 0)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,130 @@
+#!/usr/bin/env python
+#
+# Convert a dump of the FreeRTOS trace recorder (freertos_trace.c) into
+# Chrome trace_event JSON, to be loaded in chrome://tracing or Perfetto.
+#
+# The dump comes from the TCP trace port of a "make TRACE=1 TRACE_PORT=5555"
+# build or from trace_dump_uart():
+#   nc <ip> 5555 > trace.txt
+#   trace2chrome.py trace.txt > trace.json
+#
+# Each task gets its own row with a slice per run, interrupts get a row of
+# their own and queue operations are shown as instant events.
+#
+import argparse
+import json
+import sys
+
+SWITCHED_IN = 1
+SWITCHED_OUT = 2
+QUEUE_SEND = 3
+QUEUE_RECEIVE = 4
+QUEUE_BLOCK_SEND = 5
+QUEUE_BLOCK_RECEIVE = 6
+QUEUE_SEND_ISR = 7
+QUEUE_RECEIVE_ISR = 8
+ISR_ENTER = 9
+ISR_EXIT = 10
+TASK_DELAY = 11
+
+TASK_ISR = 0xFF
+
+INSTANTS = {
+    QUEUE_SEND: "queue send",
+    QUEUE_RECEIVE: "queue receive",
+    QUEUE_BLOCK_SEND: "block on send",
+    QUEUE_BLOCK_RECEIVE: "block on receive",
+    QUEUE_SEND_ISR: "queue send",
+    QUEUE_RECEIVE_ISR: "queue receive",
+    TASK_DELAY: "delay",
+}
+
+DRAM_START = 0x3FFE8000
+
+def parse(lines):
+    freq = 80000000
+    tasks = {}
+    events = []
+    last = None
+    high = 0
+    for line in lines:
+        fields = line.split()
+        if not fields:
+            continue
+        if fields[0] == "#":
+            if len(fields) >= 3 and fields[1] == "trace":
+                freq = int(fields[2])
+            elif len(fields) >= 3 and fields[1] == "task":
+                tasks[int(fields[2])] = " ".join(fields[3:])
+            continue
+        ts, event, task, obj = [int(f) for f in fields[:4]]
+        # ccount is 32 bits, it wraps every 27 s at 160 MHz
+        if last is not None and ts < last:
+            high += 1 << 32
+        last = ts
+        events.append((high + ts, event, task, obj))
+    return freq, tasks, events
+
+def convert(freq, tasks, events):
+    out = []
+    if not events:
+        return out
+    origin = events[0][0]
+
+    def us(ts):
+        return (ts - origin) * 1e6 / freq
+
+    for num, name in sorted(tasks.items()):
+        out.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": num,
+                    "args": {"name": "%s (%d)" % (name, num)}})
+    out.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": TASK_ISR,
+                "args": {"name": "interrupts"}})
+
+    running = {}
+    isrs = {}
+    for ts, event, task, obj in events:
+        if event == SWITCHED_IN:
+            running[task] = ts
+        elif event == SWITCHED_OUT:
+            start = running.pop(task, None)
+            if start is not None:
+                out.append({"name": tasks.get(task, "task %d" % task),
+                            "ph": "X", "pid": 1, "tid": task,
+                            "ts": us(start), "dur": us(ts) - us(start)})
+        elif event == ISR_ENTER:
+            isrs[obj] = ts
+        elif event == ISR_EXIT:
+            start = isrs.pop(obj, None)
+            if start is not None:
+                out.append({"name": "irq %d" % obj, "ph": "X", "pid": 1,
+                            "tid": TASK_ISR, "ts": us(start),
+                            "dur": us(ts) - us(start)})
+        elif event in INSTANTS:
+            args = {}
+            if event != TASK_DELAY:
+                args["queue"] = "0x%08x" % (DRAM_START + (obj << 2))
+            out.append({"name": INSTANTS[event], "ph": "i", "s": "t",
+                        "pid": 1, "tid": task, "ts": us(ts), "args": args})
+
+    # close the slice of the task still running at the end of the dump
+    end = events[-1][0]
+    for task, start in running.items():
+        out.append({"name": tasks.get(task, "task %d" % task), "ph": "X",
+                    "pid": 1, "tid": task, "ts": us(start),
+                    "dur": us(end) - us(start)})
+    return out
+
+def main():
+    parser = argparse.ArgumentParser(description='FreeRTOS trace to Chrome trace_event JSON', prog='trace2chrome')
+    parser.add_argument('input', nargs='?', type=argparse.FileType('r'), default=sys.stdin,
+                        help='trace dump, stdin by default')
+    parser.add_argument('--output', '-o', type=argparse.FileType('w'), default=sys.stdout,
+                        help='JSON output, stdout by default')
+    args = parser.parse_args()
+
+    freq, tasks, events = parse(args.input)
+    json.dump({"traceEvents": convert(freq, tasks, events),
+               "displayTimeUnit": "ns"}, args.output)
+
+if __name__ == "__main__":
+    main()